@@ -22,6 +22,7 @@
 #include <wut-fixups.h>
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <file.h>
 #include <localisation.h>
@@ -52,6 +53,12 @@ extern "C"
     void setUpdateCheck(bool enabled);
     bool autoResumeEnabled();
     void setAutoResume(bool enabled);
+    bool lowPowerEnabled();
+    void setLowPower(bool enabled);
+    bool logExportEnabled();
+    void setLogExport(bool enabled);
+    uint32_t getContentCacheSize();
+    void setContentCacheSize(uint32_t size);
     const char *getFormattedRegion(MCPRegion region);
     Swkbd_LanguageType getKeyboardLanguage();
     Swkbd_LanguageType getUnfilteredLanguage();
@@ -0,0 +1,67 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <wut-fixups.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <file.h>
+#include <tmd.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define CONTENT_CACHE_DIR NUSDIR_SD "cache/"
+
+    typedef struct WUT_PACKED
+    {
+        uint64_t tid;
+        uint64_t size; // .app + .h3
+        uint32_t hash[5];
+        uint16_t index;
+        uint16_t hashed;
+    } CACHE_ENTRY;
+
+    typedef enum
+    {
+        CACHE_RESTORE_NONE, // Nothing to do, the content is already there
+        CACHE_RESTORE_COPIED,
+        CACHE_RESTORE_MOVED,
+        CACHE_RESTORE_BROKEN, // The cached files are missing or have the wrong size
+        CACHE_RESTORE_CANCELLED,
+    } CACHE_RESTORE;
+
+    void initContentCache() __attribute__((__cold__));
+    void shutdownContentCache() __attribute__((__cold__));
+    bool findInCache(const TMD *tmd, uint16_t content, CACHE_ENTRY *out);
+    CACHE_RESTORE restoreFromCache(const CACHE_ENTRY *entry, const TMD *tmd, uint16_t content, const char *dir, bool move, COPY_PROGRESS *progress);
+    uint64_t finishCacheRestore(const CACHE_ENTRY *restored, uint32_t cid, CACHE_RESTORE result);
+    void storeInCache(const char *dir);
+    void trimContentCache();
+    void flushContentCache();
+    bool isCached(const TMD *tmd, uint16_t content);
+    uint64_t getCacheSavedBytes();
+
+#ifdef __cplusplus
+}
+#endif
@@ -35,6 +35,7 @@ extern "C"
     void addEntropy(void *e, size_t len) __attribute__((__hot__));
     int NUSrng(void *data, unsigned char *out, size_t outlen);
     bool encryptAES(void *data, int data_len, const unsigned char *key, unsigned char *iv, void *encrypted);
+    bool decryptAES(void *data, int data_len, const unsigned char *key, unsigned char *iv, void *decrypted);
 
 #define osslBytes(buf, num) NUSrng(NULL, (unsigned char *)buf, num)
 
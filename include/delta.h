@@ -0,0 +1,49 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <wut-fixups.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <file.h>
+#include <tmd.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct
+    {
+        TMD *tmd; // NULL if there's no previous version
+        char dir[FS_MAX_PATH];
+    } DELTA_SOURCE;
+
+    int findUnchangedContent(const TMD *tmd, uint16_t content, const TMD *old);
+    uint64_t getDeltaSize(const TMD *tmd, const TMD *old);
+    bool findPreviousVersion(const TMD *tmd, const char *exclude, DELTA_SOURCE *out);
+    void freeDeltaSource(DELTA_SOURCE *source);
+    uint64_t fetchFromPreviousVersion(const TMD *tmd, uint16_t content, const DELTA_SOURCE *source, const char *dir, COPY_PROGRESS *progress);
+    uint64_t getReusableSize(const TMD *tmd);
+
+#ifdef __cplusplus
+}
+#endif
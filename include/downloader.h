@@ -50,15 +50,28 @@ extern "C"
     {
         char *buf;
         size_t size;
+        size_t capacity; // Allocated bytes of buf
     } RAMBUF;
 
-#define DOWNLOAD_URL "http://ccs.cdn.wup.shop.nintendo.net/ccs/download/"
+    typedef struct
+    {
+        uint64_t tid;
+        char titleVer[33];
+        RAMBUF *rambuf; // NULL if the download failed
+    } TMD_REQUEST;
+
+#define DOWNLOAD_URL      "http://ccs.cdn.wup.shop.nintendo.net/ccs/download/"
+#define MAX_PARALLEL_TMDS 4
 
     bool initDownloader() __attribute__((__cold__));
     void deinitDownloader() __attribute__((__cold__));
+    void warmupConnection();
     int downloadFile(const char *url, char *file, downloadData *data, FileType type, bool resume, QUEUE_DATA *queueData, RAMBUF *rambuf) __attribute__((__hot__));
     bool downloadTitle(const TMD *tmd, size_t tmdSize, const TitleEntry *titleEntry, const char *titleVer, char *folderName, bool inst, NUSDEV dlDev, bool toUSB, bool keepFiles, QUEUE_DATA *queueData);
+    void downloadTmds(TMD_REQUEST *requests, size_t count);
     RAMBUF *allocRamBuf();
+    void clearRamBuf(RAMBUF *rambuf);
+    bool setRamBuf(RAMBUF *rambuf, const void *data, size_t size);
     void freeRamBuf(RAMBUF *rambuf);
 
 #ifdef __cplusplus
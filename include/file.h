@@ -39,6 +39,7 @@
 #define INSTALL_DIR_USB2 NUSDIR_USB2 "install/"
 #define INSTALL_DIR_MLC  NUSDIR_MLC "install/"
 #define IO_BUFSIZE       (128 * 1024) // 128 KB
+#define COPY_BUFFER_SIZE (1024 * 1024) // 1 MB
 
 #define FS_ALIGN(x)      ((x + 0x3F) & ~(0x3F))
 
@@ -78,10 +79,18 @@ extern "C"
         TMD_STATE_TECONMOON,
     } TMD_STATE;
 
+    // Shared between copyFile() and the thread drawing its progress
+    typedef struct
+    {
+        volatile size_t copied;
+        volatile bool cancel;
+    } COPY_PROGRESS;
+
     bool fileExists(const char *path) __attribute__((__hot__));
     bool dirExists(const char *path) __attribute__((__hot__));
     FSError removeDirectory(const char *path) __attribute__((__hot__));
     FSError moveDirectory(const char *src, const char *dest);
+    bool copyFile(const char *src, const char *dest, size_t size, COPY_PROGRESS *progress);
     FSError createDirectory(const char *path);
     bool createDirRecursive(const char *dir) __attribute__((__hot__));
     const char *translateFSErr(FSError err) __attribute__((__cold__));
@@ -23,13 +23,41 @@
 #include <stdbool.h>
 
 #include <file.h>
+#include <no-intro.h>
+#include <titles.h>
+#include <tmd.h>
+#include <utils.h>
+
+#pragma GCC diagnostic ignored "-Wundef"
+#include <coreinit/filesystem_fsa.h>
+#include <coreinit/mcp.h>
+#include <coreinit/time.h>
+#pragma GCC diagnostic pop
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+    typedef struct
+    {
+        MCPInstallTitleInfo info __attribute__((__aligned__(0x40)));
+        McpData data;
+        NO_INTRO_DATA *noIntro;
+        uint64_t size;
+        OSTime start;
+        NUSDEV dev;
+        bool hasDeps;
+        bool toUsb;
+        bool keepFiles;
+        char game[MAX_TITLENAME_LENGTH];
+        char path[FS_MAX_PATH];
+    } INSTALL_JOB;
+
     bool install(const char *game, bool hasDeps, NUSDEV dev, const char *path, bool toUsb, bool keepFiles, const TMD *tmd);
+    int startInstall(INSTALL_JOB *job, const char *game, bool hasDeps, NUSDEV dev, const char *path, bool toUsb, bool keepFiles, const TMD *tmd);
+    bool finishInstall(INSTALL_JOB *job);
+    int installToFrame(int line);
 
 #ifdef __cplusplus
 }
@@ -21,6 +21,7 @@
 #include <wut-fixups.h>
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include <titles.h>
@@ -30,7 +31,10 @@ extern "C"
 {
 #endif
 
+#define KEY_CACHE_SIZE 32 // Titles generateKeys() should be called with at most, so all keys stay cached
+
     bool generateKey(uint64_t tid, uint8_t *out);
+    bool generateKeys(const uint64_t *tids, size_t count, uint8_t *out);
 
 #ifdef __cplusplus
 }
@@ -23,6 +23,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include <memTrack.h>
+
 #pragma GCC diagnostic ignored "-Wundef"
 #include <coreinit/memdefaultheap.h>
 #include <coreinit/memory.h>
@@ -49,7 +51,7 @@ extern "C"
 
     static inline LIST *createList()
     {
-        LIST *ret = MEMAllocFromDefaultHeap(sizeof(LIST));
+        LIST *ret = memAlloc(MEM_TAG_LIST, sizeof(LIST));
         if(ret != NULL)
             OSBlockSet(ret, 0x00, sizeof(LIST));
 
@@ -66,7 +68,7 @@ extern "C"
             if(freeContents)
                 MEMFreeToDefaultHeap(tmp->content);
 
-            MEMFreeToDefaultHeap(tmp);
+            memFree(MEM_TAG_LIST, tmp);
         }
 
         list->last = NULL;
@@ -76,12 +78,12 @@ extern "C"
     static inline void destroyList(LIST *list, bool freeContents)
     {
         clearList(list, freeContents);
-        MEMFreeToDefaultHeap(list);
+        memFree(MEM_TAG_LIST, list);
     }
 
     static inline bool addToListBeginning(LIST *list, void *content)
     {
-        ELEMENT *newElement = MEMAllocFromDefaultHeap(sizeof(LIST));
+        ELEMENT *newElement = memAlloc(MEM_TAG_LIST, sizeof(LIST));
         if(newElement == NULL)
             return false;
 
@@ -98,7 +100,7 @@ extern "C"
 
     static inline bool addToListEnd(LIST *list, void *content)
     {
-        ELEMENT *newElement = MEMAllocFromDefaultHeap(sizeof(LIST));
+        ELEMENT *newElement = memAlloc(MEM_TAG_LIST, sizeof(LIST));
         if(newElement == NULL)
             return false;
 
@@ -128,7 +130,7 @@ extern "C"
         {
             ELEMENT *tmp = list->first;
             list->first = tmp->next;
-            MEMFreeToDefaultHeap(tmp);
+            memFree(MEM_TAG_LIST, tmp);
 
             list->size--;
             if(list->size == 0)
@@ -147,7 +149,7 @@ extern "C"
                     list->last = last;
 
                 list->size--;
-                MEMFreeToDefaultHeap(cur);
+                memFree(MEM_TAG_LIST, cur);
                 return;
             }
         }
@@ -187,7 +189,7 @@ extern "C"
         if(freeContent)
             MEMFreeToDefaultHeap(entry->content);
 
-        MEMFreeToDefaultHeap(entry);
+        memFree(MEM_TAG_LIST, entry);
 
         list->size--;
         if(list->size == 0)
@@ -217,7 +219,7 @@ extern "C"
         }
 
         void *ret = entry->content;
-        MEMFreeToDefaultHeap(entry);
+        memFree(MEM_TAG_LIST, entry);
 
         list->size--;
         if(list->size == 0)
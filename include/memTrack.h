@@ -0,0 +1,73 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <wut-fixups.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <file.h>
+
+#pragma GCC diagnostic ignored "-Wundef"
+#include <coreinit/memdefaultheap.h>
+#pragma GCC diagnostic pop
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef enum
+    {
+        MEM_TAG_OTHER,
+        MEM_TAG_LIST,
+        MEM_TAG_THREAD,
+        MEM_TAG_IO,
+        MEM_TAG_DOWNLOAD,
+        MEM_TAG_LOCALE,
+        MEM_TAG_RENDERER,
+        MEM_TAG_CACHE,
+        MEM_TAG_DEBUG,
+        MEM_TAG_COUNT,
+    } MEM_TAG;
+
+#ifdef NUSSPLI_DEBUG
+#define MEM_REPORT_PATH NUSDIR_SD "NUSspli_heap.txt"
+
+    void *memAlloc(MEM_TAG tag, uint32_t size);
+    void *memAllocEx(MEM_TAG tag, uint32_t size, int align);
+    void memFree(MEM_TAG tag, void *ptr);
+    void getMemOverlayString(char *out);
+    bool memOverlayEnabled();
+    void toggleMemOverlay();
+    void dumpMemReport();
+#else
+// Release builds call the heap directly
+#define memAlloc(tag, size)          MEMAllocFromDefaultHeap(size)
+#define memAllocEx(tag, size, align) MEMAllocFromDefaultHeapEx(size, align)
+#define memFree(tag, ptr)            MEMFreeToDefaultHeap(ptr)
+#define memOverlayEnabled()          false
+#define toggleMemOverlay()
+#define dumpMemReport()
+#endif
+
+#ifdef __cplusplus
+}
+#endif
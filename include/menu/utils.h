@@ -46,12 +46,16 @@ extern "C"
         FINISHING_OPERATION_INSTALL,
         FINISHING_OPERATION_DEINSTALL,
         FINISHING_OPERATION_DOWNLOAD,
-        FINISHING_OPERATION_QUEUE
+        FINISHING_OPERATION_QUEUE,
+        FINISHING_OPERATION_VERIFY,
+        FINISHING_OPERATION_CONVERT,
     } FINISHING_OPERATION;
 
     void addToScreenLog(const char *str, ...);
     void clearScreenLog();
     void writeScreenLog(int line);
+    bool startScreenLogExport();
+    void stopScreenLogExport();
     void drawErrorFrame(const char *text, ErrorOptions option);
     void showErrorFrame(const char *text);
     bool checkSystemTitle(uint64_t tid, MCPRegion region, bool deinstall);
@@ -0,0 +1,43 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <wut-fixups.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <downloader.h>
+#include <file.h>
+#include <queue.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define METADATA_CACHE_DIR NUSDIR_SD "meta/"
+
+    bool loadCachedMetadata(uint64_t tid, const char *file, const char *titleVer, bool allowStale, RAMBUF *rambuf, int *result);
+    void storeMetadata(uint64_t tid, const char *file, const char *titleVer, int result, const RAMBUF *rambuf);
+    int downloadMetadata(uint64_t tid, const char *file, const char *titleVer, FileType type, downloadData *data, QUEUE_DATA *queueData, RAMBUF *rambuf);
+
+#ifdef __cplusplus
+}
+#endif
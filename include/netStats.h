@@ -0,0 +1,99 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <wut-fixups.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <file.h>
+
+#include <curl/curl.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define NET_REPORT_PATH        NUSDIR_SD "NUSspli_network.csv"
+#define NET_REPORT_NAME_LENGTH 128 // Title names get cut here in the report
+#define NET_REPORT_LINE_LENGTH 768
+#define NET_SUMMARY_LENGTH     128
+
+    typedef enum
+    {
+        NET_HTTP_UNKNOWN,
+        NET_HTTP_1,
+        NET_HTTP_2,
+        NET_HTTP_3,
+        NET_HTTP_COUNT,
+    } NET_HTTP_VERSION;
+
+    // A single curl transfer. All times are in microseconds and per phase, not cumulative like curl reports them.
+    typedef struct
+    {
+        uint64_t lookup;
+        uint64_t connect;
+        uint64_t tls;
+        uint64_t ttfb;
+        uint64_t total;
+        uint64_t bytes;
+        uint64_t speed; // Bytes per second
+        uint64_t resumeOffset;
+        uint32_t newConnections;
+        NET_HTTP_VERSION http;
+        bool failed;
+    } NET_TRANSFER;
+
+    typedef struct
+    {
+        uint32_t transfers;
+        uint32_t failed;
+        uint32_t retries;
+        uint32_t resumed;
+        uint32_t newConnections;
+        uint32_t http[NET_HTTP_COUNT];
+        uint64_t resumedBytes;
+        uint64_t bytes;
+        uint64_t lookup; // Summed over new connections
+        uint64_t connect; // Summed over new connections
+        uint64_t tls; // Summed over new connections
+        uint64_t ttfb; // Summed over all transfers
+        uint64_t total; // Summed over all transfers
+        uint64_t maxSpeed;
+    } NET_STATS;
+
+    // Pure helpers, these neither touch curl nor the filesystem
+    void addTransferToNetStats(NET_STATS *stats, const NET_TRANSFER *transfer);
+    size_t formatNetStatsRow(char *out, const char *scope, uint64_t tid, const char *name, const NET_STATS *stats);
+    bool formatNetStatsSummary(const NET_STATS *stats, char *out);
+
+    void startTitleNetStats(uint64_t tid, const char *name);
+    void finishTitleNetStats();
+    void recordTransfer(CURL *handle, curl_off_t resumeOffset, bool failed);
+    void recordRetry();
+    bool getNetStatsSummary(char *out);
+    void writeNetStatsReport();
+    void clearNetStats();
+
+#ifdef __cplusplus
+}
+#endif
@@ -41,6 +41,9 @@ extern "C"
     void destroyNoIntroData(NO_INTRO_DATA *data);
     void revertNoIntro(NO_INTRO_DATA *data);
     NO_INTRO_DATA *transformNoIntro(const char *path);
+    void keepNoIntro(NO_INTRO_DATA *data);
+    bool recoverNoIntro(const char *path);
+    bool getTitleFilePath(const char *dir, const char *file, char *out);
 
 #ifdef __cplusplus
 }
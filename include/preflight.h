@@ -0,0 +1,77 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <wut-fixups.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ticket.h>
+#include <tmd.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define PREFLIGHT_NAME_LENGTH 16
+#define PREFLIGHT_MAX_META    0x2000 // Max. size of title.tik / title.cert we're willing to read
+
+    typedef enum
+    {
+        PREFLIGHT_STATE_OK,
+        PREFLIGHT_STATE_NO_LISTING,
+        PREFLIGHT_STATE_MISSING_APP,
+        PREFLIGHT_STATE_BAD_APP_SIZE,
+        PREFLIGHT_STATE_MISSING_H3,
+        PREFLIGHT_STATE_BAD_H3_SIZE,
+        PREFLIGHT_STATE_MISSING_TIK,
+        PREFLIGHT_STATE_BAD_TIK,
+        PREFLIGHT_STATE_MISSING_CERT,
+        PREFLIGHT_STATE_BAD_CERT,
+    } PREFLIGHT_STATE;
+
+    typedef struct
+    {
+        PREFLIGHT_STATE state;
+        uint32_t cid;
+        uint64_t expected;
+        uint64_t found;
+    } PREFLIGHT_RESULT;
+
+    typedef struct
+    {
+        char name[PREFLIGHT_NAME_LENGTH];
+        uint64_t size;
+    } PREFLIGHT_FILE;
+
+    // Pure checks, these don't touch the filesystem
+    bool checkTicketStructure(const TICKET *ticket, size_t size, uint64_t tid);
+    bool checkCertStructure(const CETK *cert, size_t size);
+    void sortListing(PREFLIGHT_FILE *files, size_t count);
+    bool checkListing(const TMD *tmd, const PREFLIGHT_FILE *files, size_t count, PREFLIGHT_RESULT *out);
+
+    bool preflightInstall(const char *dir, const TMD *tmd, PREFLIGHT_RESULT *out);
+    void preflightToString(const PREFLIGHT_RESULT *result, char *out);
+
+#ifdef __cplusplus
+}
+#endif
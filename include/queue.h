@@ -46,14 +46,19 @@ extern "C"
 
     typedef struct
     {
-        TMD *tmd;
-        size_t tmdSize;
+        TMD *tmd; // NULL while spilled to the journal or download folder
+        size_t tmdSize; // 0 if the TMD is in the download folder
         void *rambuf; // TODO
-        OPERATION operation;
+        uint64_t tid;
+        uint64_t dlSize; // Precomputed, including .h3 files
+        uint64_t installSize; // Precomputed
         const TitleEntry *entry;
-        char titleVer[33];
-        char folderName[FS_MAX_PATH - 11] __attribute__((__aligned__(0x40)));
+        const char *folderName; // Interned by addToQueue()
+        uint32_t journalId;
+        uint32_t tmdOffset; // Offset of the spilled TMD in the journal
+        OPERATION operation;
         NUSDEV dlDev;
+        char titleVer[33];
         bool toUSB;
         bool keepFiles;
     } TitleData;
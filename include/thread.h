@@ -23,6 +23,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include <memTrack.h>
+
 #pragma GCC diagnostic ignored "-Wundef"
 #include <coreinit/atomic.h>
 #include <coreinit/memdefaultheap.h>
@@ -83,14 +85,14 @@ extern "C"
         OSJoinThread(thread, ret);                                                                                                                             \
         debugPrintf("STACK: %s: 0x%08X/0x%08X", thread->name, OSCheckThreadStackUsage(thread), ((uint32_t)thread->stackStart) - ((uint32_t)thread->stackEnd)); \
         OSDetachThread(thread);                                                                                                                                \
-        MEMFreeToDefaultHeap(thread);                                                                                                                          \
+        memFree(MEM_TAG_THREAD, thread);                                                                                                                       \
     }
 #else
-#define stopThread(thread, ret)       \
-    {                                 \
-        OSJoinThread(thread, ret);    \
-        OSDetachThread(thread);       \
-        MEMFreeToDefaultHeap(thread); \
+#define stopThread(thread, ret)          \
+    {                                    \
+        OSJoinThread(thread, ret);       \
+        OSDetachThread(thread);          \
+        memFree(MEM_TAG_THREAD, thread); \
     }
 #endif
 
@@ -0,0 +1,77 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <wut-fixups.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <file.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef NUSSPLI_DEBUG
+#define TRACE_PATH        NUSDIR_SD "NUSspli_trace.json"
+#define TRACE_RING_EVENTS 0x2000 // Per core, has to be a power of 2
+
+    typedef enum
+    {
+        TRACE_EVENT_BEGIN,
+        TRACE_EVENT_END,
+        TRACE_EVENT_COUNTER,
+    } TRACE_EVENT_TYPE;
+
+    void initTrace();
+    void shutdownTrace();
+    void traceEvent(TRACE_EVENT_TYPE type, const char *name, uint32_t value) __attribute__((__hot__));
+    bool exportTrace();
+
+    static inline const char *traceScopeBegin(const char *name)
+    {
+        traceEvent(TRACE_EVENT_BEGIN, name, 0);
+        return name;
+    }
+
+    static inline void traceScopeEnd(const char **name)
+    {
+        traceEvent(TRACE_EVENT_END, *name, 0);
+    }
+
+// name has to be a string literal (or otherwise outlive the trace)
+#define traceBegin(name)          traceEvent(TRACE_EVENT_BEGIN, name, 0)
+#define traceEnd(name)            traceEvent(TRACE_EVENT_END, name, 0)
+#define traceCounter(name, value) traceEvent(TRACE_EVENT_COUNTER, name, value)
+#define traceScope(name)          const char *traceScopeName __attribute__((__cleanup__(traceScopeEnd), __unused__)) = traceScopeBegin(name)
+#else
+#define initTrace()
+#define shutdownTrace()
+#define exportTrace()
+#define traceBegin(name)
+#define traceEnd(name)
+#define traceCounter(name, value)
+#define traceScope(name)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
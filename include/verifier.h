@@ -0,0 +1,61 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <wut-fixups.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <tmd.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define VERIFY_THREADS     3
+#define VERIFY_NO_BLOCK    0xFFFFFFFF
+#define HASHED_BLOCK_SIZE  0x10000
+#define HASHED_HEADER_SIZE 0x400
+#define VERIFY_BUFFER_SIZE (16 * HASHED_BLOCK_SIZE)
+
+    typedef enum
+    {
+        VERIFY_STATE_PENDING,
+        VERIFY_STATE_OK,
+        VERIFY_STATE_MISSING,
+        VERIFY_STATE_READ_ERROR,
+        VERIFY_STATE_BAD_HASH,
+        VERIFY_STATE_BAD_H3,
+        VERIFY_STATE_BAD_BLOCK,
+    } VERIFY_STATE;
+
+    typedef struct
+    {
+        VERIFY_STATE state;
+        uint32_t block; // First bad block of hashed contents, VERIFY_NO_BLOCK otherwise
+    } VERIFY_RESULT;
+
+    bool verifyContents(const char *dir, const TMD *tmd, VERIFY_RESULT *results);
+    bool verifyFolder(const char *dir, const TMD *tmd, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,265 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <wut-fixups.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <bulkConvert.h>
+#include <file.h>
+#include <filesystem.h>
+#include <ioQueue.h>
+#include <keygen.h>
+#include <list.h>
+#include <localisation.h>
+#include <menu/utils.h>
+#include <no-intro.h>
+#include <renderer.h>
+#include <state.h>
+#include <ticket.h>
+#include <tmd.h>
+#include <utils.h>
+
+#pragma GCC diagnostic ignored "-Wundef"
+#include <coreinit/filesystem_fsa.h>
+#include <coreinit/memdefaultheap.h>
+#include <coreinit/memory.h>
+#include <coreinit/time.h>
+#pragma GCC diagnostic pop
+
+#define BULK_NO_INTRO  0x01
+#define BULK_NO_TICKET 0x02
+#define BULK_NO_CERT   0x04
+#define BULK_FAILED    0x08
+
+typedef struct
+{
+    char path[FS_MAX_PATH];
+    const char *installDir;
+    TMD *tmd;
+    uint32_t state;
+} BULK_ENTRY;
+
+static const char *const installDirs[] = {
+    INSTALL_DIR_SD,
+    INSTALL_DIR_USB1,
+    INSTALL_DIR_USB2,
+    INSTALL_DIR_MLC,
+};
+
+static bool fileInDir(char *path, char *ptr, const char *file)
+{
+    strcpy(ptr, file);
+    bool ret = fileExists(path);
+    *ptr = '\0';
+    return ret;
+}
+
+static void scanInstallDir(const char *installDir, LIST *entries)
+{
+    FSADirectoryHandle dir;
+    if(FSAOpenDir(getFSAClient(), installDir, &dir) != FS_ERROR_OK)
+        return;
+
+    FSADirectoryEntry entry;
+    BULK_ENTRY *bulk = NULL;
+    size_t s;
+    char *ptr;
+    while(FSAReadDir(getFSAClient(), dir, &entry) == FS_ERROR_OK)
+    {
+        if(!(entry.info.flags & FS_STAT_DIRECTORY) || entry.name[0] == '.')
+            continue;
+
+        if(bulk == NULL)
+        {
+            bulk = MEMAllocFromDefaultHeap(sizeof(BULK_ENTRY));
+            if(bulk == NULL)
+                break;
+        }
+
+        strcpy(bulk->path, installDir);
+        strcat(bulk->path, entry.name);
+        s = strlen(bulk->path);
+        bulk->path[s++] = '/';
+        bulk->path[s] = '\0';
+        ptr = bulk->path + s;
+
+        recoverNoIntro(bulk->path);
+        bulk->state = 0;
+        if(!fileInDir(bulk->path, ptr, "title.tmd"))
+        {
+            if(!fileInDir(bulk->path, ptr, "tmd"))
+                continue; // Not a title
+
+            bulk->state |= BULK_NO_INTRO;
+            if(!fileInDir(bulk->path, ptr, "cetk"))
+                bulk->state |= BULK_NO_TICKET;
+        }
+        else if(!fileInDir(bulk->path, ptr, "title.tik"))
+            bulk->state |= BULK_NO_TICKET;
+
+        if(!fileInDir(bulk->path, ptr, "title.cert"))
+            bulk->state |= BULK_NO_CERT;
+
+        bulk->tmd = getTmd(bulk->path, true);
+        if(bulk->tmd == NULL)
+        {
+            addToScreenLog("Invalid title.tmd file at %s", prettyDir(bulk->path));
+            continue;
+        }
+
+        bulk->installDir = installDir;
+        if(!addToListEnd(entries, bulk))
+        {
+            MEMFreeToDefaultHeap(bulk->tmd);
+            break;
+        }
+
+        bulk = NULL;
+    }
+
+    if(bulk != NULL)
+        MEMFreeToDefaultHeap(bulk);
+
+    FSACloseDir(getFSAClient(), dir);
+}
+
+static void convertEntry(BULK_ENTRY *bulk)
+{
+    if(bulk->state & BULK_NO_INTRO)
+    {
+        // The no-intro code renames everything and creates ticket and cert, we just don't revert it
+        NO_INTRO_DATA *data = transformNoIntro(bulk->path);
+        if(data == NULL)
+            bulk->state |= BULK_FAILED;
+        else
+            keepNoIntro(data);
+
+        return;
+    }
+
+    char *ptr = bulk->path + strlen(bulk->path);
+    if(bulk->state & BULK_NO_TICKET)
+    {
+        strcpy(ptr, "title.tik");
+        if(!generateTik(bulk->path, bulk->tmd))
+            bulk->state |= BULK_FAILED;
+    }
+
+    if(bulk->state & BULK_NO_CERT)
+    {
+        strcpy(ptr, "title.cert");
+        if(!generateCert(bulk->tmd, NULL, 0, bulk->path))
+            bulk->state |= BULK_FAILED;
+    }
+
+    *ptr = '\0';
+}
+
+static void drawBulkFrame(size_t done, size_t count)
+{
+    char toScreen[32];
+    startNewFrame();
+    textToFrame(0, 0, localise("Preparing install folders"));
+    barToFrame(1, 0, 40, (float)done / (float)count);
+    sprintf(toScreen, "%zu / %zu", done, count);
+    textToFrame(1, 41, toScreen);
+    writeScreenLog(2);
+    drawFrame();
+    showFrame();
+}
+
+/*
+ * Scans all install folders and converts no-intro sets to the NUS layout,
+ * creating missing tickets and certs on the way. Keys get derived in
+ * batches and all writes go through the I/O queue, so the main thread only
+ * has to do renames. Installs of converted folders don't need to touch
+ * them anymore.
+ */
+bool bulkConvert()
+{
+    LIST *entries = createList();
+    if(entries == NULL)
+        return false;
+
+    OSTime t = OSGetTime();
+    for(size_t i = 0; i < sizeof(installDirs) / sizeof(installDirs[0]); ++i)
+        scanInstallDir(installDirs[i], entries);
+
+    size_t count = getListSize(entries);
+    size_t done = 0;
+    size_t failed = 0;
+    size_t converted = 0;
+    uint64_t tids[KEY_CACHE_SIZE];
+    size_t batch;
+    BULK_ENTRY *bulk;
+    ELEMENT *chunk = entries->first;
+    ELEMENT *cur;
+    while(chunk != NULL && AppRunning(true))
+    {
+        // Derive the keys of the next few titles with a single HMAC context
+        batch = 0;
+        for(cur = chunk; cur != NULL && batch < KEY_CACHE_SIZE; cur = cur->next)
+        {
+            bulk = (BULK_ENTRY *)cur->content;
+            if(bulk->state & BULK_NO_TICKET)
+                tids[batch++] = bulk->tmd->tid;
+        }
+
+        if(batch != 0)
+        {
+            uint8_t keys[batch * 16];
+            generateKeys(tids, batch, keys);
+        }
+
+        batch = 0;
+        for(cur = chunk; cur != NULL && batch < KEY_CACHE_SIZE; cur = cur->next)
+        {
+            bulk = (BULK_ENTRY *)cur->content;
+            if(bulk->state & BULK_NO_TICKET)
+                ++batch;
+
+            if(bulk->state != 0)
+            {
+                convertEntry(bulk);
+                if(bulk->state & BULK_FAILED)
+                {
+                    addToScreenLog("Couldn't prepare %s", prettyDir(bulk->path));
+                    ++failed;
+                }
+                else
+                    ++converted;
+            }
+
+            drawBulkFrame(++done, count);
+        }
+
+        chunk = cur;
+    }
+
+    flushIOQueue();
+    t = OSGetTime() - t;
+    addToScreenLog("Prepared %u of %u folders (%u failed) in %llu ms", converted, count, failed, OSTicksToMilliseconds(t));
+
+    forEachListEntry(entries, bulk)
+        MEMFreeToDefaultHeap(bulk->tmd);
+
+    destroyList(entries, true);
+    return failed == 0;
+}
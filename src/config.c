@@ -23,6 +23,7 @@
 #include <string.h>
 
 #include <config.h>
+#include <contentCache.h>
 #include <crypto.h>
 #include <ioQueue.h>
 #include <localisation.h>
@@ -76,6 +77,9 @@
 static bool changed = false;
 static bool checkForUpdates = true;
 static bool autoResume = true;
+static bool lowPower = false;
+static bool logExport = false;
+static uint32_t contentCacheSize = 0;
 static Swkbd_LanguageType lang = Swkbd_LanguageType__Invalid;
 static Swkbd_LanguageType sysLang;
 static Swkbd_LanguageType menuLang = Swkbd_LanguageType__English;
@@ -253,6 +257,33 @@ void initConfig()
         changed = true;
     }
 
+    configEntry = json_object_get(json, "Low power downloads");
+    if(configEntry != NULL && json_is_boolean(configEntry))
+        lowPower = json_is_true(configEntry);
+    else
+    {
+        addToScreenLog("Low power setting not found!");
+        changed = true;
+    }
+
+    configEntry = json_object_get(json, "Save log to SD");
+    if(configEntry != NULL && json_is_boolean(configEntry))
+        logExport = json_is_true(configEntry);
+    else
+    {
+        addToScreenLog("Log export setting not found!");
+        changed = true;
+    }
+
+    configEntry = json_object_get(json, "Content cache size");
+    if(configEntry != NULL && json_is_integer(configEntry) && json_integer_value(configEntry) >= 0)
+        contentCacheSize = json_integer_value(configEntry);
+    else
+    {
+        addToScreenLog("Content cache setting not found!");
+        changed = true;
+    }
+
     configEntry = json_object_get(json, "Region");
     if(configEntry != NULL && json_is_string(configEntry))
     {
@@ -418,27 +449,39 @@ void saveConfig(bool force)
                                     value = json_string(getNotificationString(getNotificationMethod()));
                                     if(setValue(config, "Notification method", value))
                                     {
-                                        uint32_t entropy;
-                                        NUSrng(NULL, (unsigned char *)&entropy, 4);
-                                        value = json_integer(entropy);
-                                        if(setValue(config, "Seed", value))
+                                        value = lowPower ? json_true() : json_false();
+                                        if(setValue(config, "Low power downloads", value))
                                         {
-                                            char *json = json_dumps(config, JSON_INDENT(4));
-                                            if(json != NULL)
+                                            value = logExport ? json_true() : json_false();
+                                            if(setValue(config, "Save log to SD", value))
                                             {
-                                                entropy = strlen(json);
-                                                flushIOQueue();
-                                                FSAFileHandle f = openFile(CONFIG_PATH, "w", 0);
-                                                if(f != 0)
+                                                value = json_integer(contentCacheSize);
+                                                if(setValue(config, "Content cache size", value))
                                                 {
-                                                    addToIOQueue(json, 1, entropy, f);
-                                                    addToIOQueue(NULL, 0, 0, f);
-                                                    changed = false;
+                                                    uint32_t entropy;
+                                                    NUSrng(NULL, (unsigned char *)&entropy, 4);
+                                                    value = json_integer(entropy);
+                                                    if(setValue(config, "Seed", value))
+                                                    {
+                                                        char *json = json_dumps(config, JSON_INDENT(4));
+                                                        if(json != NULL)
+                                                        {
+                                                            entropy = strlen(json);
+                                                            flushIOQueue();
+                                                            FSAFileHandle f = openFile(CONFIG_PATH, "w", 0);
+                                                            if(f != 0)
+                                                            {
+                                                                addToIOQueue(json, 1, entropy, f);
+                                                                addToIOQueue(NULL, 0, 0, f);
+                                                                changed = false;
+                                                            }
+                                                            else
+                                                                showErrorFrame(localise("Couldn't save config file!\nYour SD card might be write locked."));
+
+                                                            MEMFreeToDefaultHeap(json);
+                                                        }
+                                                    }
                                                 }
-                                                else
-                                                    showErrorFrame(localise("Couldn't save config file!\nYour SD card might be write locked."));
-
-                                                MEMFreeToDefaultHeap(json);
                                             }
                                         }
                                     }
@@ -486,6 +529,58 @@ void setAutoResume(bool enabled)
     changed = true;
 }
 
+bool lowPowerEnabled()
+{
+    return lowPower;
+}
+
+void setLowPower(bool enabled)
+{
+    if(lowPower == enabled)
+        return;
+
+    lowPower = enabled;
+    changed = true;
+}
+
+bool logExportEnabled()
+{
+    return logExport;
+}
+
+void setLogExport(bool enabled)
+{
+    if(logExport == enabled)
+        return;
+
+    if(enabled)
+    {
+        if(!startScreenLogExport())
+            return;
+    }
+    else
+        stopScreenLogExport();
+
+    logExport = enabled;
+    changed = true;
+}
+
+// In GB, 0 = disabled
+uint32_t getContentCacheSize()
+{
+    return contentCacheSize;
+}
+
+void setContentCacheSize(uint32_t size)
+{
+    if(contentCacheSize == size)
+        return;
+
+    contentCacheSize = size;
+    changed = true;
+    trimContentCache();
+}
+
 const char *getFormattedRegion(MCPRegion region)
 {
     if(region & MCP_REGION_EUROPE)
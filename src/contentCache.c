@@ -0,0 +1,442 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <wut-fixups.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <config.h>
+#include <contentCache.h>
+#include <file.h>
+#include <filesystem.h>
+#include <ioQueue.h>
+#include <list.h>
+#include <memTrack.h>
+#include <menu/utils.h>
+#include <titles.h>
+#include <tmd.h>
+#include <utils.h>
+
+#pragma GCC diagnostic ignored "-Wundef"
+#include <coreinit/filesystem_fsa.h>
+#include <coreinit/memdefaultheap.h>
+#include <coreinit/memory.h>
+#pragma GCC diagnostic pop
+
+#define CACHE_INDEX_PATH  CONTENT_CACHE_DIR "index.bin"
+#define CACHE_INDEX_MAGIC 0x4E555343 // "NUSC"
+#define CACHE_NAME_LENGTH (sizeof("0000000000000000_0000_") - 1 + 40)
+
+/*
+ * Contents of temporary downloads on the SD card are moved here after they
+ * got installed instead of deleting them. downloadTitle() asks the cache first,
+ * so downloading the same or a slightly changed title again only fetches
+ * what's missing. Contents are encrypted with the title key and their index,
+ * so the key is the title ID, the index and the SHA-1 from the TMD.
+ * The index file is kept in LRU order: Oldest entry first.
+ * The index only gets touched from the main thread, copy threads get a
+ * CACHE_ENTRY by value and call restoreFromCache() only.
+ */
+
+static LIST *cacheEntries = NULL;
+static uint64_t cacheSize = 0;
+static uint64_t cacheSaved = 0;
+static bool cacheDirty = false;
+
+static void getCacheName(const CACHE_ENTRY *entry, char *out)
+{
+    sprintf(out, "%016" PRIx64 "_%04x_", entry->tid, entry->index);
+    out += sizeof("0000000000000000_0000_") - 1;
+    for(int i = 0; i < 5; ++i, out += 8)
+        sprintf(out, "%08x", entry->hash[i]);
+}
+
+static void setCachePath(const CACHE_ENTRY *entry, char *out, const char *ext)
+{
+    OSBlockMove(out, CONTENT_CACHE_DIR, sizeof(CONTENT_CACHE_DIR) - 1, false);
+    out += sizeof(CONTENT_CACHE_DIR) - 1;
+    getCacheName(entry, out);
+    strcpy(out + CACHE_NAME_LENGTH, ext);
+}
+
+static inline uint64_t getCacheBudget()
+{
+    return ((uint64_t)getContentCacheSize()) << 30;
+}
+
+static void saveCacheIndex()
+{
+    if(!cacheDirty)
+        return;
+
+    FSAFileHandle f = openFile(CACHE_INDEX_PATH, "w", 0);
+    if(f == 0)
+        return;
+
+    uint32_t magic = CACHE_INDEX_MAGIC;
+    addToIOQueue(&magic, 1, sizeof(uint32_t), f);
+
+    CACHE_ENTRY *entry;
+    forEachListEntry(cacheEntries, entry)
+        addToIOQueue(entry, 1, sizeof(CACHE_ENTRY), f);
+
+    addToIOQueue(NULL, 0, 0, f);
+    cacheDirty = false;
+}
+
+static void dropEntry(CACHE_ENTRY *entry, bool removeFiles)
+{
+    if(removeFiles)
+    {
+        char path[sizeof(CONTENT_CACHE_DIR) + CACHE_NAME_LENGTH + 4];
+        setCachePath(entry, path, ".app");
+        FSARemove(getFSAClient(), path);
+        if(entry->hashed)
+        {
+            setCachePath(entry, path, ".h3");
+            FSARemove(getFSAClient(), path);
+        }
+    }
+
+    removeFromList(cacheEntries, entry);
+    cacheSize -= entry->size;
+    memFree(MEM_TAG_CACHE, entry);
+    cacheDirty = true;
+}
+
+static void evict(uint64_t budget)
+{
+    CACHE_ENTRY *entry;
+    while(cacheSize > budget && (entry = getContent(cacheEntries, 0)) != NULL)
+    {
+        debugPrintf("Content cache: Evicting %016" PRIx64 "/%04x", entry->tid, entry->index);
+        dropEntry(entry, true);
+    }
+}
+
+void initContentCache()
+{
+    cacheEntries = createList();
+    if(cacheEntries == NULL || !fileExists(CACHE_INDEX_PATH))
+        return;
+
+    uint8_t *buf;
+    size_t size = readFile(CACHE_INDEX_PATH, (void **)&buf);
+    if(buf == NULL)
+        return;
+
+    if(size >= sizeof(uint32_t) && *(uint32_t *)buf == CACHE_INDEX_MAGIC)
+    {
+        CACHE_ENTRY *entry;
+        for(size_t pos = sizeof(uint32_t); pos + sizeof(CACHE_ENTRY) <= size; pos += sizeof(CACHE_ENTRY))
+        {
+            entry = memAlloc(MEM_TAG_CACHE, sizeof(CACHE_ENTRY));
+            if(entry == NULL)
+                break;
+
+            OSBlockMove(entry, buf + pos, sizeof(CACHE_ENTRY), false);
+            if(!addToListEnd(cacheEntries, entry))
+            {
+                memFree(MEM_TAG_CACHE, entry);
+                break;
+            }
+
+            cacheSize += entry->size;
+        }
+    }
+
+    MEMFreeToDefaultHeap(buf);
+    debugPrintf("Content cache: %d entries, %" PRIu64 " bytes", getListSize(cacheEntries), cacheSize);
+    trimContentCache();
+}
+
+void shutdownContentCache()
+{
+    if(cacheEntries == NULL)
+        return;
+
+    saveCacheIndex();
+    CACHE_ENTRY *entry;
+    forEachListEntry(cacheEntries, entry)
+        memFree(MEM_TAG_CACHE, entry);
+
+    destroyList(cacheEntries, false);
+    cacheEntries = NULL;
+}
+
+void trimContentCache()
+{
+    if(cacheEntries == NULL)
+        return;
+
+    evict(getCacheBudget());
+    saveCacheIndex();
+}
+
+static CACHE_ENTRY *findEntry(const TMD *tmd, uint16_t content)
+{
+    const TMD_CONTENT *c = tmd->contents + content;
+    CACHE_ENTRY *entry;
+    forEachListEntry(cacheEntries, entry)
+    {
+        if(entry->tid == tmd->tid && entry->index == c->index && memcmp(entry->hash, c->hash, sizeof(entry->hash)) == 0)
+            return entry;
+    }
+
+    return NULL;
+}
+
+static CACHE_ENTRY *findSameEntry(const CACHE_ENTRY *key)
+{
+    if(cacheEntries == NULL)
+        return NULL;
+
+    CACHE_ENTRY *entry;
+    forEachListEntry(cacheEntries, entry)
+    {
+        if(entry->tid == key->tid && entry->index == key->index && memcmp(entry->hash, key->hash, sizeof(entry->hash)) == 0)
+            return entry;
+    }
+
+    return NULL;
+}
+
+static bool restoreFile(const CACHE_ENTRY *entry, const char *ext, char *dest, size_t size, bool move, COPY_PROGRESS *progress)
+{
+    char src[sizeof(CONTENT_CACHE_DIR) + CACHE_NAME_LENGTH + 4];
+    setCachePath(entry, src, ext);
+    if(getFilesize(src) != size)
+        return false;
+
+    if(move)
+        return FSARename(getFSAClient(), src, dest) == FS_ERROR_OK;
+
+    return copyFile(src, dest, size, progress);
+}
+
+// Copies the index entry of a content to out, main thread only
+bool findInCache(const TMD *tmd, uint16_t content, CACHE_ENTRY *out)
+{
+    if(cacheEntries == NULL || getContentCacheSize() == 0)
+        return false;
+
+    CACHE_ENTRY *entry = findEntry(tmd, content);
+    if(entry == NULL)
+        return false;
+
+    OSBlockMove(out, entry, sizeof(CACHE_ENTRY), false);
+    return true;
+}
+
+/*
+ * Restores the .app (and .h3) file of a content found by findInCache() into
+ * dir. If move is true the files get moved out of the cache. This is used for
+ * temporary downloads on the SD card which will be moved back after the
+ * installation. Copies report to progress, see copyFile().
+ * This only works on files, so it's safe to call from a copy thread. Hand the
+ * result to finishCacheRestore() on the main thread.
+ */
+CACHE_RESTORE restoreFromCache(const CACHE_ENTRY *entry, const TMD *tmd, uint16_t content, const char *dir, bool move, COPY_PROGRESS *progress)
+{
+    const TMD_CONTENT *c = tmd->contents + content;
+    char path[FS_MAX_PATH];
+    size_t len = strlen(dir);
+    OSBlockMove(path, dir, len, false);
+    sprintf(path + len, "%08x.app", c->cid);
+    if(getFilesize(path) == c->size) // Already downloaded, let downloadFile() skip it
+        return CACHE_RESTORE_NONE;
+
+    // Renames only work on the same device
+    move = move && getDevFromPath(dir) == NUSDEV_SD;
+
+    bool ret = restoreFile(entry, ".app", path, c->size, move, progress);
+    if(ret && entry->hashed)
+    {
+        sprintf(path + len, "%08x.h3", c->cid);
+        ret = restoreFile(entry, ".h3", path, getH3size(c->size), move, progress);
+    }
+
+    if(!ret)
+        return progress != NULL && progress->cancel ? CACHE_RESTORE_CANCELLED : CACHE_RESTORE_BROKEN;
+
+    return move ? CACHE_RESTORE_MOVED : CACHE_RESTORE_COPIED;
+}
+
+/*
+ * Updates the index after restoreFromCache(): Moved contents leave the cache,
+ * copied ones become the most recently used and broken ones get dropped.
+ * Main thread only. Returns the restored bytes, 0 if nothing was restored.
+ * The index gets written by flushContentCache().
+ */
+uint64_t finishCacheRestore(const CACHE_ENTRY *restored, uint32_t cid, CACHE_RESTORE result)
+{
+    if(result == CACHE_RESTORE_NONE || result == CACHE_RESTORE_CANCELLED)
+        return 0;
+
+    // The copy didn't hold a pointer into the list, so look it up again
+    CACHE_ENTRY *entry = findSameEntry(restored);
+
+    if(result == CACHE_RESTORE_BROKEN)
+    {
+        debugPrintf("Content cache: Broken entry %016" PRIx64 "/%04x", restored->tid, restored->index);
+        if(entry != NULL)
+            dropEntry(entry, true);
+
+        return 0;
+    }
+
+    uint64_t size = restored->size;
+    cacheSaved += size;
+    if(entry != NULL)
+    {
+        if(result == CACHE_RESTORE_MOVED)
+            dropEntry(entry, false);
+        else
+        {
+            // Most recently used
+            removeFromList(cacheEntries, entry);
+            if(!addToListEnd(cacheEntries, entry))
+            {
+                cacheSize -= entry->size;
+                memFree(MEM_TAG_CACHE, entry);
+            }
+
+            cacheDirty = true;
+        }
+    }
+
+    addToScreenLog("%08x.app restored from cache", cid);
+    return size;
+}
+
+/*
+ * Moves the contents of an installed temporary download into the cache,
+ * evicting the least recently used entries to stay in budget. Only works for
+ * folders on the SD card as renames can't cross devices.
+ */
+void storeInCache(const char *dir)
+{
+    uint64_t budget = getCacheBudget();
+    if(cacheEntries == NULL || budget == 0 || getDevFromPath(dir) != NUSDEV_SD)
+        return;
+
+    TMD *tmd = getTmd(dir, false);
+    if(tmd == NULL)
+        return;
+
+    if(!dirExists(CONTENT_CACHE_DIR) && createDirectory(CONTENT_CACHE_DIR) != FS_ERROR_OK)
+    {
+        MEMFreeToDefaultHeap(tmd);
+        return;
+    }
+
+    char src[FS_MAX_PATH];
+    char dest[sizeof(CONTENT_CACHE_DIR) + CACHE_NAME_LENGTH + 4];
+    size_t len = strlen(dir);
+    OSBlockMove(src, dir, len, false);
+    CACHE_ENTRY *entry;
+    const TMD_CONTENT *c;
+    for(uint16_t i = 0; i < tmd->num_contents; ++i)
+    {
+        c = tmd->contents + i;
+        if(findEntry(tmd, i) != NULL)
+            continue;
+
+        entry = memAlloc(MEM_TAG_CACHE, sizeof(CACHE_ENTRY));
+        if(entry == NULL)
+            break;
+
+        entry->tid = tmd->tid;
+        entry->index = c->index;
+        entry->hashed = (c->type & TMD_CONTENT_TYPE_HASHED) ? 1 : 0;
+        entry->size = c->size;
+        if(entry->hashed)
+            entry->size += getH3size(c->size);
+
+        OSBlockMove(entry->hash, c->hash, sizeof(entry->hash), false);
+        if(entry->size > budget)
+        {
+            memFree(MEM_TAG_CACHE, entry);
+            continue;
+        }
+
+        sprintf(src + len, "%08x.app", c->cid);
+        setCachePath(entry, dest, ".app");
+        if(getFilesize(src) != c->size || FSARename(getFSAClient(), src, dest) != FS_ERROR_OK)
+        {
+            memFree(MEM_TAG_CACHE, entry);
+            continue;
+        }
+
+        if(entry->hashed)
+        {
+            sprintf(src + len, "%08x.h3", c->cid);
+            setCachePath(entry, dest, ".h3");
+            if(FSARename(getFSAClient(), src, dest) != FS_ERROR_OK)
+            {
+                setCachePath(entry, dest, ".app");
+                FSARemove(getFSAClient(), dest);
+                memFree(MEM_TAG_CACHE, entry);
+                continue;
+            }
+        }
+
+        evict(budget - entry->size);
+        if(!addToListEnd(cacheEntries, entry))
+        {
+            setCachePath(entry, dest, ".app");
+            FSARemove(getFSAClient(), dest);
+            if(entry->hashed)
+            {
+                setCachePath(entry, dest, ".h3");
+                FSARemove(getFSAClient(), dest);
+            }
+
+            memFree(MEM_TAG_CACHE, entry);
+            continue;
+        }
+
+        cacheSize += entry->size;
+        cacheDirty = true;
+    }
+
+    MEMFreeToDefaultHeap(tmd);
+    debugPrintf("Content cache: %d entries, %" PRIu64 " bytes", getListSize(cacheEntries), cacheSize);
+    saveCacheIndex();
+}
+
+// Writes the index if fetchFromCache() changed it, called once per title
+void flushContentCache()
+{
+    if(cacheEntries != NULL)
+        saveCacheIndex();
+}
+
+bool isCached(const TMD *tmd, uint16_t content)
+{
+    return cacheEntries != NULL && getContentCacheSize() != 0 && findEntry(tmd, content) != NULL;
+}
+
+uint64_t getCacheSavedBytes()
+{
+    return cacheSaved;
+}
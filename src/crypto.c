@@ -22,96 +22,128 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <crypto.h>
-#include <thread.h>
 
 #include <mbedtls/aes.h>
 
 #pragma GCC diagnostic ignored "-Wundef"
+#include <coreinit/atomic.h>
+#include <coreinit/core.h>
+#include <coreinit/interrupts.h>
 #include <coreinit/time.h>
 #pragma GCC diagnostic pop
 
-static spinlock rngLock;
-static volatile uint32_t entropy;
-
-#define reseed()                      \
-    {                                 \
-        entropy ^= OSGetSystemTick(); \
-        entropy ^= OSGetTick();       \
+#define RNG_CORES         3
+#define ENTROPY_FOLD      64 // Bytes of entropy a core collects before sharing them
+#define RNG_POOL_INTERVAL 16 // Calls between mixing in the shared entropy
+
+/*
+ * Every core has its own generator and entropy accumulator on its own
+ * cache line. Disabling interrupts keeps other threads on the same core
+ * out and other cores never touch them, so no lock is needed. Collected
+ * entropy gets shared through a pool all generators mix in from time to
+ * time.
+ */
+typedef struct
+{
+    uint32_t state;
+    uint32_t entropy;
+    uint32_t collected;
+    uint32_t calls;
+} __attribute__((__aligned__(0x40))) RNG_CORE;
+
+static RNG_CORE rngCores[RNG_CORES];
+static volatile uint32_t entropyPool;
+
+#define reseed(core)                        \
+    {                                       \
+        (core)->state ^= OSGetSystemTick(); \
+        (core)->state ^= OSGetTick();       \
     }
 
 // Based on George Marsaglias paper "Xorshift RNGs" from https://www.jstatsoft.org/article/view/v008i14
-#define rngRun()                      \
-    {                                 \
-        if(entropy)                   \
-        {                             \
-            entropy ^= entropy << 13; \
-            entropy ^= entropy >> 17; \
-            entropy ^= entropy << 5;  \
-        }                             \
-        else                          \
-            reseed();                 \
+#define rngRun(core)                              \
+    {                                             \
+        if((core)->state)                         \
+        {                                         \
+            (core)->state ^= (core)->state << 13; \
+            (core)->state ^= (core)->state >> 17; \
+            (core)->state ^= (core)->state << 5;  \
+        }                                         \
+        else                                      \
+            reseed(core);                         \
     }
 
 int NUSrng(void *data, unsigned char *out, size_t outlen)
 {
     (void)data;
 
-    --out;
-    ++outlen;
-
-    spinLock(rngLock);
+    BOOL irq = OSDisableInterrupts();
+    RNG_CORE *core = rngCores + OSGetCoreId();
+    if(++core->calls % RNG_POOL_INTERVAL == 0)
+        core->state ^= entropyPool;
 
-    while(--outlen)
+    for(; outlen >= 4; outlen -= 4, out += 4)
     {
-        rngRun();
-        *++out = entropy;
+        rngRun(core);
+        memcpy(out, &core->state, 4);
     }
 
-    spinReleaseLock(rngLock);
+    if(outlen)
+    {
+        rngRun(core);
+        memcpy(out, &core->state, outlen);
+    }
 
+    OSRestoreInterrupts(irq);
     return 0;
 }
 
 void addEntropy(void *e, size_t l)
 {
-    uint8_t *buf8 = (uint8_t *)e;
-    uint32_t *buf32;
-    size_t l32 = l >> 2;
-    if(l32)
-    {
-        buf32 = (uint32_t *)e;
-        --buf32;
-        buf8 += l32 << 2;
-        l %= 4;
-    }
+    const uint8_t *buf = (const uint8_t *)e;
+    uint32_t word;
 
-    ++l;
-    ++l32;
-    --buf8;
+    BOOL irq = OSDisableInterrupts();
+    RNG_CORE *core = rngCores + OSGetCoreId();
+    core->collected += l;
 
-    spinLock(rngLock);
+    for(; l >= 4; l -= 4, buf += 4)
+    {
+        memcpy(&word, buf, 4);
+        rngRun(core);
+        core->state ^= word;
+        core->entropy = ((core->entropy << 5) | (core->entropy >> 27)) ^ word;
+    }
 
-    while(--l32)
+    for(; l; --l, ++buf)
     {
-        rngRun();
-        entropy ^= *++buf32; // Not uninitialised!
+        rngRun(core);
+        core->state ^= *buf;
+        core->entropy = ((core->entropy << 5) | (core->entropy >> 27)) ^ *buf;
     }
 
-    while(--l)
+    if(core->collected >= ENTROPY_FOLD)
     {
-        rngRun();
-        entropy ^= *++buf8;
+        OSXorAtomic(&entropyPool, core->entropy);
+        core->collected = 0;
     }
 
-    spinReleaseLock(rngLock);
+    OSRestoreInterrupts(irq);
 }
 
 bool initCrypto()
 {
-    reseed();
-    spinCreateLock(rngLock, SPINLOCK_FREE);
+    // Entropy might have been added already, so keep what's there
+    for(int i = 0; i < RNG_CORES; ++i)
+    {
+        rngCores[i].state ^= 0x9E3779B9 * (i + 1);
+        reseed(rngCores + i);
+    }
+
+    entropyPool ^= OSGetSystemTick();
     return true;
 }
 
@@ -133,3 +165,12 @@ bool encryptAES(void *data, int data_len, const unsigned char *key, unsigned cha
     // mbedtls_aes_free(&ctx);
     return ret;
 }
+
+bool decryptAES(void *data, int data_len, const unsigned char *key, unsigned char *iv, void *decrypted)
+{
+    mbedtls_aes_context ctx;
+    mbedtls_aes_init(&ctx);
+    mbedtls_aes_setkey_dec(&ctx, key, 128);
+    // See encryptAES() for why mbedtls_aes_free() isn't called
+    return mbedtls_aes_crypt_cbc(&ctx, MBEDTLS_AES_DECRYPT, data_len, iv, data, decrypted) == 0;
+}
@@ -0,0 +1,624 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2019-2020 Pokes303                                        *
+ * Copyright (c) 2020-2022 V10lator <v10lator@myway.de>                    *
+ * Copyright (c) 2022 Xpl0itU <DaThinkingChair@protonmail.com>             *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <wut-fixups.h>
+
+#ifdef NUSSPLI_DEBUG
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <memTrack.h>
+#include <thread.h>
+#include <utils.h>
+
+#pragma GCC diagnostic ignored "-Wundef"
+#include <coreinit/atomic.h>
+#include <coreinit/cache.h>
+#include <coreinit/memory.h>
+#include <coreinit/thread.h>
+#include <coreinit/time.h>
+#include <whb/log.h>
+#include <whb/log_cafe.h>
+#include <whb/log_udp.h>
+#pragma GCC diagnostic pop
+
+static const char days[7][4] = {
+    "Sun",
+    "Mon",
+    "Tue",
+    "Wed",
+    "Thu",
+    "Fri",
+    "Sat",
+};
+
+static const char months[12][4] = {
+    "Jan",
+    "Feb",
+    "Mar",
+    "Apr",
+    "May",
+    "Jun",
+    "Jul",
+    "Aug",
+    "Sep",
+    "Nov",
+    "Dez",
+};
+
+static spinlock debugLock;
+
+/*
+ * debugPrintf() only captures the format string, its arguments and a
+ * timestamp into a ring, formatting and sending happens on a low priority
+ * thread. The format string has to stay valid (so has to be a literal),
+ * strings passed as arguments get copied.
+ */
+#define LOG_ENTRIES   512 // Has to be a power of 2
+#define LOG_DATA_SIZE 232
+#define LOG_LINE_SIZE 512
+
+typedef enum
+{
+    LOG_LEN_NONE,
+    LOG_LEN_HH,
+    LOG_LEN_H,
+    LOG_LEN_L,
+    LOG_LEN_LL,
+    LOG_LEN_J,
+    LOG_LEN_Z,
+    LOG_LEN_T,
+    LOG_LEN_BIG_L,
+} LOG_LEN;
+
+typedef struct
+{
+    const char *start;
+    const char *end;
+    bool widthStar;
+    bool precStar;
+    LOG_LEN len;
+    char conv;
+} LOG_SPEC;
+
+typedef struct
+{
+    volatile uint32_t seq;
+    uint16_t specs; // Number of captured conversions
+    bool truncated;
+    OSTime time;
+    const char *fmt;
+    uint8_t data[LOG_DATA_SIZE];
+} LOG_ENTRY;
+
+static LOG_ENTRY *logRing = NULL;
+static volatile uint32_t logHead;
+static volatile uint32_t logTail;
+static volatile uint32_t logDropped;
+static volatile bool logRunning = false;
+static OSThread *logThread = NULL;
+
+// fmt has to point behind the '%'
+static const char *parseSpec(const char *fmt, LOG_SPEC *spec)
+{
+    spec->start = fmt - 1;
+    spec->widthStar = spec->precStar = false;
+    spec->len = LOG_LEN_NONE;
+
+    while(*fmt == '-' || *fmt == '+' || *fmt == ' ' || *fmt == '#' || *fmt == '0')
+        ++fmt;
+
+    if(*fmt == '*')
+    {
+        spec->widthStar = true;
+        ++fmt;
+    }
+    else
+        while(isNumber(*fmt))
+            ++fmt;
+
+    if(*fmt == '.')
+    {
+        if(*++fmt == '*')
+        {
+            spec->precStar = true;
+            ++fmt;
+        }
+        else
+            while(isNumber(*fmt))
+                ++fmt;
+    }
+
+    switch(*fmt)
+    {
+        case 'h':
+            if(*++fmt == 'h')
+            {
+                spec->len = LOG_LEN_HH;
+                ++fmt;
+            }
+            else
+                spec->len = LOG_LEN_H;
+            break;
+        case 'l':
+            if(*++fmt == 'l')
+            {
+                spec->len = LOG_LEN_LL;
+                ++fmt;
+            }
+            else
+                spec->len = LOG_LEN_L;
+            break;
+        case 'j':
+            spec->len = LOG_LEN_J;
+            ++fmt;
+            break;
+        case 'z':
+            spec->len = LOG_LEN_Z;
+            ++fmt;
+            break;
+        case 't':
+            spec->len = LOG_LEN_T;
+            ++fmt;
+            break;
+        case 'L':
+            spec->len = LOG_LEN_BIG_L;
+            ++fmt;
+            break;
+    }
+
+    spec->conv = *fmt;
+    if(*fmt != '\0')
+        ++fmt;
+
+    spec->end = fmt;
+    return fmt;
+}
+
+static inline bool isIntConv(char c)
+{
+    return c == 'd' || c == 'i' || c == 'u' || c == 'x' || c == 'X' || c == 'o' || c == 'c';
+}
+
+static inline bool isFloatConv(char c)
+{
+    return c == 'f' || c == 'F' || c == 'e' || c == 'E' || c == 'g' || c == 'G' || c == 'a' || c == 'A';
+}
+
+static bool pushSlot(uint8_t **ptr, const uint8_t *end, const void *val)
+{
+    if(*ptr + 8 > end)
+        return false;
+
+    OSBlockMove(*ptr, val, 8, false);
+    *ptr += 8;
+    return true;
+}
+
+static bool captureArgs(LOG_ENTRY *entry, va_list va)
+{
+    uint8_t *ptr = entry->data;
+    const uint8_t *end = entry->data + LOG_DATA_SIZE;
+    const char *fmt = entry->fmt;
+    LOG_SPEC spec;
+    uint64_t u;
+    double d;
+    const char *s;
+    size_t l;
+
+    entry->specs = 0;
+    while((fmt = strchr(fmt, '%')) != NULL)
+    {
+        if(*++fmt == '%')
+        {
+            ++fmt;
+            continue;
+        }
+
+        fmt = parseSpec(fmt, &spec);
+        if(spec.widthStar)
+        {
+            u = va_arg(va, int);
+            if(!pushSlot(&ptr, end, &u))
+                return false;
+        }
+        if(spec.precStar)
+        {
+            u = va_arg(va, int);
+            if(!pushSlot(&ptr, end, &u))
+                return false;
+        }
+
+        if(isIntConv(spec.conv))
+        {
+            switch(spec.len)
+            {
+                case LOG_LEN_L:
+                    u = va_arg(va, long);
+                    break;
+                case LOG_LEN_LL:
+                    u = va_arg(va, long long);
+                    break;
+                case LOG_LEN_J:
+                    u = va_arg(va, intmax_t);
+                    break;
+                case LOG_LEN_Z:
+                    u = va_arg(va, size_t);
+                    break;
+                case LOG_LEN_T:
+                    u = va_arg(va, ptrdiff_t);
+                    break;
+                default:
+                    u = va_arg(va, int);
+                    break;
+            }
+
+            if(!pushSlot(&ptr, end, &u))
+                return false;
+        }
+        else if(isFloatConv(spec.conv))
+        {
+            d = spec.len == LOG_LEN_BIG_L ? (double)va_arg(va, long double) : va_arg(va, double);
+            if(!pushSlot(&ptr, end, &d))
+                return false;
+        }
+        else if(spec.conv == 's')
+        {
+            s = va_arg(va, const char *);
+            if(s == NULL)
+                s = "(null)";
+
+            l = strlen(s);
+            if(ptr + l + 1 > end)
+            {
+                if(ptr == end)
+                    return false;
+
+                // Keep what fits
+                l = end - ptr - 1;
+                OSBlockMove(ptr, s, l, false);
+                ptr[l] = '\0';
+                ++entry->specs;
+                return false;
+            }
+
+            OSBlockMove(ptr, s, l + 1, false);
+            ptr += l + 1;
+        }
+        else if(spec.conv == 'p' || spec.conv == 'n')
+        {
+            u = (uintptr_t)va_arg(va, void *);
+            if(!pushSlot(&ptr, end, &u))
+                return false;
+        }
+        else // Unknown conversion, print the rest as is
+            return true;
+
+        ++entry->specs;
+    }
+
+    return true;
+}
+
+static const uint8_t *popSlot(const uint8_t *ptr, void *out)
+{
+    OSBlockMove(out, ptr, 8, false);
+    return ptr + 8;
+}
+
+// Rebuilds the conversion spec with the captured '*' values filled in
+static void buildSpec(const LOG_SPEC *spec, const uint8_t **ptr, char *out)
+{
+    uint64_t star;
+    for(const char *c = spec->start; c != spec->end; ++c)
+    {
+        if(*c == '*')
+        {
+            *ptr = popSlot(*ptr, &star);
+            out += sprintf(out, "%d", (int)star);
+        }
+        else
+            *out++ = *c;
+    }
+
+    *out = '\0';
+}
+
+static size_t formatEntry(const LOG_ENTRY *entry, char *out, size_t size)
+{
+    const uint8_t *ptr = entry->data;
+    const char *fmt = entry->fmt;
+    const char *next;
+    LOG_SPEC spec;
+    char specStr[64];
+    uint64_t u;
+    double d;
+    size_t pos = 0;
+    size_t l;
+    int r;
+    uint16_t specs = 0;
+
+    --size;
+    while(pos < size)
+    {
+        next = strchr(fmt, '%');
+        l = next == NULL ? strlen(fmt) : (size_t)(next - fmt);
+        if(pos + l > size)
+            l = size - pos;
+
+        OSBlockMove(out + pos, fmt, l, false);
+        pos += l;
+        if(next == NULL || pos == size)
+            break;
+
+        fmt = next + 1;
+        if(*fmt == '%')
+        {
+            out[pos++] = '%';
+            ++fmt;
+            continue;
+        }
+
+        if(specs == entry->specs)
+        {
+            if(entry->truncated)
+            {
+                l = strlen(" [...]");
+                if(pos + l <= size)
+                {
+                    OSBlockMove(out + pos, " [...]", l, false);
+                    pos += l;
+                }
+                break;
+            }
+
+            // Unknown conversion, print the rest as is
+            fmt = next;
+            l = strlen(fmt);
+            if(pos + l > size)
+                l = size - pos;
+
+            OSBlockMove(out + pos, fmt, l, false);
+            pos += l;
+            break;
+        }
+
+        fmt = parseSpec(fmt, &spec);
+        buildSpec(&spec, &ptr, specStr);
+        if(spec.len == LOG_LEN_BIG_L) // Got captured as double
+        {
+            char *bigL = strrchr(specStr, 'L');
+            OSBlockMove(bigL, bigL + 1, strlen(bigL), false);
+        }
+
+        r = 0;
+        if(isIntConv(spec.conv))
+        {
+            ptr = popSlot(ptr, &u);
+            switch(spec.len)
+            {
+                case LOG_LEN_L:
+                    r = snprintf(out + pos, size - pos + 1, specStr, (long)u);
+                    break;
+                case LOG_LEN_LL:
+                case LOG_LEN_J:
+                    r = snprintf(out + pos, size - pos + 1, specStr, (long long)u);
+                    break;
+                case LOG_LEN_Z:
+                    r = snprintf(out + pos, size - pos + 1, specStr, (size_t)u);
+                    break;
+                case LOG_LEN_T:
+                    r = snprintf(out + pos, size - pos + 1, specStr, (ptrdiff_t)u);
+                    break;
+                default:
+                    r = snprintf(out + pos, size - pos + 1, specStr, (int)u);
+                    break;
+            }
+        }
+        else if(isFloatConv(spec.conv))
+        {
+            ptr = popSlot(ptr, &d);
+            r = snprintf(out + pos, size - pos + 1, specStr, d);
+        }
+        else if(spec.conv == 's')
+        {
+            r = snprintf(out + pos, size - pos + 1, specStr, (const char *)ptr);
+            ptr += strlen((const char *)ptr) + 1;
+        }
+        else if(spec.conv == 'p')
+        {
+            ptr = popSlot(ptr, &u);
+            r = snprintf(out + pos, size - pos + 1, specStr, (void *)(uintptr_t)u);
+        }
+        else // %n
+            ptr += 8;
+
+        if(r > 0)
+            pos += (size_t)r > size - pos ? size - pos : (size_t)r;
+
+        ++specs;
+    }
+
+    out[pos] = '\0';
+    return pos;
+}
+
+static void printEntry(const LOG_ENTRY *entry, char *line)
+{
+    OSCalendarTime now;
+    OSTicksToCalendarTime(entry->time, &now);
+    size_t tss = sprintf(line, "%s %02d %s %d %02d:%02d:%02d.%03d\t", days[now.tm_wday], now.tm_mday, months[now.tm_mon], now.tm_year, now.tm_hour, now.tm_min, now.tm_sec, now.tm_msec);
+    formatEntry(entry, line + tss, LOG_LINE_SIZE - tss);
+
+    spinLock(debugLock);
+    WHBLogPrint(line);
+    spinReleaseLock(debugLock);
+}
+
+static void drainLog(char *line)
+{
+    LOG_ENTRY *entry;
+    uint32_t tail = logTail;
+    uint32_t dropped;
+    while(true)
+    {
+        entry = logRing + (tail & (LOG_ENTRIES - 1));
+        if(entry->seq != tail + 1)
+            break;
+
+        OSMemoryBarrier();
+        printEntry(entry, line);
+        logTail = ++tail;
+    }
+
+    dropped = OSSwapAtomic(&logDropped, 0);
+    if(dropped != 0)
+    {
+        sprintf(line, "Debug log overflow: %u messages dropped", dropped);
+        spinLock(debugLock);
+        WHBLogPrint(line);
+        spinReleaseLock(debugLock);
+    }
+}
+
+static int logThreadMain(int argc, const char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    char line[LOG_LINE_SIZE];
+    while(logRunning)
+    {
+        drainLog(line);
+        OSSleepTicks(OSMillisecondsToTicks(2));
+    }
+
+    return 0;
+}
+
+void debugInit()
+{
+    spinCreateLock(debugLock, SPINLOCK_FREE);
+    WHBLogUdpInit();
+    WHBLogCafeInit();
+
+    logRing = memAlloc(MEM_TAG_DEBUG, sizeof(LOG_ENTRY) * LOG_ENTRIES);
+    if(logRing == NULL)
+        return;
+
+    OSBlockSet(logRing, 0x00, sizeof(LOG_ENTRY) * LOG_ENTRIES);
+    logHead = logTail = logDropped = 0;
+    logRunning = true;
+    logThread = startThread("NUSspli debug log", THREAD_PRIORITY_LOW, STACKSIZE_SMALL, logThreadMain, 0, NULL, AFFINITY_CPU12);
+    if(logThread == NULL)
+    {
+        logRunning = false;
+        memFree(MEM_TAG_DEBUG, logRing);
+        logRing = NULL;
+    }
+}
+
+void shutdownDebug()
+{
+    if(logThread != NULL)
+    {
+        logRunning = false;
+        OSJoinThread(logThread, NULL);
+        OSDetachThread(logThread);
+        memFree(MEM_TAG_THREAD, logThread);
+        logThread = NULL;
+
+        // Print whatever got logged while the thread was shutting down
+        char line[LOG_LINE_SIZE];
+        drainLog(line);
+
+        memFree(MEM_TAG_DEBUG, logRing);
+        logRing = NULL;
+    }
+
+    WHBLogUdpDeinit();
+    WHBLogCafeDeinit();
+}
+
+void restartUdpLog1()
+{
+    spinLock(debugLock);
+    WHBLogUdpDeinit();
+}
+
+void restartUdpLog2()
+{
+    WHBLogUdpInit();
+    spinReleaseLock(debugLock);
+}
+
+void debugPrintf(const char *str, ...)
+{
+    OSTime now = OSGetTime();
+    va_list va;
+    va_start(va, str);
+
+    if(logRing == NULL)
+    {
+        // Not initialised (or no memory), print synchronously
+        LOG_ENTRY entry;
+        char line[LOG_LINE_SIZE];
+        entry.time = now;
+        entry.fmt = str;
+        entry.truncated = !captureArgs(&entry, va);
+        va_end(va);
+        printEntry(&entry, line);
+        return;
+    }
+
+    uint32_t head;
+    do
+    {
+        head = logHead;
+        if(head - logTail >= LOG_ENTRIES)
+        {
+            OSAddAtomic(&logDropped, 1);
+            va_end(va);
+            return;
+        }
+    } while(!OSCompareAndSwapAtomic(&logHead, head, head + 1));
+
+    LOG_ENTRY *entry = logRing + (head & (LOG_ENTRIES - 1));
+    entry->time = now;
+    entry->fmt = str;
+    entry->truncated = !captureArgs(entry, va);
+    va_end(va);
+
+    OSMemoryBarrier();
+    entry->seq = head + 1;
+}
+
+void checkStacks(const char *src)
+{
+    debugPrintf("%s: Checking thread stacks...", src);
+    OSCheckActiveThreads();
+    OSThread *trd = OSGetCurrentThread();
+    debugPrintf("%s: 0x%08X/0x%08X", src, OSCheckThreadStackUsage(trd), (uint32_t)((uintptr_t)trd->stackStart - (uintptr_t)trd->stackEnd));
+}
+
+#endif // ifdef NUSSPLI_DEBUG
@@ -0,0 +1,229 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <wut-fixups.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <contentCache.h>
+#include <delta.h>
+#include <file.h>
+#include <filesystem.h>
+#include <no-intro.h>
+#include <titles.h>
+#include <tmd.h>
+#include <utils.h>
+
+#pragma GCC diagnostic ignored "-Wundef"
+#include <coreinit/filesystem_fsa.h>
+#include <coreinit/memdefaultheap.h>
+#include <coreinit/memory.h>
+#pragma GCC diagnostic pop
+
+/*
+ * Contents are encrypted with the title key and their index only, so a
+ * content with the same index, size and hash is byte for byte the same in
+ * every version of a title. Those get copied from a kept download folder of
+ * another version instead of downloading them again.
+ */
+
+// Returns the position of the unchanged content in the old TMD or -1
+int findUnchangedContent(const TMD *tmd, uint16_t content, const TMD *old)
+{
+    const TMD_CONTENT *c = tmd->contents + content;
+    for(uint16_t i = 0; i < old->num_contents; ++i)
+    {
+        if(old->contents[i].index == c->index && old->contents[i].size == c->size && memcmp(old->contents[i].hash, c->hash, 20) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+static inline uint64_t getContentSize(const TMD_CONTENT *c)
+{
+    uint64_t ret = c->size;
+    if(c->type & TMD_CONTENT_TYPE_HASHED)
+        ret += getH3size(c->size);
+
+    return ret;
+}
+
+uint64_t getDeltaSize(const TMD *tmd, const TMD *old)
+{
+    if(tmd->tid != old->tid)
+        return 0;
+
+    uint64_t ret = 0;
+    for(uint16_t i = 0; i < tmd->num_contents; ++i)
+        if(findUnchangedContent(tmd, i, old) >= 0)
+            ret += getContentSize(tmd->contents + i);
+
+    return ret;
+}
+
+static void scanInstallDir(const char *installDir, const TMD *tmd, const char *exclude, DELTA_SOURCE *out, uint64_t *best)
+{
+    FSADirectoryHandle dir;
+    if(FSAOpenDir(getFSAClient(), installDir, &dir) != FS_ERROR_OK)
+        return;
+
+    char tag[20];
+    tag[0] = '[';
+    hex(tmd->tid, 16, tag + 1);
+    tag[17] = ']';
+    tag[18] = '\0';
+
+    char path[FS_MAX_PATH];
+    size_t len = strlen(installDir);
+    OSBlockMove(path, installDir, len, false);
+    FSADirectoryEntry entry;
+    TMD *old;
+    uint64_t size;
+    while(FSAReadDir(getFSAClient(), dir, &entry) == FS_ERROR_OK)
+    {
+        if(!(entry.info.flags & FS_STAT_DIRECTORY) || strstr(entry.name, tag) == NULL || len + strlen(entry.name) + 2 > FS_MAX_PATH)
+            continue;
+
+        strcpy(path + len, entry.name);
+        strcat(path, "/");
+        if(exclude != NULL && strcmp(path, exclude) == 0)
+            continue;
+
+        old = getTmd(path, true);
+        if(old == NULL)
+            continue;
+
+        size = old->title_version == tmd->title_version ? 0 : getDeltaSize(tmd, old);
+        if(size > *best)
+        {
+            *best = size;
+            if(out->tmd != NULL)
+                MEMFreeToDefaultHeap(out->tmd);
+
+            out->tmd = old;
+            strcpy(out->dir, path);
+        }
+        else
+            MEMFreeToDefaultHeap(old);
+    }
+
+    FSACloseDir(getFSAClient(), dir);
+}
+
+/*
+ * Searches the install folders on SD and USB for another version of the
+ * title, exclude is the folder the new version gets downloaded to.
+ * The version sharing the most contents wins.
+ */
+bool findPreviousVersion(const TMD *tmd, const char *exclude, DELTA_SOURCE *out)
+{
+    out->tmd = NULL;
+    if(!isUpdate(tmd->tid) && !isDLC(tmd->tid) && !isGame(tmd->tid))
+        return false;
+
+    uint64_t best = 0;
+    scanInstallDir(INSTALL_DIR_SD, tmd, exclude, out, &best);
+    switch(getUSB())
+    {
+        case NUSDEV_USB01:
+            scanInstallDir(INSTALL_DIR_USB1, tmd, exclude, out, &best);
+            break;
+        case NUSDEV_USB02:
+            scanInstallDir(INSTALL_DIR_USB2, tmd, exclude, out, &best);
+            break;
+        default:
+            break;
+    }
+
+    if(out->tmd == NULL)
+        return false;
+
+    debugPrintf("Delta: Reusing %llu bytes from %s", best, out->dir);
+    return true;
+}
+
+void freeDeltaSource(DELTA_SOURCE *source)
+{
+    if(source->tmd != NULL)
+    {
+        MEMFreeToDefaultHeap(source->tmd);
+        source->tmd = NULL;
+    }
+}
+
+static bool copyContentFile(const DELTA_SOURCE *source, uint32_t oldCid, const char *dir, uint32_t cid, const char *ext, size_t size, COPY_PROGRESS *progress)
+{
+    char src[FS_MAX_PATH];
+    char dest[FS_MAX_PATH];
+    snprintf(dest, FS_MAX_PATH, "%08x%s", oldCid, ext);
+    if(!getTitleFilePath(source->dir, dest, src)) // The source might be a no-intro set
+        return false;
+
+    snprintf(dest, FS_MAX_PATH, "%s%08x%s", dir, cid, ext);
+    return getFilesize(src) == size && copyFile(src, dest, size, progress);
+}
+
+/*
+ * Copies an unchanged content from the previous version into dir, reporting
+ * to progress. Returns the copied bytes, 0 if the content changed, is
+ * already there or the copy got cancelled. Runs on the copy thread of
+ * reuseContent(), which logs the copy once it joined.
+ */
+uint64_t fetchFromPreviousVersion(const TMD *tmd, uint16_t content, const DELTA_SOURCE *source, const char *dir, COPY_PROGRESS *progress)
+{
+    if(source->tmd == NULL)
+        return 0;
+
+    int old = findUnchangedContent(tmd, content, source->tmd);
+    if(old < 0)
+        return 0;
+
+    const TMD_CONTENT *c = tmd->contents + content;
+    char path[FS_MAX_PATH];
+    snprintf(path, FS_MAX_PATH, "%s%08x.app", dir, c->cid);
+    if(getFilesize(path) == c->size) // Already downloaded, let downloadFile() skip it
+        return 0;
+
+    uint32_t oldCid = source->tmd->contents[old].cid;
+    if(!copyContentFile(source, oldCid, dir, c->cid, ".app", c->size, progress))
+        return 0;
+
+    if((c->type & TMD_CONTENT_TYPE_HASHED) && !copyContentFile(source, oldCid, dir, c->cid, ".h3", getH3size(c->size), progress))
+        return 0;
+
+    return getContentSize(c);
+}
+
+// Bytes which don't need to be downloaded thanks to the content cache or another version
+uint64_t getReusableSize(const TMD *tmd)
+{
+    DELTA_SOURCE source;
+    findPreviousVersion(tmd, NULL, &source);
+
+    uint64_t ret = 0;
+    for(uint16_t i = 0; i < tmd->num_contents; ++i)
+        if(isCached(tmd, i) || (source.tmd != NULL && findUnchangedContent(tmd, i, source.tmd) >= 0))
+            ret += getContentSize(tmd->contents + i);
+
+    freeDeltaSource(&source);
+    return ret;
+}
@@ -23,7 +23,9 @@
 #include <netinet/tcp.h>
 
 #include <config.h>
+#include <contentCache.h>
 #include <crypto.h>
+#include <delta.h>
 #include <downloader.h>
 #include <file.h>
 #include <filesystem.h>
@@ -31,16 +33,20 @@
 #include <installer.h>
 #include <ioQueue.h>
 #include <localisation.h>
+#include <memTrack.h>
 #include <menu/utils.h>
+#include <metaCache.h>
+#include <netShare.h>
+#include <netStats.h>
 #include <queue.h>
 #include <renderer.h>
 #include <romfs.h>
 #include <state.h>
-#include <staticMem.h>
 #include <thread.h>
 #include <ticket.h>
 #include <titles.h>
 #include <tmd.h>
+#include <trace.h>
 #include <utils.h>
 
 #include <mbedtls/entropy.h>
@@ -59,13 +65,29 @@
 #include <nsysnet/netconfig.h>
 #pragma GCC diagnostic pop
 
-#define USERAGENT        "NUSspli/" NUSSPLI_VERSION
-#define SMOOTHING_FACTOR 0.2f
+#define USERAGENT             "NUSspli/" NUSSPLI_VERSION
+#define SMOOTHING_FACTOR      0.2f
+
+#define LOW_POWER_IDLE_FRAMES (10 * 60) // Frames without input until the low power mode kicks in
+#define LOW_POWER_FRAMES      (5 * 60) // Redraw interval while in low power mode
+#define LOW_POWER_SLEEP       6 // Frames to sleep between input checks while in low power mode
+#define WARMUP_IDLE           60 // Seconds without transfer until a connection gets warmed up again
+#define WARMUP_TIMEOUT        3000L // Milliseconds
 
 static bool initialised = false;
 static CURL *curl;
+static CURLSH *curlShare = NULL;
+#ifdef NUSSPLI_DEBUG
+static uint32_t connections = 0;
+static uint32_t handshakes = 0;
+#endif
 static char curlError[CURL_ERROR_SIZE];
 static bool curlReuseConnection = true;
+static int idleFrames = 0; // Kept between files so a long queue stays in low power mode
+static OSThread *warmupThread = NULL;
+static CURL *warmupHandle = NULL;
+static volatile bool warmupCancel = false;
+static OSTime lastTransfer = 0;
 
 static void *cancelOverlay = NULL;
 
@@ -192,9 +214,8 @@ static CURLcode ssl_ctx_init(CURL *cu, void *sslctx, void *parm)
 
 static bool showNetworkError(const char *err)
 {
-    char *toScreen = getToFrameBuffer();
-    if(toScreen != err)
-        strcpy(toScreen, err);
+    char toScreen[2048];
+    strcpy(toScreen, err);
 
     int os = 0;
     int frames = 0;
@@ -374,6 +395,7 @@ bool initDownloader()
     CURLcode ret = curl_global_init(CURL_GLOBAL_DEFAULT & ~(CURL_GLOBAL_SSL));
     if(ret == CURLE_OK)
     {
+        curlShare = initNetShare();
         curl = curl_easy_init();
         if(curl != NULL)
         {
@@ -430,8 +452,13 @@ bool initDownloader()
                                                         ret = curl_easy_setopt(curl, opt, pUrl2);
                                                         if(ret == CURLE_OK)
                                                         {
-                                                            initialised = true;
-                                                            return true;
+                                                            opt = CURLOPT_SHARE;
+                                                            ret = curl_easy_setopt(curl, opt, curlShare);
+                                                            if(ret == CURLE_OK)
+                                                            {
+                                                                initialised = true;
+                                                                return true;
+                                                            }
                                                         }
                                                     }
                                                 }
@@ -456,6 +483,12 @@ bool initDownloader()
         else
             debugPrintf("curl_easy_init() failed!");
 #endif
+        if(curlShare != NULL)
+        {
+            curl_share_cleanup(curlShare);
+            curlShare = NULL;
+        }
+
         curl_global_cleanup();
     }
 
@@ -465,24 +498,169 @@ bool initDownloader()
     return false;
 }
 
+static int warmupThreadMain(int argc, const char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+#ifdef NUSSPLI_DEBUG
+    CURLcode ret = curl_easy_perform(warmupHandle);
+    debugPrintf("Connection warm-up: %s", curl_easy_strerror(ret));
+#else
+    curl_easy_perform(warmupHandle);
+#endif
+    return 0;
+}
+
+static size_t discardData(const void *ptr, size_t size, size_t nmemb, void *userdata)
+{
+    (void)ptr;
+    (void)userdata;
+
+    return size * nmemb;
+}
+
+#define RAMBUF_MIN_CAPACITY 0x1000
+
+/*
+ * Write callback for downloads to RAM. Grows the buffer through the memory
+ * tracker and keeps it '\0' terminated, like open_memstream() did.
+ */
+static size_t writeRamBuf(const void *ptr, size_t size, size_t nmemb, RAMBUF *rambuf)
+{
+    size *= nmemb;
+    if(rambuf->size + size >= rambuf->capacity)
+    {
+        size_t capacity = rambuf->capacity == 0 ? RAMBUF_MIN_CAPACITY : rambuf->capacity;
+        while(capacity <= rambuf->size + size)
+            capacity <<= 1;
+
+        char *buf = memAlloc(MEM_TAG_DOWNLOAD, capacity);
+        if(buf == NULL)
+            return 0; // Makes curl fail with CURLE_WRITE_ERROR
+
+        if(rambuf->buf != NULL)
+        {
+            OSBlockMove(buf, rambuf->buf, rambuf->size, false);
+            memFree(MEM_TAG_DOWNLOAD, rambuf->buf);
+        }
+
+        rambuf->buf = buf;
+        rambuf->capacity = capacity;
+    }
+
+    OSBlockMove(rambuf->buf + rambuf->size, ptr, size, false);
+    rambuf->size += size;
+    rambuf->buf[rambuf->size] = '\0';
+    return size;
+}
+
+static int warmupProgress(void *rawData, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
+{
+    (void)rawData;
+    (void)dltotal;
+    (void)dlnow;
+    (void)ultotal;
+    (void)ulnow;
+
+    return warmupCancel ? 1 : 0;
+}
+
+// Makes a running warm-up give up without waiting for it, its thread gets joined later by finishWarmup()
+static void cancelWarmup()
+{
+    if(warmupThread != NULL)
+        warmupCancel = true;
+}
+
+// Joins the warm-up thread. Returns false if it's still running and wait isn't set
+static bool finishWarmup(bool wait)
+{
+    if(warmupThread == NULL)
+        return true;
+
+    if(!wait && !OSIsThreadTerminated(warmupThread))
+        return false;
+
+    stopThread(warmupThread, NULL);
+    warmupThread = NULL;
+    curl_easy_cleanup(warmupHandle);
+    warmupHandle = NULL;
+    return true;
+}
+
+/*
+ * Resolves the NUS and opens a connection to it in the background. The
+ * connection ends up in the shared pool, so the next download can skip
+ * DNS and TCP setup. Does nothing while the last transfer is recent enough
+ * for its connection to still be open.
+ */
+void warmupConnection()
+{
+    if(!initialised || !finishWarmup(false) || (uint64_t)(OSGetTime() - lastTransfer) < OSSecondsToTicks(WARMUP_IDLE))
+        return;
+
+    warmupHandle = curl_easy_duphandle(curl);
+    if(warmupHandle == NULL)
+        return;
+
+    if(curl_easy_setopt(warmupHandle, CURLOPT_SHARE, curlShare) == CURLE_OK &&
+       curl_easy_setopt(warmupHandle, CURLOPT_URL, DOWNLOAD_URL) == CURLE_OK &&
+       curl_easy_setopt(warmupHandle, CURLOPT_NOBODY, 1L) == CURLE_OK &&
+       curl_easy_setopt(warmupHandle, CURLOPT_XFERINFOFUNCTION, warmupProgress) == CURLE_OK &&
+       curl_easy_setopt(warmupHandle, CURLOPT_XFERINFODATA, NULL) == CURLE_OK &&
+       curl_easy_setopt(warmupHandle, CURLOPT_NOPROGRESS, 0L) == CURLE_OK &&
+       curl_easy_setopt(warmupHandle, CURLOPT_FAILONERROR, 0L) == CURLE_OK &&
+       curl_easy_setopt(warmupHandle, CURLOPT_FRESH_CONNECT, 0L) == CURLE_OK &&
+       curl_easy_setopt(warmupHandle, CURLOPT_RESUME_FROM_LARGE, (curl_off_t)0) == CURLE_OK &&
+       curl_easy_setopt(warmupHandle, CURLOPT_TIMEOUT_MS, WARMUP_TIMEOUT) == CURLE_OK &&
+       curl_easy_setopt(warmupHandle, CURLOPT_ERRORBUFFER, NULL) == CURLE_OK &&
+       curl_easy_setopt(warmupHandle, CURLOPT_WRITEFUNCTION, discardData) == CURLE_OK)
+    {
+        warmupCancel = false;
+        warmupThread = startThread("NUSspli connection warm-up", THREAD_PRIORITY_LOW, STACKSIZE_BIG, warmupThreadMain, 0, NULL, AFFINITY_CPU12);
+        if(warmupThread != NULL)
+        {
+            // The warm-up opens a fresh connection already, the next download may reuse it
+            curlReuseConnection = true;
+            lastTransfer = OSGetTime();
+            return;
+        }
+    }
+
+    curl_easy_cleanup(warmupHandle);
+    warmupHandle = NULL;
+}
+
 void deinitDownloader()
 {
     if(!initialised)
         return;
 
+    cancelWarmup();
+    finishWarmup(true);
     if(curl != NULL)
     {
         curl_easy_cleanup(curl);
         curl = NULL;
     }
+    if(curlShare != NULL)
+    {
+        curl_share_cleanup(curlShare);
+        curlShare = NULL;
+    }
     curl_global_cleanup();
+    // The pooled connections are gone, the next init may warm up again
+    lastTransfer = 0;
     initialised = false;
 }
 
 static int dlThreadMain(int argc, const char **argv)
 {
     debugPrintf("Download thread spawned!");
+    traceBegin("curl_easy_perform");
     argc = curl_easy_perform(curl);
+    traceEnd("curl_easy_perform");
     ((curlProgressData *)argv[0])->running = false;
     return argc;
 }
@@ -531,7 +709,7 @@ static void drawStatLine(int line, curl_off_t totalSize, curl_off_t currentSize,
     else
         barToFrame(line, 0, 29, 0.0D);
 
-    char *toScreen = getToFrameBuffer();
+    char toScreen[64];
     humanize(currentSize, toScreen);
     char *ptr = toScreen + strlen(toScreen);
     strcpy(ptr, " / ");
@@ -543,10 +721,138 @@ static void drawStatLine(int line, curl_off_t totalSize, curl_off_t currentSize,
     textToFrame(line, ALIGNED_RIGHT, toScreen);
 }
 
+// Text only progress on black background, used by the low power mode
+static void drawLowPowerFrame(const downloadData *data, const QUEUE_DATA *queueData, const char *name, size_t dlnow, size_t dltotal, float bps)
+{
+    colorStartNewFrame(SCREEN_COLOR_BLACK);
+
+    char toScreen[MAX_TITLENAME_LENGTH + 64];
+    if(data != NULL)
+    {
+        curl_off_t now = data->dlnow + dlnow;
+        curl_off_t total = data->dltotal;
+        if(queueData != NULL)
+        {
+            now = queueData->downloaded + dlnow;
+            total = queueData->dlSize;
+        }
+
+        sprintf(toScreen, "%s: %d%% | ", data->name, total == 0 ? 0 : (int)((now * 100) / total));
+    }
+    else
+        sprintf(toScreen, "%s: %d%% | ", name, dltotal == 0 ? 0 : (int)((((uint64_t)dlnow) * 100) / dltotal));
+
+    getSpeedString(bps, toScreen + strlen(toScreen));
+    textToFrameColored(MAX_LINES >> 1, ALIGNED_CENTER, toScreen, SCREEN_COLOR_GRAY);
+    drawFrame();
+}
+
+// Draws the title and queue progress, returns the next free line
+static int titleToFrame(downloadData *data, QUEUE_DATA *queueData, curl_off_t now, float bps)
+{
+    if(data == NULL)
+        return 0;
+
+    char toScreen[MAX_TITLENAME_LENGTH + 64];
+    int line;
+    if(queueData != NULL)
+    {
+        sprintf(toScreen, "%s (%d/%d)", data->name, queueData->current, queueData->packages);
+        line = textToFrameMultiline(0, ALIGNED_CENTER, toScreen, MAX_CHARS);
+    }
+    else
+        line = textToFrameMultiline(0, ALIGNED_CENTER, data->name, MAX_CHARS);
+
+    drawStatLine(line++, data->dltotal, data->dlnow + now, bps, &data->eta);
+
+    if(queueData != NULL)
+        drawStatLine(line++, queueData->dlSize, queueData->downloaded + now, bps, &queueData->eta);
+
+    lineToFrame(line++, SCREEN_COLOR_WHITE);
+
+    sprintf(toScreen, "(%d/%d)", data->dcontent + 1, data->contents);
+    textToFrame(line, ALIGNED_CENTER, toScreen);
+    return line;
+}
+
+#define lowPowerActive(lowPower) ((lowPower) && idleFrames >= LOW_POWER_IDLE_FRAMES && cancelOverlay == NULL)
+
+/*
+ * Waits for the next frame. In low power mode nothing changes on screen
+ * between two redraws, so instead of waking up on every vsync this sleeps
+ * for LOW_POWER_SLEEP frames and only reads the input. Callers count their
+ * redraw interval in LOW_POWER_SLEEP frames then.
+ */
+static void waitFrame(bool lowPower)
+{
+    if(lowPowerActive(lowPower))
+    {
+        OSSleepTicks(OSMillisecondsToTicks(LOW_POWER_SLEEP * 1000 / 60));
+        readInput();
+    }
+    else
+        showFrame();
+}
+
+/*
+ * Counts the frames without input for the low power mode. Returns true if
+ * the input woke it up, that input shouldn't do anything else then.
+ */
+static bool lowPowerInput(int *frames)
+{
+    if(vpad.trigger || vpad.hold)
+    {
+        if(idleFrames >= LOW_POWER_IDLE_FRAMES)
+        {
+            idleFrames = 0;
+            *frames = 1;
+            return true;
+        }
+
+        idleFrames = 0;
+    }
+    else if(idleFrames < LOW_POWER_IDLE_FRAMES && ++idleFrames == LOW_POWER_IDLE_FRAMES)
+        *frames = 1;
+
+    return false;
+}
+
+// Handles the cancel overlay, returns true once the user confirmed it
+static bool cancelConfirmed()
+{
+    if(cancelOverlay == NULL)
+    {
+        if(vpad.trigger & VPAD_BUTTON_B)
+        {
+            char toScreen[512];
+            strcpy(toScreen, localise("Do you really want to cancel?"));
+            strcat(toScreen, "\n\n" BUTTON_A " ");
+            strcat(toScreen, localise("Yes"));
+            strcat(toScreen, " || " BUTTON_B " ");
+            strcat(toScreen, localise("No"));
+            cancelOverlay = addErrorOverlay(toScreen);
+        }
+
+        return false;
+    }
+
+    if(vpad.trigger & VPAD_BUTTON_A)
+    {
+        closeCancelOverlay();
+        return true;
+    }
+
+    if(vpad.trigger & VPAD_BUTTON_B)
+        closeCancelOverlay();
+
+    return false;
+}
+
 int downloadFile(const char *url, char *file, downloadData *data, FileType type, bool resume, QUEUE_DATA *queueData, RAMBUF *rambuf)
 {
     // Results: 0 = OK | 1 = Error | 2 = No ticket aviable | 3 = Exit
     // Types: 0 = .app | 1 = .h3 | 2 = title.tmd | 3 = tilte.tik
+    traceScope("downloadFile");
 
     debugPrintf("Download URL: %s", url);
     debugPrintf("Download PATH: %s", rambuf ? "<RAM>" : file);
@@ -562,12 +868,14 @@ int downloadFile(const char *url, char *file, downloadData *data, FileType type,
         name = file + haystack + 1;
     }
 
-    char *toScreen = getToFrameBuffer();
+    char toScreen[2048];
     void *fp;
     size_t fileSize;
     if(rambuf)
     {
-        fp = (void *)open_memstream(&rambuf->buf, &rambuf->size);
+        // Drops what an earlier try left behind
+        clearRamBuf(rambuf);
+        fp = rambuf;
         fileSize = 0;
     }
     else
@@ -593,14 +901,14 @@ int downloadFile(const char *url, char *file, downloadData *data, FileType type,
                         return downloadFile(url, file, data, type, false, queueData, rambuf);
                 }
 
-                fp = (void *)openFile(file, "a", 0);
+                fp = (void *)(intptr_t)openFile(file, "a", 0);
             }
             else
-                fp = (void *)openFile(file, "w", data == NULL ? 0 : data->cs);
+                fp = (void *)(intptr_t)openFile(file, "w", data == NULL ? 0 : data->cs);
         }
         else
         {
-            fp = (void *)openFile(file, "w", data == NULL ? 0 : data->cs);
+            fp = (void *)(intptr_t)openFile(file, "w", data == NULL ? 0 : data->cs);
             fileSize = 0;
         }
     }
@@ -608,6 +916,9 @@ int downloadFile(const char *url, char *file, downloadData *data, FileType type,
     if(fp == NULL)
         return 1;
 
+    // Don't block on a warm-up still in progress, the transfer connects on its own then
+    cancelWarmup();
+    lastTransfer = OSGetTime();
     curlError[0] = '\0';
     volatile curlProgressData cdata = {
         .running = true,
@@ -637,7 +948,7 @@ int downloadFile(const char *url, char *file, downloadData *data, FileType type,
             {
                 opt = CURLOPT_WRITEFUNCTION;
 #pragma GCC diagnostic ignored "-Wcast-function-type"
-                ret = curl_easy_setopt(curl, opt, rambuf ? fwrite : (size_t(*)(const void *, size_t, size_t, FILE *))addToIOQueue);
+                ret = curl_easy_setopt(curl, opt, rambuf ? (size_t(*)(const void *, size_t, size_t, FILE *))writeRamBuf : (size_t(*)(const void *, size_t, size_t, FILE *))addToIOQueue);
 #pragma GCC diagnostic pop
                 if(ret == CURLE_OK)
                 {
@@ -655,10 +966,8 @@ int downloadFile(const char *url, char *file, downloadData *data, FileType type,
 
     if(ret != CURLE_OK)
     {
-        if(rambuf)
-            fclose((FILE *)fp);
-        else
-            addToIOQueue(NULL, 0, 0, (FSAFileHandle)fp);
+        if(!rambuf)
+            addToIOQueue(NULL, 0, 0, (FSAFileHandle)(intptr_t)fp);
 
         debugPrintf("curl_easy_setopt error: %s (%d / %u / %ud)", curlError, ret, opt, fileSize);
         return 1;
@@ -678,10 +987,16 @@ int downloadFile(const char *url, char *file, downloadData *data, FileType type,
     size_t dlnow;
     size_t downloaded = 0;
     size_t tmp;
+    uint32_t eta = 0;
     float bps;
     float oldBps = 0.0D;
     int frames = 1;
     int line;
+    bool lowPower = lowPowerEnabled();
+#ifdef NUSSPLI_DEBUG
+    OSTime uiTime = 0;
+    OSTime uiStart;
+#endif
     while(cdata.running && AppRunning(true))
     {
         if(--frames == 0)
@@ -726,30 +1041,30 @@ int downloadFile(const char *url, char *file, downloadData *data, FileType type,
             }
 
             lastTransfair = ts;
-            startNewFrame();
+#ifdef NUSSPLI_DEBUG
+            uiStart = OSGetSystemTime();
+#endif
 
-            if(data != NULL)
+            if(lowPowerActive(lowPower))
             {
-                if(queueData != NULL)
+                if(dltotal)
                 {
-                    sprintf(toScreen, "%s (%d/%d)", data->name, queueData->current, queueData->packages);
-                    line = textToFrameMultiline(0, ALIGNED_CENTER, toScreen, MAX_CHARS);
-                }
-                else
-                    line = textToFrameMultiline(0, ALIGNED_CENTER, data->name, MAX_CHARS);
-
-                drawStatLine(line++, data->dltotal, data->dlnow + dlnow, bps, &data->eta);
-
-                if(queueData != NULL)
-                    drawStatLine(line++, queueData->dlSize, queueData->downloaded + dlnow, bps, &queueData->eta);
+                    if(!rambuf)
+                        checkForQueueErrors();
 
-                lineToFrame(line++, SCREEN_COLOR_WHITE);
+                    dltotal += fileSize;
+                }
 
-                sprintf(toScreen, "(%d/%d)", data->dcontent + 1, data->contents);
-                textToFrame(line, ALIGNED_CENTER, toScreen);
+                frames = LOW_POWER_FRAMES / LOW_POWER_SLEEP;
+                drawLowPowerFrame(data, queueData, name, dlnow, dltotal, bps);
+#ifdef NUSSPLI_DEBUG
+                uiTime += OSGetSystemTime() - uiStart;
+#endif
+                goto frameDone;
             }
-            else
-                line = 0;
+
+            startNewFrame();
+            line = titleToFrame(data, queueData, dlnow, bps);
 
             if(dltotal)
             {
@@ -767,7 +1082,7 @@ int downloadFile(const char *url, char *file, downloadData *data, FileType type,
                 getSpeedString(bps, toScreen);
                 textToFrame(line, ALIGNED_RIGHT, toScreen);
 
-                drawStatLine(++line, dltotal, dlnow, bps, &tmp);
+                drawStatLine(++line, dltotal, dlnow, bps, &eta);
             }
             else
             {
@@ -778,34 +1093,26 @@ int downloadFile(const char *url, char *file, downloadData *data, FileType type,
                 textToFrame(line++, 0, toScreen);
             }
 
-            writeScreenLog(++line);
+            ++line;
+            line += installToFrame(line);
+            writeScreenLog(line);
             drawFrame();
+#ifdef NUSSPLI_DEBUG
+            uiTime += OSGetSystemTime() - uiStart;
+#endif
         }
 
-        showFrame();
+    frameDone:
+        waitFrame(lowPower);
 
-        if(cancelOverlay == NULL)
-        {
-            if(vpad.trigger & VPAD_BUTTON_B)
-            {
-                strcpy(toScreen, localise("Do you really want to cancel?"));
-                strcat(toScreen, "\n\n" BUTTON_A " ");
-                strcat(toScreen, localise("Yes"));
-                strcat(toScreen, " || " BUTTON_B " ");
-                strcat(toScreen, localise("No"));
-                cancelOverlay = addErrorOverlay(toScreen);
-            }
-        }
-        else
+        // Wake up with a full frame right away and don't let the wake up input do anything else
+        if(lowPower && lowPowerInput(&frames))
+            continue;
+
+        if(cancelConfirmed())
         {
-            if(vpad.trigger & VPAD_BUTTON_A)
-            {
-                cdata.error = CURLE_ABORTED_BY_CALLBACK;
-                closeCancelOverlay();
-                break;
-            }
-            if(vpad.trigger & VPAD_BUTTON_B)
-                closeCancelOverlay();
+            cdata.error = CURLE_ABORTED_BY_CALLBACK;
+            break;
         }
     }
 
@@ -813,15 +1120,17 @@ int downloadFile(const char *url, char *file, downloadData *data, FileType type,
 
     t = OSGetSystemTime() - t;
     addEntropy(&t, sizeof(OSTime));
+#ifdef NUSSPLI_DEBUG
+    debugPrintf("UI time: %llu ms of %llu ms (low power: %s)", OSTicksToMilliseconds(uiTime), OSTicksToMilliseconds(t), lowPower ? "on" : "off");
+#endif
     if(data == NULL && cancelOverlay != NULL)
         closeCancelOverlay();
 
     debugPrintf("curl_easy_perform() returned: %d", ret);
+    recordTransfer(curl, fileSize, ret != CURLE_OK);
 
-    if(rambuf)
-        fclose((FILE *)fp);
-    else
-        addToIOQueue(NULL, 0, 0, (FSAFileHandle)fp);
+    if(!rambuf)
+        addToIOQueue(NULL, 0, 0, (FSAFileHandle)(intptr_t)fp);
 
     if(!AppRunning(true))
         return 1;
@@ -847,12 +1156,7 @@ int downloadFile(const char *url, char *file, downloadData *data, FileType type,
         switch(ret)
         {
             case CURLE_RANGE_ERROR:
-                if(rambuf && rambuf->buf)
-                {
-                    MEMFreeToDefaultHeap(rambuf->buf);
-                    rambuf->buf = NULL;
-                    rambuf->size = 0;
-                }
+                recordRetry();
                 int r = downloadFile(url, file, data, type, false, queueData, rambuf);
                 curlReuseConnection = false;
                 return r;
@@ -882,6 +1186,7 @@ int downloadFile(const char *url, char *file, downloadData *data, FileType type,
         {
             resetNetwork();
             flushIOQueue(); // We flush here so the last file is completely on disc and closed before we retry.
+            recordRetry();
             return downloadFile(url, file, data, type, resume, queueData, rambuf);
         }
 
@@ -889,6 +1194,21 @@ int downloadFile(const char *url, char *file, downloadData *data, FileType type,
         return 1;
     }
     debugPrintf("curl_easy_perform executed successfully");
+#ifdef NUSSPLI_DEBUG
+    long newConnections;
+    curl_off_t handshake;
+    curl_off_t ttfb;
+    if(curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &newConnections) == CURLE_OK &&
+       curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &handshake) == CURLE_OK &&
+       curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &ttfb) == CURLE_OK)
+    {
+        connections += newConnections;
+        if(handshake != 0)
+            ++handshakes;
+
+        debugPrintf("Time to first byte: %lld us (%u connections, %u TLS handshakes so far)", ttfb, connections, handshakes);
+    }
+#endif
 
     long resp;
     curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &resp);
@@ -901,9 +1221,7 @@ int downloadFile(const char *url, char *file, downloadData *data, FileType type,
         if(!rambuf)
         {
             flushIOQueue();
-            char *newFile = getStaticPathBuffer(2);
-            strcpy(newFile, file);
-            FSARemove(getFSAClient(), newFile);
+            FSARemove(getFSAClient(), file);
         }
 
         if(resp == 404 && (type & FILE_TYPE_TMD) == FILE_TYPE_TMD) // Title.tmd not found
@@ -926,12 +1244,7 @@ int downloadFile(const char *url, char *file, downloadData *data, FileType type,
                     break;
                 if(vpad.trigger & VPAD_BUTTON_Y)
                 {
-                    if(rambuf && rambuf->buf)
-                    {
-                        MEMFreeToDefaultHeap(rambuf->buf);
-                        rambuf->buf = NULL;
-                        rambuf->size = 0;
-                    }
+                    recordRetry();
                     return downloadFile(url, file, data, type, resume, queueData, rambuf);
                 }
             }
@@ -964,7 +1277,10 @@ int downloadFile(const char *url, char *file, downloadData *data, FileType type,
                 if(vpad.trigger & VPAD_BUTTON_B)
                     break;
                 if(vpad.trigger & VPAD_BUTTON_Y)
+                {
+                    recordRetry();
                     return downloadFile(url, file, data, type, resume, queueData, rambuf);
+                }
             }
             return 1;
         }
@@ -990,7 +1306,150 @@ int downloadFile(const char *url, char *file, downloadData *data, FileType type,
     return 0;
 }
 
-bool downloadTitle(const TMD *tmd, size_t tmdSize, const TitleEntry *titleEntry, const char *titleVer, char *folderName, bool inst, NUSDEV dlDev, bool toUSB, bool keepFiles, QUEUE_DATA *queueData)
+typedef struct
+{
+    const TMD *tmd;
+    const DELTA_SOURCE *previous;
+    const char *dir;
+    COPY_PROGRESS progress;
+    CACHE_ENTRY cacheEntry;
+    CACHE_RESTORE restored;
+    uint64_t cached;
+    uint64_t copied;
+    uint16_t content;
+    bool inCache;
+    bool move;
+    volatile bool running;
+} REUSE_DATA;
+
+// Only copies files, the cache index and the screen log get updated by reuseContent() after the join
+static int reuseThreadMain(int argc, const char **argv)
+{
+    (void)argc;
+
+    REUSE_DATA *reuse = (REUSE_DATA *)argv;
+    reuse->restored = CACHE_RESTORE_NONE;
+    if(reuse->inCache)
+        reuse->restored = restoreFromCache(&reuse->cacheEntry, reuse->tmd, reuse->content, reuse->dir, reuse->move, &reuse->progress);
+
+    if(reuse->restored != CACHE_RESTORE_COPIED && reuse->restored != CACHE_RESTORE_MOVED && !reuse->progress.cancel)
+        reuse->copied = fetchFromPreviousVersion(reuse->tmd, reuse->content, reuse->previous, reuse->dir, &reuse->progress);
+
+    reuse->running = false;
+    return 0;
+}
+
+static void finishReuse(REUSE_DATA *reuse)
+{
+    uint32_t cid = reuse->tmd->contents[reuse->content].cid;
+    if(reuse->inCache)
+        reuse->cached = finishCacheRestore(&reuse->cacheEntry, cid, reuse->restored);
+    if(reuse->copied != 0)
+        addToScreenLog("%08x.app copied from previous version", cid);
+}
+
+/*
+ * Takes a content from the content cache or a previous version instead of
+ * downloading it. Contents can be gigabytes big, so the copy runs in its own
+ * thread while this draws the download frame and lets the user cancel.
+ * Returns false if the user cancelled.
+ */
+static bool reuseContent(REUSE_DATA *reuse, downloadData *data, QUEUE_DATA *queueData)
+{
+    reuse->cached = 0;
+    reuse->copied = 0;
+    reuse->progress.copied = 0;
+    reuse->progress.cancel = false;
+    reuse->inCache = findInCache(reuse->tmd, reuse->content, &reuse->cacheEntry);
+    if(!reuse->inCache)
+    {
+        if(reuse->previous->tmd == NULL || findUnchangedContent(reuse->tmd, reuse->content, reuse->previous->tmd) < 0)
+            return true;
+    }
+
+    reuse->running = true;
+    OSThread *thread = startThread("NUSspli content copy", THREAD_PRIORITY_HIGH, STACKSIZE_MEDIUM, reuseThreadMain, 0, (char *)reuse, OS_THREAD_ATTRIB_AFFINITY_CPU0);
+    if(thread == NULL)
+    {
+        reuseThreadMain(0, (const char **)reuse);
+        finishReuse(reuse);
+        return true;
+    }
+
+    const TMD_CONTENT *c = reuse->tmd->contents + reuse->content;
+    size_t total = c->size;
+    if(c->type & TMD_CONTENT_TYPE_HASHED)
+        total += getH3size(c->size);
+
+    char name[13];
+    sprintf(name, "%08x.app", c->cid);
+    char toScreen[256];
+    OSTime start = OSGetSystemTime();
+    size_t copied;
+    float bps;
+    uint32_t eta = 0;
+    int frames = 1;
+    int line;
+    bool lowPower = lowPowerEnabled();
+    while(reuse->running && AppRunning(true))
+    {
+        if(--frames == 0)
+        {
+            copied = reuse->progress.copied;
+            bps = copied;
+            bps *= 1000.0f;
+            bps /= OSTicksToMilliseconds(OSGetSystemTime() - start) + 1; // byte/s
+
+            if(lowPowerActive(lowPower))
+            {
+                frames = LOW_POWER_FRAMES / LOW_POWER_SLEEP;
+                drawLowPowerFrame(data, queueData, name, copied, total, bps);
+            }
+            else
+            {
+                frames = 60;
+                startNewFrame();
+                line = titleToFrame(data, queueData, copied, bps);
+
+                strcpy(toScreen, localise("Copying"));
+                strcat(toScreen, " ");
+                strcat(toScreen, name);
+                textToFrame(line, 0, toScreen);
+
+                getSpeedString(bps, toScreen);
+                textToFrame(line, ALIGNED_RIGHT, toScreen);
+
+                drawStatLine(++line, total, copied, bps, &eta);
+
+                ++line;
+                line += installToFrame(line);
+                writeScreenLog(line);
+                drawFrame();
+            }
+        }
+
+        waitFrame(lowPower);
+
+        if(lowPower && lowPowerInput(&frames))
+            continue;
+
+        if(cancelConfirmed())
+        {
+            reuse->progress.cancel = true;
+            break;
+        }
+    }
+
+    // copyFile() stops after the current block
+    if(reuse->running)
+        reuse->progress.cancel = true;
+
+    stopThread(thread, NULL);
+    finishReuse(reuse);
+    return !reuse->progress.cancel;
+}
+
+static bool innerDownloadTitle(const TMD *tmd, size_t tmdSize, const TitleEntry *titleEntry, const char *titleVer, char *folderName, bool inst, NUSDEV dlDev, bool toUSB, bool keepFiles, QUEUE_DATA *queueData)
 {
     char tid[17];
     hex(tmd->tid, 16, tid);
@@ -1015,7 +1474,7 @@ bool downloadTitle(const TMD *tmd, size_t tmdSize, const TitleEntry *titleEntry,
         strcat(folderName, titleVer);
     }
 
-    char *installDir = getStaticPathBuffer(3);
+    char installDir[FS_MAX_PATH];
     strcpy(installDir, dlDev == NUSDEV_USB01 ? INSTALL_DIR_USB1 : (dlDev == NUSDEV_USB02 ? INSTALL_DIR_USB2 : (dlDev == NUSDEV_SD ? INSTALL_DIR_SD : INSTALL_DIR_MLC)));
     if(!dirExists(installDir))
     {
@@ -1025,9 +1484,7 @@ bool downloadTitle(const TMD *tmd, size_t tmdSize, const TitleEntry *titleEntry,
             addToScreenLog("Install directory successfully created");
         else
         {
-            char *toScreen = getToFrameBuffer();
-            strcpy(toScreen, translateFSErr(err));
-            showErrorFrame(toScreen);
+            showErrorFrame(translateFSErr(err));
             return false;
         }
     }
@@ -1046,9 +1503,7 @@ bool downloadTitle(const TMD *tmd, size_t tmdSize, const TitleEntry *titleEntry,
             addToScreenLog("Download directory successfully created");
         else
         {
-            char *toScreen = getToFrameBuffer();
-            strcpy(toScreen, translateFSErr(err));
-            showErrorFrame(toScreen);
+            showErrorFrame(translateFSErr(err));
             return false;
         }
     }
@@ -1069,7 +1524,7 @@ bool downloadTitle(const TMD *tmd, size_t tmdSize, const TitleEntry *titleEntry,
     addToIOQueue(NULL, 0, 0, fp);
     addToScreenLog("title.tmd saved");
 
-    char *toScreen = getToFrameBuffer();
+    char toScreen[64];
     strcpy(toScreen, "=>Title type: ");
     bool hasDependencies;
     switch(getTidHighFromTid(tmd->tid)) // Title type
@@ -1142,7 +1597,7 @@ bool downloadTitle(const TMD *tmd, size_t tmdSize, const TitleEntry *titleEntry,
             return false;
 
         data.cs = 0;
-        int tikRes = downloadFile(downloadUrl, installDir, &data, FILE_TYPE_TIK | FILE_TYPE_TORAM, false, queueData, tikBuf);
+        int tikRes = downloadMetadata(tmd->tid, "cetk", "", FILE_TYPE_TIK, &data, queueData, tikBuf);
         switch(tikRes)
         {
             case 2:
@@ -1207,15 +1662,52 @@ bool downloadTitle(const TMD *tmd, size_t tmdSize, const TitleEntry *titleEntry,
 
     char *dupp = dup + 8;
     char *idpp = idp + 8;
+    bool moveFromCache = !keepFiles && dlDev == NUSDEV_SD;
+    uint64_t cached = 0;
+    uint64_t copied = 0;
+    uint64_t reused;
+    DELTA_SOURCE previous;
+    *idp = '\0';
+    findPreviousVersion(tmd, installDir, &previous);
+    REUSE_DATA reuse = {
+        .tmd = tmd,
+        .previous = &previous,
+        .dir = installDir,
+        .move = moveFromCache,
+    };
     for(int i = 0; i < tmd->num_contents && AppRunning(true); ++i)
     {
+        *idp = '\0';
+        reuse.content = i;
+        if(!reuseContent(&reuse, &data, queueData))
+        {
+            freeDeltaSource(&previous);
+            return false;
+        }
+
+        cached += reuse.cached;
+        copied += reuse.copied;
+        reused = reuse.cached + reuse.copied;
+        if(reused != 0)
+        {
+            data.dlnow += reused;
+            if(queueData != NULL)
+                queueData->downloaded += reused;
+
+            data.dcontent += tmd->contents[i].type & TMD_CONTENT_TYPE_HASHED ? 2 : 1;
+            continue;
+        }
+
         hex(tmd->contents[i].cid, 8, dup);
         OSBlockMove(idp, dup, 8, false);
         strcpy(idpp, ".app");
 
         data.cs = tmd->contents[i].size;
         if(downloadFile(downloadUrl, installDir, &data, FILE_TYPE_APP, true, queueData, NULL) == 1)
+        {
+            freeDeltaSource(&previous);
             return false;
+        }
 
         ++data.dcontent;
 
@@ -1226,7 +1718,10 @@ bool downloadTitle(const TMD *tmd, size_t tmdSize, const TitleEntry *titleEntry,
             data.cs = getH3size(tmd->contents[i].size);
 
             if(downloadFile(downloadUrl, installDir, &data, FILE_TYPE_H3, true, queueData, NULL) == 1)
+            {
+                freeDeltaSource(&previous);
                 return false;
+            }
 
             ++data.dcontent;
         }
@@ -1235,6 +1730,12 @@ bool downloadTitle(const TMD *tmd, size_t tmdSize, const TitleEntry *titleEntry,
     if(cancelOverlay != NULL)
         closeCancelOverlay();
 
+    freeDeltaSource(&previous);
+    if(cached != 0)
+        addToScreenLog("Content cache saved %llu MB", cached >> 20);
+    if(copied != 0)
+        addToScreenLog("Previous version saved %llu MB", copied >> 20);
+
     if(!AppRunning(true))
         return false;
 
@@ -1250,21 +1751,209 @@ bool downloadTitle(const TMD *tmd, size_t tmdSize, const TitleEntry *titleEntry,
     return ret;
 }
 
+bool downloadTitle(const TMD *tmd, size_t tmdSize, const TitleEntry *titleEntry, const char *titleVer, char *folderName, bool inst, NUSDEV dlDev, bool toUSB, bool keepFiles, QUEUE_DATA *queueData)
+{
+    startTitleNetStats(tmd->tid, titleEntry->name);
+    bool ret = innerDownloadTitle(tmd, tmdSize, titleEntry, titleVer, folderName, inst, dlDev, toUSB, keepFiles, queueData);
+    finishTitleNetStats();
+    flushContentCache();
+    return ret;
+}
+
+static void freeTmdHandle(CURLM *multi, CURL *handle)
+{
+    curl_multi_remove_handle(multi, handle);
+    curl_easy_cleanup(handle);
+}
+
+// Downloads multiple title.tmd files in parallel, used for bulk imports
+void downloadTmds(TMD_REQUEST *requests, size_t count)
+{
+    cancelWarmup();
+    lastTransfer = OSGetTime();
+    for(size_t i = 0; i < count; ++i)
+        requests[i].rambuf = NULL;
+
+    CURLM *multi = curl_multi_init();
+    if(multi == NULL)
+    {
+        debugPrintf("curl_multi_init() failed!");
+        return;
+    }
+
+    CURL *handles[MAX_PARALLEL_TMDS];
+    size_t active[MAX_PARALLEL_TMDS];
+    for(int i = 0; i < MAX_PARALLEL_TMDS; ++i)
+        handles[i] = NULL;
+
+    char toScreen[32];
+    char url[256];
+    char tid[17];
+    size_t next = 0;
+    size_t done = 0;
+    size_t drawn = -1;
+    int running;
+    int cached;
+    CURLMsg *msg;
+    TMD_REQUEST *request;
+    while(done < count && AppRunning(true))
+    {
+        for(int i = 0; i < MAX_PARALLEL_TMDS && next < count; ++i)
+        {
+            if(handles[i] != NULL)
+                continue;
+
+            request = requests + next;
+            active[i] = next++;
+            request->rambuf = allocRamBuf();
+            if(request->rambuf != NULL)
+            {
+                if(loadCachedMetadata(request->tid, "tmd", request->titleVer, false, request->rambuf, &cached) && cached == 0)
+                {
+                    debugPrintf("Metadata cache hit: %016llx/tmd", request->tid);
+                    ++done;
+                    --i; // Slot is still free
+                    continue;
+                }
+
+                clearRamBuf(request->rambuf);
+                // The duplicate inherits user agent, proxy and socket options, but not the share
+                handles[i] = curl_easy_duphandle(curl);
+                if(handles[i] != NULL)
+                {
+                    hex(request->tid, 16, tid);
+                    strcpy(url, DOWNLOAD_URL);
+                    strcat(url, tid);
+                    strcat(url, "/tmd");
+                    if(request->titleVer[0] != '\0')
+                    {
+                        strcat(url, ".");
+                        strcat(url, request->titleVer);
+                    }
+
+                    if(curl_easy_setopt(handles[i], CURLOPT_SHARE, curlShare) == CURLE_OK &&
+                       curl_easy_setopt(handles[i], CURLOPT_URL, url) == CURLE_OK &&
+                       curl_easy_setopt(handles[i], CURLOPT_NOPROGRESS, 1L) == CURLE_OK &&
+                       curl_easy_setopt(handles[i], CURLOPT_RESUME_FROM_LARGE, (curl_off_t)0) == CURLE_OK &&
+                       curl_easy_setopt(handles[i], CURLOPT_FAILONERROR, 1L) == CURLE_OK &&
+                       curl_easy_setopt(handles[i], CURLOPT_WRITEFUNCTION, writeRamBuf) == CURLE_OK &&
+                       curl_easy_setopt(handles[i], CURLOPT_WRITEDATA, request->rambuf) == CURLE_OK &&
+                       curl_multi_add_handle(multi, handles[i]) == CURLM_OK)
+                        continue;
+
+                    curl_easy_cleanup(handles[i]);
+                    handles[i] = NULL;
+                }
+
+                freeRamBuf(request->rambuf);
+                request->rambuf = NULL;
+            }
+
+            ++done;
+        }
+
+        curl_multi_perform(multi, &running);
+        while((msg = curl_multi_info_read(multi, &running)) != NULL)
+        {
+            if(msg->msg != CURLMSG_DONE)
+                continue;
+
+            for(int i = 0; i < MAX_PARALLEL_TMDS; ++i)
+            {
+                if(handles[i] != msg->easy_handle)
+                    continue;
+
+                request = requests + active[i];
+                CURLcode ret = msg->data.result;
+                recordTransfer(handles[i], 0, ret != CURLE_OK);
+                freeTmdHandle(multi, handles[i]);
+                handles[i] = NULL;
+                if(ret == CURLE_OK)
+                    storeMetadata(request->tid, "tmd", request->titleVer, 0, request->rambuf);
+                else
+                {
+                    debugPrintf("Error downloading TMD for %016llx: %s", request->tid, curl_easy_strerror(ret));
+                    if(!loadCachedMetadata(request->tid, "tmd", request->titleVer, true, request->rambuf, &cached) || cached != 0)
+                    {
+                        freeRamBuf(request->rambuf);
+                        request->rambuf = NULL;
+                    }
+                }
+
+                ++done;
+                break;
+            }
+        }
+
+        if(done != drawn)
+        {
+            drawn = done;
+            startNewFrame();
+            textToFrame(0, 0, localise("Downloading title.tmd files"));
+            barToFrame(1, 0, 40, (float)done / (float)count);
+            sprintf(toScreen, "%zu / %zu", done, count);
+            textToFrame(1, 41, toScreen);
+            writeScreenLog(2);
+            drawFrame();
+        }
+
+        showFrame();
+    }
+
+    // Cancelled
+    for(int i = 0; i < MAX_PARALLEL_TMDS; ++i)
+    {
+        if(handles[i] != NULL)
+        {
+            freeTmdHandle(multi, handles[i]);
+            freeRamBuf(requests[active[i]].rambuf);
+            requests[active[i]].rambuf = NULL;
+        }
+    }
+
+    curl_multi_cleanup(multi);
+}
+
 RAMBUF *allocRamBuf()
 {
-    RAMBUF *ret = MEMAllocFromDefaultHeap(sizeof(RAMBUF));
+    RAMBUF *ret = memAlloc(MEM_TAG_DOWNLOAD, sizeof(RAMBUF));
     if(ret == NULL)
         return NULL;
 
     ret->buf = NULL;
     ret->size = 0;
+    ret->capacity = 0;
     return ret;
 }
 
-void freeRamBuf(RAMBUF *rambuf)
+void clearRamBuf(RAMBUF *rambuf)
 {
     if(rambuf->buf != NULL)
-        MEMFreeToDefaultHeap(rambuf->buf);
+    {
+        memFree(MEM_TAG_DOWNLOAD, rambuf->buf);
+        rambuf->buf = NULL;
+    }
 
-    MEMFreeToDefaultHeap(rambuf);
+    rambuf->size = 0;
+    rambuf->capacity = 0;
+}
+
+// Replaces the payload with a copy of data
+bool setRamBuf(RAMBUF *rambuf, const void *data, size_t size)
+{
+    clearRamBuf(rambuf);
+    rambuf->buf = memAlloc(MEM_TAG_DOWNLOAD, size);
+    if(rambuf->buf == NULL)
+        return false;
+
+    OSBlockMove(rambuf->buf, data, size, false);
+    rambuf->size = size;
+    rambuf->capacity = size;
+    return true;
+}
+
+void freeRamBuf(RAMBUF *rambuf)
+{
+    clearRamBuf(rambuf);
+    memFree(MEM_TAG_DOWNLOAD, rambuf);
 }
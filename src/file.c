@@ -29,9 +29,8 @@
 #include <filesystem.h>
 #include <ioQueue.h>
 #include <menu/utils.h>
-#include <renderer.h>
-#include <staticMem.h>
 #include <tmd.h>
+#include <trace.h>
 #include <utils.h>
 
 #include <mbedtls/sha256.h>
@@ -55,13 +54,10 @@ bool dirExists(const char *path)
     return FSAGetStat(getFSAClient(), path, &stat) == FS_ERROR_OK && (stat.flags & FS_STAT_DIRECTORY);
 }
 
-FSError removeDirectory(const char *path)
+// newPath is a FS_MAX_PATH buffer the entries get appended to
+static FSError removeDirectoryIn(char *newPath)
 {
-    size_t len = strlen(path);
-    char *newPath = getStaticPathBuffer(0);
-    if(newPath != path)
-        OSBlockMove(newPath, path, len + 1, false);
-
+    size_t len = strlen(newPath);
     if(newPath[len - 1] != '/')
     {
         newPath[len] = '/';
@@ -79,7 +75,7 @@ FSError removeDirectory(const char *path)
         {
             strcpy(inSentence, entry.name);
             if(entry.info.flags & FS_STAT_DIRECTORY)
-                ret = removeDirectory(newPath);
+                ret = removeDirectoryIn(newPath);
             else
                 ret = FSARemove(getFSAClient(), newPath);
 
@@ -102,13 +98,80 @@ FSError removeDirectory(const char *path)
     return ret;
 }
 
-FSError moveDirectory(const char *src, const char *dest)
+FSError removeDirectory(const char *path)
+{
+    char *newPath = MEMAllocFromDefaultHeap(FS_MAX_PATH);
+    if(newPath == NULL)
+        return FS_ERROR_OUT_OF_RESOURCES;
+
+    strcpy(newPath, path);
+    FSError ret = removeDirectoryIn(newPath);
+    MEMFreeToDefaultHeap(newPath);
+    return ret;
+}
+
+/*
+ * Copies a file on or across devices, writes go through the I/O queue.
+ * If progress isn't NULL the copied bytes get added to it and the copy
+ * stops as soon as its cancel flag is set.
+ */
+bool copyFile(const char *src, const char *dest, size_t size, COPY_PROGRESS *progress)
 {
-    size_t len = strlen(src) + 1;
-    char *newSrc = getStaticPathBuffer(0);
-    if(newSrc != src)
-        OSBlockMove(newSrc, src, len, false);
+    FSAFileHandle in;
+    if(FSAOpenFileEx(getFSAClient(), src, "r", 0x000, FS_OPEN_FLAG_NONE, 0, &in) != FS_ERROR_OK)
+        return false;
+
+    bool ret = false;
+    void *buf = MEMAllocFromDefaultHeapEx(COPY_BUFFER_SIZE, 0x40);
+    if(buf != NULL)
+    {
+        FSAFileHandle out = openFile(dest, "w", size);
+        if(out != 0)
+        {
+            FSError err;
+            ret = true;
+            while(size != 0)
+            {
+                if(progress != NULL && progress->cancel)
+                {
+                    ret = false;
+                    break;
+                }
 
+                err = FSAReadFile(getFSAClient(), buf, 1, size > COPY_BUFFER_SIZE ? COPY_BUFFER_SIZE : size, in, 0);
+                if(err <= 0)
+                {
+                    debugPrintf("Error reading %s: %s", src, translateFSErr(err));
+                    ret = false;
+                    break;
+                }
+
+                // The I/O queue copies the data, so the buffer can be reused right away
+                addToIOQueue(buf, 1, err, out);
+                size -= err;
+                if(progress != NULL)
+                    progress->copied += err;
+            }
+
+            addToIOQueue(NULL, 0, 0, out);
+            if(!ret)
+            {
+                flushIOQueue();
+                FSARemove(getFSAClient(), dest);
+            }
+        }
+
+        MEMFreeToDefaultHeap(buf);
+    }
+
+    FSACloseFile(getFSAClient(), in);
+    return ret;
+}
+
+// newSrc and newDest are FS_MAX_PATH buffers the entries get appended to
+static FSError moveDirectoryIn(char *newSrc, char *newDest)
+{
+    size_t len = strlen(newSrc) + 1;
     char *inSrc = newSrc + --len;
     if(*--inSrc != '/')
     {
@@ -124,11 +187,7 @@ FSError moveDirectory(const char *src, const char *dest)
 
     if(ret == FS_ERROR_OK)
     {
-        len = strlen(dest) + 1;
-        char *newDest = getStaticPathBuffer(1);
-        if(newDest != dest)
-            OSBlockMove(newDest, dest, len, false);
-
+        len = strlen(newDest) + 1;
         ret = createDirectory(newDest);
         if(ret == FS_ERROR_OK)
         {
@@ -148,7 +207,7 @@ FSError moveDirectory(const char *src, const char *dest)
                 if(entry.info.flags & FS_STAT_DIRECTORY)
                 {
                     debugPrintf("\tmoveDirectory('%s', '%s')", newSrc, newDest);
-                    ret = moveDirectory(newSrc, newDest);
+                    ret = moveDirectoryIn(newSrc, newDest);
                 }
                 else
                 {
@@ -171,16 +230,27 @@ FSError moveDirectory(const char *src, const char *dest)
     return ret;
 }
 
+FSError moveDirectory(const char *src, const char *dest)
+{
+    char *newSrc = MEMAllocFromDefaultHeap(FS_MAX_PATH * 2);
+    if(newSrc == NULL)
+        return FS_ERROR_OUT_OF_RESOURCES;
+
+    char *newDest = newSrc + FS_MAX_PATH;
+    strcpy(newSrc, src);
+    strcpy(newDest, dest);
+    FSError ret = moveDirectoryIn(newSrc, newDest);
+    MEMFreeToDefaultHeap(newSrc);
+    return ret;
+}
+
 // There are no files > 4 GB on the Wii U, so size_t should be more than enough.
 size_t getFilesize(const char *path)
 {
-    char *newPath = getStaticPathBuffer(0);
-    strcpy(newPath, path);
-
     FSAStat stat;
     OSTime t = OSGetTime();
 
-    if(FSAGetStat(getFSAClient(), newPath, &stat) != FS_ERROR_OK)
+    if(FSAGetStat(getFSAClient(), path, &stat) != FS_ERROR_OK)
         return -1;
 
     t = OSGetTime() - t;
@@ -191,15 +261,12 @@ size_t getFilesize(const char *path)
 
 size_t readFile(const char *path, void **buffer)
 {
-    char *toScreen = getToFrameBuffer();
-    toScreen[0] = '\0';
     size_t filesize = getFilesize(path);
     if(filesize == (size_t)0)
         debugPrintf("Zero byte file: %s", path);
     else if(filesize != (size_t)-1)
     {
         FSAFileHandle handle;
-        path = getStaticPathBuffer(0); // getFilesize() setted it for us
         FSError err = FSAOpenFileEx(getFSAClient(), path, "r", 0x000, 0, 0, &handle);
         if(err == FS_ERROR_OK)
         {
@@ -213,7 +280,7 @@ size_t readFile(const char *path, void **buffer)
                     return filesize;
                 }
 
-                sprintf(toScreen, "Error reading %s: %s!", path, translateFSErr(err));
+                addToScreenLog("Error reading %s: %s!", path, translateFSErr(err));
                 MEMFreeToDefaultHeap(*buffer);
             }
             else
@@ -222,15 +289,12 @@ size_t readFile(const char *path, void **buffer)
             FSACloseFile(getFSAClient(), handle);
         }
         else
-            sprintf(toScreen, "Error opening %s: %s!", path, translateFSErr(err));
+            addToScreenLog("Error opening %s: %s!", path, translateFSErr(err));
     }
     else
-        sprintf(toScreen, "Error getting filesize for %s!", path);
+        addToScreenLog("Error getting filesize for %s!", path);
 
     *buffer = NULL;
-    if(toScreen[0] != '\0')
-        addToScreenLog(toScreen);
-
     return 0;
 }
 
@@ -277,6 +341,7 @@ size_t getDirsize(const char *path)
 // This uses informations from https://github.com/Maschell/nuspacker
 TMD_STATE verifyTmd(const TMD *tmd, size_t size)
 {
+    traceScope("verifyTmd");
     if(size >= sizeof(TMD) + (sizeof(TMD_CONTENT) * 9)) // Minimal title.tmd size
     {
         if(tmd->num_contents == tmd->content_infos[0].count) // Validate num_contents
@@ -23,6 +23,7 @@
 #include <config.h>
 #include <crypto.h>
 #include <input.h>
+#include <memTrack.h>
 #include <menu/utils.h>
 #include <messages.h>
 #include <renderer.h>
@@ -503,6 +504,14 @@ void readInput()
         OSBlockSet(kps, 0, sizeof(KPADStatus));
     }
 
+#ifdef NUSSPLI_DEBUG
+    if(vpad.trigger & VPAD_BUTTON_STICK_R)
+    {
+        toggleMemOverlay();
+        vpad.trigger &= ~VPAD_BUTTON_STICK_R;
+    }
+#endif
+
     if(vpad.trigger != 0)
     {
         OSTime t = OSGetSystemTime() - lastButtonPress;
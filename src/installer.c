@@ -20,7 +20,10 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 
+#include <contentCache.h>
 #include <crypto.h>
 #include <deinstaller.h>
 #include <file.h>
@@ -31,10 +34,11 @@
 #include <localisation.h>
 #include <menu/utils.h>
 #include <no-intro.h>
+#include <preflight.h>
 #include <renderer.h>
 #include <state.h>
-#include <staticMem.h>
 #include <ticket.h>
+#include <trace.h>
 #include <utils.h>
 
 #pragma GCC diagnostic ignored "-Wundef"
@@ -87,8 +91,16 @@ static void cleanupCancelledInstallation(NUSDEV dev, const char *path, bool toUs
     }
 }
 
-bool install(const char *game, bool hasDeps, NUSDEV dev, const char *path, bool toUsb, bool keepFiles, const TMD *tmd)
+static INSTALL_JOB *runningJob = NULL;
+
+/*
+ * Prepares the installation and hands it over to MCP.
+ * Returns 0 if MCP is installing in the background (finishInstall() has to be called then),
+ * 1 on error and 2 if there is nothing to install.
+ */
+int startInstall(INSTALL_JOB *job, const char *game, bool hasDeps, NUSDEV dev, const char *path, bool toUsb, bool keepFiles, const TMD *tmd)
 {
+    traceScope("startInstall");
     if(tmd != NULL)
     {
         MCPTitleListType titleEntry __attribute__((__aligned__(0x40)));
@@ -97,7 +109,7 @@ bool install(const char *game, bool hasDeps, NUSDEV dev, const char *path, bool
     }
 
     startNewFrame();
-    char *toScreen = getToFrameBuffer();
+    char toScreen[FS_MAX_PATH + 64];
     strcpy(toScreen, localise("Installing"));
     strcat(toScreen, " ");
     strcat(toScreen, game);
@@ -124,10 +136,11 @@ bool install(const char *game, bool hasDeps, NUSDEV dev, const char *path, bool
         size += tmd2->contents[i].size;
 
     if(!checkFreeSpace(toUsb ? getUSB() : NUSDEV_MLC, size))
-        return !(AppRunning(true));
+        return AppRunning(true) ? 1 : 2;
 
     // No-intro
-    char *tmpPath = getStaticPathBuffer(1);
+    recoverNoIntro(path);
+    char tmpPath[FS_MAX_PATH];
     size_t s = strlen(path);
     OSBlockMove(tmpPath, path, s, false);
     OSBlockMove(tmpPath + s, "title.tmd", sizeof("title.tmd"), false);
@@ -142,7 +155,7 @@ bool install(const char *game, bool hasDeps, NUSDEV dev, const char *path, bool
             const char *err = localise("Error transforming no-image set");
             addToScreenLog("Installation failed!");
             showErrorFrame(err);
-            return false;
+            return 1;
         }
     }
 
@@ -173,7 +186,7 @@ bool install(const char *game, bool hasDeps, NUSDEV dev, const char *path, bool
                             if(noIntro != NULL)
                                 revertNoIntro(noIntro);
 
-                            return install(game, hasDeps, dev, path, toUsb, keepFiles, tmd2);
+                            return startInstall(job, game, hasDeps, dev, path, toUsb, keepFiles, tmd2);
                         }
                         else
                             debugPrintf("Error fixing ticket!");
@@ -183,20 +196,32 @@ bool install(const char *game, bool hasDeps, NUSDEV dev, const char *path, bool
         }
     }
 
-    MCPInstallTitleInfo info __attribute__((__aligned__(0x40)));
-    McpData data;
+    // Catch missing or broken files before MCP spends time copying
+    PREFLIGHT_RESULT preflight;
+    if(!preflightInstall(path, tmd2, &preflight))
+    {
+        if(noIntro != NULL)
+            revertNoIntro(noIntro);
+
+        sprintf(toScreen, "%s \"%s\"\n", localise("Can't install"), path);
+        preflightToString(&preflight, toScreen + strlen(toScreen));
+        debugPrintf("%s", toScreen);
+        addToScreenLog("Installation failed!");
+        showErrorFrame(toScreen);
+        return 1;
+    }
 
     // Let's see if MCP is able to parse the TMD...
     OSTime t = OSGetSystemTime();
-    data.err = MCP_InstallGetInfo(mcpHandle, path, (MCPInstallInfo *)&info);
+    job->data.err = MCP_InstallGetInfo(mcpHandle, path, (MCPInstallInfo *)&job->info);
     t = OSGetSystemTime() - t;
     addEntropy(&t, sizeof(OSTime));
-    if(data.err != 0)
+    if(job->data.err != 0)
     {
         if(noIntro != NULL)
             revertNoIntro(noIntro);
 
-        switch(data.err)
+        switch(job->data.err)
         {
             case 0xfffbf3e2:
             noTmd:
@@ -206,26 +231,26 @@ bool install(const char *game, bool hasDeps, NUSDEV dev, const char *path, bool
                 sprintf(toScreen, "%s \"%s\"", localise("Internal error installing"), path);
                 break;
             default:
-                sprintf(toScreen, "%s \"%s\" %s: %#010x", localise("Error getting info for"), path, localise("from MCP"), data.err);
+                sprintf(toScreen, "%s \"%s\" %s: %#010x", localise("Error getting info for"), path, localise("from MCP"), job->data.err);
         }
 
-        debugPrintf(toScreen);
+        debugPrintf("%s", toScreen);
         addToScreenLog("Installation failed!");
         showErrorFrame(toScreen);
-        return false;
+        return 1;
     }
 
     // Allright, let's set if we want to install to USB or NAND
     MCPInstallTarget target = toUsb ? MCP_INSTALL_TARGET_USB : MCP_INSTALL_TARGET_MLC;
 
-    data.err = MCP_InstallSetTargetDevice(mcpHandle, target);
-    if(data.err == 0)
+    job->data.err = MCP_InstallSetTargetDevice(mcpHandle, target);
+    if(job->data.err == 0)
     {
         if(toUsb && getUSB() == NUSDEV_USB02)
-            data.err = MCP_InstallSetTargetUsb(mcpHandle, ++target);
+            job->data.err = MCP_InstallSetTargetUsb(mcpHandle, ++target);
     }
 
-    if(data.err != 0)
+    if(job->data.err != 0)
     {
         if(noIntro != NULL)
             revertNoIntro(noIntro);
@@ -233,65 +258,95 @@ bool install(const char *game, bool hasDeps, NUSDEV dev, const char *path, bool
         const char *err = localise(toUsb ? "Error opening USB device" : "Error opening internal memory");
         addToScreenLog("Installation failed!");
         showErrorFrame(err);
-        return false;
+        return 1;
     }
 
     // Just some debugging stuff
     debugPrintf("Path: %s (%d)", path, strlen(path));
 
+    // Copy everything finishInstall() needs as the callers buffers might get reused while MCP is busy
+    strncpy(job->game, game, MAX_TITLENAME_LENGTH - 1);
+    job->game[MAX_TITLENAME_LENGTH - 1] = '\0';
+    strncpy(job->path, path, FS_MAX_PATH - 1);
+    job->path[FS_MAX_PATH - 1] = '\0';
+    job->noIntro = noIntro;
+    job->size = size;
+    job->dev = dev;
+    job->hasDeps = hasDeps;
+    job->toUsb = toUsb;
+    job->keepFiles = keepFiles;
+
     // Last preparing step...
-    glueMcpData(&info, &data);
+    glueMcpData(&job->info, &job->data);
+
+    // Reserve the space now so checks done while MCP is busy see it
+    claimSpace(toUsb ? getUSB() : NUSDEV_MLC, size);
 
     // Start the installation process
-    t = OSGetSystemTime();
+    job->start = OSGetSystemTime();
     disableShutdown();
-    MCPError err = MCP_InstallTitleAsync(mcpHandle, path, &info);
+    MCPError err = MCP_InstallTitleAsync(mcpHandle, job->path, &job->info);
 
     if(err != 0)
     {
+        freeSpace(toUsb ? getUSB() : NUSDEV_MLC, size);
         if(noIntro != NULL)
             revertNoIntro(noIntro);
 
-        sprintf(toScreen, "%s \"%s\": %#010x", localise("Error starting async installation of"), path, data.err);
-        debugPrintf(toScreen);
+        sprintf(toScreen, "%s \"%s\": %#010x", localise("Error starting async installation of"), path, job->data.err);
+        debugPrintf("%s", toScreen);
         addToScreenLog("Installation failed!");
         showErrorFrame(toScreen);
         enableShutdown();
-        return false;
+        return 1;
     }
 
-    showMcpProgress(&data, game, true);
+    runningJob = job;
+    return 0;
+}
+
+/*
+ * Waits for MCP to finish the installation started by startInstall(),
+ * showing its progress and allowing to cancel it, and cleans up afterwards.
+ */
+bool finishInstall(INSTALL_JOB *job)
+{
+    traceScope("finishInstall");
+    showMcpProgress(&job->data, job->game, true);
+    runningJob = NULL;
     enableShutdown();
-    t = OSGetSystemTime() - t;
+    OSTime t = OSGetSystemTime() - job->start;
     addEntropy(&t, sizeof(OSTime));
 
     // MCP thread finished. Let's see if we got any error - TODO: This is a 1:1 copy&paste from WUP Installer GX2 which itself stole it from WUP Installer Y mod which got it from WUP Installer minor edit by Nexocube who got it from WUP installer JHBL Version by Dimrok who portet it from the ASM of WUP Installer. So I think it's time for something new... ^^
-    if(data.err != 0)
+    if(job->data.err != 0)
     {
-        if(keepFiles && noIntro != NULL)
-            revertNoIntro(noIntro);
+        freeSpace(job->toUsb ? getUSB() : NUSDEV_MLC, job->size);
+        if(job->keepFiles && job->noIntro != NULL)
+            revertNoIntro(job->noIntro);
 
-        debugPrintf("Installation failed with result: %#010x", data.err);
+        debugPrintf("Installation failed with result: %#010x", job->data.err);
+        char toScreen[1024];
         strcpy(toScreen, localise("Installation failed!"));
         strcat(toScreen, "\n\n");
-        switch(data.err)
+        switch(job->data.err)
         {
             case CUSTOM_MCP_ERROR_CANCELLED:
-                cleanupCancelledInstallation(dev, path, toUsb, keepFiles);
+                cleanupCancelledInstallation(job->dev, job->path, job->toUsb, job->keepFiles);
                 // The fallthrough here is by design, don't listen to the compiler!
             case CUSTOM_MCP_ERROR_EOM:
                 return true;
             case 0xFFFCFFE9:
-                if(hasDeps)
+                if(job->hasDeps)
                 {
                     strcat(toScreen, "Install the main game to the same storage medium first");
-                    if(toUsb)
+                    if(job->toUsb)
                     {
                         strcat(toScreen, "\n");
                         strcat(toScreen, localise("Also make sure there is no error with the USB drive"));
                     }
                 }
-                else if(toUsb)
+                else if(job->toUsb)
                     strcat(toScreen, localise("Possible USB error"));
                 break;
             case 0xFFFBF446:
@@ -315,9 +370,9 @@ bool install(const char *game, bool hasDeps, NUSDEV dev, const char *path, bool
                 strcat(toScreen, localise("Files might be corrupt or bad storage medium.\nTry redownloading files or reformat/replace target device"));
                 break;
             default:
-                if((data.err & 0xFFFF0000) == 0xFFFB0000)
+                if((job->data.err & 0xFFFF0000) == 0xFFFB0000)
                 {
-                    if(dev & NUSDEV_USB)
+                    if(job->dev & NUSDEV_USB)
                     {
                         strcat(toScreen, localise("Possible USB failure. Check your drives power source."));
                         strcat(toScreen, "\n");
@@ -326,7 +381,7 @@ bool install(const char *game, bool hasDeps, NUSDEV dev, const char *path, bool
                     strcat(toScreen, localise("Files might be corrupt"));
                 }
                 else
-                    sprintf(toScreen + strlen(toScreen), "%s: %#010x", localise("Unknown Error"), data.err);
+                    sprintf(toScreen + strlen(toScreen), "%s: %#010x", localise("Unknown Error"), job->data.err);
         }
 
         addToScreenLog("Installation failed!");
@@ -334,20 +389,19 @@ bool install(const char *game, bool hasDeps, NUSDEV dev, const char *path, bool
         return false;
     }
 
-    claimSpace(toUsb ? getUSB() : NUSDEV_MLC, size);
-
-    if(keepFiles && noIntro != NULL)
-        revertNoIntro(noIntro);
+    if(job->keepFiles && job->noIntro != NULL)
+        revertNoIntro(job->noIntro);
 
     addToScreenLog("Installation finished!");
 
-    if(!keepFiles && dev == NUSDEV_SD)
+    if(!job->keepFiles && job->dev == NUSDEV_SD)
     {
+        storeInCache(job->path);
 #ifdef NUSSPLI_DEBUG
         debugPrintf("Removing installation files...");
         FSError ret =
 #endif
-            removeDirectory(path);
+            removeDirectory(job->path);
 #ifdef NUSSPLI_DEBUG
         if(ret != FS_ERROR_OK)
             debugPrintf("Couldn't remove installation files from SD card: %s", translateFSErr(ret));
@@ -356,3 +410,41 @@ bool install(const char *game, bool hasDeps, NUSDEV dev, const char *path, bool
 
     return true;
 }
+
+bool install(const char *game, bool hasDeps, NUSDEV dev, const char *path, bool toUsb, bool keepFiles, const TMD *tmd)
+{
+    traceScope("install");
+    INSTALL_JOB job;
+    switch(startInstall(&job, game, hasDeps, dev, path, toUsb, keepFiles, tmd))
+    {
+        case 0:
+            return finishInstall(&job);
+        case 1:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// Draws the progress of an installation running in the background, returns the number of lines used
+int installToFrame(int line)
+{
+    if(runningJob == NULL || !runningJob->data.processing)
+        return 0;
+
+    MCPInstallProgress progress __attribute__((__aligned__(0x40)));
+    if(MCP_InstallGetProgress(mcpHandle, &progress) != IOS_ERROR_OK || progress.inProgress != 1 || progress.sizeTotal == 0)
+        return 0;
+
+    char toScreen[MAX_TITLENAME_LENGTH + 64];
+    strcpy(toScreen, localise("Installing"));
+    strcat(toScreen, " ");
+    strcat(toScreen, runningJob->game);
+    textToFrame(line, 0, toScreen);
+    barToFrame(++line, 0, 29, (float)progress.sizeProgress / (float)progress.sizeTotal);
+    humanize(progress.sizeProgress, toScreen);
+    strcat(toScreen, " / ");
+    humanize(progress.sizeTotal, toScreen + strlen(toScreen));
+    textToFrame(line, 30, toScreen);
+    return 2;
+}
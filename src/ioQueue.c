@@ -35,9 +35,11 @@
 #include <filesystem.h>
 #include <input.h>
 #include <ioQueue.h>
+#include <memTrack.h>
 #include <renderer.h>
 #include <state.h>
 #include <thread.h>
+#include <trace.h>
 #include <utils.h>
 
 #define IO_MAX_FILE_BUFFER   (1024 * 1024) // 1 MB
@@ -83,7 +85,9 @@ static int ioThreadMain(int argc, const char **argv)
 
         if(entry->size) // WRITE command
         {
+            traceBegin("FSAWriteFile");
             err = FSAWriteFile(getFSAClient(), (void *)entry->buf, entry->size, 1, entry->file, 0);
+            traceEnd("FSAWriteFile");
             if(err != 1)
                 goto ioError;
 
@@ -92,7 +96,9 @@ static int ioThreadMain(int argc, const char **argv)
         else // Close command
         {
             OSTime t = OSGetTime();
+            traceBegin("FSACloseFile");
             err = FSACloseFile(getFSAClient(), entry->file);
+            traceEnd("FSACloseFile");
             if(err != FS_ERROR_OK)
                 goto ioError;
 
@@ -106,6 +112,7 @@ static int ioThreadMain(int argc, const char **argv)
         activeWriteBuffer = asl;
         entry->file = 0;
         entry = queueEntries + asl;
+        traceCounter("I/O queue", (activeReadBuffer + MAX_IO_QUEUE_ENTRIES - asl) % MAX_IO_QUEUE_ENTRIES);
     }
 
     return 0;
@@ -117,10 +124,10 @@ ioError:
 
 bool initIOThread()
 {
-    queueEntries = MEMAllocFromDefaultHeap(MAX_IO_QUEUE_ENTRIES * sizeof(WriteQueueEntry));
+    queueEntries = memAlloc(MEM_TAG_IO, MAX_IO_QUEUE_ENTRIES * sizeof(WriteQueueEntry));
     if(queueEntries != NULL)
     {
-        uint8_t *buf = MEMAllocFromDefaultHeapEx(MAX_IO_QUEUE_ENTRIES * IO_MAX_FILE_BUFFER, 0x40);
+        uint8_t *buf = memAllocEx(MEM_TAG_IO, MAX_IO_QUEUE_ENTRIES * IO_MAX_FILE_BUFFER, 0x40);
         if(buf != NULL)
         {
             for(int i = 0; i < MAX_IO_QUEUE_ENTRIES; ++i, buf += IO_MAX_FILE_BUFFER)
@@ -138,10 +145,10 @@ bool initIOThread()
                 return true;
 
             ioRunning = false;
-            MEMFreeToDefaultHeap(buf);
+            memFree(MEM_TAG_IO, buf);
         }
 
-        MEMFreeToDefaultHeap(queueEntries);
+        memFree(MEM_TAG_IO, queueEntries);
     }
 
     return false;
@@ -195,8 +202,8 @@ void shutdownIOThread()
 #else
     stopThread(ioThread, NULL);
 #endif
-    MEMFreeToDefaultHeap((void *)queueEntries[0].buf);
-    MEMFreeToDefaultHeap(queueEntries);
+    memFree(MEM_TAG_IO, (void *)queueEntries[0].buf);
+    memFree(MEM_TAG_IO, queueEntries);
 }
 
 size_t addToIOQueue(const void *buf, size_t size, size_t n, FSAFileHandle file)
@@ -280,6 +287,7 @@ retryAddingToQueue:
 
 void flushIOQueue()
 {
+    traceScope("flushIOQueue");
     OSMemoryBarrier();
     if(queueEntries[activeWriteBuffer].file != 0)
     {
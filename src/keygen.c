@@ -22,7 +22,9 @@
 #include <string.h>
 
 #include <crypto.h>
+#include <keygen.h>
 #include <otp.h>
+#include <thread.h>
 #include <titles.h>
 #include <utils.h>
 
@@ -36,6 +38,15 @@
 static const uint8_t KEYGEN_SECRET[10] = { 0xfd, 0x04, 0x01, 0x05, 0x06, 0x0b, 0x11, 0x1c, 0x2d, 0x49 };
 static const TitleEntry unkEnt = { .key = TITLE_KEY_mypass };
 
+// Title keys of recently used titles, so bulk operations don't derive them again
+static struct
+{
+    uint64_t tid;
+    uint8_t key[16];
+} keyCache[KEY_CACHE_SIZE];
+static int keyCacheNext = 0;
+static spinlock keyCacheLock = SPINLOCK_FREE;
+
 static inline const char *transformPassword(TITLE_KEY in)
 {
     switch(in)
@@ -64,7 +75,7 @@ static inline const char *transformPassword(TITLE_KEY in)
     return NULL; // Should never happen
 }
 
-bool generateKey(uint64_t tid, uint8_t *out)
+static bool deriveKey(mbedtls_md_context_t *ctx, uint64_t tid, uint8_t *out)
 {
     const uint8_t *ti = (const uint8_t *)&tid;
     size_t i;
@@ -93,9 +104,7 @@ bool generateKey(uint64_t tid, uint8_t *out)
         entry = &unkEnt;
 
     const char *pw = transformPassword(entry->key);
-    mbedtls_md_context_t ctx;
-    mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA1), 1);
-    if(mbedtls_pkcs5_pbkdf2_hmac(&ctx, (const unsigned char *)pw, strlen(pw), key, 16, 20, 16, key) != 0)
+    if(mbedtls_pkcs5_pbkdf2_hmac(ctx, (const unsigned char *)pw, strlen(pw), key, 16, 20, 16, key) != 0)
         return false;
 
     // The final key needs to be AES encrypted with the Wii U common key and part of the title ID padded with zeroes as IV
@@ -103,3 +112,75 @@ bool generateKey(uint64_t tid, uint8_t *out)
     OSBlockSet(out + 8, 0, 8);
     return encryptAES(key, 16, getCommonKey(), out, out);
 }
+
+static bool getCachedKey(uint64_t tid, uint8_t *out)
+{
+    bool ret = false;
+    spinLock(keyCacheLock);
+    for(int i = 0; i < KEY_CACHE_SIZE; ++i)
+    {
+        if(keyCache[i].tid == tid)
+        {
+            OSBlockMove(out, keyCache[i].key, 16, false);
+            ret = true;
+            break;
+        }
+    }
+
+    spinReleaseLock(keyCacheLock);
+    return ret;
+}
+
+static void cacheKey(uint64_t tid, const uint8_t *key)
+{
+    spinLock(keyCacheLock);
+    keyCache[keyCacheNext].tid = tid;
+    OSBlockMove(keyCache[keyCacheNext].key, key, 16, false);
+    keyCacheNext = (keyCacheNext + 1) % KEY_CACHE_SIZE;
+    spinReleaseLock(keyCacheLock);
+}
+
+static bool initHmac(mbedtls_md_context_t *ctx)
+{
+    mbedtls_md_init(ctx);
+    if(mbedtls_md_setup(ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA1), 1) == 0)
+        return true;
+
+    mbedtls_md_free(ctx);
+    return false;
+}
+
+bool generateKey(uint64_t tid, uint8_t *out)
+{
+    return generateKeys(&tid, 1, out);
+}
+
+// Generates the keys for multiple titles, out needs room for 16 bytes per title
+bool generateKeys(const uint64_t *tids, size_t count, uint8_t *out)
+{
+    mbedtls_md_context_t ctx;
+    bool hmac = false;
+    bool ret = true;
+    for(size_t i = 0; i < count; ++i, out += 16)
+    {
+        if(getCachedKey(tids[i], out))
+            continue;
+
+        if(!hmac)
+        {
+            hmac = initHmac(&ctx);
+            if(!hmac)
+                return false;
+        }
+
+        if(deriveKey(&ctx, tids[i], out))
+            cacheKey(tids[i], out);
+        else
+            ret = false;
+    }
+
+    if(hmac)
+        mbedtls_md_free(&ctx);
+
+    return ret;
+}
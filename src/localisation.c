@@ -27,6 +27,7 @@
 #include <file.h>
 #include <filesystem.h>
 #include <list.h>
+#include <memTrack.h>
 #include <utils.h>
 
 #include <jansson.h>
@@ -71,21 +72,24 @@ static void addMSG(const char *msgid, const char *msgstr)
     if(!msgstr)
         return;
 
-    hashMsg *msg = MEMAllocFromDefaultHeap(sizeof(hashMsg));
+    hashMsg *msg = memAlloc(MEM_TAG_LOCALE, sizeof(hashMsg));
     if(msg == NULL)
         return;
 
     msg->hash = hash_string((unsigned char *)msgid);
-    msg->msgstr = strdup(msgstr);
-    if(msg->msgstr != NULL)
+    size_t len = strlen(msgstr) + 1;
+    char *str = memAlloc(MEM_TAG_LOCALE, len);
+    if(str != NULL)
     {
+        OSBlockMove(str, msgstr, len, false);
+        msg->msgstr = str;
         if(addToListEnd(baseMSG, msg))
             return;
 
-        MEMFreeToDefaultHeap((void *)(msg->msgstr));
+        memFree(MEM_TAG_LOCALE, str);
     }
 
-    MEMFreeToDefaultHeap(msg);
+    memFree(MEM_TAG_LOCALE, msg);
 }
 
 void locCleanUp()
@@ -94,9 +98,12 @@ void locCleanUp()
     {
         hashMsg *msg;
         forEachListEntry(baseMSG, msg)
-            MEMFreeToDefaultHeap((void *)(msg->msgstr));
+        {
+            memFree(MEM_TAG_LOCALE, (void *)(msg->msgstr));
+            memFree(MEM_TAG_LOCALE, msg);
+        }
 
-        destroyList(baseMSG, true);
+        destroyList(baseMSG, false);
         baseMSG = NULL;
     }
 }
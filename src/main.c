@@ -26,6 +26,7 @@
 
 #include <cfw.h>
 #include <config.h>
+#include <contentCache.h>
 #include <crypto.h>
 #include <downloader.h>
 #include <file.h>
@@ -34,9 +35,11 @@
 #include <installer.h>
 #include <ioQueue.h>
 #include <localisation.h>
+#include <memTrack.h>
 #include <menu/download.h>
 #include <menu/main.h>
 #include <menu/utils.h>
+#include <netStats.h>
 #include <notifications.h>
 #include <osdefs.h>
 #include <otp.h>
@@ -48,6 +51,7 @@
 #include <thread.h>
 #include <ticket.h>
 #include <titles.h>
+#include <trace.h>
 #include <updater.h>
 #include <utils.h>
 
@@ -138,6 +142,10 @@ static void innerMain()
                                         {
                                             drawLoadingScreen("I/O thread initialized!", "Loading config...");
                                             initConfig();
+                                            initContentCache();
+                                            if(logExportEnabled() && !startScreenLogExport())
+                                                addToScreenLog("WARNING: Couldn't open log file!");
+
                                             drawLoadingScreen("Config loaded!", "Loading SWKBD...");
                                             if(SWKBD_Init())
                                             {
@@ -151,6 +159,9 @@ static void innerMain()
                                                         checkStacks("main");
                                                         mainMenu(); // main loop
                                                         drawByeFrame();
+                                                        exportTrace();
+                                                        clearNetStats();
+                                                        dumpMemReport();
                                                         checkStacks("main");
                                                         debugPrintf("Deinitializing libraries...");
                                                     }
@@ -168,7 +179,9 @@ static void innerMain()
                                             else
                                                 lerr = "Couldn't initialize SWKBD!";
 
+                                            shutdownContentCache();
                                             saveConfig(false);
+                                            stopScreenLogExport();
                                             shutdownIOThread();
                                             debugPrintf("I/O thread closed");
                                         }
@@ -242,12 +255,14 @@ static void innerMain()
 int main()
 {
     initState();
+    initTrace();
     innerMain();
 
     deinitCfw();
 
 #ifdef NUSSPLI_DEBUG
     checkStacks("main");
+    shutdownTrace();
     debugPrintf("Bye!");
     shutdownDebug();
 #endif
@@ -0,0 +1,207 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <wut-fixups.h>
+
+#ifdef NUSSPLI_DEBUG
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <memTrack.h>
+#include <thread.h>
+#include <utils.h>
+
+#ifdef __WIIU__
+#include <filesystem.h>
+
+#pragma GCC diagnostic ignored "-Wundef"
+#include <coreinit/filesystem_fsa.h>
+#include <coreinit/memexpheap.h>
+#include <coreinit/memheap.h>
+#pragma GCC diagnostic pop
+
+#define blockSize(ptr) MEMGetSizeForMBlockExpHeap(ptr)
+#else
+// Host builds map the default heap to malloc()
+#include <malloc.h>
+
+#define blockSize(ptr) malloc_usable_size(ptr)
+#endif
+
+typedef struct
+{
+    int64_t live;
+    int64_t peak;
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t failed;
+} MEM_STATS;
+
+static const char *const tagNames[MEM_TAG_COUNT] = {
+    "Other",
+    "Lists",
+    "Threads",
+    "I/O queue",
+    "Downloads",
+    "Locale",
+    "Renderer",
+    "Cache",
+    "Debug",
+};
+
+static MEM_STATS stats[MEM_TAG_COUNT];
+static spinlock statsLock = SPINLOCK_FREE;
+static bool overlay = false;
+
+/*
+ * The size gets taken from the heap block itself so nothing has to be
+ * stored next to the allocation. Freeing with the wrong tag only skews the
+ * numbers, it can't corrupt the heap.
+ */
+static void *account(MEM_TAG tag, void *ptr)
+{
+    spinLock(statsLock);
+    if(ptr == NULL)
+        ++stats[tag].failed;
+    else
+    {
+        ++stats[tag].allocs;
+        stats[tag].live += blockSize(ptr);
+        if(stats[tag].live > stats[tag].peak)
+            stats[tag].peak = stats[tag].live;
+    }
+
+    spinReleaseLock(statsLock);
+    return ptr;
+}
+
+void *memAlloc(MEM_TAG tag, uint32_t size)
+{
+    return account(tag, MEMAllocFromDefaultHeap(size));
+}
+
+void *memAllocEx(MEM_TAG tag, uint32_t size, int align)
+{
+    return account(tag, MEMAllocFromDefaultHeapEx(size, align));
+}
+
+void memFree(MEM_TAG tag, void *ptr)
+{
+    if(ptr == NULL)
+        return;
+
+    spinLock(statsLock);
+    ++stats[tag].frees;
+    stats[tag].live -= blockSize(ptr);
+    spinReleaseLock(statsLock);
+
+    MEMFreeToDefaultHeap(ptr);
+}
+
+// Free and largest free block of the default heap, 0 on host builds
+static void getHeapInfo(uint32_t *freeSize, uint32_t *largest)
+{
+#ifdef __WIIU__
+    MEMHeapHandle heap = MEMGetBaseHeapHandle(MEM_BASE_HEAP_MEM2);
+    *freeSize = MEMGetTotalFreeSizeForExpHeap(heap);
+    *largest = MEMGetAllocatableSizeForExpHeapEx(heap, 4);
+#else
+    *freeSize = *largest = 0;
+#endif
+}
+
+// How much of the free memory isn't usable for one big block, in percent
+static uint32_t getFragmentation(uint32_t freeSize, uint32_t largest)
+{
+    return freeSize == 0 ? 0 : 100 - (uint32_t)(((uint64_t)largest * 100) / freeSize);
+}
+
+void getMemOverlayString(char *out)
+{
+    uint32_t freeSize;
+    uint32_t largest;
+    getHeapInfo(&freeSize, &largest);
+
+    int64_t live = 0;
+    spinLock(statsLock);
+    for(int i = 0; i < MEM_TAG_COUNT; ++i)
+        live += stats[i].live;
+    spinReleaseLock(statsLock);
+
+    sprintf(out, "Heap: %u KB free | %u KB largest | %u%% frag | %" PRId64 " KB tracked", freeSize >> 10, largest >> 10, getFragmentation(freeSize, largest), live >> 10);
+}
+
+bool memOverlayEnabled()
+{
+    return overlay;
+}
+
+void toggleMemOverlay()
+{
+    overlay = !overlay;
+    if(overlay)
+        dumpMemReport();
+}
+
+/*
+ * Logs the per tag statistics and, on the console, writes them to the SD
+ * card, too. Use this to size buffers against the real headroom.
+ */
+void dumpMemReport()
+{
+    char *report = MEMAllocFromDefaultHeap(0x800);
+    if(report == NULL)
+        return;
+
+    uint32_t freeSize;
+    uint32_t largest;
+    getHeapInfo(&freeSize, &largest);
+    size_t size = sprintf(report, "Heap: %u KB free, %u KB largest free block, %u%% fragmentation\n", freeSize >> 10, largest >> 10, getFragmentation(freeSize, largest));
+    size += sprintf(report + size, "%-10s %10s %10s %8s %8s %6s\n", "Tag", "Live KB", "Peak KB", "Allocs", "Frees", "Failed");
+
+    MEM_STATS copy[MEM_TAG_COUNT];
+    spinLock(statsLock);
+    for(int i = 0; i < MEM_TAG_COUNT; ++i)
+        copy[i] = stats[i];
+    spinReleaseLock(statsLock);
+
+    for(int i = 0; i < MEM_TAG_COUNT; ++i)
+        size += sprintf(report + size, "%-10s %10" PRId64 " %10" PRId64 " %8u %8u %6u\n", tagNames[i], copy[i].live >> 10, copy[i].peak >> 10, copy[i].allocs, copy[i].frees, copy[i].failed);
+
+    // debugPrintf() can't handle the whole report at once
+    for(char *line = report, *end; *line != '\0'; line = end + 1)
+    {
+        end = strchr(line, '\n');
+        debugPrintf("%.*s", (int)(end - line), line);
+    }
+
+#ifdef __WIIU__
+    FSAFileHandle file;
+    if(FSAOpenFileEx(getFSAClient(), MEM_REPORT_PATH, "w", 0x660, FS_OPEN_FLAG_NONE, 0, &file) == FS_ERROR_OK)
+    {
+        FSAWriteFile(getFSAClient(), report, size, 1, file, 0);
+        FSACloseFile(getFSAClient(), file);
+    }
+#endif
+
+    MEMFreeToDefaultHeap(report);
+}
+
+#endif // ifdef NUSSPLI_DEBUG
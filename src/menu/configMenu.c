@@ -19,6 +19,7 @@
 
 #include <wut-fixups.h>
 
+#include <stdio.h>
 #include <string.h>
 
 #include <config.h>
@@ -35,7 +36,7 @@
 #include <coreinit/mcp.h>
 #pragma GCC diagnostic pop
 
-#define ENTRY_COUNT 4
+#define ENTRY_COUNT 7
 
 static int cursorPos = 0;
 
@@ -69,6 +70,24 @@ static void drawConfigMenu()
     strcat(toScreen, localise(getFormattedRegion(getRegion())));
     textToFrame(4, 4, toScreen);
 
+    strcpy(toScreen, localise("Low power downloads:"));
+    strcat(toScreen, " ");
+    strcat(toScreen, localise(lowPowerEnabled() ? "Enabled" : "Disabled"));
+    textToFrame(5, 4, toScreen);
+
+    strcpy(toScreen, localise("Save log to SD:"));
+    strcat(toScreen, " ");
+    strcat(toScreen, localise(logExportEnabled() ? "Enabled" : "Disabled"));
+    textToFrame(6, 4, toScreen);
+
+    strcpy(toScreen, localise("Content cache:"));
+    strcat(toScreen, " ");
+    if(getContentCacheSize() == 0)
+        strcat(toScreen, localise("Disabled"));
+    else
+        sprintf(toScreen + strlen(toScreen), "%u GB", getContentCacheSize());
+    textToFrame(7, 4, toScreen);
+
     lineToFrame(MAX_LINES - 2, SCREEN_COLOR_WHITE);
     textToFrame(MAX_LINES - 1, ALIGNED_CENTER, localise("Press " BUTTON_B " to return"));
 
@@ -199,6 +218,17 @@ static inline void switchNotificationMethod()
     setNotificationMethod(m);
 }
 
+static inline void switchContentCacheSize()
+{
+    uint32_t size = getContentCacheSize();
+    if(vpad.trigger & VPAD_BUTTON_LEFT)
+        size = size == 0 ? 32 : size >> 1;
+    else
+        size = size == 0 ? 1 : (size == 32 ? 0 : size << 1);
+
+    setContentCacheSize(size);
+}
+
 static inline void switchRegion()
 {
     MCPRegion reg = getRegion();
@@ -283,6 +313,15 @@ void configMenu()
                 case 4:
                     switchRegion();
                     break;
+                case 5:
+                    setLowPower(!lowPowerEnabled());
+                    break;
+                case 6:
+                    setLogExport(!logExportEnabled());
+                    break;
+                case 7:
+                    switchContentCacheSize();
+                    break;
             }
 
             redraw = true;
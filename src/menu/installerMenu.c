@@ -33,6 +33,7 @@
 #include <state.h>
 #include <tmd.h>
 #include <utils.h>
+#include <verifier.h>
 
 #pragma GCC diagnostic ignored "-Wundef"
 #include <coreinit/filesystem_fsa.h>
@@ -52,7 +53,8 @@ static bool addToOpQueue(const TitleEntry *entry, const char *dir, const TMD *tm
     titleInfo->rambuf = NULL;
     titleInfo->operation = OPERATION_INSTALL;
     titleInfo->entry = entry;
-    strcpy(titleInfo->folderName, dir);
+    titleInfo->titleVer[0] = '\0';
+    titleInfo->folderName = dir;
     titleInfo->dlDev = fromDev;
     titleInfo->toUSB = toUSB;
     titleInfo->keepFiles = keepFiles;
@@ -132,7 +134,10 @@ static void drawInstallerMenuFrame(const char *name, NUSDEV dev, NUSDEV toDev, b
     strcat(toFrame, localise(BUTTON_PLUS " to start"));
     textToFrame(MAX_LINES - 2, ALIGNED_CENTER, toFrame);
 
-    textToFrame(MAX_LINES - 1, ALIGNED_CENTER, localise(BUTTON_MINUS " to add to the queue"));
+    strcpy(toFrame, localise(BUTTON_MINUS " to add to the queue"));
+    strcat(toFrame, " || ");
+    strcat(toFrame, localise(BUTTON_Y " to verify"));
+    textToFrame(MAX_LINES - 1, ALIGNED_CENTER, toFrame);
 
     drawFrame();
 }
@@ -219,6 +224,11 @@ refreshDir:
 
             goto grabNewDir;
         }
+        else if(vpad.trigger & VPAD_BUTTON_Y)
+        {
+            verifyFolder(dir, tmd, nd);
+            redraw = true;
+        }
         else if(vpad.trigger & (VPAD_BUTTON_A | VPAD_BUTTON_RIGHT | VPAD_BUTTON_LEFT))
         {
             switch(cursorPos)
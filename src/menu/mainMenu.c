@@ -22,6 +22,7 @@
 
 #include <string.h>
 
+#include <bulkConvert.h>
 #include <input.h>
 #include <installer.h>
 #include <localisation.h>
@@ -61,6 +62,7 @@ static void drawMainMenuFrame()
     textToFrame(line++, 4, localise("Download content"));
     textToFrame(line++, 4, localise("Install content"));
     textToFrame(line++, 4, localise("Generate a fake <title.tik> file"));
+    textToFrame(line++, 4, localise("Prepare install folders"));
     textToFrame(line++, 4, localise("Browse installed titles"));
     textToFrame(line++, 4, localise("Options"));
     textToFrame(line++, 4, localise("Logs"));
@@ -125,12 +127,18 @@ void mainMenu()
                     generateFakeTicket();
                     break;
                 case 14:
-                    ititleBrowserMenu();
+                    if(bulkConvert())
+                        showFinishedScreen(localise("Install folders"), FINISHING_OPERATION_CONVERT);
+                    else
+                        showErrorFrame(localise("Some folders couldn't be prepared!\nSee the log for details."));
                     break;
                 case 15:
-                    configMenu();
+                    ititleBrowserMenu();
                     break;
                 case 16:
+                    configMenu();
+                    break;
+                case 17:
                     logsMenu();
                     break;
             }
@@ -139,7 +147,7 @@ void mainMenu()
         }
         else if(vpad.trigger & VPAD_BUTTON_DOWN)
         {
-            if(++cursorPos == 17)
+            if(++cursorPos == 18)
                 cursorPos = 11;
 
             redraw = true;
@@ -147,7 +155,7 @@ void mainMenu()
         else if(vpad.trigger & VPAD_BUTTON_UP)
         {
             if(--cursorPos == 10)
-                cursorPos = 16;
+                cursorPos = 17;
 
             redraw = true;
         }
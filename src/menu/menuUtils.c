@@ -28,13 +28,15 @@
 #include <file.h>
 #include <filesystem.h>
 #include <input.h>
-#include <list.h>
 #include <localisation.h>
 #include <menu/utils.h>
+#include <messages.h>
+#include <netStats.h>
 #include <notifications.h>
 #include <renderer.h>
 #include <state.h>
 #include <stdio.h>
+#include <thread.h>
 #include <titles.h>
 #include <tmd.h>
 #include <utils.h>
@@ -44,74 +46,208 @@
 #include <coreinit/mcp.h>
 #include <coreinit/memdefaultheap.h>
 #include <coreinit/memory.h>
+#include <coreinit/messagequeue.h>
 #pragma GCC diagnostic pop
 
-static LIST *logList = NULL;
+#define LOG_LINES     256 // Must be a power of 2 and at least MAX_LINES
+#define LOG_LINE_SIZE (MAX_CHARS + 2)
+#define LOG_PATH      NUSDIR_SD "NUSspli.log"
+#define LOG_PATH_OLD  LOG_PATH ".1"
+#define LOG_BUFSIZE   (16 * 1024)
+
+typedef struct
+{
+    volatile uint32_t seq; // Line number + 1 once the line is complete, 0 while it's written
+    char text[LOG_LINE_SIZE];
+} LOG_SLOT;
+
+// The ring holds more lines than the screen can show so the log writer can lag behind a bit
+static LOG_SLOT logRing[LOG_LINES];
+static volatile uint32_t logHead = 0; // Total lines added, the newest line is logHead - 1
+static uint32_t logTail = 0; // Oldest line still in the ring
+
+static OSThread *logThread = NULL;
+static OSMessageQueue logQueue;
+static OSMessage logMsg[2];
+static FSAFileHandle logFile;
+static uint32_t logWritten;
+static uint32_t logDropped;
+static bool logRotated = false; // NUSspli.log belongs to this run
+static char logBuffer[LOG_BUFSIZE] __attribute__((__aligned__(0x40)));
 
 void addToScreenLog(const char *str, ...)
 {
-    if(logList == NULL)
-    {
-        logList = createList();
-        if(logList == NULL)
-            return;
-    }
+    uint32_t head = logHead;
+    LOG_SLOT *slot = logRing + (head & (LOG_LINES - 1));
+    char *line = slot->text;
 
-    char *line;
-    if(getListSize(logList) == MAX_LINES)
-        line = wrapFirstEntry(logList);
-    else
-    {
-        line = MEMAllocFromDefaultHeap(MAX_CHARS + 2);
-        if(line == NULL)
-            return;
-
-        if(!addToListEnd(logList, line))
-        {
-            MEMFreeToDefaultHeap(line);
-            return;
-        }
-    }
+    slot->seq = 0;
+    OSMemoryBarrier();
 
     va_list va;
     va_start(va, str);
-    vsnprintf(line, MAX_CHARS + 2, str, va);
+    vsnprintf(line, LOG_LINE_SIZE, str, va);
     va_end(va);
 
-    debugPrintf(line);
+    OSMemoryBarrier();
+    slot->seq = head + 1;
+    logHead = ++head;
+    if(head - logTail > LOG_LINES)
+        logTail = head - LOG_LINES;
+
+    debugPrintf("%s", line);
+
+    if(logThread != NULL)
+    {
+        OSMessage msg = { .message = NUSSPLI_MESSAGE_NONE };
+        OSSendMessage(&logQueue, &msg, OS_MESSAGE_FLAGS_NONE);
+    }
 }
 
 void clearScreenLog()
 {
-    if(logList == NULL)
-        return;
-
-    destroyList(logList, true);
-    logList = NULL;
+    logHead = logTail = 0;
+    for(int i = 0; i < LOG_LINES; ++i)
+        logRing[i].seq = 0;
 }
 
 void writeScreenLog(int line)
 {
-    int i;
+    uint32_t visible;
     if(line != -1)
     {
         lineToFrame(line, SCREEN_COLOR_WHITE);
-        i = line + 2;
+        if(line >= MAX_LINES - 1)
+            return;
+
+        visible = MAX_LINES - (line + 1);
     }
     else
-        i = 1;
+        visible = MAX_LINES;
 
-    if(logList == NULL)
-        return;
+    uint32_t i = logHead;
+    i = i - logTail > visible ? i - visible : logTail;
+    for(; i != logHead; ++i)
+        textToFrame(++line, 0, logRing[i & (LOG_LINES - 1)].text);
+}
 
-    const char *text;
-    forEachListEntry(logList, text)
+static void writeLogLines()
+{
+    uint32_t head = logHead;
+    if(head - logWritten > LOG_LINES)
+    {
+        logDropped += head - logWritten - LOG_LINES;
+        logWritten = head - LOG_LINES;
+    }
+
+    size_t size = 0;
+    size_t len;
+    const LOG_SLOT *slot;
+    while(logWritten != head)
     {
-        if(i == 1)
-            textToFrame(++line, 0, text);
+        slot = logRing + (logWritten & (LOG_LINES - 1));
+        if(slot->seq != logWritten + 1) // Already overwritten or still being written
+        {
+            ++logDropped;
+            ++logWritten;
+            continue;
+        }
+
+        OSMemoryBarrier();
+        len = strnlen(slot->text, LOG_LINE_SIZE - 1);
+        if(size + len + 1 > LOG_BUFSIZE)
+            break;
+
+        OSBlockMove(logBuffer + size, slot->text, len, false);
+        // The main thread might have started to overwrite the line while we copied it
+        OSMemoryBarrier();
+        if(slot->seq == logWritten + 1)
+        {
+            size += len;
+            logBuffer[size++] = '\n';
+        }
         else
-            --i;
+            ++logDropped;
+
+        ++logWritten;
     }
+
+    if(size != 0)
+    {
+        FSAWriteFile(getFSAClient(), logBuffer, size, 1, logFile, 0);
+        FSAFlushFile(getFSAClient(), logFile);
+    }
+}
+
+static int logThreadMain(int argc, const char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    OSMessage msg;
+    do
+    {
+        OSReceiveMessage(&logQueue, &msg, OS_MESSAGE_FLAGS_BLOCKING);
+        writeLogLines();
+    } while(msg.message != NUSSPLI_MESSAGE_EXIT);
+
+    // Catch up with lines which didn't fit into the last batch
+    while(logWritten != logHead)
+        writeLogLines();
+
+    return 0;
+}
+
+bool startScreenLogExport()
+{
+    if(logThread != NULL)
+        return true;
+
+    // Keep the log of the last run, it might be the post-mortem of a failed queue. Enabling the export again appends to the log of this run
+    bool append = logRotated;
+    if(!append)
+    {
+        FSARemove(getFSAClient(), LOG_PATH_OLD);
+        FSARename(getFSAClient(), LOG_PATH, LOG_PATH_OLD);
+        logRotated = true;
+    }
+
+    FSError err = FSAOpenFileEx(getFSAClient(), LOG_PATH, append ? "a" : "w", 0x660, FS_OPEN_FLAG_NONE, 0, &logFile);
+    if(err != FS_ERROR_OK)
+    {
+        debugPrintf("Error opening %s: %s!", LOG_PATH, translateFSErr(err));
+        return false;
+    }
+
+    // Export what's still in the ring, too. When appending go on after the last exported line if it's still there
+    if(!append || logWritten - logTail > logHead - logTail)
+        logWritten = logTail;
+    logDropped = 0;
+    OSInitMessageQueueEx(&logQueue, logMsg, 2, "NUSspli log queue");
+    logThread = startThread("NUSspli log writer", THREAD_PRIORITY_LOW, STACKSIZE_SMALL, logThreadMain, 0, NULL, AFFINITY_CPU12);
+    if(logThread != NULL)
+    {
+        OSMessage msg = { .message = NUSSPLI_MESSAGE_NONE };
+        OSSendMessage(&logQueue, &msg, OS_MESSAGE_FLAGS_NONE);
+        return true;
+    }
+
+    FSACloseFile(getFSAClient(), logFile);
+    return false;
+}
+
+void stopScreenLogExport()
+{
+    if(logThread == NULL)
+        return;
+
+    OSMessage msg = { .message = NUSSPLI_MESSAGE_EXIT };
+    OSSendMessage(&logQueue, &msg, OS_MESSAGE_FLAGS_BLOCKING);
+    stopThread(logThread, NULL);
+    logThread = NULL;
+
+    FSACloseFile(getFSAClient(), logFile);
+    debugPrintf("Log export stopped, %u lines dropped", logDropped);
 }
 
 void drawErrorFrame(const char *text, ErrorOptions option)
@@ -349,11 +485,14 @@ const char *prettyDir(const char *dir)
     return ret;
 }
 
-static inline void drawFinishedScreen(const char *titleName, const char *text, FINISHING_OPERATION op)
+static inline void drawFinishedScreen(const char *titleName, const char *text, const char *netSummary, FINISHING_OPERATION op)
 {
     colorStartNewFrame(SCREEN_COLOR_D_GREEN);
     int i = op != FINISHING_OPERATION_QUEUE ? textToFrameMultiline(0, ALIGNED_CENTER, titleName, MAX_CHARS) : 0;
     textToFrame(i++, 0, text);
+    if(netSummary != NULL)
+        textToFrame(i++, 0, netSummary);
+
     writeScreenLog(i);
     drawFrame();
 }
@@ -375,9 +514,18 @@ void showFinishedScreen(const char *titleName, FINISHING_OPERATION op)
         case FINISHING_OPERATION_QUEUE:
             text = localise("Queue finished successfully!");
             break;
+        case FINISHING_OPERATION_VERIFY:
+            text = localise("Verified successfully!");
+            break;
+        case FINISHING_OPERATION_CONVERT:
+            text = localise("Prepared successfully!");
+            break;
     }
 
-    drawFinishedScreen(titleName, text, op);
+    char netSummary[NET_SUMMARY_LENGTH];
+    const char *summary = getNetStatsSummary(netSummary) ? netSummary : NULL;
+
+    drawFinishedScreen(titleName, text, summary, op);
     startNotification();
 
     while(AppRunning(true))
@@ -385,7 +533,7 @@ void showFinishedScreen(const char *titleName, FINISHING_OPERATION op)
         if(app == APP_STATE_BACKGROUND)
             continue;
         if(app == APP_STATE_RETURNING)
-            drawFinishedScreen(titleName, text, op);
+            drawFinishedScreen(titleName, text, summary, op);
 
         showFrame();
 
@@ -27,11 +27,13 @@
 
 #include <config.h>
 #include <deinstaller.h>
+#include <delta.h>
 #include <downloader.h>
 #include <filesystem.h>
 #include <input.h>
 #include <menu/predownload.h>
 #include <menu/utils.h>
+#include <metaCache.h>
 #include <queue.h>
 #include <renderer.h>
 #include <state.h>
@@ -64,7 +66,7 @@ static inline bool isInstalled(const TitleEntry *entry, MCPTitleListType *out)
     return MCP_GetTitleInfo(mcpHandle, entry->tid, out) == 0;
 }
 
-static void drawPDMenuFrame(const TitleEntry *entry, const char *titleVer, uint64_t size, bool installed, const char *folderName)
+static void drawPDMenuFrame(const TitleEntry *entry, const char *titleVer, uint64_t size, uint64_t reusable, bool installed, const char *folderName)
 {
     startNewFrame();
 
@@ -85,6 +87,20 @@ static void drawPDMenuFrame(const TitleEntry *entry, const char *titleVer, uint6
     flagToFrame(++line, 3, entry->region);
     textToFrame(line, 7, localise(getFormattedRegion(entry->region)));
 
+    if(reusable != 0)
+    {
+        // Contents found in the cache or another version get copied instead of downloaded
+        strcat(toFrame, " (");
+        humanize(size - reusable, toFrame + strlen(toFrame));
+        strcat(toFrame, " ");
+        strcat(toFrame, localise("to download"));
+        strcat(toFrame, ", ");
+        humanize(reusable, toFrame + strlen(toFrame));
+        strcat(toFrame, " ");
+        strcat(toFrame, localise("reused"));
+        strcat(toFrame, ")");
+    }
+
     textToFrame(++line, 0, localise("Size:"));
     textToFrame(++line, 3, toFrame);
 
@@ -354,7 +370,7 @@ static bool addToOpQueue(RAMBUF *rambuf, const TitleEntry *entry, const char *ti
         titleInfo->rambuf = rambuf;
         titleInfo->entry = entry;
         strcpy(titleInfo->titleVer, titleVer);
-        strcpy(titleInfo->folderName, folderName);
+        titleInfo->folderName = folderName;
         titleInfo->operation = operation;
         titleInfo->dlDev = dlDev;
         titleInfo->toUSB = instDev & NUSDEV_USB;
@@ -380,10 +396,9 @@ bool predownloadMenu(const TitleEntry *entry)
     folderName[0] = titleVer[0] = '\0';
     TMD *tmd;
     uint64_t dls;
+    uint64_t reusable;
     bool redraw;
     bool toQueue;
-    char tid[17];
-    char downloadUrl[256];
     bool autoAddToQueue = false;
     bool autoStartQueue = false;
     NUSDEV usbMounted = getUSB();
@@ -400,20 +415,8 @@ downloadTMD:
     if(rambuf == NULL)
         return true;
 
-    hex(entry->tid, 16, tid);
-
     debugPrintf("Downloading TMD...");
-    strcpy(downloadUrl, DOWNLOAD_URL);
-    strcat(downloadUrl, tid);
-    strcat(downloadUrl, "/tmd");
-
-    if(strlen(titleVer) > 0)
-    {
-        strcat(downloadUrl, ".");
-        strcat(downloadUrl, titleVer);
-    }
-
-    if(downloadFile(downloadUrl, "title.tmd", NULL, (FileType)(FILE_TYPE_TMD | FILE_TYPE_TORAM), false, NULL, rambuf))
+    if(downloadMetadata(entry->tid, "tmd", titleVer, FILE_TYPE_TMD, NULL, NULL, rambuf))
     {
         freeRamBuf(rambuf);
         debugPrintf("Error downloading TMD");
@@ -439,6 +442,10 @@ downloadTMD:
         dls += tmd->contents[i].size;
     }
 
+    reusable = getReusableSize(tmd);
+    // A cached TMD leaves the network untouched, get a connection ready while the user decides
+    warmupConnection();
+
 naNedNa:
     toQueue = autoAddToQueue;
     if(!toQueue)
@@ -454,7 +461,7 @@ naNedNa:
 
             if(redraw)
             {
-                drawPDMenuFrame(entry, titleVer, dls, installed, folderName);
+                drawPDMenuFrame(entry, titleVer, dls, reusable, installed, folderName);
                 redraw = false;
             }
             showFrame();
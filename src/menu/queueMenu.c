@@ -28,6 +28,7 @@
 #include <menu/queue.h>
 #include <menu/utils.h>
 #include <queue.h>
+#include <queueImport.h>
 #include <renderer.h>
 #include <state.h>
 
@@ -80,12 +81,12 @@ static void drawQueueMenu(LIST *titleQueue, size_t cursor, size_t pos)
         if(data->operation & OPERATION_INSTALL)
             deviceToFrame(i, SPACER, data->toUSB ? DEVICE_TYPE_USB : DEVICE_TYPE_NAND);
 
-        if(isDLC(data->tmd->tid))
+        if(isDLC(data->tid))
         {
             p = sizeof("[DLC] ") - 1;
             OSBlockMove(toScreen, "[DLC] ", p, false);
         }
-        else if(isUpdate(data->tmd->tid))
+        else if(isUpdate(data->tid))
         {
             p = sizeof("[UPD] ") - 1;
             OSBlockMove(toScreen, "[UPD] ", p, false);
@@ -111,7 +112,12 @@ static void drawQueueMenu(LIST *titleQueue, size_t cursor, size_t pos)
             break;
     }
 
-    textToFrame(MAX_LINES - 2, ALIGNED_CENTER, localise("Press " BUTTON_B " to return"));
+    strcpy(toScreen, localise("Press " BUTTON_B " to return"));
+    strcat(toScreen, " || ");
+    strcat(toScreen, localise(BUTTON_X " to import"));
+    strcat(toScreen, " || ");
+    strcat(toScreen, localise(BUTTON_Y " to export"));
+    textToFrame(MAX_LINES - 2, ALIGNED_CENTER, toScreen);
 
     strcpy(toScreen, localise(BUTTON_PLUS " to start the queue"));
     strcat(toScreen, " || ");
@@ -149,6 +155,21 @@ bool queueMenu()
         if(vpad.trigger & VPAD_BUTTON_B)
             return false;
 
+        if(vpad.trigger & VPAD_BUTTON_X)
+        {
+            importQueue();
+            mov = getListSize(titleQueue) >= MAX_ENTRIES;
+            redraw = true;
+        }
+        else if(vpad.trigger & VPAD_BUTTON_Y)
+        {
+            exportQueue();
+            redraw = true;
+        }
+
+        if(getListSize(titleQueue) == 0)
+            continue;
+
         if(vpad.hold & VPAD_BUTTON_UP)
         {
             if(oldHold != VPAD_BUTTON_UP)
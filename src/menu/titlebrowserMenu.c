@@ -24,6 +24,7 @@
 #include <string.h>
 
 #include <config.h>
+#include <downloader.h>
 #include <file.h>
 #include <input.h>
 #include <localisation.h>
@@ -69,11 +70,8 @@ static void drawTBMenuFrame(const TITLE_CATEGORY tab, const size_t pos, const si
     textToFrame(MAX_LINES - 2, ALIGNED_CENTER, toFrame);
 
     strcpy(toFrame, localise(BUTTON_Y " to search"));
-    if(getListSize(getTitleQueue()))
-    {
-        strcat(toFrame, " || ");
-        strcat(toFrame, localise(BUTTON_MINUS " to open the queue"));
-    }
+    strcat(toFrame, " || ");
+    strcat(toFrame, localise(BUTTON_MINUS " to open the queue"));
 
     textToFrame(MAX_LINES - 1, ALIGNED_CENTER, toFrame);
 
@@ -202,6 +200,8 @@ void titleBrowserMenu()
         return;
     }
 
+    warmupConnection();
+
     TITLE_CATEGORY tab = TITLE_CATEGORY_GAME;
     size_t cursor = 0;
     size_t pos = 0;
@@ -375,7 +375,7 @@ loop:
             return;
         }
 
-        if(vpad.trigger & VPAD_BUTTON_MINUS && getListSize(getTitleQueue()))
+        if(vpad.trigger & VPAD_BUTTON_MINUS)
         {
             if(queueMenu())
                 return;
@@ -0,0 +1,208 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <wut-fixups.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <downloader.h>
+#include <file.h>
+#include <filesystem.h>
+#include <ioQueue.h>
+#include <menu/utils.h>
+#include <metaCache.h>
+#include <preflight.h>
+#include <state.h>
+#include <ticket.h>
+#include <tmd.h>
+#include <utils.h>
+
+#pragma GCC diagnostic ignored "-Wundef"
+#include <coreinit/filesystem_fsa.h>
+#include <coreinit/memdefaultheap.h>
+#include <coreinit/time.h>
+#pragma GCC diagnostic pop
+
+#define METADATA_MAGIC 0x4E55534D // "NUSM"
+#define METADATA_TTL   (24 * 60 * 60) // Seconds, for the latest title.tmd and missing tickets
+
+/*
+ * Small NUS files (title.tmd, cetk) are cached on the SD card. Only files
+ * which pass the same checks as a fresh download get stored and entries
+ * failing them on load are deleted. Versioned TMDs and tickets never change,
+ * so they never get revalidated. A TMD without version points to the latest
+ * one and is downloaded again after a day. A missing ticket (fake ticket
+ * needed) is cached for a day, too, as it might show up later. If the
+ * download of an outdated entry fails the old one is used, so seen titles
+ * work offline.
+ */
+typedef struct WUT_PACKED
+{
+    uint32_t magic;
+    int32_t result; // Result of downloadFile()
+    OSTime fetched;
+} METADATA_HEADER;
+
+static uint32_t hits = 0;
+static uint32_t misses = 0;
+
+static void getMetadataPath(uint64_t tid, const char *file, const char *titleVer, char *out)
+{
+    if(titleVer[0] == '\0')
+        sprintf(out, METADATA_CACHE_DIR "%016" PRIx64 "_%s", tid, file);
+    else
+        sprintf(out, METADATA_CACHE_DIR "%016" PRIx64 "_%s.%s", tid, file, titleVer);
+}
+
+static inline bool isImmutable(const char *file, const char *titleVer, int result)
+{
+    return result == 0 && (titleVer[0] != '\0' || strcmp(file, "tmd") != 0);
+}
+
+static bool isValidMetadata(uint64_t tid, const char *file, const char *titleVer, int result, const void *buf, size_t size)
+{
+    if(result != 0)
+        return result == 2 && size == 0; // No ticket on the NUS
+
+    if(strcmp(file, "tmd") != 0)
+        return checkTicketStructure((const TICKET *)buf, size, tid);
+
+    const TMD *tmd = (const TMD *)buf;
+    if(verifyTmd(tmd, size) != TMD_STATE_GOOD || tmd->tid != tid)
+        return false;
+
+    return titleVer[0] == '\0' || tmd->title_version == strtoul(titleVer, NULL, 10);
+}
+
+bool loadCachedMetadata(uint64_t tid, const char *file, const char *titleVer, bool allowStale, RAMBUF *rambuf, int *result)
+{
+    char path[sizeof(METADATA_CACHE_DIR) + 16 + 1 + 4 + 1 + 33];
+    getMetadataPath(tid, file, titleVer, path);
+    if(!fileExists(path))
+        return false;
+
+    uint8_t *buf;
+    size_t size = readFile(path, (void **)&buf);
+    if(buf == NULL)
+        return false;
+
+    bool ret = false;
+    METADATA_HEADER *header = (METADATA_HEADER *)buf;
+    if(size < sizeof(METADATA_HEADER) || header->magic != METADATA_MAGIC || !isValidMetadata(tid, file, titleVer, header->result, buf + sizeof(METADATA_HEADER), size - sizeof(METADATA_HEADER)))
+    {
+        debugPrintf("Metadata cache: Dropping broken %s", path);
+        FSARemove(getFSAClient(), path);
+    }
+    else if(allowStale || isImmutable(file, titleVer, header->result) || (uint64_t)(OSGetTime() - header->fetched) < OSSecondsToTicks(METADATA_TTL))
+    {
+        size -= sizeof(METADATA_HEADER);
+        *result = header->result;
+        if(size == 0)
+            ret = true;
+        else
+            ret = setRamBuf(rambuf, buf + sizeof(METADATA_HEADER), size);
+    }
+
+    MEMFreeToDefaultHeap(buf);
+    return ret;
+}
+
+void storeMetadata(uint64_t tid, const char *file, const char *titleVer, int result, const RAMBUF *rambuf)
+{
+    char path[sizeof(METADATA_CACHE_DIR) + 16 + 1 + 4 + 1 + 33];
+    getMetadataPath(tid, file, titleVer, path);
+    size_t size = result == 0 ? rambuf->size : 0;
+    if(!isValidMetadata(tid, file, titleVer, result, rambuf->buf, size))
+    {
+        debugPrintf("Metadata cache: Not storing invalid %s", path);
+        return;
+    }
+
+    if(!dirExists(METADATA_CACHE_DIR) && createDirectory(METADATA_CACHE_DIR) != FS_ERROR_OK)
+        return;
+
+    FSAFileHandle f = openFile(path, "w", sizeof(METADATA_HEADER) + size);
+    if(f == 0)
+        return;
+
+    METADATA_HEADER header = {
+        .magic = METADATA_MAGIC,
+        .result = result,
+        .fetched = OSGetTime(),
+    };
+
+    addToIOQueue(&header, 1, sizeof(METADATA_HEADER), f);
+    if(size != 0)
+        addToIOQueue(rambuf->buf, 1, size, f);
+
+    addToIOQueue(NULL, 0, 0, f);
+}
+
+// Like downloadFile() to RAM for <tid>/<file>[.<titleVer>] on the NUS, but asks the cache first
+int downloadMetadata(uint64_t tid, const char *file, const char *titleVer, FileType type, downloadData *data, QUEUE_DATA *queueData, RAMBUF *rambuf)
+{
+    char name[sizeof("0000000000000000/tmd.") + 33];
+    hex(tid, 16, name);
+    strcpy(name + 16, "/");
+    strcat(name, file);
+    if(titleVer[0] != '\0')
+    {
+        strcat(name, ".");
+        strcat(name, titleVer);
+    }
+
+    int ret;
+    if(loadCachedMetadata(tid, file, titleVer, false, rambuf, &ret))
+    {
+        ++hits;
+        addToScreenLog("Metadata cache hit: %s", name);
+        debugPrintf("Metadata cache: %u hits, %u misses", hits, misses);
+        return ret;
+    }
+
+    ++misses;
+    debugPrintf("Metadata cache miss: %s (%u hits, %u misses)", name, hits, misses);
+    char url[sizeof(DOWNLOAD_URL) + sizeof(name)];
+    strcpy(url, DOWNLOAD_URL);
+    strcat(url, name);
+
+    ret = downloadFile(url, name, data, type | FILE_TYPE_TORAM, false, queueData, rambuf);
+    switch(ret)
+    {
+        case 0:
+        case 2:
+            storeMetadata(tid, file, titleVer, ret, rambuf);
+            break;
+        default:
+            // Offline? Better an outdated TMD than none
+            if(AppRunning(true) && loadCachedMetadata(tid, file, titleVer, true, rambuf, &ret))
+            {
+                addToScreenLog("Using cached %s", name);
+                return ret;
+            }
+
+            break;
+    }
+
+    return ret;
+}
@@ -0,0 +1,69 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <wut-fixups.h>
+
+#include <netShare.h>
+#include <thread.h>
+#include <utils.h>
+
+static spinlock shareLocks[CURL_LOCK_DATA_LAST];
+
+static void shareLock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr)
+{
+    (void)handle;
+    (void)access;
+    (void)userptr;
+
+    spinLockAsMutex(shareLocks[data]);
+}
+
+static void shareUnlock(CURL *handle, curl_lock_data data, void *userptr)
+{
+    (void)handle;
+    (void)userptr;
+
+    spinReleaseLock(shareLocks[data]);
+}
+
+/*
+ * DNS results, connections and TLS sessions are shared between the main
+ * handle and the handles of parallel transfers, so switching between them
+ * doesn't cost new lookups and handshakes. There's only one share, it gets
+ * released with curl_share_cleanup().
+ */
+CURLSH *initNetShare()
+{
+    CURLSH *share = curl_share_init();
+    if(share == NULL)
+        return NULL;
+
+    for(int i = 0; i < CURL_LOCK_DATA_LAST; ++i)
+        spinCreateLock(shareLocks[i], SPINLOCK_FREE);
+
+    if(curl_share_setopt(share, CURLSHOPT_LOCKFUNC, shareLock) == CURLSHE_OK &&
+       curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, shareUnlock) == CURLSHE_OK &&
+       curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS) == CURLSHE_OK &&
+       curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION) == CURLSHE_OK &&
+       curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT) == CURLSHE_OK)
+        return share;
+
+    debugPrintf("curl_share_setopt() failed!");
+    curl_share_cleanup(share);
+    return NULL;
+}
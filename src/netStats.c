@@ -0,0 +1,323 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <wut-fixups.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ioQueue.h>
+#include <list.h>
+#include <memTrack.h>
+#include <menu/utils.h>
+#include <netStats.h>
+#include <titles.h>
+#include <utils.h>
+
+#pragma GCC diagnostic ignored "-Wundef"
+#include <coreinit/filesystem_fsa.h>
+#include <coreinit/memory.h>
+#pragma GCC diagnostic pop
+
+typedef struct
+{
+    uint64_t tid;
+    char name[MAX_TITLENAME_LENGTH];
+    NET_STATS stats;
+} NET_TITLE_STATS;
+
+static NET_STATS session;
+static NET_STATS screen; // Title transfers since the last finished screen
+static NET_TITLE_STATS *current = NULL;
+static LIST *titles = NULL;
+
+static inline uint64_t average(uint64_t sum, uint32_t count)
+{
+    return count == 0 ? 0 : sum / count;
+}
+
+// Bytes per second over the time the transfers were actually running
+static inline uint64_t averageSpeed(const NET_STATS *stats)
+{
+    return stats->total == 0 ? 0 : stats->bytes * 1000000 / stats->total;
+}
+
+void addTransferToNetStats(NET_STATS *stats, const NET_TRANSFER *transfer)
+{
+    ++stats->transfers;
+    ++stats->http[transfer->http];
+    if(transfer->failed)
+        ++stats->failed;
+
+    if(transfer->resumeOffset != 0)
+    {
+        ++stats->resumed;
+        stats->resumedBytes += transfer->resumeOffset;
+    }
+
+    // Reused connections report no lookup / connect / handshake times, so only count new ones
+    if(transfer->newConnections != 0)
+    {
+        stats->newConnections += transfer->newConnections;
+        stats->lookup += transfer->lookup;
+        stats->connect += transfer->connect;
+        stats->tls += transfer->tls;
+    }
+
+    stats->bytes += transfer->bytes;
+    stats->ttfb += transfer->ttfb;
+    stats->total += transfer->total;
+    if(transfer->speed > stats->maxSpeed)
+        stats->maxSpeed = transfer->speed;
+}
+
+size_t formatNetStatsRow(char *out, const char *scope, uint64_t tid, const char *name, const NET_STATS *stats)
+{
+    size_t len = strlen(scope);
+    OSBlockMove(out, scope, len, false);
+    out[len++] = ',';
+
+    if(tid != 0)
+    {
+        hex(tid, 16, out + len);
+        len += 16;
+    }
+    out[len++] = ',';
+
+    // Title names may contain commas and quotes, so always quote them and double inner quotes
+    if(name != NULL)
+    {
+        out[len++] = '"';
+        for(size_t i = 0; name[i] != '\0' && i < NET_REPORT_NAME_LENGTH; ++i)
+        {
+            if(name[i] == '"')
+                out[len++] = '"';
+
+            out[len++] = name[i];
+        }
+        out[len++] = '"';
+    }
+
+    return len + sprintf(out + len, ",%u,%u,%u,%u,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%u,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%u,%u,%u,%u\n",
+                         stats->transfers,
+                         stats->failed,
+                         stats->retries,
+                         stats->resumed,
+                         stats->resumedBytes,
+                         stats->bytes,
+                         stats->total / 1000,
+                         averageSpeed(stats) >> 10,
+                         stats->maxSpeed >> 10,
+                         stats->newConnections,
+                         average(stats->lookup, stats->newConnections) / 1000,
+                         average(stats->connect, stats->newConnections) / 1000,
+                         average(stats->tls, stats->newConnections) / 1000,
+                         average(stats->ttfb, stats->transfers) / 1000,
+                         stats->http[NET_HTTP_1],
+                         stats->http[NET_HTTP_2],
+                         stats->http[NET_HTTP_3],
+                         stats->http[NET_HTTP_UNKNOWN]);
+}
+
+bool formatNetStatsSummary(const NET_STATS *stats, char *out)
+{
+    if(stats->transfers == 0)
+        return false;
+
+    char size[32];
+    char speed[32];
+    humanize(stats->bytes, size);
+    humanize(averageSpeed(stats), speed);
+    size_t len = sprintf(out, "Network: %s @ %s/s | TTFB %" PRIu64 " ms", size, speed, average(stats->ttfb, stats->transfers) / 1000);
+
+    if(stats->retries != 0)
+        len += sprintf(out + len, " | %u retries", stats->retries);
+    if(stats->resumed != 0)
+        len += sprintf(out + len, " | %u resumed", stats->resumed);
+    if(stats->failed != 0)
+        sprintf(out + len, " | %u failed", stats->failed);
+
+    return true;
+}
+
+void startTitleNetStats(uint64_t tid, const char *name)
+{
+    if(current != NULL)
+        finishTitleNetStats();
+
+    if(titles == NULL)
+    {
+        titles = createList();
+        if(titles == NULL)
+            return;
+    }
+
+    current = memAlloc(MEM_TAG_DOWNLOAD, sizeof(NET_TITLE_STATS));
+    if(current == NULL)
+        return;
+
+    OSBlockSet(current, 0x00, sizeof(NET_TITLE_STATS));
+    current->tid = tid;
+    strncpy(current->name, name, MAX_TITLENAME_LENGTH - 1);
+    if(!addToListEnd(titles, current))
+    {
+        memFree(MEM_TAG_DOWNLOAD, current);
+        current = NULL;
+    }
+}
+
+void finishTitleNetStats()
+{
+    if(current == NULL)
+        return;
+
+    char tid[17];
+    hex(current->tid, 16, tid);
+    debugPrintf("Network stats for %s: %u transfers, %" PRIu64 " bytes, %u retries, %u resumed, %u failed", tid, current->stats.transfers, current->stats.bytes, current->stats.retries, current->stats.resumed, current->stats.failed);
+
+    current = NULL;
+    writeNetStatsReport();
+}
+
+static inline NET_HTTP_VERSION translateHttpVersion(long version)
+{
+    switch(version)
+    {
+        case CURL_HTTP_VERSION_1_0:
+        case CURL_HTTP_VERSION_1_1:
+            return NET_HTTP_1;
+        case CURL_HTTP_VERSION_2_0:
+            return NET_HTTP_2;
+        case CURL_HTTP_VERSION_3:
+            return NET_HTTP_3;
+        default:
+            return NET_HTTP_UNKNOWN;
+    }
+}
+
+static inline uint64_t phase(curl_off_t from, curl_off_t to)
+{
+    return to > from ? to - from : 0;
+}
+
+void recordTransfer(CURL *handle, curl_off_t resumeOffset, bool failed)
+{
+    curl_off_t lookup = 0;
+    curl_off_t connect = 0;
+    curl_off_t tls = 0;
+    curl_off_t ttfb = 0;
+    curl_off_t total = 0;
+    curl_off_t bytes = 0;
+    curl_off_t speed = 0;
+    long newConnections = 0;
+    long http = 0;
+    long resp = 0;
+
+    curl_easy_getinfo(handle, CURLINFO_NAMELOOKUP_TIME_T, &lookup);
+    curl_easy_getinfo(handle, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(handle, CURLINFO_APPCONNECT_TIME_T, &tls);
+    curl_easy_getinfo(handle, CURLINFO_STARTTRANSFER_TIME_T, &ttfb);
+    curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME_T, &total);
+    curl_easy_getinfo(handle, CURLINFO_SIZE_DOWNLOAD_T, &bytes);
+    curl_easy_getinfo(handle, CURLINFO_SPEED_DOWNLOAD_T, &speed);
+    curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &newConnections);
+    curl_easy_getinfo(handle, CURLINFO_HTTP_VERSION, &http);
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &resp);
+
+    NET_TRANSFER transfer = {
+        .lookup = lookup,
+        .connect = phase(lookup, connect),
+        .tls = tls == 0 ? 0 : phase(connect, tls),
+        .ttfb = ttfb,
+        .total = total,
+        .bytes = bytes,
+        .speed = speed,
+        .resumeOffset = resumeOffset,
+        .newConnections = newConnections,
+        .http = translateHttpVersion(http),
+        .failed = failed || (resp != 200 && resp != 206),
+    };
+
+    addTransferToNetStats(&session, &transfer);
+    if(current != NULL)
+    {
+        addTransferToNetStats(&current->stats, &transfer);
+        addTransferToNetStats(&screen, &transfer);
+    }
+}
+
+void recordRetry()
+{
+    ++session.retries;
+    if(current != NULL)
+    {
+        ++current->stats.retries;
+        ++screen.retries;
+    }
+}
+
+/*
+ * Summarises the title transfers since the last call, so each
+ * finished screen only shows the transfers belonging to it.
+ */
+bool getNetStatsSummary(char *out)
+{
+    bool ret = formatNetStatsSummary(&screen, out);
+    OSBlockSet(&screen, 0x00, sizeof(NET_STATS));
+    return ret;
+}
+
+// Rewrites the whole report, so it's usable even if we crash later on
+void writeNetStatsReport()
+{
+    FSAFileHandle file = openFile(NET_REPORT_PATH, "w", 0);
+    if(file == 0)
+        return;
+
+    char line[NET_REPORT_LINE_LENGTH];
+    static const char header[] = "scope,tid,name,transfers,failed,retries,resumed,resumed_bytes,bytes,transfer_ms,avg_kbps,max_kbps,new_connections,avg_lookup_ms,avg_connect_ms,avg_tls_ms,avg_ttfb_ms,http1,http2,http3,http_unknown\n";
+    addToIOQueue(header, 1, sizeof(header) - 1, file);
+    addToIOQueue(line, 1, formatNetStatsRow(line, "session", 0, NULL, &session), file);
+
+    if(titles != NULL)
+    {
+        NET_TITLE_STATS *title;
+        forEachListEntry(titles, title)
+            addToIOQueue(line, 1, formatNetStatsRow(line, "title", title->tid, title->name, &title->stats), file);
+    }
+
+    addToIOQueue(NULL, 0, 0, file);
+}
+
+void clearNetStats()
+{
+    current = NULL;
+    if(titles != NULL)
+    {
+        NET_TITLE_STATS *title;
+        forEachListEntry(titles, title)
+            memFree(MEM_TAG_DOWNLOAD, title);
+
+        destroyList(titles, false);
+        titles = NULL;
+    }
+
+    OSBlockSet(&session, 0x00, sizeof(NET_STATS));
+    OSBlockSet(&screen, 0x00, sizeof(NET_STATS));
+}
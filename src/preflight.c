@@ -0,0 +1,390 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#include <wut-fixups.h>
+
+#include <stddef.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include <file.h>
+#include <filesystem.h>
+#include <localisation.h>
+#include <preflight.h>
+#include <thread.h>
+#include <ticket.h>
+#include <titles.h>
+#include <trace.h>
+#include <utils.h>
+
+#pragma GCC diagnostic ignored "-Wundef"
+#include <coreinit/filesystem_fsa.h>
+#include <coreinit/memdefaultheap.h>
+#include <coreinit/memory.h>
+#include <coreinit/thread.h>
+#include <coreinit/time.h>
+#pragma GCC diagnostic pop
+
+#define SIG_TYPE_RSA4096_SHA256 0x00010003
+#define SIG_TYPE_RSA2048_SHA256 0x00010004
+
+typedef struct
+{
+    char path[FS_MAX_PATH];
+    const TMD *tmd;
+    PREFLIGHT_STATE state;
+} META_JOB;
+
+bool checkTicketStructure(const TICKET *ticket, size_t size, uint64_t tid)
+{
+    if(size < sizeof(TICKET) || size > PREFLIGHT_MAX_META)
+        return false;
+
+    // Our own tickets hide a NUS_HEADER inside the signature, so don't look at more than the signature type
+    if(ticket->header.sig_type != SIG_TYPE_RSA2048_SHA256 || ticket->tid != tid || ticket->header_version != 1)
+        return false;
+
+    return offsetof(TICKET, header_version) + ticket->total_hdr_size <= size;
+}
+
+bool checkCertStructure(const CETK *cert, size_t size)
+{
+    if(size < sizeof(CETK) || size > PREFLIGHT_MAX_META)
+        return false;
+
+    // cert1 starts with a NUS_HEADER on NUSspli generated files, the signature type is kept intact
+    if(cert->cert1.sig_type != SIG_TYPE_RSA4096_SHA256 || cert->cert2.sig_type != SIG_TYPE_RSA2048_SHA256 || cert->cert3.sig_type != SIG_TYPE_RSA2048_SHA256)
+        return false;
+
+    return strncmp(cert->cert1.issuer, "Root", 4) == 0 && strncmp(cert->cert2.issuer, "Root", 4) == 0 && strncmp(cert->cert3.issuer, "Root", 4) == 0;
+}
+
+static int compareFiles(const void *a, const void *b)
+{
+    return strcasecmp(((const PREFLIGHT_FILE *)a)->name, ((const PREFLIGHT_FILE *)b)->name);
+}
+
+void sortListing(PREFLIGHT_FILE *files, size_t count)
+{
+    qsort(files, count, sizeof(PREFLIGHT_FILE), compareFiles);
+}
+
+static const PREFLIGHT_FILE *findFile(const PREFLIGHT_FILE *files, size_t count, const char *name)
+{
+    PREFLIGHT_FILE key;
+    strcpy(key.name, name);
+    return bsearch(&key, files, count, sizeof(PREFLIGHT_FILE), compareFiles);
+}
+
+/*
+ * Checks a sorted directory listing against the TMD. Stops at the first
+ * problem found and returns false in that case. The ticket and certificate
+ * are only checked for presence here.
+ */
+bool checkListing(const TMD *tmd, const PREFLIGHT_FILE *files, size_t count, PREFLIGHT_RESULT *out)
+{
+    out->cid = 0;
+    out->expected = out->found = 0;
+
+    if(findFile(files, count, "title.tik") == NULL)
+    {
+        out->state = PREFLIGHT_STATE_MISSING_TIK;
+        return false;
+    }
+    if(findFile(files, count, "title.cert") == NULL)
+    {
+        out->state = PREFLIGHT_STATE_MISSING_CERT;
+        return false;
+    }
+
+    char name[PREFLIGHT_NAME_LENGTH];
+    const PREFLIGHT_FILE *file;
+    const TMD_CONTENT *content;
+    for(uint16_t i = 0; i < tmd->num_contents; ++i)
+    {
+        content = tmd->contents + i;
+        out->cid = content->cid;
+        hex(content->cid, 8, name);
+
+        strcpy(name + 8, ".app");
+        file = findFile(files, count, name);
+        if(file == NULL)
+        {
+            out->state = PREFLIGHT_STATE_MISSING_APP;
+            return false;
+        }
+
+        // Contents are padded to the AES block size
+        if(file->size != content->size && file->size != ((content->size + 15) & ~15ULL))
+        {
+            out->state = PREFLIGHT_STATE_BAD_APP_SIZE;
+            out->expected = content->size;
+            out->found = file->size;
+            return false;
+        }
+
+        if(content->type & TMD_CONTENT_TYPE_HASHED)
+        {
+            strcpy(name + 8, ".h3");
+            file = findFile(files, count, name);
+            if(file == NULL)
+            {
+                out->state = PREFLIGHT_STATE_MISSING_H3;
+                return false;
+            }
+
+            out->expected = (uint64_t)getH3size(content->size);
+            if(file->size != out->expected)
+            {
+                out->state = PREFLIGHT_STATE_BAD_H3_SIZE;
+                out->found = file->size;
+                return false;
+            }
+
+            out->expected = 0;
+        }
+    }
+
+    out->cid = 0;
+    out->state = PREFLIGHT_STATE_OK;
+    return true;
+}
+
+static void *readMeta(const char *path, size_t *size)
+{
+    FSAFileHandle file;
+    if(FSAOpenFileEx(getFSAClient(), path, "r", 0x000, FS_OPEN_FLAG_NONE, 0, &file) != FS_ERROR_OK)
+        return NULL;
+
+    void *ret = NULL;
+    FSStat stat;
+    if(FSAGetStatFile(getFSAClient(), file, &stat) == FS_ERROR_OK && stat.size != 0 && stat.size <= PREFLIGHT_MAX_META)
+    {
+        ret = MEMAllocFromDefaultHeapEx(FS_ALIGN(stat.size), 0x40);
+        if(ret != NULL)
+        {
+            if(FSAReadFile(getFSAClient(), ret, stat.size, 1, file, 0) == 1)
+                *size = stat.size;
+            else
+            {
+                MEMFreeToDefaultHeap(ret);
+                ret = NULL;
+            }
+        }
+    }
+
+    FSACloseFile(getFSAClient(), file);
+    return ret;
+}
+
+// Reads and checks title.tik and title.cert while the caller lists the directory
+static int metaThreadMain(int argc, const char **argv)
+{
+    (void)argc;
+    META_JOB *job = (META_JOB *)argv;
+    char *ptr = job->path + strlen(job->path);
+    size_t size = 0;
+
+    strcpy(ptr, "title.tik");
+    void *buf = readMeta(job->path, &size);
+    if(buf != NULL)
+    {
+        bool ok = checkTicketStructure((TICKET *)buf, size, job->tmd->tid);
+        MEMFreeToDefaultHeap(buf);
+        if(!ok)
+        {
+            job->state = PREFLIGHT_STATE_BAD_TIK;
+            return 0;
+        }
+    }
+
+    strcpy(ptr, "title.cert");
+    buf = readMeta(job->path, &size);
+    if(buf != NULL)
+    {
+        bool ok = checkCertStructure((CETK *)buf, size);
+        MEMFreeToDefaultHeap(buf);
+        if(!ok)
+        {
+            job->state = PREFLIGHT_STATE_BAD_CERT;
+            return 0;
+        }
+    }
+
+    // Missing files get reported by checkListing()
+    job->state = PREFLIGHT_STATE_OK;
+    return 0;
+}
+
+static bool isInteresting(const char *name, size_t len)
+{
+    if(len == 12)
+        return strcasecmp(name + 8, ".app") == 0;
+    if(len == 11)
+        return strcasecmp(name + 8, ".h3") == 0;
+
+    return strcmp(name, "title.tik") == 0 || strcmp(name, "title.cert") == 0;
+}
+
+static PREFLIGHT_FILE *listDirectory(const char *dir, const TMD *tmd, size_t *count)
+{
+    FSADirectoryHandle handle;
+    if(FSAOpenDir(getFSAClient(), dir, &handle) != FS_ERROR_OK)
+        return NULL;
+
+    size_t max = (tmd->num_contents << 1) + 2;
+    PREFLIGHT_FILE *files = MEMAllocFromDefaultHeap(sizeof(PREFLIGHT_FILE) * max);
+    if(files != NULL)
+    {
+        *count = 0;
+        FSADirectoryEntry entry;
+        size_t len;
+        PREFLIGHT_FILE *tmp;
+        while(FSAReadDir(getFSAClient(), handle, &entry) == FS_ERROR_OK)
+        {
+            if(entry.info.flags & FS_STAT_DIRECTORY)
+                continue;
+
+            len = strlen(entry.name);
+            if(!isInteresting(entry.name, len))
+                continue;
+
+            // Leftovers of older versions
+            if(*count == max)
+            {
+                max <<= 1;
+                tmp = MEMAllocFromDefaultHeap(sizeof(PREFLIGHT_FILE) * max);
+                if(tmp == NULL)
+                {
+                    MEMFreeToDefaultHeap(files);
+                    files = NULL;
+                    break;
+                }
+
+                OSBlockMove(tmp, files, sizeof(PREFLIGHT_FILE) * *count, false);
+                MEMFreeToDefaultHeap(files);
+                files = tmp;
+            }
+
+            OSBlockMove(files[*count].name, entry.name, len + 1, false);
+            files[(*count)++].size = entry.info.size;
+        }
+    }
+
+    FSACloseDir(getFSAClient(), handle);
+    return files;
+}
+
+/*
+ * Checks that everything MCP needs is there before handing the folder over.
+ * The directory gets listed once while title.tik and title.cert get checked
+ * on a second thread, so bad folders fail fast instead of mid-install.
+ */
+bool preflightInstall(const char *dir, const TMD *tmd, PREFLIGHT_RESULT *out)
+{
+    traceScope("preflightInstall");
+    OSTime t = OSGetTime();
+    META_JOB *job = MEMAllocFromDefaultHeap(sizeof(META_JOB));
+    if(job == NULL)
+    {
+        out->state = PREFLIGHT_STATE_NO_LISTING;
+        return false;
+    }
+
+    strcpy(job->path, dir);
+    job->tmd = tmd;
+    job->state = PREFLIGHT_STATE_OK;
+    OSThread *thread = startThread("NUSspli preflight", THREAD_PRIORITY_MEDIUM, STACKSIZE_SMALL, metaThreadMain, 0, (char *)job, AFFINITY_CPU12);
+    if(thread == NULL)
+        metaThreadMain(0, (const char **)job);
+
+    size_t count;
+    PREFLIGHT_FILE *files = listDirectory(dir, tmd, &count);
+    bool ret;
+    if(files != NULL)
+    {
+        sortListing(files, count);
+        ret = checkListing(tmd, files, count, out);
+        MEMFreeToDefaultHeap(files);
+    }
+    else
+    {
+        out->state = PREFLIGHT_STATE_NO_LISTING;
+        out->cid = 0;
+        ret = false;
+    }
+
+    if(thread != NULL)
+        stopThread(thread, NULL);
+
+    // Prefer the listing result as a missing file makes the structural check meaningless
+    if(ret && job->state != PREFLIGHT_STATE_OK)
+    {
+        out->state = job->state;
+        ret = false;
+    }
+
+    MEMFreeToDefaultHeap(job);
+    t = OSGetTime() - t;
+    debugPrintf("Preflight: %s in %" PRIu64 " us", ret ? "OK" : "failed", OSTicksToMicroseconds(t));
+    return ret;
+}
+
+void preflightToString(const PREFLIGHT_RESULT *result, char *out)
+{
+    char cid[9];
+    hex(result->cid, 8, cid);
+
+    switch(result->state)
+    {
+        case PREFLIGHT_STATE_OK:
+            *out = '\0';
+            break;
+        case PREFLIGHT_STATE_NO_LISTING:
+            strcpy(out, localise("Can't read the title folder"));
+            break;
+        case PREFLIGHT_STATE_MISSING_APP:
+            sprintf(out, "%s.app: %s", cid, localise("File missing"));
+            break;
+        case PREFLIGHT_STATE_BAD_APP_SIZE:
+            sprintf(out, "%s.app: %s (%" PRIu64 " / %" PRIu64 ")", cid, localise("Wrong size"), result->found, result->expected);
+            break;
+        case PREFLIGHT_STATE_MISSING_H3:
+            sprintf(out, "%s.h3: %s", cid, localise("File missing"));
+            break;
+        case PREFLIGHT_STATE_BAD_H3_SIZE:
+            sprintf(out, "%s.h3: %s (%" PRIu64 " / %" PRIu64 ")", cid, localise("Wrong size"), result->found, result->expected);
+            break;
+        case PREFLIGHT_STATE_MISSING_TIK:
+            sprintf(out, "title.tik: %s", localise("File missing"));
+            break;
+        case PREFLIGHT_STATE_BAD_TIK:
+            sprintf(out, "title.tik: %s", localise("Invalid ticket"));
+            break;
+        case PREFLIGHT_STATE_MISSING_CERT:
+            sprintf(out, "title.cert: %s", localise("File missing"));
+            break;
+        case PREFLIGHT_STATE_BAD_CERT:
+            sprintf(out, "title.cert: %s", localise("Invalid certificate"));
+            break;
+    }
+}
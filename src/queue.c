@@ -19,49 +19,459 @@
 
 #include <wut-fixups.h>
 
+#include <string.h>
+
 #include <downloader.h>
+#include <file.h>
+#include <filesystem.h>
 #include <installer.h>
+#include <ioQueue.h>
 #include <list.h>
+#include <localisation.h>
 #include <menu/utils.h>
 #include <queue.h>
+#include <scheduler.h>
 #include <state.h>
+#include <titles.h>
 
 #pragma GCC diagnostic ignored "-Wundef"
+#include <coreinit/filesystem_fsa.h>
 #include <coreinit/memdefaultheap.h>
+#include <coreinit/memory.h>
 #pragma GCC diagnostic pop
 
+#define JOURNAL_PATH   NUSDIR_SD "NUSspli_queue.bin"
+#define JOURNAL_MAGIC  0x4E555351 // "NUSQ"
+#define JOURNAL_ADD    0
+#define JOURNAL_REMOVE 1
+
+#define JOURNAL_FLAG_TO_USB     0x01
+#define JOURNAL_FLAG_KEEP_FILES 0x02
+
+/*
+ * The queue journal is an append only file on the SD card. Every queued title
+ * gets an ADD record (including the TMD for titles to download) and a REMOVE
+ * record once it's done or removed. Records are written through the I/O thread,
+ * so the main thread only pays for opening the file. Which contents are already
+ * downloaded isn't journaled: The files on disc are the truth and downloadFile()
+ * skips complete ones without touching the network.
+ */
+typedef struct WUT_PACKED
+{
+    uint32_t magic;
+    uint8_t type;
+    uint8_t operation;
+    uint8_t flags;
+    uint8_t padding;
+    uint16_t folderLength;
+    uint16_t padding2;
+    uint32_t id;
+    uint64_t tid;
+    uint32_t dlDev;
+    uint32_t tmdSize;
+    char titleVer[33];
+} JOURNAL_RECORD;
+
 static LIST *titleQueue;
+static LIST *folderNames;
+static uint32_t journalId = 0;
+static uint32_t journalSize = 0;
+static bool journalPending = false;
+
+/*
+ * Queue entries are kept small so huge queues don't eat the heap needed by
+ * curl and the I/O thread: Folder names are interned, sizes are precomputed
+ * and TMDs are spilled to the journal (or read from the download folder for
+ * titles to install only) until the title gets processed.
+ */
+static const char *internFolderName(const char *name)
+{
+    char *interned;
+    forEachListEntry(folderNames, interned)
+    {
+        if(strcmp(interned, name) == 0)
+            return interned;
+    }
+
+    size_t len = strlen(name) + 1;
+    interned = MEMAllocFromDefaultHeap(len);
+    if(interned == NULL)
+        return NULL;
+
+    OSBlockMove(interned, name, len, false);
+    if(addToListEnd(folderNames, interned))
+        return interned;
+
+    MEMFreeToDefaultHeap(interned);
+    return NULL;
+}
+
+static void calculateSizes(TitleData *title, const TMD *tmd)
+{
+    title->tid = tmd->tid;
+    title->dlSize = title->installSize = 0;
+    for(uint16_t i = 0; i < tmd->num_contents; ++i)
+    {
+        title->installSize += tmd->contents[i].size;
+        title->dlSize += tmd->contents[i].size;
+        if(tmd->contents[i].type & TMD_CONTENT_TYPE_HASHED)
+            title->dlSize += getH3size(tmd->contents[i].size);
+    }
+}
+
+static void writeJournalRecord(FSAFileHandle f, TitleData *title)
+{
+    JOURNAL_RECORD rec;
+    OSBlockSet(&rec, 0x00, sizeof(JOURNAL_RECORD));
+    rec.magic = JOURNAL_MAGIC;
+    rec.type = JOURNAL_ADD;
+    rec.operation = title->operation;
+    rec.flags = (title->toUSB ? JOURNAL_FLAG_TO_USB : 0) | (title->keepFiles ? JOURNAL_FLAG_KEEP_FILES : 0);
+    rec.folderLength = strlen(title->folderName);
+    rec.id = title->journalId;
+    rec.tid = title->entry == NULL ? 0 : title->entry->tid;
+    rec.dlDev = title->dlDev;
+    rec.tmdSize = title->tmdSize;
+    OSBlockMove(rec.titleVer, title->titleVer, sizeof(rec.titleVer), false);
+
+    addToIOQueue(&rec, 1, sizeof(JOURNAL_RECORD), f);
+    if(rec.folderLength != 0)
+        addToIOQueue(title->folderName, 1, rec.folderLength, f);
+    if(rec.tmdSize != 0)
+        addToIOQueue(title->tmd, 1, rec.tmdSize, f);
+
+    title->tmdOffset = journalSize + sizeof(JOURNAL_RECORD) + rec.folderLength;
+    journalSize = title->tmdOffset + rec.tmdSize;
+    journalPending = true;
+}
+
+static void spillTmd(TitleData *title)
+{
+    if(title->rambuf != NULL)
+    {
+        freeRamBuf(title->rambuf);
+        title->rambuf = NULL;
+    }
+    else if(title->tmd != NULL)
+        MEMFreeToDefaultHeap(title->tmd);
+
+    title->tmd = NULL;
+}
+
+static bool loadTmd(TitleData *title)
+{
+    if(title->tmd != NULL)
+        return true;
+
+    if(title->tmdSize == 0)
+    {
+        title->tmd = getTmd(title->folderName, true);
+        return title->tmd != NULL;
+    }
+
+    if(journalPending)
+    {
+        flushIOQueue();
+        journalPending = false;
+    }
+
+    FSAFileHandle f;
+    FSError err = FSAOpenFileEx(getFSAClient(), JOURNAL_PATH, "r", 0x000, FS_OPEN_FLAG_NONE, 0, &f);
+    if(err != FS_ERROR_OK)
+    {
+        debugPrintf("Error opening %s: %s!", JOURNAL_PATH, translateFSErr(err));
+        return false;
+    }
+
+    title->tmd = MEMAllocFromDefaultHeapEx(FS_ALIGN(title->tmdSize), 0x40);
+    if(title->tmd != NULL)
+    {
+        err = FSAReadFileWithPos(getFSAClient(), title->tmd, title->tmdSize, 1, title->tmdOffset, f, 0);
+        if(err != 1 || title->tmd->tid != title->tid)
+        {
+            debugPrintf("Error reading spilled TMD: %s!", translateFSErr(err));
+            MEMFreeToDefaultHeap(title->tmd);
+            title->tmd = NULL;
+        }
+    }
+
+    FSACloseFile(getFSAClient(), f);
+    return title->tmd != NULL;
+}
+
+static void journalAdd(TitleData *title)
+{
+    FSAFileHandle f = openFile(JOURNAL_PATH, "a", 0);
+    if(f == 0)
+        return;
+
+    writeJournalRecord(f, title);
+    addToIOQueue(NULL, 0, 0, f);
+    spillTmd(title);
+}
+
+static void removeJournal()
+{
+    // Make sure no append is still in flight before deleting the file
+    flushIOQueue();
+    FSARemove(getFSAClient(), JOURNAL_PATH);
+    journalSize = 0;
+    journalPending = false;
+}
+
+static void writeRemoveRecord(FSAFileHandle f, uint32_t id)
+{
+    JOURNAL_RECORD rec;
+    OSBlockSet(&rec, 0x00, sizeof(JOURNAL_RECORD));
+    rec.magic = JOURNAL_MAGIC;
+    rec.type = JOURNAL_REMOVE;
+    rec.id = id;
+    addToIOQueue(&rec, 1, sizeof(JOURNAL_RECORD), f);
+    journalSize += sizeof(JOURNAL_RECORD);
+}
+
+static void journalRemove(const TitleData *title)
+{
+    if(titleQueue->size == 0)
+    {
+        removeJournal();
+        return;
+    }
+
+    FSAFileHandle f = openFile(JOURNAL_PATH, "a", 0);
+    if(f == 0)
+        return;
+
+    writeRemoveRecord(f, title->journalId);
+    addToIOQueue(NULL, 0, 0, f);
+}
+
+// Journals a title again after the scheduler changed it, the TMD has to be loaded
+static void journalUpdate(TitleData *title)
+{
+    FSAFileHandle f = openFile(JOURNAL_PATH, "a", 0);
+    if(f == 0)
+        return;
+
+    writeRemoveRecord(f, title->journalId);
+    title->journalId = journalId++;
+    writeJournalRecord(f, title);
+    addToIOQueue(NULL, 0, 0, f);
+}
+
+static void freeTitleData(TitleData *title)
+{
+    spillTmd(title);
+    MEMFreeToDefaultHeap(title);
+}
+
+// The TMD of the returned title points into the record
+static TitleData *loadJournalRecord(const JOURNAL_RECORD *rec)
+{
+    const char *folder = ((const char *)rec) + sizeof(JOURNAL_RECORD);
+    const TitleEntry *entry = rec->tid == 0 ? NULL : getTitleEntryByTid(rec->tid);
+    if(entry == NULL && (rec->operation & OPERATION_DOWNLOAD))
+        return NULL;
+
+    TitleData *title = MEMAllocFromDefaultHeap(sizeof(TitleData));
+    if(title == NULL)
+        return NULL;
+
+    char folderName[FS_MAX_PATH];
+    OSBlockMove(folderName, folder, rec->folderLength, false);
+    folderName[rec->folderLength] = '\0';
+    title->folderName = internFolderName(folderName);
+    if(title->folderName == NULL)
+        goto loadError;
+
+    OSBlockMove(title->titleVer, rec->titleVer, sizeof(rec->titleVer), false);
+    title->titleVer[sizeof(title->titleVer) - 1] = '\0';
+    title->operation = rec->operation;
+    title->entry = entry;
+    title->dlDev = rec->dlDev;
+    title->toUSB = rec->flags & JOURNAL_FLAG_TO_USB;
+    title->keepFiles = rec->flags & JOURNAL_FLAG_KEEP_FILES;
+    title->journalId = rec->id;
+    title->rambuf = NULL;
+    title->tmdSize = rec->tmdSize;
+
+    if(rec->tmdSize == 0)
+    {
+        title->tmd = getTmd(title->folderName, true);
+        if(title->tmd == NULL)
+            goto loadError;
+
+        calculateSizes(title, title->tmd);
+        spillTmd(title);
+        return title;
+    }
+
+    title->tmd = (TMD *)(folder + rec->folderLength);
+    if(verifyTmd(title->tmd, title->tmdSize) != TMD_STATE_BAD)
+    {
+        calculateSizes(title, title->tmd);
+        return title;
+    }
+
+loadError:
+    MEMFreeToDefaultHeap(title);
+    return NULL;
+}
+
+// Replays the journal of the last session and compacts it
+static void loadJournal()
+{
+    if(!fileExists(JOURNAL_PATH))
+        return;
+
+    uint8_t *buf;
+    size_t size = readFile(JOURNAL_PATH, (void **)&buf);
+    if(buf == NULL)
+        return;
+
+    TitleData *title;
+    const JOURNAL_RECORD *rec;
+    size_t recSize;
+    for(size_t pos = 0; pos + sizeof(JOURNAL_RECORD) <= size; pos += recSize)
+    {
+        rec = (const JOURNAL_RECORD *)(buf + pos);
+        if(rec->magic != JOURNAL_MAGIC)
+            break;
+
+        recSize = sizeof(JOURNAL_RECORD) + rec->folderLength + rec->tmdSize;
+        if(pos + recSize > size || rec->folderLength >= FS_MAX_PATH) // Torn write
+            break;
+
+        if(rec->type == JOURNAL_REMOVE)
+        {
+            forEachListEntry(titleQueue, title)
+            {
+                if(title->journalId == rec->id)
+                {
+                    removeFromList(titleQueue, title);
+                    title->tmd = NULL;
+                    freeTitleData(title);
+                    break;
+                }
+            }
+        }
+        else
+        {
+            if(rec->id >= journalId)
+                journalId = rec->id + 1;
+
+            title = loadJournalRecord(rec);
+            if(title != NULL && !addToListEnd(titleQueue, title))
+                MEMFreeToDefaultHeap(title);
+        }
+    }
+
+    debugPrintf("Restored %d queue entries", titleQueue->size);
+    if(titleQueue->size == 0)
+    {
+        MEMFreeToDefaultHeap(buf);
+        clearList(folderNames, true);
+        FSARemove(getFSAClient(), JOURNAL_PATH);
+        return;
+    }
+
+    addToScreenLog("Restored %d queue entries", titleQueue->size);
+    FSAFileHandle f = openFile(JOURNAL_PATH, "w", 0);
+    forEachListEntry(titleQueue, title)
+    {
+        if(f != 0)
+        {
+            writeJournalRecord(f, title);
+            title->tmd = NULL;
+        }
+        else if(title->tmdSize != 0)
+        {
+            // Without a journal to spill to keep a copy of the TMD in RAM
+            RAMBUF *rambuf = allocRamBuf();
+            if(rambuf != NULL)
+            {
+                if(setRamBuf(rambuf, title->tmd, title->tmdSize))
+                {
+                    title->rambuf = rambuf;
+                    title->tmd = (TMD *)rambuf->buf;
+                    continue;
+                }
+
+                freeRamBuf(rambuf);
+            }
+
+            title->tmd = NULL;
+        }
+    }
+
+    if(f != 0)
+        addToIOQueue(NULL, 0, 0, f);
+
+    MEMFreeToDefaultHeap(buf);
+}
 
 bool initQueue()
 {
     titleQueue = createList();
-    return titleQueue != NULL;
+    if(titleQueue == NULL)
+        return false;
+
+    folderNames = createList();
+    if(folderNames == NULL)
+    {
+        destroyList(titleQueue, false);
+        return false;
+    }
+
+    loadJournal();
+    debugPrintf("Queue entry size: %u bytes", sizeof(TitleData));
+    return true;
 }
 
 void shutdownQueue()
 {
-    clearQueue();
+    // Keep the journal, the queue will be restored on next start
+    TitleData *title;
+    forEachListEntry(titleQueue, title)
+        freeTitleData(title);
+
     destroyList(titleQueue, false);
+    destroyList(folderNames, true);
 }
 
 int addToQueue(TitleData *data)
 {
     TitleData *title;
+    uint64_t tid = data->tmd->tid;
     forEachListEntry(titleQueue, title)
     {
         if(data->operation & OPERATION_INSTALL && title->operation & OPERATION_INSTALL)
         {
-            if(data->toUSB && title->toUSB && data->tmd->tid == title->tmd->tid)
+            if(data->toUSB && title->toUSB && tid == title->tid)
                 return 2;
         }
         if(data->operation & OPERATION_DOWNLOAD && title->operation & OPERATION_DOWNLOAD)
         {
-            if(data->dlDev == title->dlDev && data->tmd->tid == title->tmd->tid)
+            if(data->dlDev == title->dlDev && tid == title->tid)
                 return 3;
         }
     }
 
-    return addToListEnd(titleQueue, data) ? 1 : 0;
+    data->folderName = internFolderName(data->folderName);
+    if(data->folderName == NULL)
+        return 0;
+
+    calculateSizes(data, data->tmd);
+    // Titles to install only have their TMD on disc already
+    if(data->rambuf == NULL)
+        data->tmdSize = 0;
+
+    if(!addToListEnd(titleQueue, data))
+        return 0;
+
+    data->journalId = journalId++;
+    journalAdd(data);
+    return 1;
 }
 
 static inline void removeFQ(TitleData *title)
@@ -69,50 +479,97 @@ static inline void removeFQ(TitleData *title)
     if(title != NULL)
     {
         removeFromList(titleQueue, title);
-        if(title->rambuf != NULL)
-            freeRamBuf(title->rambuf);
-        else
-            MEMFreeToDefaultHeap(title->tmd);
+        journalRemove(title);
+        freeTitleData(title);
+        if(titleQueue->size == 0)
+            clearList(folderNames, true);
+    }
+}
+
+static void scheduleQueue()
+{
+    size_t count = getListSize(titleQueue);
+    TitleData **titles = MEMAllocFromDefaultHeap(sizeof(TitleData *) * count);
+    if(titles == NULL)
+        return;
+
+    size_t i = 0;
+    TitleData *title;
+    forEachListEntry(titleQueue, title)
+        titles[i++] = title;
+
+    if(scheduleTitles(titles, count))
+    {
+        // Reorder in place, the list elements stay the same
+        i = 0;
+        for(ELEMENT *cur = titleQueue->first; cur != NULL; cur = cur->next)
+            cur->content = titles[i++];
+
+        addToScreenLog("Queue reordered: Small titles first, updates and DLC after their games");
+    }
+
+    MEMFreeToDefaultHeap(titles);
+}
+
+static inline NUSDEV getInstallSource(const TitleData *title)
+{
+    return title->operation & OPERATION_DOWNLOAD ? title->dlDev : getDevFromPath(title->folderName);
+}
+
+static inline const char *getDevName(NUSDEV dev)
+{
+    return dev == NUSDEV_SD ? "SD" : (dev & NUSDEV_USB ? "USB" : "NAND");
+}
+
+// Checked before every title as finished titles freed and the running installation claimed space in the meantime
+static bool checkTitleSpace(const TitleData *title)
+{
+    uint64_t dlSize = title->operation & OPERATION_DOWNLOAD ? title->dlSize : 0;
+    if(title->operation & OPERATION_INSTALL)
+    {
+        NUSDEV instDev = title->toUSB ? getUSB() : NUSDEV_MLC;
+        uint64_t size = title->installSize;
+        if(title->dlDev == instDev)
+        {
+            size += dlSize;
+            dlSize = 0;
+        }
 
-        MEMFreeToDefaultHeap(title);
+        if(!checkFreeSpace(instDev, size))
+            return false;
     }
+
+    return dlSize == 0 || checkFreeSpace(title->dlDev, dlSize);
 }
 
 bool proccessQueue()
 {
     TitleData *title;
     uint64_t sizes[3] = { 0, 0, 0 };
+    uint64_t tmpSizes[3] = { 0, 0, 0 };
+    int dev;
     QUEUE_DATA queueData = { .downloaded = 0, .dlSize = 0, .packages = 0, .current = 0, .eta = -1 };
 
     forEachListEntry(titleQueue, title)
     {
+        if(title->operation & OPERATION_INSTALL)
+            sizes[title->toUSB ? 0 : 2] += title->installSize;
+
         if(title->operation & OPERATION_DOWNLOAD)
-            queueData.packages++;
-        for(uint16_t i = 0; i < title->tmd->num_contents; ++i)
         {
-            if(title->operation & OPERATION_INSTALL)
-                sizes[title->toUSB ? 0 : 2] += title->tmd->contents[i].size;
-
-            if(title->operation & OPERATION_DOWNLOAD)
-            {
-                queueData.dlSize += title->tmd->contents[i].size;
-                if(title->tmd->contents[i].type & TMD_CONTENT_TYPE_HASHED)
-                    queueData.dlSize += getH3size(title->tmd->contents[i].size);
-
-                if(title->keepFiles)
-                {
-                    int j = title->dlDev & NUSDEV_USB ? 0 : (title->dlDev & NUSDEV_SD ? 1 : 2);
-                    if(title->tmd->contents[i].type & TMD_CONTENT_TYPE_HASHED)
-                        sizes[j] += getH3size(title->tmd->contents[i].size);
-
-                    sizes[j] += title->tmd->contents[i].size;
-                }
-            }
+            queueData.packages++;
+            queueData.dlSize += title->dlSize;
+            dev = title->dlDev & NUSDEV_USB ? 0 : (title->dlDev & NUSDEV_SD ? 1 : 2);
+            if(title->keepFiles)
+                sizes[dev] += title->dlSize;
+            else if(title->dlSize > tmpSizes[dev])
+                tmpSizes[dev] = title->dlSize; // Temporary files of the biggest title
         }
     }
 
     for(int i = 0; i < 3; ++i)
     {
+        sizes[i] += tmpSizes[i];
         if(sizes[i] != 0)
         {
             NUSDEV toCheck;
@@ -133,36 +590,118 @@ bool proccessQueue()
         }
     }
 
+    /*
+     * Downloads and installations are pipelined: While MCP installs a title
+     * in the background the next one gets downloaded. Only one installation
+     * can run at a time, so the previous one gets finished before the next
+     * one starts. Cancelling a download stops the queue but the running
+     * installation is still shown and can be cancelled on its own.
+     * A title stays in the queue (and the journal) until it's installed.
+     * The scheduler decides on the order and moves temporary downloads away
+     * from the device the running installation reads from.
+     */
+    scheduleQueue();
+    static INSTALL_JOB job;
+    TitleData *installing = NULL;
+    bool ret = false;
     TitleData *last = NULL;
     disableApd();
     forEachListEntry(titleQueue, title)
     {
         removeFQ(last);
+        last = NULL;
         if(!AppRunning(true))
             goto exitApd;
 
+        if(!loadTmd(title))
+        {
+            showErrorFrame(localise("Invalid title.tmd file!"));
+            goto exitApd;
+        }
+
+        if(installing != NULL && (title->operation & OPERATION_DOWNLOAD))
+        {
+            NUSDEV busy = getInstallSource(installing);
+            NUSDEV dlDev = getBalancedDownloadDevice(title, busy, getUSB());
+            if(dlDev != title->dlDev && getFreeSpace(dlDev) >= title->dlSize)
+            {
+                addToScreenLog("Scheduler: Downloading %s to %s while installing from %s", title->entry->name, getDevName(dlDev), getDevName(busy));
+                title->dlDev = dlDev;
+                journalUpdate(title);
+            }
+        }
+
+        if(!checkTitleSpace(title))
+            goto exitApd;
+
+        const char *game;
+        const char *path;
+        char dir[FS_MAX_PATH];
         if(title->operation & OPERATION_DOWNLOAD)
         {
             queueData.current++;
 
-            if(!downloadTitle(title->tmd, title->tmdSize, title->entry, title->titleVer, title->folderName, title->operation & OPERATION_INSTALL, title->dlDev, title->toUSB, title->keepFiles, &queueData))
+            // downloadTitle() appends the title ID and version, interned names are shared
+            char folderName[FS_MAX_PATH - 11];
+            strcpy(folderName, title->folderName);
+            if(!downloadTitle(title->tmd, title->tmdSize, title->entry, title->titleVer, folderName, false, title->dlDev, title->toUSB, title->keepFiles, &queueData))
                 goto exitApd;
+
+            game = title->entry->name;
+            strcpy(dir, title->dlDev == NUSDEV_USB01 ? INSTALL_DIR_USB1 : (title->dlDev == NUSDEV_USB02 ? INSTALL_DIR_USB2 : (title->dlDev == NUSDEV_SD ? INSTALL_DIR_SD : INSTALL_DIR_MLC)));
+            strcat(dir, folderName);
+            strcat(dir, "/");
+            path = dir;
         }
-        else if(title->operation & OPERATION_INSTALL)
+        else
         {
-            if(!install(title->entry == NULL ? prettyDir(title->folderName) : title->entry->name, false /* TODO */, title->dlDev, title->folderName, title->toUSB, title->keepFiles, title->tmd))
-                goto exitApd;
+            game = title->entry == NULL ? prettyDir(title->folderName) : title->entry->name;
+            path = title->folderName;
+        }
+
+        if(title->operation & OPERATION_INSTALL)
+        {
+            if(installing != NULL)
+            {
+                TitleData *installed = installing;
+                installing = NULL;
+                // Waiting for MCP leaves the connection idle, keep it warm for the next download
+                if(queueData.current < queueData.packages)
+                    warmupConnection();
+                if(!finishInstall(&job))
+                    goto exitApd;
+
+                removeFQ(installed);
+            }
+
+            switch(startInstall(&job, game, isDLC(title->tmd->tid) || isUpdate(title->tmd->tid), title->dlDev, path, title->toUSB, title->keepFiles, title->tmd))
+            {
+                case 0:
+                    installing = title;
+                    continue;
+                case 1:
+                    goto exitApd;
+                default:
+                    break;
+            }
         }
 
         last = title;
     }
 
-    removeFQ(last);
-    enableApd();
-    return true;
+    ret = true;
 exitApd:
+    if(installing != NULL)
+    {
+        if(finishInstall(&job))
+            removeFQ(installing);
+        else
+            ret = false;
+    }
+
+    removeFQ(last);
     enableApd();
-    return false;
+    return ret;
 }
 
 bool removeFromQueue(uint32_t index)
@@ -171,26 +710,23 @@ bool removeFromQueue(uint32_t index)
     if(title == NULL)
         return false;
 
-    if(title->rambuf != NULL)
-        freeRamBuf(title->rambuf);
-    else
-        MEMFreeToDefaultHeap(title->tmd);
+    journalRemove(title);
+    freeTitleData(title);
+    if(titleQueue->size == 0)
+        clearList(folderNames, true);
 
-    MEMFreeToDefaultHeap(title);
     return true;
 }
 
 void clearQueue()
 {
     TitleData *title;
-    TitleData *last = NULL;
     forEachListEntry(titleQueue, title)
-    {
-        removeFQ(last);
-        last = title;
-    }
+        freeTitleData(title);
 
-    removeFQ(last);
+    clearList(titleQueue, false);
+    clearList(folderNames, true);
+    removeJournal();
 }
 
 LIST *getTitleQueue()
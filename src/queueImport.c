@@ -0,0 +1,506 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <wut-fixups.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <config.h>
+#include <downloader.h>
+#include <file.h>
+#include <filesystem.h>
+#include <ioQueue.h>
+#include <localisation.h>
+#include <menu/utils.h>
+#include <queue.h>
+#include <queueImport.h>
+#include <renderer.h>
+#include <titles.h>
+#include <utils.h>
+
+#include <jansson.h>
+
+#pragma GCC diagnostic ignored "-Wundef"
+#include <coreinit/memdefaultheap.h>
+#include <coreinit/memory.h>
+#pragma GCC diagnostic pop
+
+/*
+ * Import format, either as JSON array of objects with the keys "tid",
+ * "version" and "device" or as text file with one title per line:
+ * <title ID> [version] [device]
+ * Device is the install target ("usb" or "mlc") or, to download only, the
+ * download target ("sd", "dl-usb" or "dl-mlc").
+ * Without device the title gets installed to USB if connected, else to NAND.
+ * Lines starting with # are ignored.
+ */
+
+typedef struct
+{
+    TMD_REQUEST request;
+    OPERATION operation;
+    NUSDEV dlDev; // Only used to download only
+    bool toUSB;
+    size_t slot; // Index of the shared TMD request
+} IMPORT_ENTRY;
+
+static bool parseTid(const char *str, uint64_t *tid)
+{
+    if(strlen(str) != 16)
+        return false;
+
+    for(int i = 0; i < 16; ++i)
+        if(!isHexa(str[i]))
+            return false;
+
+    *tid = strtoull(str, NULL, 16);
+    return true;
+}
+
+static bool parseVersion(const char *str, char *out)
+{
+    size_t len = strlen(str);
+    if(len == 0 || len > 32)
+        return false;
+
+    for(size_t i = 0; i < len; ++i)
+        if(!isNumber(str[i]))
+            return false;
+
+    OSBlockMove(out, str, len + 1, false);
+    return true;
+}
+
+static bool parseDevice(const char *str, IMPORT_ENTRY *entry)
+{
+    if(strcmp(str, "sd") == 0 || strcmp(str, "dl-sd") == 0)
+    {
+        entry->operation = OPERATION_DOWNLOAD;
+        entry->dlDev = NUSDEV_SD;
+        entry->toUSB = false;
+    }
+    else if(strcmp(str, "dl-usb") == 0)
+    {
+        entry->dlDev = getUSB();
+        if(entry->dlDev == NUSDEV_NONE)
+            return false;
+
+        entry->operation = OPERATION_DOWNLOAD;
+        entry->toUSB = false;
+    }
+    else if(strcmp(str, "dl-mlc") == 0 || strcmp(str, "dl-nand") == 0)
+    {
+        entry->operation = OPERATION_DOWNLOAD;
+        entry->dlDev = NUSDEV_MLC;
+        entry->toUSB = false;
+    }
+    else if(strcmp(str, "usb") == 0)
+    {
+        if(getUSB() == NUSDEV_NONE)
+            return false;
+
+        entry->operation = OPERATION_DOWNLOAD_INSTALL;
+        entry->toUSB = true;
+    }
+    else if(strcmp(str, "mlc") == 0 || strcmp(str, "nand") == 0)
+    {
+        entry->operation = OPERATION_DOWNLOAD_INSTALL;
+        entry->toUSB = false;
+    }
+    else
+        return false;
+
+    return true;
+}
+
+static void initEntry(IMPORT_ENTRY *entry)
+{
+    entry->request.titleVer[0] = '\0';
+    entry->operation = OPERATION_DOWNLOAD_INSTALL;
+    entry->dlDev = NUSDEV_SD;
+    entry->toUSB = getUSB() != NUSDEV_NONE;
+}
+
+static inline bool sameRequest(const TMD_REQUEST *a, const TMD_REQUEST *b)
+{
+    return a->tid == b->tid && strcmp(a->titleVer, b->titleVer) == 0;
+}
+
+static bool isDuplicateEntry(const IMPORT_ENTRY *entries, size_t count, const IMPORT_ENTRY *entry)
+{
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(entries[i].operation != entry->operation || entries[i].toUSB != entry->toUSB || !sameRequest(&entries[i].request, &entry->request))
+            continue;
+
+        if(entry->operation != OPERATION_DOWNLOAD || entries[i].dlDev == entry->dlDev)
+            return true;
+    }
+
+    return false;
+}
+
+static RAMBUF *copyRamBuf(const RAMBUF *rambuf)
+{
+    RAMBUF *ret = allocRamBuf();
+    if(ret == NULL || setRamBuf(ret, rambuf->buf, rambuf->size))
+        return ret;
+
+    freeRamBuf(ret);
+    return NULL;
+}
+
+static size_t parseJson(const char *buf, size_t size, IMPORT_ENTRY **out)
+{
+    json_t *json = json_loadb(buf, size, 0, NULL);
+    if(json == NULL || !json_is_array(json))
+    {
+        if(json != NULL)
+            json_decref(json);
+
+        return 0;
+    }
+
+    size_t ret = 0;
+    size_t count = json_array_size(json);
+    IMPORT_ENTRY *entries = count == 0 ? NULL : MEMAllocFromDefaultHeap(sizeof(IMPORT_ENTRY) * count);
+    if(entries != NULL)
+    {
+        json_t *obj;
+        json_t *value;
+        char ver[12];
+        for(size_t i = 0; i < count; ++i)
+        {
+            obj = json_array_get(json, i);
+            if(!json_is_object(obj))
+                continue;
+
+            initEntry(entries + ret);
+            value = json_object_get(obj, "tid");
+            if(value == NULL || !json_is_string(value) || !parseTid(json_string_value(value), &entries[ret].request.tid))
+                continue;
+
+            value = json_object_get(obj, "version");
+            if(value != NULL)
+            {
+                if(json_is_integer(value))
+                {
+                    sprintf(ver, "%d", (int)json_integer_value(value));
+                    if(!parseVersion(ver, entries[ret].request.titleVer))
+                        continue;
+                }
+                else if(!json_is_string(value) || (json_string_value(value)[0] != '\0' && !parseVersion(json_string_value(value), entries[ret].request.titleVer)))
+                    continue;
+            }
+
+            value = json_object_get(obj, "device");
+            if(value != NULL && (!json_is_string(value) || !parseDevice(json_string_value(value), entries + ret)))
+                continue;
+
+            ++ret;
+        }
+
+        *out = entries;
+    }
+
+    json_decref(json);
+    return ret;
+}
+
+static size_t parseText(const char *buf, size_t size, IMPORT_ENTRY **out)
+{
+    size_t count = 1;
+    for(size_t i = 0; i < size; ++i)
+        if(buf[i] == '\n')
+            ++count;
+
+    IMPORT_ENTRY *entries = MEMAllocFromDefaultHeap(sizeof(IMPORT_ENTRY) * count);
+    if(entries == NULL)
+        return 0;
+
+    size_t ret = 0;
+    const char *end = buf + size;
+    const char *nl;
+    char line[128];
+    size_t len;
+    char *token;
+    char *saveptr;
+    while(buf < end)
+    {
+        nl = buf;
+        while(nl < end && *nl != '\n')
+            ++nl;
+
+        len = nl - buf;
+        if(len > sizeof(line) - 1)
+            len = sizeof(line) - 1;
+
+        OSBlockMove(line, buf, len, false);
+        line[len] = '\0';
+        buf = nl + 1;
+
+        token = strtok_r(line, " \t\r,", &saveptr);
+        if(token == NULL || token[0] == '#')
+            continue;
+
+        initEntry(entries + ret);
+        if(!parseTid(token, &entries[ret].request.tid))
+        {
+            debugPrintf("Invalid title ID: %s", token);
+            continue;
+        }
+
+        bool valid = true;
+        while(valid && (token = strtok_r(NULL, " \t\r,", &saveptr)) != NULL)
+            valid = isNumber(token[0]) ? parseVersion(token, entries[ret].request.titleVer) : parseDevice(token, entries + ret);
+
+        if(valid)
+            ++ret;
+    }
+
+    *out = entries;
+    return ret;
+}
+
+bool importQueue()
+{
+    bool json = fileExists(QUEUE_IMPORT_JSON);
+    const char *path = json ? QUEUE_IMPORT_JSON : QUEUE_IMPORT_TEXT;
+    if(!json && !fileExists(path))
+    {
+        char toScreen[1024];
+        sprintf(toScreen, "%s\n%s\n%s", localise("No queue to import found. Put a list of title IDs into"), prettyDir(QUEUE_IMPORT_TEXT), prettyDir(QUEUE_IMPORT_JSON));
+        showErrorFrame(toScreen);
+        return false;
+    }
+
+    char *buf;
+    size_t size = readFile(path, (void **)&buf);
+    if(buf == NULL)
+        return false;
+
+    IMPORT_ENTRY *entries = NULL;
+    size_t count = json ? parseJson(buf, size, &entries) : parseText(buf, size, &entries);
+    MEMFreeToDefaultHeap(buf);
+    if(count == 0)
+    {
+        if(entries != NULL)
+            MEMFreeToDefaultHeap(entries);
+
+        showErrorFrame(localise("No valid title IDs found!"));
+        return false;
+    }
+
+    /*
+     * The queue needs a database entry for every title to download, so drop unknown ones
+     * and duplicated lines before hitting the network. Titles which only differ in the
+     * device share their TMD request.
+     */
+    int failed = 0;
+    int duplicates = 0;
+    size_t j = 0;
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(getTitleEntryByTid(entries[i].request.tid) == NULL)
+        {
+            debugPrintf("Unknown title ID: %016llx", entries[i].request.tid);
+            ++failed;
+        }
+        else if(isDuplicateEntry(entries, j, entries + i))
+            ++duplicates;
+        else
+        {
+            if(i != j)
+                OSBlockMove(entries + j, entries + i, sizeof(IMPORT_ENTRY), false);
+
+            ++j;
+        }
+    }
+
+    count = j;
+    TMD_REQUEST *requests = MEMAllocFromDefaultHeap(sizeof(TMD_REQUEST) * (count == 0 ? 1 : count));
+    if(requests == NULL)
+    {
+        MEMFreeToDefaultHeap(entries);
+        return false;
+    }
+
+    size_t requestCount = 0;
+    for(size_t i = 0; i < count; ++i)
+    {
+        for(j = 0; j < requestCount; ++j)
+            if(sameRequest(requests + j, &entries[i].request))
+                break;
+
+        if(j == requestCount)
+            OSBlockMove(requests + requestCount++, &entries[i].request, sizeof(TMD_REQUEST), false);
+
+        entries[i].slot = j;
+    }
+
+    downloadTmds(requests, requestCount);
+
+    NUSDEV usb = getUSB();
+    NUSDEV dlDev = usb != NUSDEV_NONE && dlToUSBenabled() ? usb : NUSDEV_SD;
+    int added = 0;
+    TMD_REQUEST *request;
+    RAMBUF *rambuf;
+    TMD *tmd;
+    TitleData *title;
+    for(size_t i = 0; i < count; ++i)
+    {
+        request = requests + entries[i].slot;
+        if(request->rambuf == NULL)
+        {
+            ++failed;
+            continue;
+        }
+
+        tmd = (TMD *)request->rambuf->buf;
+        if(verifyTmd(tmd, request->rambuf->size) != TMD_STATE_GOOD || tmd->tid != request->tid)
+        {
+            ++failed;
+            continue;
+        }
+
+        // Every queue entry owns its TMD
+        rambuf = copyRamBuf(request->rambuf);
+        if(rambuf == NULL)
+        {
+            ++failed;
+            continue;
+        }
+
+        title = MEMAllocFromDefaultHeap(sizeof(TitleData));
+        if(title == NULL)
+        {
+            freeRamBuf(rambuf);
+            ++failed;
+            continue;
+        }
+
+        title->tmd = (TMD *)rambuf->buf;
+        title->tmdSize = rambuf->size;
+        title->rambuf = rambuf;
+        title->entry = getTitleEntryByTid(request->tid);
+        strcpy(title->titleVer, request->titleVer);
+        title->folderName = "";
+        title->operation = entries[i].operation;
+        title->dlDev = entries[i].operation == OPERATION_DOWNLOAD ? entries[i].dlDev : dlDev;
+        title->toUSB = entries[i].toUSB;
+        title->keepFiles = entries[i].operation == OPERATION_DOWNLOAD;
+
+        switch(addToQueue(title))
+        {
+            case 1:
+                ++added;
+                continue;
+            case 0:
+                ++failed;
+                break;
+            default:
+                ++duplicates;
+                break;
+        }
+
+        freeRamBuf(title->rambuf);
+        MEMFreeToDefaultHeap(title);
+    }
+
+    for(size_t i = 0; i < requestCount; ++i)
+        if(requests[i].rambuf != NULL)
+            freeRamBuf(requests[i].rambuf);
+
+    MEMFreeToDefaultHeap(requests);
+    MEMFreeToDefaultHeap(entries);
+
+    addToScreenLog("Imported %d titles (%d duplicates, %d failed)", added, duplicates, failed);
+    if(failed != 0)
+    {
+        char toScreen[128];
+        sprintf(toScreen, "%d %s", failed, localise("titles couldn't be imported"));
+        showErrorFrame(toScreen);
+    }
+
+    return added != 0;
+}
+
+static const char *getExportDevice(const TitleData *title)
+{
+    if(title->operation & OPERATION_INSTALL)
+        return title->toUSB ? "usb" : "mlc";
+
+    if(title->dlDev & NUSDEV_USB)
+        return "dl-usb";
+
+    return title->dlDev == NUSDEV_MLC ? "dl-mlc" : "sd";
+}
+
+bool exportQueue()
+{
+    json_t *json = json_array();
+    if(json == NULL)
+        return false;
+
+    TitleData *title;
+    json_t *obj;
+    char tid[17];
+    forEachListEntry(getTitleQueue(), title)
+    {
+        // Local folders to install can't be imported
+        if(!(title->operation & OPERATION_DOWNLOAD) || title->entry == NULL)
+            continue;
+
+        obj = json_object();
+        if(obj == NULL)
+            continue;
+
+        hex(title->tid, 16, tid);
+        json_object_set_new(obj, "tid", json_string(tid));
+        if(title->titleVer[0] != '\0')
+            json_object_set_new(obj, "version", json_string(title->titleVer));
+
+        json_object_set_new(obj, "device", json_string(getExportDevice(title)));
+        json_array_append_new(json, obj);
+    }
+
+    bool ret = false;
+    char *out = json_dumps(json, JSON_INDENT(4));
+    if(out != NULL)
+    {
+        flushIOQueue();
+        FSAFileHandle f = openFile(QUEUE_IMPORT_JSON, "w", 0);
+        if(f != 0)
+        {
+            addToIOQueue(out, 1, strlen(out), f);
+            addToIOQueue(NULL, 0, 0, f);
+            addToScreenLog("Queue exported to %s", prettyDir(QUEUE_IMPORT_JSON));
+            ret = true;
+        }
+        else
+            showErrorFrame(localise("Couldn't save queue file!\nYour SD card might be write locked."));
+
+        MEMFreeToDefaultHeap(out);
+    }
+
+    json_decref(json);
+    return ret;
+}
@@ -21,12 +21,15 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <crypto.h>
 #include <file.h>
 #include <input.h>
 #include <list.h>
+#include <memTrack.h>
 #include <menu/utils.h>
 #include <osdefs.h>
 #include <renderer.h>
@@ -34,6 +37,7 @@
 #include <staticMem.h>
 #include <swkbd_wrapper.h>
 #include <thread.h>
+#include <trace.h>
 #include <utils.h>
 
 #include <SDL2/SDL.h>
@@ -56,12 +60,26 @@
 #define MAX_OVERLAYS 8
 #define SDL_RECTS    512
 
+// All icons are packed into a single atlas texture with one cell per icon
+#define ICON_CELL      21
+#define ICON_ARROW     0
+#define ICON_CHECKMARK 1
+#define ICON_FLAG      2
+#define ICON_DEVICE    (ICON_FLAG + 8)
+#define ICONS          (ICON_DEVICE + 4)
+
 typedef struct
 {
     SDL_Texture *tex;
     SDL_Rect rect[2];
 } ErrorOverlay;
 
+typedef struct
+{
+    SDL_Texture *tex;
+    SDL_Rect rect;
+} Icon;
+
 static SDL_Window *window = NULL;
 static SDL_Renderer *renderer = NULL;
 static FC_Font *font = NULL;
@@ -72,34 +90,143 @@ static int32_t spaceWidth;
 
 static SDL_Texture *frameBuffer;
 static SDL_Texture *defaultTex = NULL;
-static SDL_Texture *arrowTex;
-static SDL_Texture *checkmarkTex;
+static SDL_Texture *iconAtlas = NULL;
+static Icon icons[ICONS];
 static SDL_Texture *tabTex;
-static SDL_Texture *flagTex[8];
-static SDL_Texture *deviceTex[4];
 static SDL_Texture *barTex;
 static SDL_Texture *bgTex;
 static SDL_Texture *byeTex;
 static SDL_Rect byeRect;
 
-static LIST *rectList;
 static LIST *errorOverlayList;
 
-static inline SDL_Rect *createRect()
+static SDL_Rect rectArena[SDL_RECTS];
+static size_t rectCount = 0;
+static size_t rectBatchStart = 0;
+static SCREEN_COLOR rectBatchColor;
+
+#ifdef NUSSPLI_DEBUG
+typedef struct
 {
-    SDL_Rect *ret = MEMAllocFromDefaultHeap(sizeof(SDL_Rect));
-    if(!ret)
-        return NULL;
+    uint32_t drawCalls;
+    uint32_t rects;
+    uint32_t arenaWraps;
+} FrameStats;
+
+static FrameStats frameStats;
+static FrameStats lastFrameStats;
 
-    if(!addToListEnd(rectList, ret))
+// Time from colorStartNewFrame() till the frame got presented, in microseconds
+#define FRAME_SAMPLES 256
+static OSTime frameStart = 0;
+static uint32_t frameTimes[FRAME_SAMPLES];
+static uint32_t frameSamples = 0;
+
+#define countDrawCall() ++frameStats.drawCalls
+
+static int compareFrameTimes(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void addFrameTime()
+{
+    if(frameStart == 0)
+        return;
+
+    frameTimes[frameSamples++] = OSTicksToMicroseconds(OSGetSystemTime() - frameStart);
+    frameStart = 0;
+    if(frameSamples != FRAME_SAMPLES)
+        return;
+
+    qsort(frameTimes, FRAME_SAMPLES, sizeof(uint32_t), compareFrameTimes);
+    debugPrintf("Frame times (us): p50 %u, p90 %u, p99 %u, max %u", frameTimes[FRAME_SAMPLES / 2], frameTimes[(FRAME_SAMPLES * 9) / 10], frameTimes[(FRAME_SAMPLES * 99) / 100], frameTimes[FRAME_SAMPLES - 1]);
+    frameSamples = 0;
+}
+
+// Drawn above everything else, straight to the screen
+static void drawMemOverlay()
+{
+    if(!memOverlayEnabled())
+        return;
+
+    char line[128];
+    getMemOverlayString(line);
+    FC_DrawColor(font, renderer, FONT_SIZE >> 1, SCREEN_HEIGHT - (FONT_SIZE << 1), SCREEN_COLOR_YELLOW, line);
+}
+#else
+#define countDrawCall()
+#define addFrameTime()
+#define drawMemOverlay()
+#endif
+
+// Submits all pending rectangles of the current batch with a single draw call
+static inline void flushRects()
+{
+    int n = rectCount - rectBatchStart;
+    if(n == 0)
+        return;
+
+    SDL_SetRenderDrawColor(renderer, rectBatchColor.r, rectBatchColor.g, rectBatchColor.b, rectBatchColor.a);
+    SDL_RenderFillRects(renderer, rectArena + rectBatchStart, n);
+    rectBatchStart = rectCount;
+    countDrawCall();
+}
+
+// SDL copies the rectangles into its command queue, so once everything got flushed the arena can be reused
+static inline SDL_Rect *createRect()
+{
+    if(rectCount == SDL_RECTS)
     {
-        MEMFreeToDefaultHeap(ret);
-        return NULL;
+        flushRects();
+        rectCount = rectBatchStart = 0;
+#ifdef NUSSPLI_DEBUG
+        ++frameStats.arenaWraps;
+#endif
     }
 
-    return ret;
+#ifdef NUSSPLI_DEBUG
+    ++frameStats.rects;
+#endif
+    return rectArena + rectCount++;
+}
+
+static inline void rectToFrame(int x, int y, int w, int h, SCREEN_COLOR color)
+{
+    if(rectCount != rectBatchStart && *(uint32_t *)&(color.r) != *(uint32_t *)&(rectBatchColor.r))
+        flushRects();
+
+    SDL_Rect *rect = createRect();
+    rectBatchColor = color;
+
+    rect->x = x;
+    rect->y = y;
+    rect->w = w;
+    rect->h = h;
+}
+
+// Texture copies must not take their destination from the arena as flushRects() would fill it with the batch color
+static inline void copyToFrame(SDL_Texture *tex, const SDL_Rect *src, const SDL_Rect *rect)
+{
+    flushRects();
+    SDL_RenderCopy(renderer, tex, src, rect);
+    countDrawCall();
 }
 
+static inline void iconToFrame(int x, int y, const Icon *icon)
+{
+    SDL_Rect rect = {
+        .x = x,
+        .y = y,
+        .w = icon->rect.w,
+        .h = icon->rect.h,
+    };
+    copyToFrame(icon->tex, &(icon->rect), &rect);
+}
+
+// Needs a lineBuffer big enough for a copy of str in scope when maxWidth is set
 #define internalTextToFrame()                                 \
     {                                                         \
         ++line;                                               \
@@ -110,7 +237,6 @@ static inline SDL_Rect *createRect()
         if(maxWidth != 0 && w > maxWidth)                     \
         {                                                     \
             size_t i = strlen(str);                           \
-            char *lineBuffer = (char *)getStaticLineBuffer(); \
             char *tmp = lineBuffer;                           \
             OSBlockMove(tmp, str, i + 1, false);              \
             tmp += i;                                         \
@@ -159,8 +285,11 @@ void textToFrameCut(int line, int column, const char *str, int maxWidth)
     if(font == NULL)
         return;
 
+    char lineBuffer[maxWidth == 0 ? 1 : strlen(str) + 1];
     internalTextToFrame();
+    flushRects();
     FC_Draw(font, renderer, column, line, str);
+    countDrawCall();
 }
 
 void textToFrameColoredCut(int line, int column, const char *str, SCREEN_COLOR color, int maxWidth)
@@ -168,8 +297,11 @@ void textToFrameColoredCut(int line, int column, const char *str, SCREEN_COLOR c
     if(font == NULL)
         return;
 
+    char lineBuffer[maxWidth == 0 ? 1 : strlen(str) + 1];
     internalTextToFrame();
+    flushRects();
     FC_DrawColor(font, renderer, column, line, color, str);
+    countDrawCall();
 }
 
 int textToFrameMultiline(int x, int y, const char *text, size_t len)
@@ -184,8 +316,9 @@ int textToFrameMultiline(int x, int y, const char *text, size_t len)
         return 1;
     }
 
-    char *p = getStaticLineBuffer();
     size_t l = strlen(text);
+    char lineBuffer[l + 1];
+    char *p = lineBuffer;
     OSBlockMove(p, text, l + 1, false);
 
     char *t;
@@ -234,17 +367,7 @@ void lineToFrame(int column, SCREEN_COLOR color)
     ++column;
     column *= FONT_SIZE;
 
-    SDL_Rect *rect = createRect();
-    if(rect == NULL)
-        return;
-
-    rect->x = FONT_SIZE;
-    rect->y = column + ((FONT_SIZE >> 1) - 1);
-    rect->w = SCREEN_WIDTH - (FONT_SIZE << 1);
-    rect->h = 3;
-
-    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-    SDL_RenderFillRect(renderer, rect);
+    rectToFrame(FONT_SIZE, column + ((FONT_SIZE >> 1) - 1), SCREEN_WIDTH - (FONT_SIZE << 1), 3, color);
 }
 
 void boxToFrame(int lineStart, int lineEnd)
@@ -252,39 +375,20 @@ void boxToFrame(int lineStart, int lineEnd)
     if(font == NULL)
         return;
 
-    SDL_Rect *rect[3];
-    for(int i = 0; i < 3; i++)
-    {
-        rect[i] = createRect();
-        if(rect[i] == NULL)
-            return;
-    }
-
     // Horizontal lines
     lineToFrame(lineStart, SCREEN_COLOR_GRAY);
     lineToFrame(lineEnd, SCREEN_COLOR_GRAY);
 
-    // Vertical lines
-    rect[0]->w = 3;
-    rect[0]->h = (lineEnd - lineStart) * FONT_SIZE;
-    rect[0]->x = FONT_SIZE;
-    rect[0]->y = ((++lineStart) * FONT_SIZE) + ((FONT_SIZE >> 1) - 1);
-    SDL_RenderFillRect(renderer, rect[0]);
-
-    rect[1]->x = (SCREEN_WIDTH - (FONT_SIZE << 1) + FONT_SIZE) - 3;
-    rect[1]->y = rect[0]->y;
-    rect[1]->w = 3;
-    rect[1]->h = rect[0]->h;
-    SDL_RenderFillRect(renderer, rect[1]);
+    // Vertical lines - these end up in the same batch as the horizontal ones
+    int h = (lineEnd - lineStart) * FONT_SIZE;
+    int y = ((++lineStart) * FONT_SIZE) + ((FONT_SIZE >> 1) - 1);
+    rectToFrame(FONT_SIZE, y, 3, h, SCREEN_COLOR_GRAY);
+    rectToFrame((SCREEN_WIDTH - (FONT_SIZE << 1) + FONT_SIZE) - 3, y, 3, h, SCREEN_COLOR_GRAY);
 
     // Background - we paint it on top of the gray lines as they look better that way
-    rect[2]->x = FONT_SIZE + 2;
-    rect[2]->y = rect[0]->y + 2;
-    rect[2]->w = SCREEN_WIDTH - (FONT_SIZE << 1) - 3;
-    rect[2]->h = rect[0]->h - 3;
     SCREEN_COLOR co = SCREEN_COLOR_BLACK;
-    SDL_SetRenderDrawColor(renderer, co.r, co.g, co.b, 64);
-    SDL_RenderFillRect(renderer, rect[2]);
+    co.a = 64;
+    rectToFrame(FONT_SIZE + 2, y + 2, SCREEN_WIDTH - (FONT_SIZE << 1) - 3, h - 3, co);
 }
 
 void barToFrame(int line, int column, uint32_t width, float progress)
@@ -292,44 +396,30 @@ void barToFrame(int line, int column, uint32_t width, float progress)
     if(font == NULL)
         return;
 
-    SDL_Rect *rect[3];
-    for(int i = 0; i < 3; i++)
-    {
-        rect[i] = createRect();
-        if(rect[i] == NULL)
-            return;
-    }
-
-    rect[0]->x = FONT_SIZE + (column * spaceWidth);
-    rect[0]->y = ((++line) * FONT_SIZE) - 2;
-    rect[0]->w = ((int)width) * spaceWidth;
-    rect[0]->h = FONT_SIZE;
-
-    SDL_Color co = SCREEN_COLOR_GRAY;
-    SDL_SetRenderDrawColor(renderer, co.r, co.g, co.b, co.a);
-    SDL_RenderFillRect(renderer, rect[0]);
-
-    rect[1]->x = rect[0]->x + 2;
-    rect[1]->y = rect[0]->y + 2;
-    rect[1]->h = FONT_SIZE - 4;
-    rect[2]->w = rect[0]->w - 4;
+    int x = FONT_SIZE + (column * spaceWidth);
+    int y = ((++line) * FONT_SIZE) - 2;
+    int w = ((int)width) * spaceWidth;
+    rectToFrame(x, y, w, FONT_SIZE, SCREEN_COLOR_GRAY);
 
     char text[8];
     sprintf(text, "%d%%%%", (int)(progress * 100.0f));
 
-    progress *= rect[2]->w;
-    rect[1]->w = progress;
+    x += 2;
+    y += 2;
+    w -= 4;
+    progress *= w;
 
-    SDL_RenderCopy(renderer, barTex, NULL, rect[1]);
+    SDL_Rect rect = {
+        .x = x,
+        .y = y,
+        .w = progress,
+        .h = FONT_SIZE - 4,
+    };
+    copyToFrame(barTex, NULL, &rect);
 
-    rect[2]->x = rect[1]->x + rect[1]->w;
-    rect[2]->y = rect[1]->y;
-    rect[2]->w -= rect[1]->w;
-    rect[2]->h = FONT_SIZE - 4;
-
-    co = SCREEN_COLOR_BLACK;
-    SDL_SetRenderDrawColor(renderer, co.r, co.g, co.b, 64);
-    SDL_RenderFillRect(renderer, rect[2]);
+    SCREEN_COLOR co = SCREEN_COLOR_BLACK;
+    co.a = 64;
+    rectToFrame(x + rect.w, y, w - rect.w, FONT_SIZE - 4, co);
 
     textToFrame(--line, column + (width >> 1) - (strlen(text) >> 1), text);
 }
@@ -344,15 +434,7 @@ void arrowToFrame(int line, int column)
     column *= spaceWidth;
     column += spaceWidth;
 
-    SDL_Rect *rect = createRect();
-    if(rect == NULL)
-        return;
-
-    rect->x = column + FONT_SIZE,
-    rect->y = line,
-
-    SDL_QueryTexture(arrowTex, NULL, NULL, &(rect->w), &(rect->h));
-    SDL_RenderCopy(renderer, arrowTex, NULL, rect);
+    iconToFrame(column + FONT_SIZE, line, icons + ICON_ARROW);
 }
 
 void checkmarkToFrame(int line, int column)
@@ -365,34 +447,26 @@ void checkmarkToFrame(int line, int column)
     column *= spaceWidth;
     column += spaceWidth >> 1;
 
-    SDL_Rect *rect = createRect();
-    if(rect == NULL)
-        return;
-
-    rect->x = column + FONT_SIZE,
-    rect->y = line,
-
-    SDL_QueryTexture(checkmarkTex, NULL, NULL, &(rect->w), &(rect->h));
-    SDL_RenderCopy(renderer, checkmarkTex, NULL, rect);
+    iconToFrame(column + FONT_SIZE, line, icons + ICON_CHECKMARK);
 }
 
-static inline SDL_Texture *getFlagData(MCPRegion flag)
+static inline int getFlagIcon(MCPRegion flag)
 {
     if(flag & MCP_REGION_EUROPE)
     {
         if(flag & MCP_REGION_USA)
-            return flagTex[flag & MCP_REGION_JAPAN ? 7 : 4];
+            return ICON_FLAG + (flag & MCP_REGION_JAPAN ? 7 : 4);
 
-        return flagTex[flag & MCP_REGION_JAPAN ? 5 : 1];
+        return ICON_FLAG + (flag & MCP_REGION_JAPAN ? 5 : 1);
     }
 
     if(flag & MCP_REGION_USA)
-        return flagTex[flag & MCP_REGION_JAPAN ? 6 : 2];
+        return ICON_FLAG + (flag & MCP_REGION_JAPAN ? 6 : 2);
 
     if(flag & MCP_REGION_JAPAN)
-        return flagTex[3];
+        return ICON_FLAG + 3;
 
-    return flagTex[0];
+    return ICON_FLAG;
 }
 
 void flagToFrame(int line, int column, MCPRegion flag)
@@ -405,16 +479,7 @@ void flagToFrame(int line, int column, MCPRegion flag)
     column *= spaceWidth;
     column += spaceWidth >> 1;
 
-    SDL_Texture *fd = getFlagData(flag);
-
-    SDL_Rect *rect = createRect();
-    if(rect == NULL)
-        return;
-
-    rect->x = column + FONT_SIZE,
-    rect->y = line,
-    SDL_QueryTexture(fd, NULL, NULL, &(rect->w), &(rect->h));
-    SDL_RenderCopy(renderer, fd, NULL, rect);
+    iconToFrame(column + FONT_SIZE, line, icons + getFlagIcon(flag));
 }
 
 void deviceToFrame(int line, int column, DEVICE_TYPE dev)
@@ -427,15 +492,7 @@ void deviceToFrame(int line, int column, DEVICE_TYPE dev)
     column *= spaceWidth;
     column += spaceWidth >> 1;
 
-    SDL_Rect *rect = createRect();
-    if(rect == NULL)
-        return;
-
-    rect->x = column + FONT_SIZE;
-    rect->y = line;
-
-    SDL_QueryTexture(deviceTex[dev], NULL, NULL, &(rect->w), &(rect->h));
-    SDL_RenderCopy(renderer, deviceTex[dev], NULL, rect);
+    iconToFrame(column + FONT_SIZE, line, icons + ICON_DEVICE + dev);
 }
 
 void tabToFrame(int line, int column, const char *label, bool active)
@@ -448,26 +505,23 @@ void tabToFrame(int line, int column, const char *label, bool active)
     column *= 240;
     column += 13;
 
-    SDL_Rect *curRect = createRect();
-    if(curRect == NULL)
-        return;
-
-    curRect->x = column + FONT_SIZE;
-    curRect->y = line;
+    SDL_Rect curRect = {
+        .x = column + FONT_SIZE,
+        .y = line,
+    };
 
-    SDL_QueryTexture(tabTex, NULL, NULL, &(curRect->w), &(curRect->h));
-    SDL_RenderCopy(renderer, tabTex, NULL, curRect);
+    SDL_QueryTexture(tabTex, NULL, NULL, &(curRect.w), &(curRect.h));
+    copyToFrame(tabTex, NULL, &curRect);
 
-    column = curRect->x + (curRect->w >> 1) - (FC_GetWidth(font, label) >> 1);
+    column = curRect.x + (curRect.w >> 1) - (FC_GetWidth(font, label) >> 1);
     line += 20 - (FONT_SIZE >> 1);
 
     if(active)
-    {
         FC_Draw(font, renderer, column, line, label);
-        return;
-    }
+    else
+        FC_DrawColor(font, renderer, column, line, SCREEN_COLOR_WHITE_TRANSP, label);
 
-    FC_DrawColor(font, renderer, column, line, SCREEN_COLOR_WHITE_TRANSP, label);
+    countDrawCall();
 }
 
 void *addErrorOverlay(const char *err)
@@ -477,7 +531,7 @@ void *addErrorOverlay(const char *err)
     if(font == NULL)
         return NULL;
 
-    ErrorOverlay *overlay = MEMAllocFromDefaultHeap(sizeof(ErrorOverlay));
+    ErrorOverlay *overlay = memAlloc(MEM_TAG_RENDERER, sizeof(ErrorOverlay));
     if(overlay == NULL)
         return NULL;
 
@@ -491,6 +545,7 @@ void *addErrorOverlay(const char *err)
             if(addToListEnd(errorOverlayList, overlay))
             {
                 SDL_SetTextureBlendMode(overlay->tex, SDL_BLENDMODE_BLEND);
+                flushRects();
                 SDL_SetRenderTarget(renderer, overlay->tex);
 
                 SDL_Color co = SCREEN_COLOR_BLACK;
@@ -532,7 +587,7 @@ void *addErrorOverlay(const char *err)
         }
     }
 
-    MEMFreeToDefaultHeap(overlay);
+    memFree(MEM_TAG_RENDERER, overlay);
     return NULL;
 }
 
@@ -547,7 +602,7 @@ void removeErrorOverlay(void *overlay)
     removeFromList(errorOverlayList, overlay);
     drawFrame();
     SDL_DestroyTexture(((ErrorOverlay *)overlay)->tex);
-    MEMFreeToDefaultHeap(overlay);
+    memFree(MEM_TAG_RENDERER, overlay);
 }
 
 static inline void loadDefaultTexture()
@@ -593,39 +648,121 @@ static inline void loadDefaultTexture()
     SDL_SetRenderTarget(renderer, frameBuffer);
 }
 
-static bool loadTexture(const char *path, SDL_Texture **out)
+static SDL_Surface *loadSurface(const char *path)
 {
     void *buffer;
     size_t fs = readFile(path, &buffer);
+    if(buffer == NULL)
+        return NULL;
+
+    SDL_Surface *surface = NULL;
+    SDL_RWops *rw = SDL_RWFromMem(buffer, fs);
+    if(rw != NULL)
+    {
+        surface = IMG_Load_RW(rw, SDL_TRUE);
+        if(surface == NULL)
+            debugPrintf("Error creating surface!");
+    }
+    else
+        debugPrintf("Error creating SDL_WRops!");
+
+    MEMFreeToDefaultHeap(buffer);
+    return surface;
+}
+
+static bool loadTexture(const char *path, SDL_Texture **out)
+{
     *out = defaultTex;
-    if(buffer != NULL)
+    SDL_Surface *surface = loadSurface(path);
+    if(surface != NULL)
     {
-        SDL_RWops *rw = SDL_RWFromMem(buffer, fs);
-        if(rw != NULL)
+        *out = SDL_CreateTextureFromSurface(renderer, surface);
+        SDL_FreeSurface(surface);
+        if(*out == NULL)
         {
-            SDL_Surface *surface = IMG_Load_RW(rw, SDL_TRUE);
-            if(surface != NULL)
-            {
-                *out = SDL_CreateTextureFromSurface(renderer, surface);
-                SDL_FreeSurface(surface);
-                if(*out == NULL)
-                {
-                    *out = defaultTex;
-                    debugPrintf("Error creating texture!");
-                }
-            }
-            else
-                debugPrintf("Error creating surface!");
+            *out = defaultTex;
+            debugPrintf("Error creating texture!");
         }
-        else
-            debugPrintf("Error creating SDL_WRops!");
-
-        MEMFreeToDefaultHeap(buffer);
     }
 
     return *out != defaultTex;
 }
 
+static void loadIconAtlas()
+{
+    static const char *const iconPaths[ICONS] = {
+        ROMFS_PATH "textures/arrow.png",
+        ROMFS_PATH "textures/checkmark.png",
+        ROMFS_PATH "textures/flags/unk.png",
+        ROMFS_PATH "textures/flags/eur.png",
+        ROMFS_PATH "textures/flags/usa.png",
+        ROMFS_PATH "textures/flags/jap.png",
+        ROMFS_PATH "textures/flags/eurUsa.png",
+        ROMFS_PATH "textures/flags/eurJap.png",
+        ROMFS_PATH "textures/flags/usaJap.png",
+        ROMFS_PATH "textures/flags/multi.png",
+        ROMFS_PATH "textures/dev/unk.png",
+        ROMFS_PATH "textures/dev/usb.png",
+        ROMFS_PATH "textures/dev/sd.png",
+        ROMFS_PATH "textures/dev/nand.png",
+    };
+
+    // Missing icons fall back to the default texture
+    for(int i = 0; i < ICONS; ++i)
+    {
+        icons[i].tex = defaultTex;
+        icons[i].rect.x = icons[i].rect.y = 0;
+        icons[i].rect.w = 7;
+        icons[i].rect.h = 11;
+    }
+
+    SDL_Surface *atlas = SDL_CreateRGBSurfaceWithFormat(0, ICON_CELL * ICONS, ICON_CELL, 32, SDL_PIXELFORMAT_RGBA8888);
+    if(atlas == NULL)
+    {
+        debugPrintf("Error creating icon atlas surface!");
+        return;
+    }
+
+    SDL_Rect rect[ICONS];
+    SDL_Surface *surface;
+    for(int i = 0; i < ICONS; ++i)
+    {
+        rect[i].w = 0;
+        surface = loadSurface(iconPaths[i]);
+        if(surface != NULL)
+        {
+            rect[i].x = ICON_CELL * i;
+            rect[i].y = 0;
+            rect[i].w = surface->w > ICON_CELL ? ICON_CELL : surface->w;
+            rect[i].h = surface->h > ICON_CELL ? ICON_CELL : surface->h;
+
+            // Copy the alpha channel as is instead of blending it with the empty atlas.
+            // Oversized icons get cut, a NULL source rect would spill them into the next cell.
+            SDL_Rect src = { .x = 0, .y = 0, .w = rect[i].w, .h = rect[i].h };
+            SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(surface, &src, atlas, rect + i);
+            SDL_FreeSurface(surface);
+        }
+    }
+
+    iconAtlas = SDL_CreateTextureFromSurface(renderer, atlas);
+    SDL_FreeSurface(atlas);
+    if(iconAtlas == NULL)
+    {
+        debugPrintf("Error creating icon atlas texture!");
+        return;
+    }
+
+    for(int i = 0; i < ICONS; ++i)
+    {
+        if(rect[i].w != 0)
+        {
+            icons[i].tex = iconAtlas;
+            icons[i].rect = rect[i];
+        }
+    }
+}
+
 void resumeRenderer()
 {
     if(font != NULL)
@@ -652,8 +789,7 @@ void resumeRenderer()
             byeRect.x = (SCREEN_WIDTH >> 1) - (byeRect.w >> 1);
             byeRect.y = (SCREEN_HEIGHT >> 1) - (byeRect.h >> 1);
 
-            loadTexture(ROMFS_PATH "textures/arrow.png", &arrowTex);
-            loadTexture(ROMFS_PATH "textures/checkmark.png", &checkmarkTex);
+            loadIconAtlas();
             loadTexture(ROMFS_PATH "textures/tab.png", &tabTex);
 
             barTex = SDL_CreateTexture(renderer, SDL_GetWindowPixelFormat(window), SDL_TEXTUREACCESS_TARGET, 2, 1);
@@ -682,59 +818,6 @@ void resumeRenderer()
 
             SDL_SetRenderTarget(renderer, frameBuffer);
 
-            const char *tex;
-            for(int i = 0; i < 8; ++i)
-            {
-                switch(i)
-                {
-                    case 0:
-                        tex = ROMFS_PATH "textures/flags/unk.png";
-                        break;
-                    case 1:
-                        tex = ROMFS_PATH "textures/flags/eur.png";
-                        break;
-                    case 2:
-                        tex = ROMFS_PATH "textures/flags/usa.png";
-                        break;
-                    case 3:
-                        tex = ROMFS_PATH "textures/flags/jap.png";
-                        break;
-                    case 4:
-                        tex = ROMFS_PATH "textures/flags/eurUsa.png";
-                        break;
-                    case 5:
-                        tex = ROMFS_PATH "textures/flags/eurJap.png";
-                        break;
-                    case 6:
-                        tex = ROMFS_PATH "textures/flags/usaJap.png";
-                        break;
-                    case 7:
-                        tex = ROMFS_PATH "textures/flags/multi.png";
-                        break;
-                }
-                loadTexture(tex, flagTex + i);
-            }
-
-            for(int i = 0; i < 4; i++)
-            {
-                switch(i)
-                {
-                    case 0:
-                        tex = ROMFS_PATH "textures/dev/unk.png";
-                        break;
-                    case 1:
-                        tex = ROMFS_PATH "textures/dev/usb.png";
-                        break;
-                    case 2:
-                        tex = ROMFS_PATH "textures/dev/sd.png";
-                        break;
-                    case 3:
-                        tex = ROMFS_PATH "textures/dev/nand.png";
-                        break;
-                }
-                loadTexture(tex, deviceTex + i);
-            }
-
             // TODO: Ugly workaround for the exit overlay working from the home button callback
             showExitOverlay(false);
 
@@ -783,10 +866,6 @@ bool initRenderer()
     if(font)
         return true;
 
-    rectList = createList();
-    if(rectList == NULL)
-        return false;
-
     errorOverlayList = createList();
     if(errorOverlayList != NULL)
     {
@@ -870,7 +949,6 @@ bool initRenderer()
         destroyList(errorOverlayList, true);
     }
 
-    destroyList(rectList, true);
     return false;
 }
 
@@ -885,19 +963,17 @@ void pauseRenderer()
     if(font == NULL)
         return;
 
-    destroyTex(arrowTex);
-    destroyTex(checkmarkTex);
+    if(iconAtlas != NULL)
+    {
+        SDL_DestroyTexture(iconAtlas);
+        iconAtlas = NULL;
+    }
+
     destroyTex(tabTex);
     destroyTex(barTex);
     destroyTex(bgTex);
     destroyTex(byeTex);
 
-    for(int i = 0; i < 8; ++i)
-        destroyTex(flagTex[i]);
-
-    for(int i = 0; i < 4; i++)
-        destroyTex(deviceTex[i]);
-
     if(defaultTex != NULL)
     {
         SDL_DestroyTexture(defaultTex);
@@ -914,7 +990,7 @@ void drawByeFrame()
         return;
 
     startNewFrame();
-    SDL_RenderCopy(renderer, byeTex, NULL, &byeRect);
+    copyToFrame(byeTex, NULL, &byeRect);
     if(!Swkbd_IsReady() || Swkbd_IsHidden())
         drawFrame();
 }
@@ -937,7 +1013,6 @@ void shutdownRenderer()
     SDL_DestroyWindow(window);
 
     quitSDL();
-    destroyList(rectList, true);
 }
 
 void colorStartNewFrame(SCREEN_COLOR color)
@@ -945,6 +1020,21 @@ void colorStartNewFrame(SCREEN_COLOR color)
     if(font == NULL)
         return;
 
+    // Whatever is still pending belongs to the old frame
+    rectCount = rectBatchStart = 0;
+
+#ifdef NUSSPLI_DEBUG
+    // Only report changes as some menus rebuild the same frame on every vsync
+    if(frameStats.drawCalls != lastFrameStats.drawCalls || frameStats.rects != lastFrameStats.rects || frameStats.arenaWraps != lastFrameStats.arenaWraps)
+    {
+        debugPrintf("Frame: %u draw calls, %u rects, %u arena wraps", frameStats.drawCalls, frameStats.rects, frameStats.arenaWraps);
+        lastFrameStats = frameStats;
+    }
+
+    OSBlockSet(&frameStats, 0x00, sizeof(FrameStats));
+    frameStart = OSGetSystemTime();
+#endif
+
     if(*(uint32_t *)&(color.r) == *(uint32_t *)&(SCREEN_COLOR_BLUE.r))
         SDL_RenderCopy(renderer, bgTex, NULL, NULL);
     else
@@ -953,7 +1043,7 @@ void colorStartNewFrame(SCREEN_COLOR color)
         SDL_RenderClear(renderer);
     }
 
-    clearList(rectList, true);
+    countDrawCall();
 }
 
 void showFrame()
@@ -961,6 +1051,8 @@ void showFrame()
     if(font == NULL)
         return;
 
+    traceScope("showFrame");
+
     // Contrary to VSync enabled SDL we use GX2WaitForVsync() directly instead of
     // WHBGFX WHBGfxBeginRender() for VSync as WHBGfxBeginRender() produces frames
     // way shorter than 16 ms sometimes, confusing frame counting timers
@@ -972,6 +1064,7 @@ void showFrame()
     if(font == NULL)                     \
         return;                          \
                                          \
+    flushRects();                        \
     SDL_SetRenderTarget(renderer, NULL); \
     SDL_RenderCopy(renderer, frameBuffer, NULL, NULL);
 
@@ -980,12 +1073,15 @@ void showFrame()
     forEachListEntry(errorOverlayList, overlay)             \
         SDL_RenderCopy(renderer, overlay->tex, NULL, NULL); \
                                                             \
+    drawMemOverlay();                                       \
     SDL_RenderPresent(renderer);                            \
+    addFrameTime();                                         \
     SDL_SetRenderTarget(renderer, frameBuffer);
 
 // We need to draw the DRC before the TV, else the DRC is always one frame behind
 void drawFrame()
 {
+    traceScope("drawFrame");
     predrawFrame();
     postdrawFrame();
 }
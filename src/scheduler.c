@@ -0,0 +1,177 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <wut-fixups.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <filesystem.h>
+#include <queue.h>
+#include <scheduler.h>
+#include <titles.h>
+#include <utils.h>
+
+#pragma GCC diagnostic ignored "-Wundef"
+#include <coreinit/memdefaultheap.h>
+#pragma GCC diagnostic pop
+
+/*
+ * The scheduler only works on the data of the queue entries, it doesn't touch
+ * the filesystem or the network. Titles get sorted by size, so small ones get
+ * installed while the big ones are still downloading. Updates and DLC are
+ * sorted right behind their base game if that's queued for the same device.
+ */
+
+typedef struct
+{
+    TitleData *title;
+    uint64_t size;
+    size_t index;
+    size_t anchor; // Index of the base game or the own index
+    uint64_t anchorSize;
+    uint32_t rank;
+} SCHEDULE_ENTRY;
+
+static inline uint64_t getScheduleSize(const TitleData *title)
+{
+    return title->operation & OPERATION_DOWNLOAD ? title->dlSize : title->installSize;
+}
+
+static inline uint32_t getScheduleRank(uint64_t tid)
+{
+    if(isUpdate(tid))
+        return 1;
+
+    if(isDLC(tid))
+        return 2;
+
+    return 0;
+}
+
+static inline bool sameTarget(const TitleData *a, const TitleData *b)
+{
+    if(a->operation & OPERATION_INSTALL)
+        return (b->operation & OPERATION_INSTALL) && a->toUSB == b->toUSB;
+
+    return !(b->operation & OPERATION_INSTALL) && a->dlDev == b->dlDev;
+}
+
+static bool scheduleBefore(const SCHEDULE_ENTRY *a, const SCHEDULE_ENTRY *b)
+{
+    if(a->anchor != b->anchor)
+    {
+        if(a->anchorSize != b->anchorSize)
+            return a->anchorSize < b->anchorSize;
+
+        return a->anchor < b->anchor;
+    }
+
+    if(a->rank != b->rank)
+        return a->rank < b->rank;
+
+    if(a->size != b->size)
+        return a->size < b->size;
+
+    return a->index < b->index;
+}
+
+// Sorts the titles in place, returns true if the order changed
+bool scheduleTitles(TitleData **titles, size_t count)
+{
+    if(count < 2)
+        return false;
+
+    SCHEDULE_ENTRY *entries = MEMAllocFromDefaultHeap(sizeof(SCHEDULE_ENTRY) * count);
+    if(entries == NULL)
+        return false;
+
+    uint64_t base;
+    for(size_t i = 0; i < count; ++i)
+    {
+        entries[i].title = titles[i];
+        entries[i].size = getScheduleSize(titles[i]);
+        entries[i].index = i;
+        entries[i].anchor = i;
+        entries[i].anchorSize = entries[i].size;
+        entries[i].rank = getScheduleRank(titles[i]->tid);
+    }
+
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(entries[i].rank == 0)
+            continue;
+
+        base = (titles[i]->tid & 0x00000000FFFFFFFF) | ((uint64_t)TID_HIGH_GAME << 32);
+        for(size_t j = 0; j < count; ++j)
+        {
+            if(titles[j]->tid == base && sameTarget(titles[i], titles[j]))
+            {
+                entries[i].anchor = j;
+                entries[i].anchorSize = entries[j].size;
+                debugPrintf("Scheduler: %016llx depends on %016llx", titles[i]->tid, base);
+                break;
+            }
+        }
+    }
+
+    // Insertion sort: Stable and queues are short
+    SCHEDULE_ENTRY tmp;
+    size_t j;
+    for(size_t i = 1; i < count; ++i)
+    {
+        tmp = entries[i];
+        for(j = i; j > 0 && scheduleBefore(&tmp, entries + j - 1); --j)
+            entries[j] = entries[j - 1];
+
+        entries[j] = tmp;
+    }
+
+    bool ret = false;
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(entries[i].index != i)
+            ret = true;
+
+        titles[i] = entries[i].title;
+        debugPrintf("Scheduler: #%u: %016llx (%llu bytes)", i, titles[i]->tid, entries[i].size);
+    }
+
+    MEMFreeToDefaultHeap(entries);
+    return ret;
+}
+
+/*
+ * While MCP installs from one device the next download should write to the
+ * other one. Only temporary downloads get moved, titles the user wants to keep
+ * stay where they are. Returns the device to download to, the caller has to
+ * check if there's enough space on it.
+ */
+NUSDEV getBalancedDownloadDevice(const TitleData *title, NUSDEV busy, NUSDEV usb)
+{
+    if(title->keepFiles || title->operation != OPERATION_DOWNLOAD_INSTALL || usb == NUSDEV_NONE || title->dlDev != busy)
+        return title->dlDev;
+
+    if(title->dlDev == NUSDEV_SD)
+        return usb;
+
+    if(title->dlDev & NUSDEV_USB)
+        return NUSDEV_SD;
+
+    return title->dlDev;
+}
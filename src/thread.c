@@ -19,6 +19,7 @@
 #include <wut-fixups.h>
 
 #include <crypto.h>
+#include <memTrack.h>
 #include <thread.h>
 #include <utils.h>
 
@@ -33,7 +34,7 @@ OSThread *prepareThread(const char *name, THREAD_PRIORITY priority, size_t stack
     if(name == NULL)
         return NULL;
 
-    uint8_t *thread = MEMAllocFromDefaultHeapEx(sizeof(OSThread) + stacksize, 8);
+    uint8_t *thread = memAllocEx(MEM_TAG_THREAD, sizeof(OSThread) + stacksize, 8);
     if(thread != NULL)
     {
         OSThread *ost = (OSThread *)thread;
@@ -47,7 +48,7 @@ OSThread *prepareThread(const char *name, THREAD_PRIORITY priority, size_t stack
             return ost;
         }
 
-        MEMFreeToDefaultHeap(thread);
+        memFree(MEM_TAG_THREAD, thread);
     }
 
     return NULL;
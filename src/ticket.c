@@ -36,6 +36,7 @@
 #include <localisation.h>
 #include <menu/filebrowser.h>
 #include <menu/utils.h>
+#include <metaCache.h>
 #include <renderer.h>
 #include <state.h>
 #include <titles.h>
@@ -45,6 +46,7 @@
 #pragma GCC diagnostic ignored "-Wundef"
 #include <coreinit/memdefaultheap.h>
 #include <coreinit/memory.h>
+#include <coreinit/time.h>
 #pragma GCC diagnostic pop
 
 #define TICKET_BUCKET "/vol/slc/sys/rights/ticket/apps/"
@@ -128,7 +130,7 @@ bool generateTik(const char *path, const TMD *tmd)
     FSAFileHandle tik = openFile(path, "w", 0);
     if(tik == 0)
     {
-        char *err = getStaticScreenBuffer();
+        char err[FS_MAX_PATH + 128];
         sprintf(err, "%s\n%s", localise("Could not open path"), prettyDir(path));
         showErrorFrame(err);
         return false;
@@ -164,7 +166,8 @@ static uint8_t *getDefaultCert()
         RAMBUF *rambuf = allocRamBuf();
         if(rambuf != NULL)
         {
-            if(downloadFile(DOWNLOAD_URL "000500101000400a/cetk", "OSv10 title.tik", NULL, FILE_TYPE_TIK | FILE_TYPE_TORAM, false, NULL, rambuf) == 0)
+            // Cached on SD, so this is downloaded once ever
+            if(downloadMetadata(0x000500101000400aULL, "cetk", "", FILE_TYPE_TIK, NULL, NULL, rambuf) == 0)
             {
                 if(rambuf->size >= 0x350 + sizeof(OTHER_PPKI_CERT)) // TODO
                 {
@@ -255,7 +258,7 @@ bool generateCert(const TMD *tmd, const TICKET *ticket, size_t ticketSize, const
     FSAFileHandle cert = openFile(path, "w", 0);
     if(cert == 0)
     {
-        char *err = getStaticScreenBuffer();
+        char err[FS_MAX_PATH + 128];
         sprintf(err, "%s\n%s", localise("Could not open path"), prettyDir(path));
         showErrorFrame(err);
         return false;
@@ -379,7 +382,7 @@ void deleteTicket(uint64_t tid)
     if(ticketList == NULL)
         return;
 
-    char *path = getStaticPathBuffer(0);
+    char path[FS_MAX_PATH];
     OSBlockMove(path, TICKET_BUCKET, sizeof(TICKET_BUCKET), false);
 
     char *inSentence = path + (sizeof(TICKET_BUCKET) - 1);
@@ -20,6 +20,7 @@
 #include <wut-fixups.h>
 
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <gtitles.h>
@@ -27,6 +28,63 @@
 #include <titles.h>
 #include <utils.h>
 
+#pragma GCC diagnostic ignored "-Wundef"
+#include <coreinit/memdefaultheap.h>
+#pragma GCC diagnostic pop
+
+// Per category title entries sorted by title ID, built on first use
+static const TitleEntry **tidIndex[TITLE_CATEGORY_DISC + 1] = { NULL };
+
+static int compareTid(const void *a, const void *b)
+{
+    const TitleEntry *ea = *(const TitleEntry **)a;
+    const TitleEntry *eb = *(const TitleEntry **)b;
+    if(ea->tid != eb->tid)
+        return ea->tid < eb->tid ? -1 : 1;
+
+    // Keep the database order for duplicates
+    return ea < eb ? -1 : ea > eb;
+}
+
+static const TitleEntry *searchTid(TITLE_CATEGORY cat, uint64_t tid)
+{
+    const TitleEntry *haystack = getTitleEntries(cat);
+    size_t haySize = getTitleEntriesSize(cat);
+    const TitleEntry **index = tidIndex[cat];
+    if(index == NULL)
+    {
+        index = MEMAllocFromDefaultHeap(haySize * sizeof(TitleEntry *));
+        if(index == NULL)
+        {
+            for(++haySize; --haySize; ++haystack)
+                if(haystack->tid == tid)
+                    return haystack;
+
+            return NULL;
+        }
+
+        for(size_t i = 0; i < haySize; ++i)
+            index[i] = haystack + i;
+
+        qsort(index, haySize, sizeof(TitleEntry *), compareTid);
+        tidIndex[cat] = index;
+    }
+
+    size_t lower = 0;
+    size_t upper = haySize;
+    size_t current;
+    while(lower != upper)
+    {
+        current = lower + ((upper - lower) >> 1);
+        if(index[current]->tid < tid)
+            lower = current + 1;
+        else
+            upper = current;
+    }
+
+    return lower < haySize && index[lower]->tid == tid ? index[lower] : NULL;
+}
+
 const TitleEntry *getTitleEntryByTid(uint64_t tid)
 {
     TITLE_CATEGORY cat;
@@ -49,24 +107,11 @@ const TitleEntry *getTitleEntryByTid(uint64_t tid)
             cat = TITLE_CATEGORY_ALL;
     }
 
-    const TitleEntry *haystack = getTitleEntries(cat);
-    size_t haySize = getTitleEntriesSize(cat);
-
-    for(++haySize; --haySize; ++haystack)
-        if(haystack->tid == tid)
-            return haystack;
-
-    if(cat == TITLE_CATEGORY_GAME)
-    {
-        haystack = getTitleEntries(TITLE_CATEGORY_DISC);
-        haySize = getTitleEntriesSize(TITLE_CATEGORY_DISC);
-
-        for(++haySize; --haySize; ++haystack)
-            if(haystack->tid == tid)
-                return haystack;
-    }
+    const TitleEntry *ret = searchTid(cat, tid);
+    if(ret == NULL && cat == TITLE_CATEGORY_GAME)
+        ret = searchTid(TITLE_CATEGORY_DISC, tid);
 
-    return NULL;
+    return ret;
 }
 
 const char *tid2name(const char *tid)
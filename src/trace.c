@@ -0,0 +1,277 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#include <wut-fixups.h>
+
+#ifdef NUSSPLI_DEBUG
+
+#include <stdio.h>
+
+#include <file.h>
+#include <filesystem.h>
+#include <memTrack.h>
+#include <trace.h>
+#include <utils.h>
+
+#pragma GCC diagnostic ignored "-Wundef"
+#include <coreinit/cache.h>
+#include <coreinit/core.h>
+#include <coreinit/filesystem_fsa.h>
+#include <coreinit/interrupts.h>
+#include <coreinit/memdefaultheap.h>
+#include <coreinit/thread.h>
+#include <coreinit/time.h>
+#pragma GCC diagnostic pop
+
+#define TRACE_CORES        3
+#define TRACE_MAX_THREADS  64
+#define TRACE_BUFFER_SIZE  0x1000
+#define TRACE_BUFFER_FLUSH (TRACE_BUFFER_SIZE - 0x200)
+
+typedef struct
+{
+    OSTime time;
+    const char *name;
+    const char *thread;
+    uint32_t value;
+    uint16_t tid;
+    uint8_t type;
+} TRACE_EVENT;
+
+/*
+ * Every core writes to its own ring with interrupts disabled, so there's
+ * exactly one writer per ring at any time and no locking is needed. When a
+ * ring is full the oldest events get overwritten.
+ */
+typedef struct
+{
+    TRACE_EVENT *events;
+    uint32_t head;
+} __attribute__((__aligned__(0x40))) TRACE_RING;
+
+static TRACE_RING rings[TRACE_CORES];
+static volatile bool tracing = false;
+static OSTime traceStart;
+
+void initTrace()
+{
+    TRACE_EVENT *events = memAlloc(MEM_TAG_DEBUG, sizeof(TRACE_EVENT) * TRACE_RING_EVENTS * TRACE_CORES);
+    if(events == NULL)
+    {
+        debugPrintf("Not enough memory for tracing!");
+        return;
+    }
+
+    for(int i = 0; i < TRACE_CORES; ++i)
+    {
+        rings[i].events = events + (TRACE_RING_EVENTS * i);
+        rings[i].head = 0;
+    }
+
+    traceStart = OSGetTime();
+    tracing = true;
+}
+
+void shutdownTrace()
+{
+    if(rings[0].events == NULL)
+        return;
+
+    tracing = false;
+    memFree(MEM_TAG_DEBUG, rings[0].events);
+    rings[0].events = NULL;
+}
+
+void traceEvent(TRACE_EVENT_TYPE type, const char *name, uint32_t value)
+{
+    if(!tracing)
+        return;
+
+    BOOL irq = OSDisableInterrupts();
+    TRACE_RING *ring = rings + OSGetCoreId();
+    TRACE_EVENT *event = ring->events + (ring->head++ & (TRACE_RING_EVENTS - 1));
+    OSThread *thread = OSGetCurrentThread();
+
+    event->time = OSGetTime();
+    event->name = name;
+    event->thread = thread->name;
+    event->value = value;
+    event->tid = thread->id;
+    event->type = type;
+    OSRestoreInterrupts(irq);
+}
+
+static bool writeTraceBuffer(FSAFileHandle file, char *buf, size_t *size)
+{
+    if(*size == 0)
+        return true;
+
+    bool ret = FSAWriteFile(getFSAClient(), buf, *size, 1, file, 0) == 1;
+    *size = 0;
+    return ret;
+}
+
+typedef struct
+{
+    uint16_t tid;
+    uint16_t depth; // Open begin events
+} TRACE_THREAD;
+
+// Returns NULL if there are too many threads
+static TRACE_THREAD *findThread(TRACE_THREAD *threads, size_t *count, uint16_t tid, bool *added)
+{
+    *added = false;
+    for(size_t i = 0; i < *count; ++i)
+        if(threads[i].tid == tid)
+            return threads + i;
+
+    if(*count == TRACE_MAX_THREADS)
+        return NULL;
+
+    TRACE_THREAD *ret = threads + (*count)++;
+    ret->tid = tid;
+    ret->depth = 0;
+    *added = true;
+    return ret;
+}
+
+// Oldest event not exported yet of all rings or NULL when done
+static TRACE_EVENT *nextEvent(uint32_t *next, const uint32_t *heads)
+{
+    TRACE_EVENT *ret = NULL;
+    TRACE_EVENT *event;
+    int core = 0;
+    for(int i = 0; i < TRACE_CORES; ++i)
+    {
+        if(next[i] == heads[i])
+            continue;
+
+        event = rings[i].events + (next[i] & (TRACE_RING_EVENTS - 1));
+        if(ret == NULL || event->time < ret->time)
+        {
+            ret = event;
+            core = i;
+        }
+    }
+
+    if(ret != NULL)
+        ++next[core];
+
+    return ret;
+}
+
+/*
+ * Writes all rings to the SD card in the Chrome trace event format, to be
+ * opened with chrome://tracing or Perfetto. Tracing is paused while
+ * exporting so the export itself doesn't show up. The rings get merged by
+ * time, so threads moving between cores stay in order, and end events whose
+ * begin event got overwritten are left out.
+ */
+bool exportTrace()
+{
+    if(rings[0].events == NULL)
+        return false;
+
+    char *buf = MEMAllocFromDefaultHeap(TRACE_BUFFER_SIZE);
+    if(buf == NULL)
+        return false;
+
+    FSAFileHandle file;
+    FSError err = FSAOpenFileEx(getFSAClient(), TRACE_PATH, "w", 0x660, FS_OPEN_FLAG_NONE, 0, &file);
+    if(err != FS_ERROR_OK)
+    {
+        debugPrintf("Error opening %s: %s!", TRACE_PATH, translateFSErr(err));
+        MEMFreeToDefaultHeap(buf);
+        return false;
+    }
+
+    tracing = false;
+    OSMemoryBarrier();
+
+    TRACE_THREAD threads[TRACE_MAX_THREADS];
+    size_t threadCount = 0;
+    uint32_t heads[TRACE_CORES];
+    uint32_t next[TRACE_CORES];
+    for(int i = 0; i < TRACE_CORES; ++i)
+    {
+        heads[i] = rings[i].head;
+        next[i] = heads[i] > TRACE_RING_EVENTS ? heads[i] - TRACE_RING_EVENTS : 0;
+    }
+
+    size_t size = sprintf(buf, "{\"traceEvents\":[");
+    const char *sep = "";
+    uint32_t exported = 0;
+    bool ret = true;
+    bool added;
+    TRACE_EVENT *event;
+    TRACE_THREAD *thread;
+    while(ret && (event = nextEvent(next, heads)) != NULL)
+    {
+        thread = findThread(threads, &threadCount, event->tid, &added);
+        if(added)
+        {
+            size += sprintf(buf + size, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", sep, event->tid, event->thread == NULL ? "?" : event->thread);
+            sep = ",";
+        }
+
+        if(thread != NULL)
+        {
+            if(event->type == TRACE_EVENT_BEGIN)
+                ++thread->depth;
+            else if(event->type == TRACE_EVENT_END)
+            {
+                if(thread->depth == 0) // The begin event got overwritten
+                    continue;
+
+                --thread->depth;
+            }
+        }
+
+        switch(event->type)
+        {
+            case TRACE_EVENT_BEGIN:
+            case TRACE_EVENT_END:
+                size += sprintf(buf + size, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu,\"pid\":1,\"tid\":%u}", sep, event->name, event->type == TRACE_EVENT_BEGIN ? 'B' : 'E', OSTicksToMicroseconds(event->time - traceStart), event->tid);
+                break;
+            case TRACE_EVENT_COUNTER:
+                size += sprintf(buf + size, "%s{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%llu,\"pid\":1,\"tid\":%u,\"args\":{\"value\":%u}}", sep, event->name, OSTicksToMicroseconds(event->time - traceStart), event->tid, event->value);
+                break;
+        }
+
+        sep = ",";
+        ++exported;
+        if(size > TRACE_BUFFER_FLUSH)
+            ret = writeTraceBuffer(file, buf, &size);
+    }
+
+    if(ret)
+    {
+        size += sprintf(buf + size, "],\"displayTimeUnit\":\"ms\"}\n");
+        ret = writeTraceBuffer(file, buf, &size);
+    }
+
+    FSACloseFile(getFSAClient(), file);
+    MEMFreeToDefaultHeap(buf);
+    debugPrintf("Exported %u trace events: %s", exported, ret ? "OK" : "Error");
+
+    tracing = true;
+    return ret;
+}
+
+#endif // ifdef NUSSPLI_DEBUG
@@ -283,95 +283,3 @@ void showMcpProgress(McpData *data, const char *game, bool inst)
     if(ovl != NULL)
         removeErrorOverlay(ovl);
 }
-
-#ifdef NUSSPLI_DEBUG
-
-#include <stdarg.h>
-
-#include <thread.h>
-
-#include <coreinit/fastmutex.h>
-#include <coreinit/time.h>
-#include <whb/log.h>
-#include <whb/log_cafe.h>
-#include <whb/log_udp.h>
-
-static const char days[7][4] = {
-    "Sun",
-    "Mon",
-    "Tue",
-    "Wed",
-    "Thu",
-    "Fri",
-    "Sat",
-};
-
-static const char months[12][4] = {
-    "Jan",
-    "Feb",
-    "Mar",
-    "Apr",
-    "May",
-    "Jun",
-    "Jul",
-    "Aug",
-    "Sep",
-    "Nov",
-    "Dez",
-};
-
-static spinlock debugLock;
-
-void debugInit()
-{
-    spinCreateLock(debugLock, SPINLOCK_FREE);
-    WHBLogUdpInit();
-    WHBLogCafeInit();
-}
-
-void shutdownDebug()
-{
-    WHBLogUdpDeinit();
-    WHBLogCafeDeinit();
-}
-
-void restartUdpLog1()
-{
-    spinLock(debugLock);
-    WHBLogUdpDeinit();
-}
-
-void restartUdpLog2()
-{
-    WHBLogUdpInit();
-    spinReleaseLock(debugLock);
-}
-
-void debugPrintf(const char *str, ...)
-{
-    spinLock(debugLock);
-    static char newStr[512];
-
-    OSCalendarTime now;
-    OSTicksToCalendarTime(OSGetTime(), &now);
-    sprintf(newStr, "%s %02d %s %d %02d:%02d:%02d.%03d\t", days[now.tm_wday], now.tm_mday, months[now.tm_mon], now.tm_year, now.tm_hour, now.tm_min, now.tm_sec, now.tm_msec);
-    size_t tss = strlen(newStr);
-
-    va_list va;
-    va_start(va, str);
-    vsnprintf(newStr + tss, 511 - tss, str, va);
-    va_end(va);
-
-    WHBLogPrint(newStr);
-    spinReleaseLock(debugLock);
-}
-
-void checkStacks(const char *src)
-{
-    debugPrintf("%s: Checking thread stacks...", src);
-    OSCheckActiveThreads();
-    OSThread *trd = OSGetCurrentThread();
-    debugPrintf("%s: 0x%08X/0x%08X", src, OSCheckThreadStackUsage(trd), ((uint32_t)trd->stackStart) - ((uint32_t)trd->stackEnd));
-}
-
-#endif // ifdef NUSSPLI_DEBUG
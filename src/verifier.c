@@ -0,0 +1,530 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <wut-fixups.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <crypto.h>
+#include <file.h>
+#include <filesystem.h>
+#include <input.h>
+#include <keygen.h>
+#include <localisation.h>
+#include <menu/utils.h>
+#include <no-intro.h>
+#include <otp.h>
+#include <renderer.h>
+#include <state.h>
+#include <thread.h>
+#include <ticket.h>
+#include <titles.h>
+#include <trace.h>
+#include <utils.h>
+#include <verifier.h>
+
+#include <mbedtls/aes.h>
+#include <mbedtls/sha1.h>
+
+#pragma GCC diagnostic ignored "-Wundef"
+#include <coreinit/filesystem_fsa.h>
+#include <coreinit/memdefaultheap.h>
+#include <coreinit/memory.h>
+#include <coreinit/thread.h>
+#include <coreinit/time.h>
+#pragma GCC diagnostic pop
+
+#define SHA1_SIZE       20
+#define HASH_TABLE_SIZE (16 * SHA1_SIZE)
+
+typedef struct
+{
+    char dir[FS_MAX_PATH];
+    const TMD *tmd;
+    uint8_t key[16];
+    uint16_t *order;
+    VERIFY_RESULT *results;
+    spinlock lock;
+    uint32_t next;
+    volatile bool cancel;
+    volatile uint64_t verified[VERIFY_THREADS];
+} VERIFY_JOB;
+
+static const OSThreadAttributes verifyAffinity[VERIFY_THREADS] = {
+    OS_THREAD_ATTRIB_AFFINITY_CPU0,
+    OS_THREAD_ATTRIB_AFFINITY_CPU1,
+    OS_THREAD_ATTRIB_AFFINITY_CPU2,
+};
+
+// Decrypts the title key from title.tik (or cetk) or generates it if there's no ticket
+static bool getTitleKey(const char *dir, const TMD *tmd, uint8_t *out)
+{
+    char path[FS_MAX_PATH];
+    TICKET *ticket = NULL;
+    size_t size = getTitleFilePath(dir, "title.tik", path) ? readFile(path, (void **)&ticket) : 0;
+    bool ret = true;
+    if(ticket != NULL && size >= sizeof(TICKET) && ticket->tid == tmd->tid)
+        OSBlockMove(out, ticket->key, 16, false);
+    else
+        ret = generateKey(tmd->tid, out);
+
+    if(ticket != NULL)
+        MEMFreeToDefaultHeap(ticket);
+
+    if(!ret)
+        return false;
+
+    uint8_t iv[16];
+    OSBlockMove(iv, &tmd->tid, 8, false);
+    OSBlockSet(iv + 8, 0, 8);
+    return decryptAES(out, 16, getCommonKey(), iv, out);
+}
+
+static bool openContent(const char *dir, uint32_t cid, const char *ext, FSAFileHandle *out)
+{
+    char name[13];
+    char path[FS_MAX_PATH];
+    hex(cid, 8, name);
+    strcpy(name + 8, ext);
+    return getTitleFilePath(dir, name, path) && FSAOpenFileEx(getFSAClient(), path, "r", 0x000, FS_OPEN_FLAG_NONE, 0, out) == FS_ERROR_OK;
+}
+
+static bool readContent(FSAFileHandle file, uint8_t *buf, size_t size)
+{
+    FSError err;
+    while(size != 0)
+    {
+        err = FSAReadFile(getFSAClient(), buf, 1, size, file, 0);
+        if(err <= 0)
+            return false;
+
+        buf += err;
+        size -= err;
+    }
+
+    return true;
+}
+
+static VERIFY_STATE verifyFlat(FSAFileHandle file, const TMD_CONTENT *content, mbedtls_aes_context *aes, uint8_t *buf, VERIFY_JOB *job, volatile uint64_t *verified)
+{
+    uint8_t iv[16];
+    OSBlockMove(iv, &content->index, 2, false);
+    OSBlockSet(iv + 2, 0, 14);
+
+    mbedtls_sha1_context sha;
+    mbedtls_sha1_init(&sha);
+    mbedtls_sha1_starts(&sha);
+
+    VERIFY_STATE ret;
+    uint64_t left = content->size;
+    size_t toHash;
+    size_t toRead;
+    while(left != 0)
+    {
+        if(job->cancel)
+        {
+            ret = VERIFY_STATE_PENDING;
+            goto flatExit;
+        }
+
+        toHash = left > VERIFY_BUFFER_SIZE ? VERIFY_BUFFER_SIZE : left;
+        toRead = (toHash + 15) & ~15; // Contents are padded to the AES block size
+        if(!readContent(file, buf, toRead))
+        {
+            ret = VERIFY_STATE_READ_ERROR;
+            goto flatExit;
+        }
+
+        mbedtls_aes_crypt_cbc(aes, MBEDTLS_AES_DECRYPT, toRead, iv, buf, buf);
+        mbedtls_sha1_update(&sha, buf, toHash);
+        left -= toHash;
+        *verified += toHash;
+    }
+
+    uint8_t hash[SHA1_SIZE];
+    mbedtls_sha1_finish(&sha, hash);
+    ret = memcmp(hash, content->hash, SHA1_SIZE) == 0 ? VERIFY_STATE_OK : VERIFY_STATE_BAD_HASH;
+
+flatExit:
+    mbedtls_sha1_free(&sha);
+    return ret;
+}
+
+/*
+ * Hashed contents are split into 0x10000 byte blocks: A 0x400 byte header
+ * holding the H0, H1 and H2 tables followed by 0xFC00 bytes of data. H0
+ * hashes the data of 16 blocks, H1 the H0 tables of 16 blocks, H2 the H1
+ * tables of 16 blocks and the .h3 file the H2 tables. The .h3 file itself
+ * is hashed in the TMD.
+ */
+static VERIFY_STATE verifyHashed(FSAFileHandle file, const TMD_CONTENT *content, mbedtls_aes_context *aes, uint8_t *buf, const uint8_t *h3, VERIFY_JOB *job, volatile uint64_t *verified, uint32_t *badBlock)
+{
+    uint32_t blocks = content->size / HASHED_BLOCK_SIZE;
+    uint32_t toRead;
+    uint8_t iv[16];
+    uint8_t hash[SHA1_SIZE];
+    uint8_t *block;
+    uint32_t b = 0;
+    while(b < blocks)
+    {
+        if(job->cancel)
+            return VERIFY_STATE_PENDING;
+
+        toRead = blocks - b;
+        if(toRead > VERIFY_BUFFER_SIZE / HASHED_BLOCK_SIZE)
+            toRead = VERIFY_BUFFER_SIZE / HASHED_BLOCK_SIZE;
+
+        if(!readContent(file, buf, toRead * HASHED_BLOCK_SIZE))
+        {
+            *badBlock = b;
+            return VERIFY_STATE_READ_ERROR;
+        }
+
+        block = buf;
+        for(uint32_t end = b + toRead; b < end; ++b, block += HASHED_BLOCK_SIZE)
+        {
+            OSBlockSet(iv, 0, 16);
+            mbedtls_aes_crypt_cbc(aes, MBEDTLS_AES_DECRYPT, HASHED_HEADER_SIZE, iv, block, block);
+            // The data IV is the H0 hash of this block
+            OSBlockMove(iv, block + (b % 16) * SHA1_SIZE, 16, false);
+            mbedtls_aes_crypt_cbc(aes, MBEDTLS_AES_DECRYPT, HASHED_BLOCK_SIZE - HASHED_HEADER_SIZE, iv, block + HASHED_HEADER_SIZE, block + HASHED_HEADER_SIZE);
+
+            mbedtls_sha1(block + HASHED_HEADER_SIZE, HASHED_BLOCK_SIZE - HASHED_HEADER_SIZE, hash);
+            if(memcmp(hash, block + (b % 16) * SHA1_SIZE, SHA1_SIZE) != 0)
+                goto badBlock;
+
+            mbedtls_sha1(block, HASH_TABLE_SIZE, hash);
+            if(memcmp(hash, block + HASH_TABLE_SIZE + ((b >> 4) % 16) * SHA1_SIZE, SHA1_SIZE) != 0)
+                goto badBlock;
+
+            mbedtls_sha1(block + HASH_TABLE_SIZE, HASH_TABLE_SIZE, hash);
+            if(memcmp(hash, block + HASH_TABLE_SIZE * 2 + ((b >> 8) % 16) * SHA1_SIZE, SHA1_SIZE) != 0)
+                goto badBlock;
+
+            mbedtls_sha1(block + HASH_TABLE_SIZE * 2, HASH_TABLE_SIZE, hash);
+            if(memcmp(hash, h3 + (b >> 12) * SHA1_SIZE, SHA1_SIZE) != 0)
+                goto badBlock;
+        }
+
+        *verified += toRead * HASHED_BLOCK_SIZE;
+    }
+
+    return VERIFY_STATE_OK;
+
+badBlock:
+    *badBlock = b;
+    return VERIFY_STATE_BAD_BLOCK;
+}
+
+static VERIFY_STATE verifyContent(VERIFY_JOB *job, const TMD_CONTENT *content, mbedtls_aes_context *aes, uint8_t *buf, volatile uint64_t *verified, uint32_t *badBlock)
+{
+    FSAFileHandle file;
+    VERIFY_STATE ret;
+    if(!(content->type & TMD_CONTENT_TYPE_HASHED))
+    {
+        if(!openContent(job->dir, content->cid, ".app", &file))
+            return VERIFY_STATE_MISSING;
+
+        ret = verifyFlat(file, content, aes, buf, job, verified);
+        FSACloseFile(getFSAClient(), file);
+        return ret;
+    }
+
+    if(!openContent(job->dir, content->cid, ".h3", &file))
+        return VERIFY_STATE_MISSING;
+
+    size_t h3Size = getH3size(content->size);
+    uint8_t *h3 = MEMAllocFromDefaultHeapEx(FS_ALIGN(h3Size), 0x40);
+    if(h3 == NULL)
+    {
+        FSACloseFile(getFSAClient(), file);
+        return VERIFY_STATE_READ_ERROR;
+    }
+
+    bool ok = readContent(file, h3, h3Size);
+    FSACloseFile(getFSAClient(), file);
+    if(ok)
+    {
+        uint8_t hash[SHA1_SIZE];
+        mbedtls_sha1(h3, h3Size, hash);
+        if(memcmp(hash, content->hash, SHA1_SIZE) == 0)
+        {
+            *verified += h3Size;
+            if(openContent(job->dir, content->cid, ".app", &file))
+            {
+                ret = verifyHashed(file, content, aes, buf, h3, job, verified, badBlock);
+                FSACloseFile(getFSAClient(), file);
+            }
+            else
+                ret = VERIFY_STATE_MISSING;
+        }
+        else
+            ret = VERIFY_STATE_BAD_H3;
+    }
+    else
+        ret = VERIFY_STATE_READ_ERROR;
+
+    MEMFreeToDefaultHeap(h3);
+    return ret;
+}
+
+static int verifyThreadMain(int argc, const char **argv)
+{
+    VERIFY_JOB *job = (VERIFY_JOB *)argv;
+    uint8_t *buf = MEMAllocFromDefaultHeapEx(VERIFY_BUFFER_SIZE, 0x40);
+    if(buf == NULL)
+    {
+        debugPrintf("Verifier: OUT OF MEMORY!");
+        return 1;
+    }
+
+    mbedtls_aes_context aes;
+    mbedtls_aes_init(&aes);
+    mbedtls_aes_setkey_dec(&aes, job->key, 128);
+
+    uint32_t i;
+    VERIFY_RESULT *result;
+    while(!job->cancel)
+    {
+        spinLock(job->lock);
+        i = job->next++;
+        spinReleaseLock(job->lock);
+        if(i >= job->tmd->num_contents)
+            break;
+
+        i = job->order[i];
+        result = job->results + i;
+        traceBegin("verifyContent");
+        result->state = verifyContent(job, job->tmd->contents + i, &aes, buf, job->verified + argc, &result->block);
+        traceEnd("verifyContent");
+    }
+
+    mbedtls_aes_free(&aes);
+    MEMFreeToDefaultHeap(buf);
+    return 0;
+}
+
+static void drawVerifyFrame(uint64_t verified, uint64_t total)
+{
+    char toScreen[64];
+    startNewFrame();
+    textToFrame(0, 0, localise("Verifying contents"));
+    barToFrame(1, 0, 40, (float)verified / (float)total);
+    humanize(verified, toScreen);
+    strcat(toScreen, " / ");
+    humanize(total, toScreen + strlen(toScreen));
+    textToFrame(1, 41, toScreen);
+    writeScreenLog(2);
+    lineToFrame(MAX_LINES - 2, SCREEN_COLOR_WHITE);
+    textToFrame(MAX_LINES - 1, ALIGNED_CENTER, localise("Press " BUTTON_B " to cancel"));
+    drawFrame();
+}
+
+/*
+ * Decrypts and hashes all contents of a title folder. The contents get
+ * spread over one worker per core, biggest first, so the last one to
+ * finish is a small one. Returns false if cancelled.
+ */
+bool verifyContents(const char *dir, const TMD *tmd, VERIFY_RESULT *results)
+{
+    VERIFY_JOB *job = MEMAllocFromDefaultHeap(sizeof(VERIFY_JOB));
+    if(job == NULL)
+        return false;
+
+    job->order = MEMAllocFromDefaultHeap(sizeof(uint16_t) * tmd->num_contents);
+    if(job->order == NULL)
+    {
+        MEMFreeToDefaultHeap(job);
+        return false;
+    }
+
+    size_t s = strlen(dir);
+    OSBlockMove(job->dir, dir, s, false);
+    if(job->dir[s - 1] != '/')
+        job->dir[s++] = '/';
+
+    job->dir[s] = '\0';
+
+    bool ret = false;
+    if(!getTitleKey(job->dir, tmd, job->key))
+    {
+        debugPrintf("Verifier: Can't get the title key!");
+        goto verifyExit;
+    }
+
+    job->tmd = tmd;
+    job->results = results;
+    spinCreateLock(job->lock, SPINLOCK_FREE);
+    job->next = 0;
+    job->cancel = false;
+
+    uint64_t total = 0;
+    uint16_t j;
+    for(uint16_t i = 0; i < tmd->num_contents; ++i)
+    {
+        results[i].state = VERIFY_STATE_PENDING;
+        results[i].block = VERIFY_NO_BLOCK;
+        total += tmd->contents[i].size;
+        if(tmd->contents[i].type & TMD_CONTENT_TYPE_HASHED)
+            total += getH3size(tmd->contents[i].size);
+
+        for(j = i; j > 0 && tmd->contents[job->order[j - 1]].size < tmd->contents[i].size; --j)
+            job->order[j] = job->order[j - 1];
+
+        job->order[j] = i;
+    }
+
+    OSThread *threads[VERIFY_THREADS];
+    int running = 0;
+    for(int i = 0; i < VERIFY_THREADS; ++i)
+    {
+        job->verified[i] = 0;
+        threads[i] = startThread("NUSspli verifier", THREAD_PRIORITY_MEDIUM, STACKSIZE_MEDIUM, verifyThreadMain, i, (char *)job, verifyAffinity[i]);
+        if(threads[i] != NULL)
+            ++running;
+    }
+
+    if(running == 0)
+        goto verifyExit;
+
+    OSTime t = OSGetTime();
+    uint64_t verified;
+    uint64_t drawn = -1;
+    while(running != 0)
+    {
+        running = 0;
+        verified = 0;
+        for(int i = 0; i < VERIFY_THREADS; ++i)
+        {
+            if(threads[i] != NULL)
+            {
+                verified += job->verified[i];
+                if(!OSIsThreadTerminated(threads[i]))
+                    ++running;
+            }
+        }
+
+        if(!AppRunning(true))
+        {
+            job->cancel = true;
+            continue;
+        }
+
+        if(app == APP_STATE_BACKGROUND)
+            continue;
+        if(app == APP_STATE_RETURNING)
+            drawn = -1;
+
+        if(verified != drawn)
+        {
+            drawn = verified;
+            drawVerifyFrame(verified, total);
+        }
+
+        showFrame();
+
+        if(vpad.trigger & VPAD_BUTTON_B)
+            job->cancel = true;
+    }
+
+    for(int i = 0; i < VERIFY_THREADS; ++i)
+        if(threads[i] != NULL)
+            stopThread(threads[i], NULL);
+
+    t = OSGetTime() - t;
+    debugPrintf("Verifier: %" PRIu64 " bytes in %" PRIu64 " ms (%" PRIu64 " KB/s)", verified, OSTicksToMilliseconds(t), OSTicksToMilliseconds(t) == 0 ? 0 : verified / OSTicksToMilliseconds(t));
+    ret = !job->cancel;
+
+verifyExit:
+    MEMFreeToDefaultHeap(job->order);
+    MEMFreeToDefaultHeap(job);
+    return ret;
+}
+
+bool verifyFolder(const char *dir, const TMD *tmd, const char *name)
+{
+    VERIFY_RESULT *results = MEMAllocFromDefaultHeap(sizeof(VERIFY_RESULT) * tmd->num_contents);
+    if(results == NULL)
+        return false;
+
+    addToScreenLog("Verifying %s", prettyDir(dir));
+    if(!verifyContents(dir, tmd, results))
+    {
+        MEMFreeToDefaultHeap(results);
+        return false;
+    }
+
+    // One line per damaged content, up to MAX_LINES - 4 of them
+    char toScreen[MAX_LINES * 256];
+    sprintf(toScreen, "%s\n\n", localise("Verification failed!"));
+    char *ptr = toScreen + strlen(toScreen);
+    int bad = 0;
+    char cid[9];
+    for(uint16_t i = 0; i < tmd->num_contents; ++i)
+    {
+        hex(tmd->contents[i].cid, 8, cid);
+        switch(results[i].state)
+        {
+            case VERIFY_STATE_OK:
+                addToScreenLog("%s.app: OK", cid);
+                continue;
+            case VERIFY_STATE_MISSING:
+                sprintf(ptr, "%s: %s", cid, localise("Missing"));
+                break;
+            case VERIFY_STATE_READ_ERROR:
+                if(results[i].block == VERIFY_NO_BLOCK)
+                    sprintf(ptr, "%s: %s", cid, localise("Read error"));
+                else
+                    sprintf(ptr, "%s: %s %u", cid, localise("Read error at block"), results[i].block);
+                break;
+            case VERIFY_STATE_BAD_HASH:
+                sprintf(ptr, "%s: %s", cid, localise("Hash mismatch"));
+                break;
+            case VERIFY_STATE_BAD_H3:
+                sprintf(ptr, "%s: %s", cid, localise("Bad .h3 file"));
+                break;
+            case VERIFY_STATE_BAD_BLOCK:
+                sprintf(ptr, "%s: %s %u (0x%08" PRIx64 ")", cid, localise("Bad block"), results[i].block, (uint64_t)results[i].block * HASHED_BLOCK_SIZE);
+                break;
+            case VERIFY_STATE_PENDING:
+                sprintf(ptr, "%s: %s", cid, localise("Not verified"));
+                break;
+        }
+
+        addToScreenLog(ptr);
+        // Show as many damaged contents as fit on the error screen
+        if(++bad < MAX_LINES - 4)
+        {
+            ptr += strlen(ptr);
+            *ptr++ = '\n';
+        }
+        *ptr = '\0';
+    }
+
+    MEMFreeToDefaultHeap(results);
+    if(bad == 0)
+    {
+        showFinishedScreen(name, FINISHING_OPERATION_VERIFY);
+        return true;
+    }
+
+    showErrorFrame(toScreen);
+    return false;
+}
@@ -0,0 +1,149 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <string.h>
+
+#include <crypto.h>
+#include <thread.h>
+
+#include <coreinit/thread.h>
+#include <coreinit/time.h>
+
+#include "test.h"
+
+#define ROUNDS      200000
+#define BULK_SIZE   (64 * 1024)
+#define BULK_ROUNDS 200
+
+/*
+ * The generator before per-core state: One spinlock and one byte per
+ * xorshift step, kept here to compare against.
+ */
+static spinlock oldLock = SPINLOCK_FREE;
+static volatile uint32_t oldState = 0x9E3779B9;
+
+#define oldRun()                    \
+    {                               \
+        oldState ^= oldState << 13; \
+        oldState ^= oldState >> 17; \
+        oldState ^= oldState << 5;  \
+    }
+
+static void oldRng(unsigned char *out, size_t len)
+{
+    spinLock(oldLock);
+    while(len--)
+    {
+        oldRun();
+        *out++ = oldState;
+    }
+    spinReleaseLock(oldLock);
+}
+
+static void oldEntropy(const void *e, size_t len)
+{
+    const uint8_t *buf = e;
+    spinLock(oldLock);
+    while(len--)
+    {
+        oldRun();
+        oldState ^= *buf++;
+    }
+    spinReleaseLock(oldLock);
+}
+
+static const OSThreadAttributes coreAffinity[3] = {
+    OS_THREAD_ATTRIB_AFFINITY_CPU0,
+    OS_THREAD_ATTRIB_AFFINITY_CPU1,
+    OS_THREAD_ATTRIB_AFFINITY_CPU2,
+};
+
+/*
+ * What a transfer does: Entropy from every progress callback and file
+ * operation and now and then some random bytes for TLS.
+ */
+static int workerMain(int old, const char **argv)
+{
+    (void)argv;
+
+    uint8_t buf[32];
+    OSTime t;
+    for(int i = 0; i < ROUNDS; ++i)
+    {
+        t = OSGetTime();
+        if(old)
+        {
+            oldEntropy(&t, sizeof(t));
+            if(i % 8 == 0)
+                oldRng(buf, sizeof(buf));
+        }
+        else
+        {
+            addEntropy(&t, sizeof(t));
+            if(i % 8 == 0)
+                NUSrng(NULL, buf, sizeof(buf));
+        }
+    }
+
+    return 0;
+}
+
+static void runThreads(const char *name, int count, bool old)
+{
+    OSThread *threads[6];
+    uint64_t t = testNow();
+    for(int i = 0; i < count; ++i)
+        threads[i] = startThread("NUSspli RNG bench", THREAD_PRIORITY_MEDIUM, STACKSIZE_SMALL, workerMain, old, NULL, coreAffinity[i % 3]);
+    for(int i = 0; i < count; ++i)
+        if(threads[i] != NULL)
+            stopThread(threads[i], NULL);
+
+    t = testNow() - t;
+    printf("%-12s %d threads %8.2f ms %7.1f ns per call\n", name, count, t / 1000000.0, (double)t / ((uint64_t)ROUNDS * count));
+}
+
+static void runBulk(const char *name, bool old)
+{
+    static uint8_t buf[BULK_SIZE];
+    uint64_t t = testNow();
+    for(int i = 0; i < BULK_ROUNDS; ++i)
+    {
+        if(old)
+            oldRng(buf, BULK_SIZE);
+        else
+            NUSrng(NULL, buf, BULK_SIZE);
+    }
+
+    t = testNow() - t;
+    printf("%-12s bulk      %8.2f ms %7.1f MiB/s\n", name, t / 1000000.0, (double)BULK_SIZE * BULK_ROUNDS / (1024 * 1024) / (t / 1000000000.0));
+}
+
+int main()
+{
+    initCrypto();
+    printf("%d entropy calls per thread, threads spread over 3 cores\n", ROUNDS);
+    for(int count = 1; count <= 6; count = count == 1 ? 3 : count * 2)
+    {
+        runThreads("global lock", count, true);
+        runThreads("per core", count, false);
+    }
+
+    runBulk("global lock", true);
+    runBulk("per core", false);
+    return 0;
+}
@@ -0,0 +1,126 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <thread.h>
+#include <utils.h>
+
+#include <coreinit/thread.h>
+#include <coreinit/time.h>
+
+#include "test.h"
+
+#define BATCH   256 // Half the ring, so nothing gets dropped
+#define BATCHES 400
+
+// The backends cost nothing here, only what the calling thread pays counts
+static volatile uint32_t printed = 0;
+
+BOOL WHBLogPrint(const char *str)
+{
+    ++printed;
+    return TRUE;
+}
+
+BOOL WHBLogUdpInit()
+{
+    return TRUE;
+}
+
+BOOL WHBLogUdpDeinit()
+{
+    return TRUE;
+}
+
+BOOL WHBLogCafeInit()
+{
+    return TRUE;
+}
+
+BOOL WHBLogCafeDeinit()
+{
+    return TRUE;
+}
+
+/*
+ * debugPrintf() before the ring: Timestamp and message formatted on the
+ * calling thread while holding the lock, kept here to compare against.
+ */
+static spinlock oldLock = SPINLOCK_FREE;
+
+static const char days[7][4] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+static const char months[12][4] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+static void oldDebugPrintf(const char *str, ...)
+{
+    spinLock(oldLock);
+    static char newStr[512];
+
+    OSCalendarTime now;
+    OSTicksToCalendarTime(OSGetTime(), &now);
+    sprintf(newStr, "%s %02d %s %d %02d:%02d:%02d.%03d\t", days[now.tm_wday], now.tm_mday, months[now.tm_mon], now.tm_year, now.tm_hour, now.tm_min, now.tm_sec, now.tm_msec);
+    size_t tss = strlen(newStr);
+
+    va_list va;
+    va_start(va, str);
+    vsnprintf(newStr + tss, 511 - tss, str, va);
+    va_end(va);
+
+    WHBLogPrint(newStr);
+    spinReleaseLock(oldLock);
+}
+
+static void waitPrinted(uint32_t n)
+{
+    while(printed < n)
+        OSSleepTicks(OSMillisecondsToTicks(1));
+}
+
+// A typical message: One string, two numbers
+#define bench(name, fn)                                                                     \
+    {                                                                                       \
+        const char *file = "/vol/external01/install/Title [0005000010101000]/00000004.app"; \
+        uint64_t total = 0;                                                                 \
+        uint64_t t;                                                                         \
+        printed = 0;                                                                        \
+        for(uint32_t b = 0; b < BATCHES; ++b)                                               \
+        {                                                                                   \
+            t = testNow();                                                                  \
+            for(uint32_t i = 0; i < BATCH; ++i)                                             \
+                fn("Writing %s: %d / %u bytes", file, (int)i, 0x8000u);                     \
+                                                                                            \
+            total += testNow() - t;                                                         \
+            waitPrinted((b + 1) * BATCH);                                                   \
+        }                                                                                   \
+                                                                                            \
+        printf("%-16s %6.1f ns per call\n", name, (double)total / (BATCHES * BATCH));       \
+    }
+
+int main()
+{
+    printf("%d calls in batches of %d, log backends stubbed out\n", BATCHES * BATCH, BATCH);
+    bench("vsnprintf", oldDebugPrintf);
+
+    debugInit();
+    bench("deferred", debugPrintf);
+    shutdownDebug();
+    return 0;
+}
@@ -0,0 +1,123 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <keygen.h>
+#include <titles.h>
+
+#include "test.h"
+
+#define BATCH KEY_CACHE_SIZE
+
+static volatile uintptr_t sink;
+
+// The lookup before the title ID index, for comparison
+static const TitleEntry *linearLookup(uint64_t tid)
+{
+    TITLE_CATEGORY cat;
+    switch(getTidHighFromTid(tid))
+    {
+        case TID_HIGH_GAME:
+            cat = TITLE_CATEGORY_GAME;
+            break;
+        case TID_HIGH_UPDATE:
+            cat = TITLE_CATEGORY_UPDATE;
+            break;
+        case TID_HIGH_DLC:
+            cat = TITLE_CATEGORY_DLC;
+            break;
+        case TID_HIGH_DEMO:
+            cat = TITLE_CATEGORY_DEMO;
+            break;
+        default:
+            cat = TITLE_CATEGORY_ALL;
+    }
+
+    for(int pass = 0; pass < 2; ++pass)
+    {
+        const TitleEntry *e = getTitleEntries(cat);
+        for(size_t i = getTitleEntriesSize(cat); i != 0; --i, ++e)
+            if(e->tid == tid)
+                return e;
+
+        if(cat != TITLE_CATEGORY_GAME)
+            break;
+
+        cat = TITLE_CATEGORY_DISC;
+    }
+
+    return NULL;
+}
+
+static void report(const char *name, uint64_t ns, size_t count)
+{
+    printf("%-28s %9.3f ms total %9.1f ns per title\n", name, ns / 1000000.0, (double)ns / count);
+}
+
+/*
+ * Looks up and derives the keys of every title in the (synthetic, see
+ * tests/gtitles.c) title database.
+ */
+int main()
+{
+    size_t count = getTitleEntriesSize(TITLE_CATEGORY_ALL);
+    uint64_t *tids = malloc(count * sizeof(uint64_t));
+    for(size_t i = 0; i < count; ++i)
+        tids[i] = getTitleEntries(TITLE_CATEGORY_ALL)[i].tid;
+
+    printf("%zu titles\n", count);
+
+    uint64_t t = testNow();
+    for(size_t i = 0; i < count; ++i)
+        sink = (uintptr_t)linearLookup(tids[i]);
+    report("lookup, linear scan", testNow() - t, count);
+
+    // The first call builds the index
+    t = testNow();
+    sink = (uintptr_t)getTitleEntryByTid(tids[0]);
+    report("lookup, index build", testNow() - t, count);
+
+    t = testNow();
+    for(size_t i = 0; i < count; ++i)
+        sink = (uintptr_t)getTitleEntryByTid(tids[i]);
+    report("lookup, index", testNow() - t, count);
+
+    uint8_t *keys = malloc(count * 16);
+    // The cache holds KEY_CACHE_SIZE titles only, so these all miss
+    t = testNow();
+    for(size_t i = 0; i < count; ++i)
+        generateKey(tids[i], keys + i * 16);
+    report("generateKey()", testNow() - t, count);
+
+    t = testNow();
+    for(size_t i = 0; i < count; i += BATCH)
+        generateKeys(tids + i, count - i < BATCH ? count - i : BATCH, keys + i * 16);
+    report("generateKeys(), batches of 32", testNow() - t, count);
+
+    // What a queue of the same titles hits, e.g. verifying after download
+    t = testNow();
+    for(size_t i = 0; i < count; ++i)
+        generateKey(tids[i % BATCH], keys + i * 16);
+    report("generateKey(), cached", testNow() - t, count);
+
+    free(keys);
+    free(tids);
+    return 0;
+}
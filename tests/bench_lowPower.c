@@ -0,0 +1,171 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <downloader.h>
+#include <file.h>
+#include <renderer.h>
+#include <romfs.h>
+
+#include "fixtures.h"
+#include "headlessSdl.h"
+#include "nusServer.h"
+#include "test.h"
+
+#include <coreinit/filesystem_fsa.h>
+
+/*
+ * Main loop CPU time of downloadFile() per downloaded gigabyte, with and
+ * without the low power mode. The file comes from the local NUS stand-in at
+ * a fixed rate and the headless renderer waits for the 60 Hz vsync of the
+ * TV, so the loop runs as often as on the console. Main loop CPU is the CPU
+ * time of the main thread, the other threads (curl, I/O) are listed apart.
+ */
+
+#define MB           (1024 * 1024)
+#define RATE         (16 * MB) // Byte per second
+#define FILE_SIZE    (64 * MB)
+#define IDLE_RATE    (4 * MB)
+#define IDLE_SIZE    (44 * MB) // Longer than the 10 seconds until the low power mode kicks in
+#define CONTENT_PATH "/ccs/download/0005000010101a00/"
+
+static bool lowPower = false;
+static uint32_t wakeups = 0;
+
+bool lowPowerEnabled()
+{
+    return lowPower;
+}
+
+// Called by showFrame() and by the low power mode on its own
+void readInput()
+{
+    ++wakeups;
+}
+
+static uint64_t cpuTime(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static bool download(const char *content, size_t size, char *file)
+{
+    char url[128];
+    sprintf(url, DOWNLOAD_URL "0005000010101a00/%s", content);
+    sprintf(file, NUSDIR_SD "bench/%s.app", content);
+    downloadData data = {
+        .name = "Bench title",
+        .contents = 1,
+        .dltotal = size,
+        .eta = -1,
+        .cs = size,
+    };
+
+    return downloadFile(url, file, &data, FILE_TYPE_APP, false, NULL, NULL) == 0 && data.dlnow == (curl_off_t)size;
+}
+
+static void run(const char *label)
+{
+    HEADLESS_STATS stats;
+    char file[FS_MAX_PATH];
+    resetHeadlessStats();
+    wakeups = 0;
+    uint64_t t = testNow();
+    uint64_t mainCpu = cpuTime(CLOCK_THREAD_CPUTIME_ID);
+    uint64_t allCpu = cpuTime(CLOCK_PROCESS_CPUTIME_ID);
+
+    bool ok = download("00000001", FILE_SIZE, file);
+
+    mainCpu = cpuTime(CLOCK_THREAD_CPUTIME_ID) - mainCpu;
+    allCpu = cpuTime(CLOCK_PROCESS_CPUTIME_ID) - allCpu;
+    t = testNow() - t;
+    getHeadlessStats(&stats);
+
+    // Freeing the blocks of the file costs more CPU than the whole main loop
+    FSARemove(getFSAClient(), file);
+    if(!ok)
+    {
+        fprintf(stderr, "%s: Download failed\n", label);
+        return;
+    }
+
+    double perGb = (1024.0 * MB) / FILE_SIZE / 1000000.0; // ns for the file to ms per GB
+    double secs = t / 1000000000.0;
+    printf("%-10s main loop %7.1f ms CPU per GB, %5.1f wakeups/s, %5.2f frames/s | other threads %7.1f ms CPU per GB\n",
+           label, mainCpu * perGb, wakeups / secs, stats.presents / secs, (allCpu - mainCpu) * perGb);
+}
+
+int main()
+{
+    static const char certs[] = "# Plain HTTP only on the host\n";
+
+    hostMakeRoot();
+    mountHostRomfs();
+    writeHostFile(ROMFS_PATH "ca-certs.pem", certs, sizeof(certs) - 1);
+    makeHostDirs(NUSDIR_SD "bench");
+    if(!initRenderer())
+    {
+        fprintf(stderr, "Can't start the renderer\n");
+        return 1;
+    }
+
+    int port = startNusServer();
+    if(port == 0)
+    {
+        fprintf(stderr, "Can't start the NUS server\n");
+        return 1;
+    }
+
+    addNusFile(CONTENT_PATH "00000001", NULL, FILE_SIZE);
+    addNusFile(CONTENT_PATH "00000002", NULL, IDLE_SIZE);
+    hostSetProxy("127.0.0.1", port);
+    if(!initDownloader())
+    {
+        fprintf(stderr, "Can't init the downloader\n");
+        return 1;
+    }
+
+    setHeadlessVsync(true);
+    printf("%d MB at %d MB/s each, 60 Hz vsync\n", FILE_SIZE / MB, RATE / MB);
+    setNusServerTiming(0, 0, RATE);
+    run("Normal");
+
+    // No input for 10 seconds
+    lowPower = true;
+    setNusServerTiming(0, 0, IDLE_RATE);
+    char file[FS_MAX_PATH];
+    if(!download("00000002", IDLE_SIZE, file))
+        fprintf(stderr, "Going idle failed\n");
+
+    FSARemove(getFSAClient(), file);
+
+    setNusServerTiming(0, 0, RATE);
+    run("Low power");
+
+    deinitDownloader();
+    stopNusServer();
+    shutdownRenderer();
+    hostRemoveRoot();
+    return 0;
+}
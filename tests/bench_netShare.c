@@ -0,0 +1,103 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdio.h>
+
+#include <netShare.h>
+
+#include "test.h"
+#include "tlsServer.h"
+
+#define FILES     64
+#define FILE_SIZE (64 * 1024)
+
+static int port;
+
+static size_t discardData(void *buf, size_t size, size_t nmemb, void *userp)
+{
+    (void)buf;
+    (void)userp;
+
+    return size * nmemb;
+}
+
+/*
+ * Downloads FILES files with two handles taking turns and prints the time
+ * to first byte per file together with the handshakes the server saw.
+ * "fresh" forces a new connection per file, like downloadFile() after a
+ * network reset.
+ */
+static void run(const char *name, bool share, bool fresh)
+{
+    char url[64];
+    sprintf(url, "https://127.0.0.1:%d/%d", port, FILE_SIZE);
+
+    CURLSH *sh = share ? initNetShare() : NULL;
+    CURL *handles[2];
+    for(int i = 0; i < 2; ++i)
+    {
+        handles[i] = curl_easy_init();
+        curl_easy_setopt(handles[i], CURLOPT_URL, url);
+        curl_easy_setopt(handles[i], CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(handles[i], CURLOPT_SSL_VERIFYHOST, 0L);
+        curl_easy_setopt(handles[i], CURLOPT_WRITEFUNCTION, discardData);
+        curl_easy_setopt(handles[i], CURLOPT_FRESH_CONNECT, fresh ? 1L : 0L);
+        curl_easy_setopt(handles[i], CURLOPT_SHARE, sh);
+    }
+
+    resetTlsServerStats();
+    curl_off_t ttfb = 0;
+    uint64_t start = testNow();
+    for(int i = 0; i < FILES; ++i)
+    {
+        curl_off_t t;
+        if(curl_easy_perform(handles[i & 1]) == CURLE_OK && curl_easy_getinfo(handles[i & 1], CURLINFO_STARTTRANSFER_TIME_T, &t) == CURLE_OK)
+            ttfb += t;
+    }
+    uint64_t total = testNow() - start;
+
+    TLS_SERVER_STATS stats;
+    getTlsServerStats(&stats);
+    printf("%-24s %6.0f us TTFB %8.2f ms total %4u connections %4u handshakes %4u resumed\n", name, (double)ttfb / FILES, total / 1000000.0, stats.connections, stats.handshakes, stats.resumed);
+
+    for(int i = 0; i < 2; ++i)
+        curl_easy_cleanup(handles[i]);
+    if(sh != NULL)
+        curl_share_cleanup(sh);
+}
+
+int main()
+{
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    port = startTlsServer();
+    if(port == 0)
+    {
+        fprintf(stderr, "Can't start the TLS server\n");
+        return 1;
+    }
+
+    printf("%d files of %d bytes over local TLS, two handles taking turns\n", FILES, FILE_SIZE);
+    run("unshared, reconnecting", false, true);
+    run("shared, reconnecting", true, true);
+    run("unshared", false, false);
+    run("shared", true, false);
+
+    stopTlsServer();
+    curl_global_cleanup();
+    return 0;
+}
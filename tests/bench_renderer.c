@@ -0,0 +1,227 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <renderer.h>
+
+#include "fixtures.h"
+#include "headlessSdl.h"
+#include "test.h"
+
+/*
+ * Replays the frames of the busiest menus on the headless renderer. The
+ * layouts follow drawTBMenuFrame(), the progress frame of downloadFile(),
+ * drawQueueMenu() and drawITBMenuFrame(), the menu logic itself is left
+ * out. Times are the CPU side of building and submitting a frame.
+ */
+
+#define FRAMES 2000
+#define TITLES 64
+#define ROWS   (MAX_LINES - 5)
+
+static char names[TITLES][128];
+
+static const char *const logLines[] = {
+    "Downloading title.tmd",
+    "Downloading title.cert",
+    "Downloading 00000000.app",
+    "Downloading 00000001.h3",
+    "Downloading 00000001.app",
+    "Verifying 00000001.app",
+};
+
+// Mostly latin, some japanese, the way the title DB looks
+static void makeNames()
+{
+    static const char *const parts[] = { "Super", "Mario", "Kart", "Legend", "Zelda", "Breath of the Wild", "Xenoblade", "Chronicles X", "Splatoon", "Pikmin", "\xE3\x82\xBC\xE3\x83\xAB\xE3\x83\x80", "\xE3\x83\x9E\xE3\x83\xAA\xE3\x82\xAA", "Deluxe", "Edition" };
+    for(int i = 0; i < TITLES; ++i)
+        sprintf(names[i], "%s %s %s %d", parts[i % 14], parts[(i * 7 + 3) % 14], parts[(i * 5 + 1) % 14], i);
+}
+
+static void titleBrowserFrame(int n)
+{
+    static const char *const tabs[5] = { "Games", "Updates", "DLC", "Demos", "All" };
+    static const MCPRegion regions[4] = { MCP_REGION_EUROPE, MCP_REGION_USA, MCP_REGION_JAPAN, MCP_REGION_EUROPE | MCP_REGION_USA };
+
+    startNewFrame();
+    for(int i = 0; i < 5; ++i)
+        tabToFrame(0, i, tabs[i], i == 0);
+
+    boxToFrame(1, MAX_LINES - 3);
+    textToFrame(MAX_LINES - 2, ALIGNED_CENTER, "Press  to select ||  to return ||  to enter a title ID");
+    textToFrame(MAX_LINES - 1, ALIGNED_CENTER, " to search ||  to open the queue");
+
+    for(int i = 0; i < ROWS; ++i)
+    {
+        int t = (n + i) % TITLES;
+        if(i == n % ROWS)
+            arrowToFrame(i + 2, 1);
+        if(t % 3 == 0)
+            checkmarkToFrame(i + 2, 4);
+
+        flagToFrame(i + 2, 7, regions[t & 3]);
+        if(t % 5 == 0)
+            textToFrameColoredCut(i + 2, 10, names[t], SCREEN_COLOR_YELLOW, (SCREEN_WIDTH - (FONT_SIZE << 1)) - (getSpaceWidth() * 11));
+        else
+            textToFrameCut(i + 2, 10, names[t], (SCREEN_WIDTH - (FONT_SIZE << 1)) - (getSpaceWidth() * 11));
+    }
+
+    drawFrame();
+}
+
+static void downloadFrame(int n)
+{
+    char line[64];
+    startNewFrame();
+    textToFrame(0, 0, names[n % TITLES]);
+    barToFrame(1, 0, 29, (float)(n % 100) / 100.0f);
+    sprintf(line, "%d.%d MB / 1024.0 MB", n % 1024, n % 10);
+    textToFrame(1, 30, line);
+    textToFrame(1, ALIGNED_RIGHT, "12.34 Mb/s (1.54 MB/s)");
+    textToFrame(2, 0, "ETA: 3 minutes 21 seconds");
+    lineToFrame(3, SCREEN_COLOR_WHITE);
+    for(int i = 0; i < 6; ++i)
+        textToFrame(i + 4, 0, logLines[(n + i) % 6]);
+
+    drawFrame();
+}
+
+static void queueFrame(int n)
+{
+    char line[64];
+    startNewFrame();
+    boxToFrame(0, MAX_LINES - 2);
+    for(int i = 0; i < MAX_LINES - 4; ++i)
+    {
+        int t = (n + i) % TITLES;
+        if(i == n % (MAX_LINES - 4))
+            arrowToFrame(i + 1, 1);
+
+        textToFrameCut(i + 1, 4, names[t], SCREEN_WIDTH >> 1);
+        sprintf(line, "%d.%02d GB", t % 16, t);
+        textToFrame(i + 1, ALIGNED_RIGHT, line);
+    }
+
+    textToFrame(MAX_LINES - 1, ALIGNED_CENTER, "Press  to start ||  to return ||  to remove");
+    drawFrame();
+}
+
+static void installedFrame(int n)
+{
+    startNewFrame();
+    boxToFrame(0, MAX_LINES - 2);
+    for(int i = 0; i < MAX_LINES - 3; ++i)
+    {
+        int t = (n + i) % TITLES;
+        if(i == n % (MAX_LINES - 3))
+            arrowToFrame(i + 1, 1);
+
+        deviceToFrame(i + 1, 4, (DEVICE_TYPE)(t & 3));
+        flagToFrame(i + 1, 7, MCP_REGION_EUROPE);
+        textToFrameCut(i + 1, 10, names[t], (SCREEN_WIDTH - (FONT_SIZE << 1)) - (getSpaceWidth() * 11));
+    }
+
+    textToFrame(MAX_LINES - 1, ALIGNED_CENTER, "Press  to select ||  to return");
+    drawFrame();
+}
+
+static int compareTimes(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void replay(const char *name, void (*frame)(int))
+{
+    static uint64_t times[FRAMES];
+    HEADLESS_STATS stats;
+
+    // The first frame fills the glyph cache, count it into the hit rate but not the times
+    resetHeadlessStats();
+    frame(0);
+    uint64_t allocs = hostHeapAllocations();
+    for(int i = 0; i < FRAMES; ++i)
+    {
+        uint64_t t = testNow();
+        frame(i + 1);
+        times[i] = testNow() - t;
+    }
+
+    getHeadlessStats(&stats);
+    allocs = hostHeapAllocations() - allocs;
+    qsort(times, FRAMES, sizeof(uint64_t), compareTimes);
+    printf("%-18s p50 %6.1f us, p90 %6.1f us, p99 %6.1f us | %5.1f draws, %5.1f tex switches, %4.2f allocs per frame | glyph hits %8.4f %% (%u misses)\n",
+           name,
+           times[FRAMES / 2] / 1000.0,
+           times[(FRAMES * 9) / 10] / 1000.0,
+           times[(FRAMES * 99) / 100] / 1000.0,
+           (double)stats.drawCalls / (FRAMES + 1),
+           (double)stats.textureSwitches / (FRAMES + 1),
+           (double)allocs / FRAMES,
+           100.0 - (100.0 * stats.glyphMisses) / stats.glyphs,
+           (unsigned)stats.glyphMisses);
+}
+
+// Coming back from the HOME menu loads the font and rebuilds the icon atlas
+static void resume()
+{
+    static uint64_t times[100];
+    HEADLESS_STATS stats;
+
+    resetHeadlessStats();
+    for(int i = 0; i < 100; ++i)
+    {
+        pauseRenderer();
+        uint64_t t = testNow();
+        resumeRenderer();
+        times[i] = testNow() - t;
+    }
+
+    getHeadlessStats(&stats);
+    qsort(times, 100, sizeof(uint64_t), compareTimes);
+    printf("%-18s p50 %6.1f us, p90 %6.1f us | %4.1f textures, %4.1f surfaces per resume\n",
+           "Resume", times[50] / 1000.0, times[90] / 1000.0,
+           stats.texturesCreated / 100.0, stats.surfacesCreated / 100.0);
+}
+
+int main()
+{
+    hostMakeRoot();
+    mountHostRomfs();
+    if(!initRenderer())
+    {
+        fprintf(stderr, "Can't start the renderer\n");
+        return 1;
+    }
+
+    makeNames();
+    printf("%d frames each, headless SDL\n", FRAMES);
+    replay("Title browser", titleBrowserFrame);
+    replay("Download", downloadFrame);
+    replay("Queue", queueFrame);
+    replay("Installed titles", installedFrame);
+    resume();
+
+    shutdownRenderer();
+    hostRemoveRoot();
+    return 0;
+}
@@ -0,0 +1,62 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdio.h>
+
+#include <trace.h>
+
+#include "test.h"
+
+/*
+ * Cost of one traceEvent() on the calling thread, which has to stay below
+ * 100 ns so tracing the hot paths doesn't change what gets measured. The
+ * loop wraps the ring many times, like a long running trace does.
+ */
+
+#define EVENTS (TRACE_RING_EVENTS * 256)
+#define RUNS   5
+
+#define bench(name, call)                                                  \
+    {                                                                      \
+        uint64_t best = UINT64_MAX;                                        \
+        uint64_t t;                                                        \
+        for(int r = 0; r < RUNS; ++r)                                      \
+        {                                                                  \
+            t = testNow();                                                 \
+            for(uint32_t i = 0; i < EVENTS; ++i)                           \
+                call;                                                      \
+                                                                           \
+            t = testNow() - t;                                             \
+            if(t < best)                                                   \
+                best = t;                                                  \
+        }                                                                  \
+                                                                           \
+        printf("%-16s %6.1f ns per event\n", name, (double)best / EVENTS); \
+    }
+
+int main()
+{
+    printf("%d events, best of %d runs\n", EVENTS, RUNS);
+    bench("off", traceCounter("bench", i));
+
+    initTrace();
+    bench("counter", traceCounter("bench", i));
+    bench("begin/end", (i & 1) ? traceEnd("bench") : traceBegin("bench"));
+    shutdownTrace();
+    return 0;
+}
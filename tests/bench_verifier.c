@@ -0,0 +1,92 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <file.h>
+#include <tmd.h>
+#include <verifier.h>
+
+#include "fixtures.h"
+#include "test.h"
+
+#define CONTENTS     6
+#define CONTENT_SIZE (256 * HASHED_BLOCK_SIZE) // 16 MiB
+#define RUNS         3
+
+/*
+ * Verifies a synthetic title folder with only flat and one with only
+ * hashed contents and prints the throughput. The files are in the page
+ * cache after the first run, so this measures decryption and hashing, not
+ * the storage.
+ */
+static void run(const char *name, const char *dir, uint64_t tid, bool hashed)
+{
+    CONTENT_DESC desc[CONTENTS];
+    for(int i = 0; i < CONTENTS; ++i)
+    {
+        desc[i].size = CONTENT_SIZE;
+        desc[i].hashed = hashed;
+    }
+
+    size_t size;
+    char path[FS_MAX_PATH];
+    makeHostDirs(dir);
+    TMD *tmd = buildTmd(tid, 0, desc, CONTENTS, &size);
+    for(uint16_t i = 0; i < CONTENTS; ++i)
+        writeEncryptedContent(dir, tmd, i);
+
+    void *ticket = buildTicket(tid, &size);
+    sprintf(path, "%stitle.tik", dir);
+    writeHostFile(path, ticket, size);
+    free(ticket);
+
+    VERIFY_RESULT results[CONTENTS];
+    char d[FS_MAX_PATH];
+    strcpy(d, dir);
+    uint64_t best = UINT64_MAX;
+    for(int r = 0; r < RUNS; ++r)
+    {
+        uint64_t t = testNow();
+        bool ok = verifyContents(d, tmd, results);
+        t = testNow() - t;
+        for(int i = 0; i < CONTENTS; ++i)
+            ok = ok && results[i].state == VERIFY_STATE_OK;
+
+        if(!ok)
+            fprintf(stderr, "%s: Verification failed!\n", name);
+        if(t < best)
+            best = t;
+    }
+
+    double mib = (double)CONTENTS * CONTENT_SIZE / (1024 * 1024);
+    printf("%-8s %6.0f MiB in %7.2f ms: %7.1f MiB/s\n", name, mib, best / 1000000.0, mib / (best / 1000000000.0));
+    free(tmd);
+}
+
+int main()
+{
+    hostMakeRoot();
+    printf("%d contents of %d MiB, %d verifier threads, best of %d\n", CONTENTS, CONTENT_SIZE / (1024 * 1024), VERIFY_THREADS, RUNS);
+    run("flat", INSTALL_DIR_SD "Flat [0005000010103000]/", 0x0005000010103000ull, false);
+    run("hashed", INSTALL_DIR_SD "Hashed [0005000010104000]/", 0x0005000010104000ull, true);
+    hostRemoveRoot();
+    return 0;
+}
@@ -0,0 +1,152 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <downloader.h>
+#include <file.h>
+#include <romfs.h>
+
+#include "fixtures.h"
+#include "nusServer.h"
+#include "test.h"
+
+/*
+ * Time to first byte of the first downloadFile() after initDownloader(),
+ * cold and after a finished warmupConnection(). The NUS stand-in holds every
+ * new connection back for CONNECT_MS, like the TCP and TLS handshakes to the
+ * real NUS do. TTFB is the time until the request reaches the server.
+ */
+
+#define CONNECT_MS 50
+#define SAMPLES    15
+#define TMD_PATH   "/ccs/download/0005000010101a00/tmd"
+
+static int compare(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static bool waitForRequest()
+{
+    NUS_SERVER_STATS stats;
+    for(int i = 0; i < 5000; ++i)
+    {
+        getNusServerStats(&stats);
+        if(stats.requests != 0)
+        {
+            // Let curl put the connection back into the pool
+            usleep(20000);
+            return true;
+        }
+
+        usleep(1000);
+    }
+
+    return false;
+}
+
+// TTFB in ns of one download, 0 on error
+static uint64_t measure(bool warm, uint32_t *connections)
+{
+    deinitDownloader();
+    if(!initDownloader())
+        return 0;
+
+    resetNusServerStats();
+    if(warm)
+    {
+        warmupConnection();
+        if(!waitForRequest())
+            return 0;
+
+        resetNusServerStats();
+    }
+
+    RAMBUF *rambuf = allocRamBuf();
+    if(rambuf == NULL)
+        return 0;
+
+    uint64_t t = testNow();
+    int ret = downloadFile(DOWNLOAD_URL "0005000010101a00/tmd", "tmd", NULL, FILE_TYPE_TMD | FILE_TYPE_TORAM, false, NULL, rambuf);
+    freeRamBuf(rambuf);
+    if(ret != 0)
+        return 0;
+
+    NUS_SERVER_STATS stats;
+    getNusServerStats(&stats);
+    *connections += stats.connections;
+    return stats.lastRequest - t;
+}
+
+static void run(const char *label, bool warm)
+{
+    uint64_t ttfb[SAMPLES];
+    uint32_t connections = 0;
+    for(int i = 0; i < SAMPLES; ++i)
+    {
+        ttfb[i] = measure(warm, &connections);
+        if(ttfb[i] == 0)
+        {
+            fprintf(stderr, "%s: Download failed\n", label);
+            return;
+        }
+    }
+
+    qsort(ttfb, SAMPLES, sizeof(uint64_t), compare);
+    printf("%-10s TTFB p50 %7.2f ms, min %7.2f ms, max %7.2f ms | %.1f new connections per download\n",
+           label, ttfb[SAMPLES / 2] / 1000000.0, ttfb[0] / 1000000.0, ttfb[SAMPLES - 1] / 1000000.0, (double)connections / SAMPLES);
+}
+
+int main()
+{
+    static const char certs[] = "# Plain HTTP only on the host\n";
+
+    hostMakeRoot();
+    makeHostDirs(ROMFS_PATH);
+    writeHostFile(ROMFS_PATH "ca-certs.pem", certs, sizeof(certs) - 1);
+
+    int port = startNusServer();
+    if(port == 0)
+    {
+        fprintf(stderr, "Can't start the NUS server\n");
+        return 1;
+    }
+
+    addNusFile(TMD_PATH, NULL, 0x1000);
+    hostSetProxy("127.0.0.1", port);
+    if(!initDownloader())
+    {
+        fprintf(stderr, "Can't init the downloader\n");
+        return 1;
+    }
+
+    setNusServerTiming(CONNECT_MS, 0, 0);
+    printf("First download after init, %d ms per new connection, %d samples\n", CONNECT_MS, SAMPLES);
+    run("Cold", false);
+    run("Warmed up", true);
+
+    deinitDownloader();
+    stopNusServer();
+    hostRemoveRoot();
+    return 0;
+}
@@ -0,0 +1,277 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <crypto.h>
+#include <file.h>
+#include <otp.h>
+#include <romfs.h>
+#include <ticket.h>
+#include <titles.h>
+#include <tmd.h>
+#include <verifier.h>
+
+#include <mbedtls/aes.h>
+#include <mbedtls/sha1.h>
+#include <mbedtls/sha256.h>
+
+#include "fixtures.h"
+#include "test.h"
+
+#define SHA1_SIZE       20
+#define HASH_TABLE_SIZE (16 * SHA1_SIZE)
+
+const uint8_t fixtureTitleKey[16] = { 0x4E, 0x55, 0x53, 0x73, 0x70, 0x6C, 0x69, 0x20, 0x74, 0x65, 0x73, 0x74, 0x20, 0x6B, 0x65, 0x79 };
+
+// Same hashes verifyTmd() checks
+void sealTmd(TMD *tmd)
+{
+    mbedtls_sha256((unsigned char *)tmd->contents, sizeof(TMD_CONTENT) * tmd->num_contents, (unsigned char *)tmd->content_infos[0].hash, 0);
+    mbedtls_sha256((unsigned char *)tmd->content_infos, sizeof(TMD_CONTENT_INFO) * 64, (unsigned char *)tmd->hash, 0);
+}
+
+// Content IDs are <version><index>, so they differ between versions
+TMD *buildTmd(uint64_t tid, uint16_t version, const CONTENT_DESC *desc, uint16_t count, size_t *size)
+{
+    // With the certificate, so the minimal title.tmd size is reached
+    *size = sizeof(TMD) + 0x700 + sizeof(TMD_CONTENT) * count;
+    TMD *tmd = calloc(1, *size);
+    tmd->tid = tid;
+    tmd->title_version = version;
+    tmd->num_contents = count;
+    tmd->content_infos[0].count = count;
+    for(uint16_t i = 0; i < count; ++i)
+    {
+        tmd->contents[i].cid = version << 8 | i;
+        tmd->contents[i].index = i;
+        tmd->contents[i].type = TMD_CONTENT_TYPE_CONTENT | TMD_CONTENT_TYPE_ENCRYPTED;
+        if(desc[i].hashed)
+            tmd->contents[i].type |= TMD_CONTENT_TYPE_HASHED;
+
+        tmd->contents[i].size = desc[i].size;
+        memset(tmd->contents[i].hash, desc[i].hash, sizeof(tmd->contents[i].hash));
+    }
+
+    sealTmd(tmd);
+    return tmd;
+}
+
+// What checkTicketStructure() wants to see plus the encrypted title key, the rest stays zero
+void *buildTicket(uint64_t tid, size_t *size)
+{
+    *size = sizeof(TICKET) + 0x100;
+    TICKET *ticket = calloc(1, *size);
+    ticket->header.sig_type = 0x00010004;
+    ticket->tid = tid;
+    ticket->header_version = 1;
+    ticket->total_hdr_size = 0x14;
+
+    uint8_t iv[16] = { 0 };
+    memcpy(iv, &tid, 8);
+    encryptAES((void *)fixtureTitleKey, 16, getCommonKey(), iv, ticket->key);
+    return ticket;
+}
+
+// What checkCertStructure() wants to see, the rest stays zero
+void *buildCert(size_t *size)
+{
+    *size = sizeof(CETK);
+    CETK *cert = calloc(1, *size);
+    cert->cert1.sig_type = 0x00010003;
+    cert->cert2.sig_type = 0x00010004;
+    cert->cert3.sig_type = 0x00010004;
+    strcpy(cert->cert1.issuer, "Root");
+    strcpy(cert->cert2.issuer, "Root-CA00000003");
+    strcpy(cert->cert3.issuer, "Root-CA00000003");
+    return cert;
+}
+
+static void fillContent(uint8_t *buf, size_t size, uint32_t seed)
+{
+    uint32_t x = seed | 1;
+    for(size_t i = 0; i < size; ++i)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        buf[i] = (uint8_t)x;
+    }
+}
+
+// Builds the H0 to H3 tables the way verifyHashed() checks them and encrypts the blocks in place
+static void hashBlocks(uint8_t *app, uint32_t blocks, uint8_t *h3, mbedtls_aes_context *aes)
+{
+    uint32_t groups = (blocks + 15) / 16;
+    uint8_t *h0 = calloc(groups * 16, SHA1_SIZE);
+    uint8_t *h1 = calloc((groups + 15) / 16 * 16, SHA1_SIZE);
+    uint8_t *h2 = calloc((groups + 255) / 256 * 16, SHA1_SIZE);
+
+    for(uint32_t b = 0; b < blocks; ++b)
+        mbedtls_sha1(app + b * HASHED_BLOCK_SIZE + HASHED_HEADER_SIZE, HASHED_BLOCK_SIZE - HASHED_HEADER_SIZE, h0 + b * SHA1_SIZE);
+    for(uint32_t g = 0; g < groups; ++g)
+        mbedtls_sha1(h0 + g * HASH_TABLE_SIZE, HASH_TABLE_SIZE, h1 + g * SHA1_SIZE);
+    for(uint32_t g = 0; g < (groups + 15) / 16; ++g)
+        mbedtls_sha1(h1 + g * HASH_TABLE_SIZE, HASH_TABLE_SIZE, h2 + g * SHA1_SIZE);
+    for(uint32_t g = 0; g < (groups + 255) / 256; ++g)
+        mbedtls_sha1(h2 + g * HASH_TABLE_SIZE, HASH_TABLE_SIZE, h3 + g * SHA1_SIZE);
+
+    uint8_t iv[16];
+    for(uint32_t b = 0; b < blocks; ++b)
+    {
+        uint8_t *block = app + b * HASHED_BLOCK_SIZE;
+        memcpy(block, h0 + (b >> 4) * HASH_TABLE_SIZE, HASH_TABLE_SIZE);
+        memcpy(block + HASH_TABLE_SIZE, h1 + (b >> 8) * HASH_TABLE_SIZE, HASH_TABLE_SIZE);
+        memcpy(block + HASH_TABLE_SIZE * 2, h2 + (b >> 12) * HASH_TABLE_SIZE, HASH_TABLE_SIZE);
+
+        memcpy(iv, h0 + b * SHA1_SIZE, 16);
+        mbedtls_aes_crypt_cbc(aes, MBEDTLS_AES_ENCRYPT, HASHED_BLOCK_SIZE - HASHED_HEADER_SIZE, iv, block + HASHED_HEADER_SIZE, block + HASHED_HEADER_SIZE);
+        memset(iv, 0, 16);
+        mbedtls_aes_crypt_cbc(aes, MBEDTLS_AES_ENCRYPT, HASHED_HEADER_SIZE, iv, block, block);
+    }
+
+    free(h0);
+    free(h1);
+    free(h2);
+}
+
+/*
+ * Writes <cid>.app, and <cid>.h3 for hashed contents, encrypted with
+ * fixtureTitleKey and puts the hash into the TMD. Call sealTmd() after the
+ * last content. Hashed contents need a size that's a multiple of
+ * HASHED_BLOCK_SIZE.
+ */
+void writeEncryptedContent(const char *dir, TMD *tmd, uint16_t i)
+{
+    TMD_CONTENT *content = tmd->contents + i;
+    size_t size = (content->size + 15) & ~15;
+    uint8_t *app = calloc(1, size);
+    fillContent(app, content->size, content->cid);
+
+    mbedtls_aes_context aes;
+    mbedtls_aes_init(&aes);
+    mbedtls_aes_setkey_enc(&aes, fixtureTitleKey, 128);
+
+    char path[FS_MAX_PATH];
+    if(content->type & TMD_CONTENT_TYPE_HASHED)
+    {
+        size_t h3Size = getH3size(content->size);
+        uint8_t *h3 = calloc(1, h3Size);
+        hashBlocks(app, content->size / HASHED_BLOCK_SIZE, h3, &aes);
+        mbedtls_sha1(h3, h3Size, (uint8_t *)content->hash);
+
+        sprintf(path, "%s%08x.h3", dir, content->cid);
+        writeHostFile(path, h3, h3Size);
+        free(h3);
+    }
+    else
+    {
+        mbedtls_sha1(app, content->size, (uint8_t *)content->hash);
+        uint8_t iv[16] = { 0 };
+        memcpy(iv, &content->index, 2);
+        mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_ENCRYPT, size, iv, app, app);
+    }
+
+    sprintf(path, "%s%08x.app", dir, content->cid);
+    writeHostFile(path, app, size);
+    free(app);
+}
+
+/*
+ * Console paths ("/vol/...") below the root set with hostSetRoot()
+ */
+static void hostFile(const char *path, char *out)
+{
+    if(strncmp(path, "/vol/", 5) == 0)
+        sprintf(out, "%s%s", hostGetRoot(), path);
+    else
+        strcpy(out, path);
+}
+
+void makeHostDirs(const char *path)
+{
+    char p[FS_MAX_PATH * 2];
+    char cmd[FS_MAX_PATH * 3];
+    hostFile(path, p);
+    sprintf(cmd, "mkdir -p '%s'", p);
+    system(cmd);
+}
+
+void writeHostFile(const char *path, const void *data, size_t size)
+{
+    char p[FS_MAX_PATH * 2];
+    hostFile(path, p);
+    FILE *f = fopen(p, "wb");
+    if(f == NULL)
+    {
+        perror(p);
+        return;
+    }
+
+    fwrite(data, 1, size, f);
+    fclose(f);
+}
+
+bool sameHostFile(const char *a, const char *b)
+{
+    char cmd[FS_MAX_PATH * 5];
+    char pa[FS_MAX_PATH * 2];
+    char pb[FS_MAX_PATH * 2];
+    hostFile(a, pa);
+    hostFile(b, pb);
+    sprintf(cmd, "cmp -s '%s' '%s'", pa, pb);
+    return system(cmd) == 0;
+}
+
+/*
+ * The romfs links to the contents of the data folder of the repository, the
+ * tests run from tests/. Files the build adds, like ca-certs.pem, can be
+ * written next to the links.
+ */
+void mountHostRomfs()
+{
+    char data[FS_MAX_PATH * 2];
+    char path[FS_MAX_PATH * 2];
+    makeHostDirs(ROMFS_PATH);
+    hostFile(ROMFS_PATH, path);
+    size_t len = strlen(path);
+    DIR *dir = opendir("../data");
+    struct dirent *entry;
+    while(dir != NULL && (entry = readdir(dir)) != NULL)
+    {
+        if(entry->d_name[0] == '.')
+            continue;
+
+        sprintf(data, "../data/%s", entry->d_name);
+        strcpy(path + len, entry->d_name);
+        char *target = realpath(data, NULL);
+        if(target == NULL || symlink(target, path) != 0)
+            fprintf(stderr, "Can't link %s into the romfs\n", entry->d_name);
+
+        free(target);
+    }
+
+    if(dir == NULL)
+        fprintf(stderr, "Can't link the romfs\n");
+    else
+        closedir(dir);
+}
@@ -0,0 +1,48 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <tmd.h>
+
+// Synthetic NUS files for the host tests, see tests/fixtures.c
+
+typedef struct
+{
+    uint64_t size;
+    uint8_t hash; // Fills the whole hash
+    bool hashed;
+} CONTENT_DESC;
+
+// Title key the tickets from buildTicket() decrypt to
+extern const uint8_t fixtureTitleKey[16];
+
+TMD *buildTmd(uint64_t tid, uint16_t version, const CONTENT_DESC *desc, uint16_t count, size_t *size);
+void sealTmd(TMD *tmd);
+void *buildTicket(uint64_t tid, size_t *size);
+void *buildCert(size_t *size);
+void writeEncryptedContent(const char *dir, TMD *tmd, uint16_t i);
+
+void makeHostDirs(const char *path);
+void writeHostFile(const char *path, const void *data, size_t size);
+bool sameHostFile(const char *a, const char *b);
+void mountHostRomfs();
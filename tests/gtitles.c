@@ -0,0 +1,99 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gtitles.h>
+#include <titles.h>
+
+/*
+ * Synthetic stand-in for the title database the build downloads. The
+ * sizes are about those of the real one. Entries are in name order like
+ * there, so the title IDs are unsorted. Every 97th game has a second
+ * entry with the same title ID, like regional duplicates in the real data.
+ */
+
+#define GAMES   3200
+#define UPDATES 2600
+#define DLCS    1700
+#define DEMOS   350
+#define DISCS   1900
+
+static TitleEntry *entries[TITLE_CATEGORY_DISC + 1];
+static size_t sizes[TITLE_CATEGORY_DISC + 1];
+
+// Spreads the IDs, so name order and title ID order differ
+static uint32_t scramble(uint32_t i)
+{
+    return (i * 2654435761u) >> 12;
+}
+
+static void addEntry(TITLE_CATEGORY cat, uint32_t high, uint32_t low, uint32_t n)
+{
+    char *name = malloc(32);
+    sprintf(name, "Title %05u", n);
+    TitleEntry entry = {
+        .name = name,
+        .tid = (uint64_t)high << 32 | low,
+        .region = MCP_REGION_EUROPE,
+        .key = n % (TITLE_KEY_MAGIC + 1),
+    };
+
+    memcpy(entries[cat] + sizes[cat]++, &entry, sizeof(TitleEntry));
+    memcpy(entries[TITLE_CATEGORY_ALL] + sizes[TITLE_CATEGORY_ALL]++, &entry, sizeof(TitleEntry));
+}
+
+__attribute__((constructor)) static void buildTitleDB()
+{
+    const size_t counts[] = { GAMES + (GAMES + 96) / 97, UPDATES, DLCS, DEMOS, 0, DISCS };
+    size_t all = 0;
+    for(int cat = 0; cat <= TITLE_CATEGORY_DISC; ++cat)
+        all += counts[cat];
+
+    for(int cat = 0; cat <= TITLE_CATEGORY_DISC; ++cat)
+        entries[cat] = malloc((cat == TITLE_CATEGORY_ALL ? all : counts[cat]) * sizeof(TitleEntry));
+
+    uint32_t n = 0;
+    for(uint32_t i = 0; i < GAMES; ++i, ++n)
+    {
+        addEntry(TITLE_CATEGORY_GAME, TID_HIGH_GAME, 0x10000000 | scramble(i), n);
+        if(i % 97 == 0)
+            addEntry(TITLE_CATEGORY_GAME, TID_HIGH_GAME, 0x10000000 | scramble(i), ++n);
+    }
+    for(uint32_t i = 0; i < UPDATES; ++i, ++n)
+        addEntry(TITLE_CATEGORY_UPDATE, TID_HIGH_UPDATE, 0x10000000 | scramble(i), n);
+    for(uint32_t i = 0; i < DLCS; ++i, ++n)
+        addEntry(TITLE_CATEGORY_DLC, TID_HIGH_DLC, 0x10000000 | scramble(i), n);
+    for(uint32_t i = 0; i < DEMOS; ++i, ++n)
+        addEntry(TITLE_CATEGORY_DEMO, TID_HIGH_DEMO, 0x10000000 | scramble(i), n);
+    // Disc titles use the game ID range, but none of the IDs above
+    for(uint32_t i = 0; i < DISCS; ++i, ++n)
+        addEntry(TITLE_CATEGORY_DISC, TID_HIGH_GAME, 0x18000000 | scramble(i), n);
+}
+
+const TitleEntry *getTitleEntries(TITLE_CATEGORY cat)
+{
+    return entries[cat];
+}
+
+size_t getTitleEntriesSize(TITLE_CATEGORY cat)
+{
+    return sizes[cat];
+}
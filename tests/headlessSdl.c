@@ -0,0 +1,633 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_mixer.h>
+#include <SDL_FontCache.h>
+
+#include <gx2/event.h>
+
+#include "headlessSdl.h"
+#include "test.h"
+
+/*
+ * Runs src/renderer.c without a GPU: Nothing gets rasterised, the calls
+ * only get counted. Textures and surfaces keep their size, so layout code
+ * and the icon atlas work as on the console. GX2WaitForVsync() returns at
+ * once, the benchmarks measure the CPU side of building a frame. Benchmarks
+ * of whole UI loops turn on setHeadlessVsync() to get the 60 Hz of the TV.
+ */
+
+#define FC_BUFFER_SIZE 4096
+#define CODEPOINTS     0x110000
+#define VSYNC_INTERVAL (1000000000ull / 60) // Nanoseconds
+
+struct SDL_Texture
+{
+    int w;
+    int h;
+};
+
+struct SDL_RWops
+{
+    const uint8_t *mem;
+    size_t size;
+};
+
+struct FC_Font
+{
+    uint8_t cached[CODEPOINTS / 8];
+    int size;
+    SDL_Texture cache; // Stands in for the glyph cache textures
+};
+
+// Never dereferenced
+static int theWindow;
+static int theRenderer;
+
+static HEADLESS_STATS stats;
+static bool vsync = false;
+static int liveTextures = 0;
+static SDL_Texture *boundTexture = NULL;
+static SDL_Texture *lastCopyTexture = NULL;
+static SDL_Rect lastCopySrc;
+static SDL_Rect lastCopyDst;
+static char fcBuffer[FC_BUFFER_SIZE];
+static bool ttfInit = false;
+
+void getHeadlessStats(HEADLESS_STATS *out)
+{
+    *out = stats;
+}
+
+void resetHeadlessStats()
+{
+    memset(&stats, 0x00, sizeof(stats));
+    boundTexture = NULL;
+}
+
+int getLiveTextures()
+{
+    return liveTextures;
+}
+
+void getLastCopy(SDL_Texture **tex, SDL_Rect *src, SDL_Rect *dst)
+{
+    *tex = lastCopyTexture;
+    *src = lastCopySrc;
+    *dst = lastCopyDst;
+}
+
+static void bindTexture(SDL_Texture *tex)
+{
+    if(tex != boundTexture)
+    {
+        ++stats.textureSwitches;
+        boundTexture = tex;
+    }
+}
+
+/*
+ * SDL2
+ */
+int SDL_Init(Uint32 flags)
+{
+    return 0;
+}
+
+void SDL_QuitSubSystem(Uint32 flags)
+{
+}
+
+void SDL_Quit()
+{
+}
+
+const char *SDL_GetError()
+{
+    return "Headless";
+}
+
+SDL_bool SDL_SetHint(const char *name, const char *value)
+{
+    return SDL_TRUE;
+}
+
+SDL_Window *SDL_CreateWindow(const char *title, int x, int y, int w, int h, Uint32 flags)
+{
+    return (SDL_Window *)&theWindow;
+}
+
+void SDL_DestroyWindow(SDL_Window *window)
+{
+}
+
+Uint32 SDL_GetWindowPixelFormat(SDL_Window *window)
+{
+    return SDL_PIXELFORMAT_RGBA8888;
+}
+
+SDL_Renderer *SDL_CreateRenderer(SDL_Window *window, int index, Uint32 flags)
+{
+    return (SDL_Renderer *)&theRenderer;
+}
+
+void SDL_DestroyRenderer(SDL_Renderer *renderer)
+{
+}
+
+int SDL_SetRenderTarget(SDL_Renderer *renderer, SDL_Texture *texture)
+{
+    return 0;
+}
+
+int SDL_SetRenderDrawColor(SDL_Renderer *renderer, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    return 0;
+}
+
+int SDL_SetRenderDrawBlendMode(SDL_Renderer *renderer, SDL_BlendMode blendMode)
+{
+    return 0;
+}
+
+int SDL_RenderClear(SDL_Renderer *renderer)
+{
+    ++stats.drawCalls;
+    return 0;
+}
+
+int SDL_RenderDrawPoint(SDL_Renderer *renderer, int x, int y)
+{
+    ++stats.drawCalls;
+    return 0;
+}
+
+int SDL_RenderFillRect(SDL_Renderer *renderer, const SDL_Rect *rect)
+{
+    return SDL_RenderFillRects(renderer, rect, 1);
+}
+
+int SDL_RenderFillRects(SDL_Renderer *renderer, const SDL_Rect *rects, int count)
+{
+    ++stats.drawCalls;
+    ++stats.fills;
+    stats.rects += count;
+    return 0;
+}
+
+int SDL_RenderCopy(SDL_Renderer *renderer, SDL_Texture *texture, const SDL_Rect *srcrect, const SDL_Rect *dstrect)
+{
+    ++stats.drawCalls;
+    ++stats.copies;
+    bindTexture(texture);
+
+    lastCopyTexture = texture;
+    if(srcrect == NULL)
+        lastCopySrc = (SDL_Rect) { .w = texture->w, .h = texture->h };
+    else
+        lastCopySrc = *srcrect;
+    if(dstrect == NULL)
+        lastCopyDst = (SDL_Rect) { .w = 1280, .h = 720 };
+    else
+        lastCopyDst = *dstrect;
+
+    return 0;
+}
+
+void SDL_RenderPresent(SDL_Renderer *renderer)
+{
+    ++stats.presents;
+}
+
+SDL_Texture *SDL_CreateTexture(SDL_Renderer *renderer, Uint32 format, int access, int w, int h)
+{
+    SDL_Texture *ret = malloc(sizeof(SDL_Texture));
+    if(ret != NULL)
+    {
+        ret->w = w;
+        ret->h = h;
+        ++stats.texturesCreated;
+        ++liveTextures;
+    }
+
+    return ret;
+}
+
+SDL_Texture *SDL_CreateTextureFromSurface(SDL_Renderer *renderer, SDL_Surface *surface)
+{
+    return SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, surface->w, surface->h);
+}
+
+void SDL_DestroyTexture(SDL_Texture *texture)
+{
+    if(texture == NULL)
+        return;
+
+    if(texture == boundTexture)
+        boundTexture = NULL;
+
+    --liveTextures;
+    free(texture);
+}
+
+int SDL_QueryTexture(SDL_Texture *texture, Uint32 *format, int *access, int *w, int *h)
+{
+    if(format != NULL)
+        *format = SDL_PIXELFORMAT_RGBA8888;
+    if(access != NULL)
+        *access = SDL_TEXTUREACCESS_STATIC;
+    if(w != NULL)
+        *w = texture->w;
+    if(h != NULL)
+        *h = texture->h;
+
+    return 0;
+}
+
+int SDL_SetTextureBlendMode(SDL_Texture *texture, SDL_BlendMode blendMode)
+{
+    return 0;
+}
+
+SDL_Surface *SDL_CreateRGBSurfaceWithFormat(Uint32 flags, int width, int height, int depth, Uint32 format)
+{
+    SDL_Surface *ret = malloc(sizeof(SDL_Surface));
+    if(ret != NULL)
+    {
+        ret->w = width;
+        ret->h = height;
+        ret->blend = SDL_TRUE;
+        ++stats.surfacesCreated;
+    }
+
+    return ret;
+}
+
+void SDL_FreeSurface(SDL_Surface *surface)
+{
+    free(surface);
+}
+
+int SDL_SetSurfaceBlendMode(SDL_Surface *surface, SDL_BlendMode blendMode)
+{
+    surface->blend = blendMode != SDL_BLENDMODE_NONE;
+    return 0;
+}
+
+// Like SDL the destination rect gets clipped to the surface
+int SDL_BlitSurface(SDL_Surface *src, const SDL_Rect *srcrect, SDL_Surface *dst, SDL_Rect *dstrect)
+{
+    if(dstrect == NULL)
+        return 0;
+
+    int w = srcrect == NULL ? src->w : srcrect->w;
+    int h = srcrect == NULL ? src->h : srcrect->h;
+    if(dstrect->x + w > dst->w)
+        w = dst->w - dstrect->x;
+    if(dstrect->y + h > dst->h)
+        h = dst->h - dstrect->y;
+
+    dstrect->w = w < 0 ? 0 : w;
+    dstrect->h = h < 0 ? 0 : h;
+    return 0;
+}
+
+SDL_RWops *SDL_RWFromMem(void *mem, int size)
+{
+    return SDL_RWFromConstMem(mem, size);
+}
+
+SDL_RWops *SDL_RWFromConstMem(const void *mem, int size)
+{
+    SDL_RWops *ret = malloc(sizeof(SDL_RWops));
+    if(ret != NULL)
+    {
+        ret->mem = mem;
+        ret->size = size;
+    }
+
+    return ret;
+}
+
+int SDL_RWclose(SDL_RWops *context)
+{
+    free(context);
+    return 0;
+}
+
+/*
+ * SDL2_image: Only the size from the IHDR chunk
+ */
+static uint32_t readBE32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+SDL_Surface *IMG_Load_RW(SDL_RWops *src, int freesrc)
+{
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    SDL_Surface *ret = NULL;
+    if(src->size >= 24 && memcmp(src->mem, signature, sizeof(signature)) == 0 && memcmp(src->mem + 12, "IHDR", 4) == 0)
+        ret = SDL_CreateRGBSurfaceWithFormat(0, readBE32(src->mem + 16), readBE32(src->mem + 20), 32, SDL_PIXELFORMAT_RGBA8888);
+
+    if(freesrc)
+        SDL_RWclose(src);
+
+    return ret;
+}
+
+/*
+ * SDL2_mixer
+ */
+int Mix_Init(int flags)
+{
+    return 0;
+}
+
+int Mix_OpenAudio(int frequency, Uint16 format, int channels, int chunksize)
+{
+    return -1;
+}
+
+void Mix_CloseAudio()
+{
+}
+
+Mix_Music *Mix_LoadMUS_RW(SDL_RWops *src, int freesrc)
+{
+    if(freesrc)
+        SDL_RWclose(src);
+
+    return NULL;
+}
+
+void Mix_FreeMusic(Mix_Music *music)
+{
+}
+
+int Mix_PlayMusic(Mix_Music *music, int loops)
+{
+    return -1;
+}
+
+int Mix_HaltMusic()
+{
+    return 0;
+}
+
+int Mix_VolumeMusic(int volume)
+{
+    return volume;
+}
+
+/*
+ * SDL2_ttf and SDL_FontCache
+ */
+int TTF_Init()
+{
+    ttfInit = true;
+    return 0;
+}
+
+void TTF_Quit()
+{
+    ttfInit = false;
+}
+
+int TTF_WasInit()
+{
+    return ttfInit;
+}
+
+FC_Font *FC_CreateFont()
+{
+    return calloc(1, sizeof(FC_Font));
+}
+
+Uint8 FC_LoadFont_RW(FC_Font *font, SDL_Renderer *renderer, SDL_RWops *file_rwops_ttf, Uint8 own_rwops, Uint32 pointSize, SDL_Color color, int style)
+{
+    font->size = pointSize;
+    font->cache.w = font->cache.h = 1024;
+    for(uint32_t c = ' '; c <= '~'; ++c)
+        font->cached[c >> 3] |= 1 << (c & 7);
+
+    if(own_rwops)
+        SDL_RWclose(file_rwops_ttf);
+
+    return 1;
+}
+
+void FC_FreeFont(FC_Font *font)
+{
+    free(font);
+}
+
+static const char *nextCodepoint(const char *str, uint32_t *cp)
+{
+    const uint8_t *s = (const uint8_t *)str;
+    int more;
+    if(*s < 0x80)
+    {
+        *cp = *s;
+        more = 0;
+    }
+    else if(*s >= 0xF0)
+    {
+        *cp = *s & 0x07;
+        more = 3;
+    }
+    else if(*s >= 0xE0)
+    {
+        *cp = *s & 0x0F;
+        more = 2;
+    }
+    else
+    {
+        *cp = *s & 0x1F;
+        more = 1;
+    }
+
+    ++s;
+    while(more-- && (*s & 0xC0) == 0x80)
+        *cp = (*cp << 6) | (*s++ & 0x3F);
+
+    if(*cp >= CODEPOINTS)
+        *cp = '?';
+
+    return (const char *)s;
+}
+
+// Half width for latin and the like, full width for CJK
+static int glyphAdvance(FC_Font *font, uint32_t cp)
+{
+    ++stats.glyphs;
+    if(!(font->cached[cp >> 3] & (1 << (cp & 7))))
+    {
+        ++stats.glyphMisses;
+        font->cached[cp >> 3] |= 1 << (cp & 7);
+    }
+
+    return cp >= 0x1100 ? font->size : font->size >> 1;
+}
+
+Uint8 FC_GetGlyphData(FC_Font *font, FC_GlyphData *result, Uint32 codepoint)
+{
+    result->rect.x = result->rect.y = 0;
+    result->rect.w = glyphAdvance(font, codepoint);
+    result->rect.h = font->size;
+    result->cache_level = 0;
+    return 1;
+}
+
+static const char *format(const char *fmt, va_list va)
+{
+    vsnprintf(fcBuffer, FC_BUFFER_SIZE, fmt, va);
+    return fcBuffer;
+}
+
+// Width of the widest line
+static int textWidth(FC_Font *font, const char *text, int *lines)
+{
+    int w = 0;
+    int max = 0;
+    uint32_t cp;
+    *lines = 1;
+    while(*text != '\0')
+    {
+        text = nextCodepoint(text, &cp);
+        if(cp == '\n')
+        {
+            ++*lines;
+            w = 0;
+            continue;
+        }
+
+        w += glyphAdvance(font, cp);
+        if(w > max)
+            max = w;
+    }
+
+    return max;
+}
+
+Uint16 FC_GetWidth(FC_Font *font, const char *formatted_text, ...)
+{
+    va_list va;
+    va_start(va, formatted_text);
+    const char *text = format(formatted_text, va);
+    va_end(va);
+
+    int lines;
+    return textWidth(font, text, &lines);
+}
+
+Uint16 FC_GetColumnHeight(FC_Font *font, Uint16 width, const char *formatted_text, ...)
+{
+    va_list va;
+    va_start(va, formatted_text);
+    const char *text = format(formatted_text, va);
+    va_end(va);
+
+    int lines;
+    int w = textWidth(font, text, &lines);
+    if(width != 0 && w > width)
+        lines += w / width;
+
+    return lines * font->size;
+}
+
+static SDL_Rect drawText(FC_Font *font, float x, float y, const char *text)
+{
+    ++stats.drawCalls;
+    ++stats.texts;
+    bindTexture(&font->cache);
+
+    int lines;
+    SDL_Rect ret = { .x = x, .y = y };
+    ret.w = textWidth(font, text, &lines);
+    ret.h = lines * font->size;
+    return ret;
+}
+
+SDL_Rect FC_Draw(FC_Font *font, SDL_Renderer *dest, float x, float y, const char *formatted_text, ...)
+{
+    va_list va;
+    va_start(va, formatted_text);
+    const char *text = format(formatted_text, va);
+    va_end(va);
+
+    return drawText(font, x, y, text);
+}
+
+SDL_Rect FC_DrawColor(FC_Font *font, SDL_Renderer *dest, float x, float y, SDL_Color color, const char *formatted_text, ...)
+{
+    va_list va;
+    va_start(va, formatted_text);
+    const char *text = format(formatted_text, va);
+    va_end(va);
+
+    return drawText(font, x, y, text);
+}
+
+SDL_Rect FC_DrawBox(FC_Font *font, SDL_Renderer *dest, SDL_Rect box, const char *formatted_text, ...)
+{
+    va_list va;
+    va_start(va, formatted_text);
+    const char *text = format(formatted_text, va);
+    va_end(va);
+
+    return drawText(font, box.x, box.y, text);
+}
+
+/*
+ * GX2
+ */
+void GX2WaitForVsync()
+{
+    ++stats.vsyncs;
+    if(!vsync)
+        return;
+
+    // Next 60 Hz tick of the monotonic clock
+    uint64_t now = testNow();
+    uint64_t next = (now / VSYNC_INTERVAL + 1) * VSYNC_INTERVAL;
+    struct timespec ts = { .tv_sec = (next - now) / 1000000000ull, .tv_nsec = (next - now) % 1000000000ull };
+    nanosleep(&ts, NULL);
+}
+
+void setHeadlessVsync(bool wait)
+{
+    vsync = wait;
+}
+
+void GX2SetTVGamma(float gamma)
+{
+}
+
+void GX2SetDRCGamma(float gamma)
+{
+}
@@ -0,0 +1,48 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <SDL2/SDL.h>
+
+// Headless SDL2 / SDL_FontCache / GX2 for the renderer tests, see tests/headlessSdl.c
+
+typedef struct
+{
+    uint32_t drawCalls; // Clears, fills, copies and text runs
+    uint32_t fills;
+    uint32_t rects; // Rectangles submitted by the fills
+    uint32_t copies;
+    uint32_t texts;
+    uint32_t textureSwitches; // Draws sampling another texture than the draw before
+    uint32_t glyphs; // Glyph lookups, for drawing and for measuring
+    uint32_t glyphMisses; // Glyphs rasterised into the cache on first use
+    uint32_t texturesCreated;
+    uint32_t surfacesCreated;
+    uint32_t presents;
+    uint32_t vsyncs;
+} HEADLESS_STATS;
+
+void getHeadlessStats(HEADLESS_STATS *out);
+void resetHeadlessStats();
+void setHeadlessVsync(bool wait); // Wait for the next 60 Hz tick in GX2WaitForVsync()
+int getLiveTextures();
+void getLastCopy(SDL_Texture **tex, SDL_Rect *src, SDL_Rect *dst);
@@ -0,0 +1,705 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+/*
+ * Host implementation of the Wii U system functions the platform independent
+ * parts of NUSspli use. FSA paths are plain host paths, threads are pthreads
+ * and the three CPU cores are faked: Every thread gets the core its affinity
+ * asks for and OSDisableInterrupts() locks that core, so only one thread per
+ * core runs code that relies on interrupts being off.
+ * Console paths ("/vol/...") get moved below the temp folder created by
+ * hostMakeRoot(), so tests can build synthetic SD cards.
+ */
+
+#include <wut-fixups.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <coreinit/core.h>
+#include <coreinit/filesystem_fsa.h>
+#include <coreinit/interrupts.h>
+#include <coreinit/memdefaultheap.h>
+#include <coreinit/thread.h>
+#include <coreinit/time.h>
+#include <coreinit/title.h>
+#include <nn/ac/ac_c.h>
+#include <nsysnet/_socket.h>
+#include <nsysnet/misc.h>
+#include <nsysnet/netconfig.h>
+
+#define HOST_CORES   3
+#define HOST_HANDLES 256
+
+static volatile uint64_t heapAllocations = 0;
+
+uint64_t hostHeapAllocations()
+{
+    return heapAllocations;
+}
+
+void *MEMAllocFromDefaultHeap(uint32_t size)
+{
+    __atomic_add_fetch(&heapAllocations, 1, __ATOMIC_RELAXED);
+    return malloc(size);
+}
+
+void *MEMAllocFromDefaultHeapEx(uint32_t size, int32_t alignment)
+{
+    if(alignment < 0)
+        alignment = -alignment;
+    if(alignment < (int32_t)sizeof(void *))
+        alignment = sizeof(void *);
+
+    __atomic_add_fetch(&heapAllocations, 1, __ATOMIC_RELAXED);
+    void *ret;
+    return posix_memalign(&ret, alignment, size) == 0 ? ret : NULL;
+}
+
+void MEMFreeToDefaultHeap(void *block)
+{
+    free(block);
+}
+
+/*
+ * Time
+ */
+static OSTime hostNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (OSTime)ts.tv_sec * OSTimerClockSpeed + ((OSTime)ts.tv_nsec * OSTimerClockSpeed) / 1000000000;
+}
+
+OSTime OSGetTime()
+{
+    return hostNow();
+}
+
+OSTime OSGetSystemTime()
+{
+    return hostNow();
+}
+
+OSTick OSGetTick()
+{
+    return (OSTick)hostNow();
+}
+
+OSTick OSGetSystemTick()
+{
+    return (OSTick)hostNow();
+}
+
+void OSTicksToCalendarTime(OSTime time, OSCalendarTime *calendarTime)
+{
+    time_t secs = OSTicksToSeconds(time);
+    struct tm tm;
+    gmtime_r(&secs, &tm);
+    calendarTime->tm_sec = tm.tm_sec;
+    calendarTime->tm_min = tm.tm_min;
+    calendarTime->tm_hour = tm.tm_hour;
+    calendarTime->tm_mday = tm.tm_mday;
+    calendarTime->tm_mon = tm.tm_mon;
+    calendarTime->tm_year = tm.tm_year + 1900;
+    calendarTime->tm_wday = tm.tm_wday;
+    calendarTime->tm_yday = tm.tm_yday;
+    calendarTime->tm_msec = OSTicksToMilliseconds(time) % 1000;
+    calendarTime->tm_usec = OSTicksToMicroseconds(time) % 1000;
+}
+
+/*
+ * Cores and threads
+ */
+static pthread_mutex_t coreLocks[HOST_CORES] = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER };
+static OSThread mainThread = { .name = "main", .core = 1 };
+static __thread OSThread *currentThread = NULL;
+static __thread BOOL interruptsOff = FALSE;
+static volatile uint32_t threadIds = 1;
+static volatile uint32_t unjoinedThreads = 0;
+
+uint32_t OSGetCoreId()
+{
+    return OSGetCurrentThread()->core;
+}
+
+uint32_t OSGetCoreCount()
+{
+    return HOST_CORES;
+}
+
+uint32_t OSGetMainCoreId()
+{
+    return 1;
+}
+
+BOOL OSDisableInterrupts()
+{
+    if(interruptsOff)
+        return FALSE;
+
+    pthread_mutex_lock(coreLocks + OSGetCoreId());
+    interruptsOff = TRUE;
+    return TRUE;
+}
+
+BOOL OSRestoreInterrupts(BOOL enable)
+{
+    BOOL ret = !interruptsOff;
+    if(enable && interruptsOff)
+    {
+        interruptsOff = FALSE;
+        pthread_mutex_unlock(coreLocks + OSGetCoreId());
+    }
+
+    return ret;
+}
+
+OSThread *OSGetCurrentThread()
+{
+    return currentThread == NULL ? &mainThread : currentThread;
+}
+
+static void *hostThreadMain(void *arg)
+{
+    OSThread *thread = arg;
+    currentThread = thread;
+    thread->result = thread->entry(thread->argc, thread->argv);
+    thread->terminated = TRUE;
+    return NULL;
+}
+
+BOOL OSCreateThread(OSThread *thread, OSThreadEntryPointFn entry, int32_t argc, char *argv, void *stack, uint32_t stackSize, int32_t priority, OSThreadAttributes attributes)
+{
+    (void)priority;
+
+    thread->name = NULL;
+    thread->id = __atomic_add_fetch(&threadIds, 1, __ATOMIC_SEQ_CST);
+    thread->stackStart = stack;
+    thread->stackEnd = (uint8_t *)stack - stackSize;
+    thread->entry = entry;
+    thread->argc = argc;
+    thread->argv = (const char **)argv;
+    thread->result = 0;
+    thread->terminated = FALSE;
+
+    thread->core = 1;
+    for(uint32_t i = 0; i < HOST_CORES; ++i)
+    {
+        if(attributes & (1 << i))
+        {
+            thread->core = i;
+            break;
+        }
+    }
+
+    return TRUE;
+}
+
+uint32_t hostUnjoinedThreads()
+{
+    return __atomic_load_n(&unjoinedThreads, __ATOMIC_SEQ_CST);
+}
+
+int32_t OSResumeThread(OSThread *thread)
+{
+    if(pthread_create(&thread->handle, NULL, hostThreadMain, thread) != 0)
+        return 0;
+
+    __atomic_add_fetch(&unjoinedThreads, 1, __ATOMIC_SEQ_CST);
+    return 1;
+}
+
+BOOL OSJoinThread(OSThread *thread, int *threadResult)
+{
+    if(pthread_join(thread->handle, NULL) != 0)
+        return FALSE;
+
+    __atomic_sub_fetch(&unjoinedThreads, 1, __ATOMIC_SEQ_CST);
+    if(threadResult != NULL)
+        *threadResult = thread->result;
+
+    return TRUE;
+}
+
+void OSDetachThread(OSThread *thread)
+{
+    (void)thread;
+}
+
+BOOL OSIsThreadTerminated(OSThread *thread)
+{
+    return thread->terminated;
+}
+
+void OSSetThreadName(OSThread *thread, const char *name)
+{
+    thread->name = name;
+}
+
+BOOL OSSetThreadPriority(OSThread *thread, int32_t priority)
+{
+    (void)thread;
+    (void)priority;
+    return TRUE;
+}
+
+BOOL OSSetThreadStackUsage(OSThread *thread)
+{
+    (void)thread;
+    return TRUE;
+}
+
+int32_t OSCheckThreadStackUsage(OSThread *thread)
+{
+    (void)thread;
+    return 0;
+}
+
+int32_t OSCheckActiveThreads()
+{
+    return 1;
+}
+
+void OSSleepTicks(OSTime ticks)
+{
+    struct timespec ts = {
+        .tv_sec = OSTicksToSeconds(ticks),
+        .tv_nsec = (OSTicksToMicroseconds(ticks) % 1000000) * 1000,
+    };
+
+    if(ts.tv_sec == 0 && ts.tv_nsec == 0)
+        sched_yield();
+    else
+        nanosleep(&ts, NULL);
+}
+
+/*
+ * FSA
+ */
+typedef struct
+{
+    FILE *file;
+    DIR *dir;
+    char path[FS_MAX_PATH * 2];
+} HOST_HANDLE;
+
+static HOST_HANDLE handles[HOST_HANDLES];
+static pthread_mutex_t handleLock = PTHREAD_MUTEX_INITIALIZER;
+static char hostRoot[FS_MAX_PATH] = "";
+
+const char *hostMakeRoot()
+{
+    strcpy(hostRoot, "/tmp/nusspli-test-XXXXXX");
+    if(mkdtemp(hostRoot) == NULL)
+    {
+        perror("mkdtemp");
+        exit(1);
+    }
+
+    return hostRoot;
+}
+
+const char *hostGetRoot()
+{
+    return hostRoot;
+}
+
+void hostRemoveRoot()
+{
+    if(hostRoot[0] == '\0')
+        return;
+
+    char cmd[FS_MAX_PATH + 16];
+    snprintf(cmd, sizeof(cmd), "rm -rf '%s'", hostRoot);
+    if(system(cmd) != 0)
+        fprintf(stderr, "Can't remove %s\n", hostRoot);
+
+    hostRoot[0] = '\0';
+}
+
+static const char *hostPath(const char *path, char *out)
+{
+    if(hostRoot[0] == '\0' || strncmp(path, "/vol/", 5) != 0)
+        return path;
+
+    snprintf(out, FS_MAX_PATH * 2, "%s%s", hostRoot, path);
+    return out;
+}
+
+static FSError translateErrno()
+{
+    switch(errno)
+    {
+        case ENOENT:
+            return FS_ERROR_NOT_FOUND;
+        case EEXIST:
+            return FS_ERROR_ALREADY_EXISTS;
+        case ENOTDIR:
+            return FS_ERROR_NOT_DIR;
+        case EISDIR:
+            return FS_ERROR_NOT_FILE;
+        case ENOTEMPTY:
+            return FS_ERROR_NOT_EMPTY;
+        case EACCES:
+        case EPERM:
+            return FS_ERROR_PERMISSION_ERROR;
+        case ENOSPC:
+            return FS_ERROR_STORAGE_FULL;
+        case EROFS:
+            return FS_ERROR_WRITE_PROTECTED;
+        default:
+            return FS_ERROR_MEDIA_ERROR;
+    }
+}
+
+static int32_t newHandle(FILE *file, DIR *dir, const char *path)
+{
+    pthread_mutex_lock(&handleLock);
+    for(int32_t i = 1; i < HOST_HANDLES; ++i)
+    {
+        if(handles[i].file == NULL && handles[i].dir == NULL)
+        {
+            handles[i].file = file;
+            handles[i].dir = dir;
+            snprintf(handles[i].path, sizeof(handles[i].path), "%s", path);
+            pthread_mutex_unlock(&handleLock);
+            return i;
+        }
+    }
+
+    pthread_mutex_unlock(&handleLock);
+    return 0;
+}
+
+static void fillStat(const struct stat *st, FSAStat *stat)
+{
+    memset(stat, 0, sizeof(FSAStat));
+    stat->flags = S_ISDIR(st->st_mode) ? FS_STAT_DIRECTORY : FS_STAT_FILE;
+    stat->mode = st->st_mode & 0777;
+    stat->size = st->st_size;
+    stat->allocSize = st->st_blocks * 512;
+}
+
+FSError FSAOpenFileEx(FSAClientHandle client, const char *path, const char *mode, uint32_t createMode, FSOpenFileFlags openFlag, uint32_t preallocSize, FSAFileHandle *outFileHandle)
+{
+    (void)client;
+    (void)createMode;
+    (void)openFlag;
+    (void)preallocSize;
+
+    char m[4];
+    char buf[FS_MAX_PATH * 2];
+    snprintf(m, sizeof(m), "%sb", mode);
+    FILE *f = fopen(hostPath(path, buf), m);
+    if(f == NULL)
+        return translateErrno();
+
+    *outFileHandle = newHandle(f, NULL, path);
+    if(*outFileHandle == 0)
+    {
+        fclose(f);
+        return FS_ERROR_MAX_MOUNT_POINTS;
+    }
+
+    return FS_ERROR_OK;
+}
+
+FSError FSACloseFile(FSAClientHandle client, FSAFileHandle fileHandle)
+{
+    (void)client;
+    if(fileHandle <= 0 || fileHandle >= HOST_HANDLES || handles[fileHandle].file == NULL)
+        return FS_ERROR_INVALID_PARAM;
+
+    fclose(handles[fileHandle].file);
+    handles[fileHandle].file = NULL;
+    return FS_ERROR_OK;
+}
+
+FSError FSAReadFile(FSAClientHandle client, void *buffer, uint32_t size, uint32_t count, FSAFileHandle handle, uint32_t flags)
+{
+    (void)client;
+    (void)flags;
+    return (FSError)fread(buffer, size, count, handles[handle].file);
+}
+
+FSError FSAReadFileWithPos(FSAClientHandle client, void *buffer, uint32_t size, uint32_t count, uint32_t pos, FSAFileHandle handle, uint32_t flags)
+{
+    if(fseek(handles[handle].file, pos, SEEK_SET) != 0)
+        return translateErrno();
+
+    return FSAReadFile(client, buffer, size, count, handle, flags);
+}
+
+FSError FSAWriteFile(FSAClientHandle client, const void *buffer, uint32_t size, uint32_t count, FSAFileHandle handle, uint32_t flags)
+{
+    (void)client;
+    (void)flags;
+    return (FSError)fwrite(buffer, size, count, handles[handle].file);
+}
+
+FSError FSAFlushFile(FSAClientHandle client, FSAFileHandle handle)
+{
+    (void)client;
+    fflush(handles[handle].file);
+    return FS_ERROR_OK;
+}
+
+FSError FSAGetStatFile(FSAClientHandle client, FSAFileHandle handle, FSAStat *stat)
+{
+    (void)client;
+    struct stat st;
+    fflush(handles[handle].file);
+    if(fstat(fileno(handles[handle].file), &st) != 0)
+        return translateErrno();
+
+    fillStat(&st, stat);
+    return FS_ERROR_OK;
+}
+
+FSError FSAGetStat(FSAClientHandle client, const char *path, FSAStat *stat)
+{
+    (void)client;
+    char buf[FS_MAX_PATH * 2];
+    struct stat st;
+    if(lstat(hostPath(path, buf), &st) != 0)
+        return translateErrno();
+
+    fillStat(&st, stat);
+    return FS_ERROR_OK;
+}
+
+FSError FSAOpenDir(FSAClientHandle client, const char *path, FSADirectoryHandle *dirHandle)
+{
+    (void)client;
+    char buf[FS_MAX_PATH * 2];
+    path = hostPath(path, buf);
+    DIR *dir = opendir(path);
+    if(dir == NULL)
+        return translateErrno();
+
+    *dirHandle = newHandle(NULL, dir, path);
+    if(*dirHandle == 0)
+    {
+        closedir(dir);
+        return FS_ERROR_MAX_MOUNT_POINTS;
+    }
+
+    return FS_ERROR_OK;
+}
+
+FSError FSAReadDir(FSAClientHandle client, FSADirectoryHandle dirHandle, FSADirectoryEntry *directoryEntry)
+{
+    (void)client;
+    HOST_HANDLE *handle = handles + dirHandle;
+    struct dirent *entry;
+    char path[FS_MAX_PATH * 3];
+    struct stat st;
+    while((entry = readdir(handle->dir)) != NULL)
+    {
+        if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+            continue;
+
+        snprintf(path, sizeof(path), "%s/%s", handle->path, entry->d_name);
+        if(stat(path, &st) != 0)
+            continue;
+
+        fillStat(&st, &directoryEntry->info);
+        snprintf(directoryEntry->name, sizeof(directoryEntry->name), "%s", entry->d_name);
+        return FS_ERROR_OK;
+    }
+
+    return FS_ERROR_END_OF_DIR;
+}
+
+FSError FSACloseDir(FSAClientHandle client, FSADirectoryHandle dirHandle)
+{
+    (void)client;
+    if(dirHandle <= 0 || dirHandle >= HOST_HANDLES || handles[dirHandle].dir == NULL)
+        return FS_ERROR_INVALID_PARAM;
+
+    closedir(handles[dirHandle].dir);
+    handles[dirHandle].dir = NULL;
+    return FS_ERROR_OK;
+}
+
+const char *FSAGetStatusStr(FSError error)
+{
+    switch(error)
+    {
+        case FS_ERROR_OK:
+            return "OK";
+        case FS_ERROR_NOT_FOUND:
+            return "NOT_FOUND";
+        case FS_ERROR_ALREADY_EXISTS:
+            return "ALREADY_EXISTS";
+        default:
+            return "ERROR";
+    }
+}
+
+FSError FSAMakeDir(FSAClientHandle client, const char *path, uint32_t mode)
+{
+    (void)client;
+    (void)mode;
+    char buf[FS_MAX_PATH * 2];
+    return mkdir(hostPath(path, buf), 0755) == 0 ? FS_ERROR_OK : translateErrno();
+}
+
+FSError FSARemove(FSAClientHandle client, const char *path)
+{
+    (void)client;
+    char buf[FS_MAX_PATH * 2];
+    return remove(hostPath(path, buf)) == 0 ? FS_ERROR_OK : translateErrno();
+}
+
+// Renames left before the process dies, -1 for never
+static int renamesToCrash = -1;
+
+void hostCrashAfterRenames(int renames)
+{
+    renamesToCrash = renames;
+}
+
+FSError FSARename(FSAClientHandle client, const char *oldPath, const char *newPath)
+{
+    (void)client;
+    if(renamesToCrash >= 0 && renamesToCrash-- == 0)
+        _exit(3);
+
+    char buf[FS_MAX_PATH * 2];
+    char newBuf[FS_MAX_PATH * 2];
+    return rename(hostPath(oldPath, buf), hostPath(newPath, newBuf)) == 0 ? FS_ERROR_OK : translateErrno();
+}
+
+/*
+ * Network: The host is always connected, the proxy is whatever the test set
+ * with hostSetProxy()
+ */
+static char proxyHost[0x80];
+static uint16_t proxyPort = 0;
+
+void hostSetProxy(const char *host, uint16_t port)
+{
+    strcpy(proxyHost, host);
+    proxyPort = port;
+}
+
+int netconf_init()
+{
+    return 0;
+}
+
+int netconf_close()
+{
+    return 0;
+}
+
+int netconf_get_proxy_config(NetConfProxyConfig *config)
+{
+    memset(config, 0, sizeof(NetConfProxyConfig));
+    if(proxyPort != 0)
+    {
+        config->use_proxy = NET_CONF_PROXY_ENABLED;
+        config->port = proxyPort;
+        strcpy(config->host, proxyHost);
+    }
+
+    return 0;
+}
+
+NNResult ACIsApplicationConnected(BOOL *connected)
+{
+    *connected = TRUE;
+    return (NNResult) { 0 };
+}
+
+NNResult ACConnect()
+{
+    return (NNResult) { 0 };
+}
+
+NNResult ACClose()
+{
+    return (NNResult) { 0 };
+}
+
+NNResult ACGetCloseStatus()
+{
+    return (NNResult) { 0 };
+}
+
+int socket_lib_init()
+{
+    return 0;
+}
+
+int socket_lib_finish()
+{
+    return 0;
+}
+
+void set_multicast_state(bool state)
+{
+    (void)state;
+}
+
+// newlib has it, glibc not
+char *itoa(int value, char *str, int base)
+{
+    char digits[33];
+    unsigned int v = value < 0 && base == 10 ? -(unsigned int)value : (unsigned int)value;
+    int i = 0;
+    do
+    {
+        digits[i++] = "0123456789abcdefghijklmnopqrstuvwxyz"[v % base];
+        v /= base;
+    } while(v != 0);
+
+    char *p = str;
+    if(value < 0 && base == 10)
+        *p++ = '-';
+
+    while(i != 0)
+        *p++ = digits[--i];
+
+    *p = '\0';
+    return str;
+}
+
+/*
+ * Shared data: The system font is only handed to the (headless) font cache
+ */
+BOOL OSGetSharedData(OSSharedDataType type, uint32_t unk_r4, void **outPtr, size_t *outSize)
+{
+    static const uint8_t font[16];
+    (void)type;
+    (void)unk_r4;
+    *outPtr = (void *)font;
+    *outSize = sizeof(font);
+    return TRUE;
+}
@@ -0,0 +1,120 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+// Headless stand-in for SDL2, see tests/headlessSdl.c. Only what NUSspli uses.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t Uint8;
+typedef uint16_t Uint16;
+typedef uint32_t Uint32;
+
+typedef enum
+{
+    SDL_FALSE = 0,
+    SDL_TRUE = 1,
+} SDL_bool;
+
+typedef struct SDL_Color
+{
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    uint8_t a;
+} SDL_Color;
+
+typedef struct SDL_Rect
+{
+    int x, y;
+    int w, h;
+} SDL_Rect;
+
+typedef struct SDL_Texture SDL_Texture;
+typedef struct SDL_Window SDL_Window;
+typedef struct SDL_Renderer SDL_Renderer;
+typedef struct SDL_RWops SDL_RWops;
+
+// Surfaces only carry their size, nothing gets rasterised
+typedef struct SDL_Surface
+{
+    int w, h;
+    SDL_bool blend;
+} SDL_Surface;
+
+typedef enum
+{
+    SDL_BLENDMODE_NONE = 0x00000000,
+    SDL_BLENDMODE_BLEND = 0x00000001,
+} SDL_BlendMode;
+
+typedef enum
+{
+    SDL_TEXTUREACCESS_STATIC,
+    SDL_TEXTUREACCESS_STREAMING,
+    SDL_TEXTUREACCESS_TARGET,
+} SDL_TextureAccess;
+
+#define SDL_INIT_AUDIO                0x00000010u
+#define SDL_INIT_VIDEO                0x00000020u
+#define SDL_WINDOWPOS_CENTERED        0x2FFF0000u
+#define SDL_WINDOW_FULLSCREEN_DESKTOP 0x00001001u
+#define SDL_RENDERER_ACCELERATED      0x00000002u
+#define SDL_PIXELFORMAT_RGBA8888      0x16462004u
+#define SDL_HINT_RENDER_SCALE_QUALITY "SDL_RENDER_SCALE_QUALITY"
+#define SDL_MIX_MAXVOLUME             128
+
+int SDL_Init(Uint32 flags);
+void SDL_QuitSubSystem(Uint32 flags);
+void SDL_Quit();
+const char *SDL_GetError();
+SDL_bool SDL_SetHint(const char *name, const char *value);
+
+SDL_Window *SDL_CreateWindow(const char *title, int x, int y, int w, int h, Uint32 flags);
+void SDL_DestroyWindow(SDL_Window *window);
+Uint32 SDL_GetWindowPixelFormat(SDL_Window *window);
+
+SDL_Renderer *SDL_CreateRenderer(SDL_Window *window, int index, Uint32 flags);
+void SDL_DestroyRenderer(SDL_Renderer *renderer);
+int SDL_SetRenderTarget(SDL_Renderer *renderer, SDL_Texture *texture);
+int SDL_SetRenderDrawColor(SDL_Renderer *renderer, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+int SDL_SetRenderDrawBlendMode(SDL_Renderer *renderer, SDL_BlendMode blendMode);
+int SDL_RenderClear(SDL_Renderer *renderer);
+int SDL_RenderDrawPoint(SDL_Renderer *renderer, int x, int y);
+int SDL_RenderFillRect(SDL_Renderer *renderer, const SDL_Rect *rect);
+int SDL_RenderFillRects(SDL_Renderer *renderer, const SDL_Rect *rects, int count);
+int SDL_RenderCopy(SDL_Renderer *renderer, SDL_Texture *texture, const SDL_Rect *srcrect, const SDL_Rect *dstrect);
+void SDL_RenderPresent(SDL_Renderer *renderer);
+
+SDL_Texture *SDL_CreateTexture(SDL_Renderer *renderer, Uint32 format, int access, int w, int h);
+SDL_Texture *SDL_CreateTextureFromSurface(SDL_Renderer *renderer, SDL_Surface *surface);
+void SDL_DestroyTexture(SDL_Texture *texture);
+int SDL_QueryTexture(SDL_Texture *texture, Uint32 *format, int *access, int *w, int *h);
+int SDL_SetTextureBlendMode(SDL_Texture *texture, SDL_BlendMode blendMode);
+
+SDL_Surface *SDL_CreateRGBSurfaceWithFormat(Uint32 flags, int width, int height, int depth, Uint32 format);
+void SDL_FreeSurface(SDL_Surface *surface);
+int SDL_SetSurfaceBlendMode(SDL_Surface *surface, SDL_BlendMode blendMode);
+int SDL_BlitSurface(SDL_Surface *src, const SDL_Rect *srcrect, SDL_Surface *dst, SDL_Rect *dstrect);
+
+SDL_RWops *SDL_RWFromMem(void *mem, int size);
+SDL_RWops *SDL_RWFromConstMem(const void *mem, int size);
+int SDL_RWclose(SDL_RWops *context);
@@ -0,0 +1,40 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#pragma once
+
+#include <SDL2/SDL.h>
+
+// There's no audio on the host, Mix_Init() always fails
+
+typedef struct Mix_Music Mix_Music;
+
+#define MIX_INIT_MP3          0x00000008
+#define MIX_DEFAULT_FREQUENCY 44100
+#define MIX_DEFAULT_FORMAT    0x8010
+#define MIX_DEFAULT_CHANNELS  2
+
+int Mix_Init(int flags);
+int Mix_OpenAudio(int frequency, Uint16 format, int channels, int chunksize);
+void Mix_CloseAudio();
+Mix_Music *Mix_LoadMUS_RW(SDL_RWops *src, int freesrc);
+void Mix_FreeMusic(Mix_Music *music);
+int Mix_PlayMusic(Mix_Music *music, int loops);
+int Mix_HaltMusic();
+int Mix_VolumeMusic(int volume);
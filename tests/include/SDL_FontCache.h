@@ -0,0 +1,53 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+/*
+ * Headless stand-in for SDL_FontCache and SDL2_ttf, see tests/headlessSdl.c.
+ * Glyphs have a fixed advance and get cached per codepoint the way
+ * SDL_FontCache does it: ASCII is rasterised when the font gets loaded,
+ * everything else on first use.
+ */
+
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#define TTF_STYLE_NORMAL 0x00
+
+typedef struct FC_Font FC_Font;
+
+typedef struct
+{
+    SDL_Rect rect;
+    int cache_level;
+} FC_GlyphData;
+
+int TTF_Init();
+void TTF_Quit();
+int TTF_WasInit();
+
+FC_Font *FC_CreateFont();
+Uint8 FC_LoadFont_RW(FC_Font *font, SDL_Renderer *renderer, SDL_RWops *file_rwops_ttf, Uint8 own_rwops, Uint32 pointSize, SDL_Color color, int style);
+void FC_FreeFont(FC_Font *font);
+Uint8 FC_GetGlyphData(FC_Font *font, FC_GlyphData *result, Uint32 codepoint);
+Uint16 FC_GetWidth(FC_Font *font, const char *formatted_text, ...);
+Uint16 FC_GetColumnHeight(FC_Font *font, Uint16 width, const char *formatted_text, ...);
+SDL_Rect FC_Draw(FC_Font *font, SDL_Renderer *dest, float x, float y, const char *formatted_text, ...);
+SDL_Rect FC_DrawColor(FC_Font *font, SDL_Renderer *dest, float x, float y, SDL_Color color, const char *formatted_text, ...);
+SDL_Rect FC_DrawBox(FC_Font *font, SDL_Renderer *dest, SDL_Rect box, const char *formatted_text, ...);
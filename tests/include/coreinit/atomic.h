@@ -0,0 +1,52 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#pragma once
+
+#include <wut.h>
+
+static inline BOOL OSCompareAndSwapAtomic(volatile uint32_t *ptr, uint32_t compare, uint32_t value)
+{
+    return __atomic_compare_exchange_n(ptr, &compare, value, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t OSSwapAtomic(volatile uint32_t *ptr, uint32_t value)
+{
+    return __atomic_exchange_n(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+static inline int32_t OSAddAtomic(volatile int32_t *ptr, int32_t value)
+{
+    return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t OSOrAtomic(volatile uint32_t *ptr, uint32_t value)
+{
+    return __atomic_fetch_or(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t OSAndAtomic(volatile uint32_t *ptr, uint32_t value)
+{
+    return __atomic_fetch_and(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t OSXorAtomic(volatile uint32_t *ptr, uint32_t value)
+{
+    return __atomic_fetch_xor(ptr, value, __ATOMIC_SEQ_CST);
+}
@@ -0,0 +1,33 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#pragma once
+
+#include <pthread.h>
+
+#include <wut.h>
+
+typedef struct
+{
+    pthread_mutex_t mutex;
+} OSFastMutex;
+
+#define OSFastMutex_Init(m, name) pthread_mutex_init(&(m)->mutex, NULL)
+#define OSFastMutex_Lock(m)       pthread_mutex_lock(&(m)->mutex)
+#define OSFastMutex_Unlock(m)     pthread_mutex_unlock(&(m)->mutex)
@@ -0,0 +1,114 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#pragma once
+
+#include <wut.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Paths are plain host paths, see tests/host.c
+#define FS_MAX_PATH 0x280
+
+    typedef int32_t FSAClientHandle;
+    typedef int32_t FSAFileHandle;
+    typedef int32_t FSADirectoryHandle;
+
+    typedef enum
+    {
+        FS_ERROR_OK = 0,
+        FS_ERROR_NOT_INIT = -0x30001,
+        FS_ERROR_END_OF_DIR = -0x30004,
+        FS_ERROR_END_OF_FILE = -0x30005,
+        FS_ERROR_MAX_MOUNT_POINTS = -0x30010,
+        FS_ERROR_MEDIA_ERROR = -0x30013,
+        FS_ERROR_DATA_CORRUPTED = -0x30014,
+        FS_ERROR_ALREADY_OPEN = -0x30015,
+        FS_ERROR_ALREADY_EXISTS = -0x30016,
+        FS_ERROR_NOT_FOUND = -0x30017,
+        FS_ERROR_NOT_EMPTY = -0x30018,
+        FS_ERROR_ACCESS_ERROR = -0x30019,
+        FS_ERROR_PERMISSION_ERROR = -0x3001A,
+        FS_ERROR_STORAGE_FULL = -0x3001B,
+        FS_ERROR_FILE_TOO_BIG = -0x3001C,
+        FS_ERROR_NOT_DIR = -0x3001D,
+        FS_ERROR_NOT_FILE = -0x3001E,
+        FS_ERROR_WRITE_PROTECTED = -0x3001F,
+        FS_ERROR_INVALID_PARAM = -0x30020,
+        FS_ERROR_OUT_OF_RESOURCES = -0x30022,
+    } FSError;
+
+    typedef enum
+    {
+        FS_STAT_DIRECTORY = 0x80000000,
+        FS_STAT_QUOTA = 0x60000000,
+        FS_STAT_FILE = 0x01000000,
+    } FSStatFlags;
+
+    typedef enum
+    {
+        FS_OPEN_FLAG_NONE = 0,
+        FS_OPEN_FLAG_UNENCRYPTED = 1 << 0,
+        FS_OPEN_FLAG_PREALLOC_SIZE = 1 << 1,
+    } FSOpenFileFlags;
+
+    typedef struct
+    {
+        FSStatFlags flags;
+        uint32_t mode;
+        uint32_t owner;
+        uint32_t group;
+        uint32_t size;
+        uint32_t allocSize;
+        uint64_t quotaSize;
+        uint32_t entryId;
+        int64_t created;
+        int64_t modified;
+    } FSStat;
+
+    typedef FSStat FSAStat;
+
+    typedef struct
+    {
+        FSAStat info;
+        char name[256];
+    } FSADirectoryEntry;
+
+    FSError FSAOpenFileEx(FSAClientHandle client, const char *path, const char *mode, uint32_t createMode, FSOpenFileFlags openFlag, uint32_t preallocSize, FSAFileHandle *outFileHandle);
+    FSError FSACloseFile(FSAClientHandle client, FSAFileHandle fileHandle);
+    FSError FSAReadFile(FSAClientHandle client, void *buffer, uint32_t size, uint32_t count, FSAFileHandle handle, uint32_t flags);
+    FSError FSAReadFileWithPos(FSAClientHandle client, void *buffer, uint32_t size, uint32_t count, uint32_t pos, FSAFileHandle handle, uint32_t flags);
+    FSError FSAWriteFile(FSAClientHandle client, const void *buffer, uint32_t size, uint32_t count, FSAFileHandle handle, uint32_t flags);
+    FSError FSAFlushFile(FSAClientHandle client, FSAFileHandle handle);
+    FSError FSAGetStatFile(FSAClientHandle client, FSAFileHandle handle, FSAStat *stat);
+    FSError FSAGetStat(FSAClientHandle client, const char *path, FSAStat *stat);
+    FSError FSAOpenDir(FSAClientHandle client, const char *path, FSADirectoryHandle *dirHandle);
+    FSError FSAReadDir(FSAClientHandle client, FSADirectoryHandle dirHandle, FSADirectoryEntry *directoryEntry);
+    FSError FSACloseDir(FSAClientHandle client, FSADirectoryHandle dirHandle);
+    FSError FSAMakeDir(FSAClientHandle client, const char *path, uint32_t mode);
+    FSError FSARemove(FSAClientHandle client, const char *path);
+    FSError FSARename(FSAClientHandle client, const char *oldPath, const char *newPath);
+    const char *FSAGetStatusStr(FSError error);
+
+#ifdef __cplusplus
+}
+#endif
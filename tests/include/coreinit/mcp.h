@@ -0,0 +1,95 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#pragma once
+
+#include <wut.h>
+
+#include <coreinit/ios.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef int32_t MCPError;
+
+    typedef enum
+    {
+        MCP_REGION_JAPAN = 0x01,
+        MCP_REGION_USA = 0x02,
+        MCP_REGION_EUROPE = 0x04,
+        MCP_REGION_CHINA = 0x10,
+        MCP_REGION_KOREA = 0x20,
+        MCP_REGION_TAIWAN = 0x40,
+    } MCPRegion;
+
+    typedef enum
+    {
+        MCP_APP_TYPE_GAME = 0x80000000,
+    } MCPAppType;
+
+    typedef struct
+    {
+        uint64_t titleId;
+        uint32_t groupId;
+        uint32_t titleVersion;
+        char path[56];
+        MCPAppType appType;
+        uint16_t device;
+        char indexedDevice[10];
+    } MCPTitleListType;
+
+    typedef enum
+    {
+        MCP_INSTALL_TARGET_MLC = 0,
+        MCP_INSTALL_TARGET_USB = 1,
+    } MCPInstallTarget;
+
+    typedef struct
+    {
+        uint8_t data[0x27F];
+    } MCPInstallInfo;
+
+    typedef struct
+    {
+        uint32_t data[0x27F / 4 + 1];
+    } MCPInstallTitleInfo;
+
+    typedef struct
+    {
+        uint32_t inProgress;
+        uint64_t tid;
+        uint64_t sizeTotal;
+        uint64_t sizeProgress;
+        uint32_t contentsTotal;
+        uint32_t contentsProgress;
+    } MCPInstallProgress;
+
+    MCPError MCP_GetTitleInfo(int32_t handle, uint64_t titleId, MCPTitleListType *titleInfo);
+    MCPError MCP_InstallGetInfo(int32_t handle, const char *path, MCPInstallInfo *out);
+    MCPError MCP_InstallSetTargetDevice(int32_t handle, MCPInstallTarget device);
+    MCPError MCP_InstallSetTargetUsb(int32_t handle, int32_t usb);
+    MCPError MCP_InstallTitleAsync(int32_t handle, const char *path, MCPInstallTitleInfo *out);
+    MCPError MCP_InstallGetProgress(int32_t handle, MCPInstallProgress *installProgressOut);
+    MCPError MCP_InstallTitleAbort(int32_t handle);
+
+#ifdef __cplusplus
+}
+#endif
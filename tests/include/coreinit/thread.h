@@ -0,0 +1,76 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#pragma once
+
+#include <pthread.h>
+
+#include <wut.h>
+
+#include <coreinit/time.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef int (*OSThreadEntryPointFn)(int argc, const char **argv);
+
+    typedef enum
+    {
+        OS_THREAD_ATTRIB_AFFINITY_CPU0 = 1 << 0,
+        OS_THREAD_ATTRIB_AFFINITY_CPU1 = 1 << 1,
+        OS_THREAD_ATTRIB_AFFINITY_CPU2 = 1 << 2,
+        OS_THREAD_ATTRIB_AFFINITY_ANY = 7,
+        OS_THREAD_ATTRIB_DETACHED = 1 << 3,
+        OS_THREAD_ATTRIB_STACK_USAGE = 1 << 5,
+    } OSThreadAttributes;
+
+    // Only the fields NUSspli touches plus what the host needs to run it as a pthread
+    typedef struct OSThread
+    {
+        const char *name;
+        uint16_t id;
+        void *stackStart;
+        void *stackEnd;
+        OSThreadEntryPointFn entry;
+        int argc;
+        const char **argv;
+        int result;
+        uint32_t core;
+        volatile BOOL terminated;
+        pthread_t handle;
+    } OSThread;
+
+    BOOL OSCreateThread(OSThread *thread, OSThreadEntryPointFn entry, int32_t argc, char *argv, void *stack, uint32_t stackSize, int32_t priority, OSThreadAttributes attributes);
+    int32_t OSResumeThread(OSThread *thread);
+    BOOL OSJoinThread(OSThread *thread, int *threadResult);
+    void OSDetachThread(OSThread *thread);
+    BOOL OSIsThreadTerminated(OSThread *thread);
+    OSThread *OSGetCurrentThread();
+    void OSSetThreadName(OSThread *thread, const char *name);
+    BOOL OSSetThreadPriority(OSThread *thread, int32_t priority);
+    BOOL OSSetThreadStackUsage(OSThread *thread);
+    int32_t OSCheckThreadStackUsage(OSThread *thread);
+    int32_t OSCheckActiveThreads();
+    void OSSleepTicks(OSTime ticks);
+
+#ifdef __cplusplus
+}
+#endif
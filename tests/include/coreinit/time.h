@@ -0,0 +1,65 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#pragma once
+
+#include <wut.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef int32_t OSTick;
+    typedef int64_t OSTime;
+
+    typedef struct
+    {
+        int32_t tm_sec;
+        int32_t tm_min;
+        int32_t tm_hour;
+        int32_t tm_mday;
+        int32_t tm_mon;
+        int32_t tm_year;
+        int32_t tm_wday;
+        int32_t tm_yday;
+        int32_t tm_msec;
+        int32_t tm_usec;
+    } OSCalendarTime;
+
+// Same timer speed as on the console, so tick math behaves the same
+#define OSTimerClockSpeed              (248625000 / 4)
+
+#define OSSecondsToTicks(val)          ((uint64_t)(val) * (uint64_t)OSTimerClockSpeed)
+#define OSMillisecondsToTicks(val)     (((uint64_t)(val) * (uint64_t)OSTimerClockSpeed) / 1000ull)
+#define OSMicrosecondsToTicks(val)     (((uint64_t)(val) * (uint64_t)OSTimerClockSpeed) / 1000000ull)
+
+#define OSTicksToSeconds(val)          ((uint64_t)(val) / (uint64_t)OSTimerClockSpeed)
+#define OSTicksToMilliseconds(val)     (((uint64_t)(val) * 1000ull) / (uint64_t)OSTimerClockSpeed)
+#define OSTicksToMicroseconds(val)     (((uint64_t)(val) * 1000000ull) / (uint64_t)OSTimerClockSpeed)
+
+    OSTime OSGetTime();
+    OSTime OSGetSystemTime();
+    OSTick OSGetTick();
+    OSTick OSGetSystemTick();
+    void OSTicksToCalendarTime(OSTime time, OSCalendarTime *calendarTime);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,34 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#pragma once
+
+#include <stddef.h>
+
+#include <wut.h>
+
+typedef enum
+{
+    OS_SHAREDDATATYPE_FONT_CHINESE = 0,
+    OS_SHAREDDATATYPE_FONT_KOREAN = 1,
+    OS_SHAREDDATATYPE_FONT_STANDARD = 2,
+    OS_SHAREDDATATYPE_FONT_TAIWANESE = 3,
+} OSSharedDataType;
+
+BOOL OSGetSharedData(OSSharedDataType type, uint32_t unk_r4, void **outPtr, size_t *outSize);
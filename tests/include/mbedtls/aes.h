@@ -0,0 +1,88 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <string.h>
+
+#include <openssl/evp.h>
+
+#define MBEDTLS_AES_ENCRYPT                  1
+#define MBEDTLS_AES_DECRYPT                  0
+#define MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH -0x0022
+
+typedef struct
+{
+    unsigned char key[32];
+    unsigned int keybits;
+} mbedtls_aes_context;
+
+static inline void mbedtls_aes_init(mbedtls_aes_context *ctx)
+{
+    memset(ctx, 0, sizeof(mbedtls_aes_context));
+}
+
+static inline void mbedtls_aes_free(mbedtls_aes_context *ctx)
+{
+    memset(ctx, 0, sizeof(mbedtls_aes_context));
+}
+
+static inline int mbedtls_aes_setkey_enc(mbedtls_aes_context *ctx, const unsigned char *key, unsigned int keybits)
+{
+    if(keybits != 128 && keybits != 192 && keybits != 256)
+        return -1;
+
+    memcpy(ctx->key, key, keybits >> 3);
+    ctx->keybits = keybits;
+    return 0;
+}
+
+// EVP derives the decryption schedule itself
+static inline int mbedtls_aes_setkey_dec(mbedtls_aes_context *ctx, const unsigned char *key, unsigned int keybits)
+{
+    return mbedtls_aes_setkey_enc(ctx, key, keybits);
+}
+
+static inline int mbedtls_aes_crypt_cbc(mbedtls_aes_context *ctx, int mode, size_t length, unsigned char iv[16], const unsigned char *input, unsigned char *output)
+{
+    if(length % 16)
+        return MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH;
+    if(length == 0)
+        return 0;
+
+    const EVP_CIPHER *cipher = ctx->keybits == 256 ? EVP_aes_256_cbc() : (ctx->keybits == 192 ? EVP_aes_192_cbc() : EVP_aes_128_cbc());
+    EVP_CIPHER_CTX *evp = EVP_CIPHER_CTX_new();
+    if(evp == NULL)
+        return -1;
+
+    // Like mbedtls the IV gets updated to continue the chain, input and output may overlap
+    unsigned char next[16];
+    if(mode != MBEDTLS_AES_ENCRYPT)
+        memcpy(next, input + length - 16, 16);
+
+    int len;
+    int ret = -1;
+    if(EVP_CipherInit_ex(evp, cipher, NULL, ctx->key, iv, mode == MBEDTLS_AES_ENCRYPT) == 1 && EVP_CIPHER_CTX_set_padding(evp, 0) == 1 && EVP_CipherUpdate(evp, output, &len, input, (int)length) == 1)
+    {
+        memcpy(iv, mode == MBEDTLS_AES_ENCRYPT ? output + length - 16 : next, 16);
+        ret = 0;
+    }
+
+    EVP_CIPHER_CTX_free(evp);
+    return ret;
+}
@@ -0,0 +1,79 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+
+#include <openssl/evp.h>
+
+typedef enum
+{
+    MBEDTLS_MD_NONE = 0,
+    MBEDTLS_MD_MD5,
+    MBEDTLS_MD_SHA1,
+    MBEDTLS_MD_SHA256,
+} mbedtls_md_type_t;
+
+typedef struct
+{
+    mbedtls_md_type_t type;
+} mbedtls_md_info_t;
+
+typedef struct
+{
+    const mbedtls_md_info_t *info;
+} mbedtls_md_context_t;
+
+static inline const mbedtls_md_info_t *mbedtls_md_info_from_type(mbedtls_md_type_t type)
+{
+    static const mbedtls_md_info_t infos[] = { { MBEDTLS_MD_NONE }, { MBEDTLS_MD_MD5 }, { MBEDTLS_MD_SHA1 }, { MBEDTLS_MD_SHA256 } };
+    return type <= MBEDTLS_MD_SHA256 ? infos + type : NULL;
+}
+
+static inline void mbedtls_md_init(mbedtls_md_context_t *ctx)
+{
+    ctx->info = NULL;
+}
+
+static inline int mbedtls_md_setup(mbedtls_md_context_t *ctx, const mbedtls_md_info_t *info, int hmac)
+{
+    (void)hmac;
+    ctx->info = info;
+    return info == NULL ? -1 : 0;
+}
+
+static inline void mbedtls_md_free(mbedtls_md_context_t *ctx)
+{
+    ctx->info = NULL;
+}
+
+static inline const EVP_MD *hostMdFromContext(const mbedtls_md_context_t *ctx)
+{
+    switch(ctx->info->type)
+    {
+        case MBEDTLS_MD_MD5:
+            return EVP_md5();
+        case MBEDTLS_MD_SHA1:
+            return EVP_sha1();
+        case MBEDTLS_MD_SHA256:
+            return EVP_sha256();
+        default:
+            return NULL;
+    }
+}
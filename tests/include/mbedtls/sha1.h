@@ -0,0 +1,66 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+
+#include <openssl/evp.h>
+
+typedef struct
+{
+    EVP_MD_CTX *evp;
+} mbedtls_sha1_context;
+
+static inline void mbedtls_sha1_init(mbedtls_sha1_context *ctx)
+{
+    ctx->evp = NULL;
+}
+
+static inline void mbedtls_sha1_free(mbedtls_sha1_context *ctx)
+{
+    EVP_MD_CTX_free(ctx->evp);
+    ctx->evp = NULL;
+}
+
+static inline int mbedtls_sha1_starts(mbedtls_sha1_context *ctx)
+{
+    if(ctx->evp == NULL)
+    {
+        ctx->evp = EVP_MD_CTX_new();
+        if(ctx->evp == NULL)
+            return -1;
+    }
+
+    return EVP_DigestInit_ex(ctx->evp, EVP_sha1(), NULL) == 1 ? 0 : -1;
+}
+
+static inline int mbedtls_sha1_update(mbedtls_sha1_context *ctx, const unsigned char *input, size_t ilen)
+{
+    return EVP_DigestUpdate(ctx->evp, input, ilen) == 1 ? 0 : -1;
+}
+
+static inline int mbedtls_sha1_finish(mbedtls_sha1_context *ctx, unsigned char output[20])
+{
+    return EVP_DigestFinal_ex(ctx->evp, output, NULL) == 1 ? 0 : -1;
+}
+
+static inline int mbedtls_sha1(const unsigned char *input, size_t ilen, unsigned char output[20])
+{
+    return EVP_Digest(input, ilen, output, NULL, EVP_sha1(), NULL) == 1 ? 0 : -1;
+}
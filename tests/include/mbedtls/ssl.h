@@ -0,0 +1,35 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+
+// Only plain HTTP gets tested on the host, curl never hands out a mbedTLS config then
+
+typedef struct
+{
+    int unused;
+} mbedtls_ssl_config;
+
+static inline void mbedtls_ssl_conf_rng(mbedtls_ssl_config *conf, int (*rng)(void *, unsigned char *, size_t), void *param)
+{
+    (void)conf;
+    (void)rng;
+    (void)param;
+}
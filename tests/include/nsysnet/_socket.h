@@ -0,0 +1,39 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#define SO_WINSCALE 0x0400
+#define SO_TCPSACK  0x0200
+
+int socket_lib_init();
+int socket_lib_finish();
+
+// WinScale, SAck and no slowstart only exist on Cafe, Linux does these on its own
+static inline int hostSetsockopt(int sock, int level, int option, const void *value, socklen_t size)
+{
+    if(level == SOL_SOCKET && (option == SO_WINSCALE || option == SO_TCPSACK || option == 0x4000))
+        return 0;
+
+    return setsockopt(sock, level, option, value, size);
+}
+
+#define setsockopt hostSetsockopt
@@ -0,0 +1,48 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+typedef enum
+{
+    NET_CONF_PROXY_DISABLED = 0,
+    NET_CONF_PROXY_ENABLED = 1,
+} NetConfProxyState;
+
+typedef enum
+{
+    NET_CONF_PROXY_AUTH_TYPE_NONE = 0,
+    NET_CONF_PROXY_AUTH_TYPE_BASIC_AUTHENTICATION = 1,
+} NetConfProxyAuthType;
+
+typedef struct
+{
+    uint16_t use_proxy;
+    uint16_t port;
+    uint32_t auth_type;
+    char host[0x80];
+    char username[0x20];
+    char password[0x20];
+} NetConfProxyConfig;
+
+// The proxy comes from hostSetProxy(), see tests/host.c
+int netconf_init();
+int netconf_close();
+int netconf_get_proxy_config(NetConfProxyConfig *config);
@@ -0,0 +1,50 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+// Host replacement for ../include/swkbd_wrapper.h: There's no keyboard, the renderer only asks if it's shown
+// and config.h needs the languages
+
+#pragma once
+
+#include <stdbool.h>
+
+typedef enum
+{
+    Swkbd_LanguageType__Japanese = 0,
+    Swkbd_LanguageType__English = 1,
+    Swkbd_LanguageType__French = 2,
+    Swkbd_LanguageType__German = 3,
+    Swkbd_LanguageType__Italian = 4,
+    Swkbd_LanguageType__Spanish = 5,
+    Swkbd_LanguageType__Chinese1 = 6,
+    Swkbd_LanguageType__Korean = 7,
+    Swkbd_LanguageType__Dutch = 8,
+    Swkbd_LanguageType__Portuguese = 9,
+    Swkbd_LanguageType__Russian = 10,
+    Swkbd_LanguageType__Chinese2 = 11,
+    Swkbd_LanguageType__Invalid = 12,
+    Swkbd_LanguageType__Portuguese_BR = 13,
+    Swkbd_LanguageType__Turkish = 14,
+    Swkbd_LanguageType__Welsh = 15,
+} Swkbd_LanguageType;
+
+bool Swkbd_IsReady();
+bool Swkbd_IsHidden();
+void Swkbd_DrawTV();
+void Swkbd_DrawDRC();
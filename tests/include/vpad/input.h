@@ -0,0 +1,49 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <wut.h>
+
+typedef enum
+{
+    VPAD_CHAN_0 = 0,
+} VPADChan;
+
+typedef enum
+{
+    VPAD_BUTTON_A = 0x8000,
+    VPAD_BUTTON_B = 0x4000,
+    VPAD_BUTTON_X = 0x2000,
+    VPAD_BUTTON_Y = 0x1000,
+    VPAD_BUTTON_LEFT = 0x0800,
+    VPAD_BUTTON_RIGHT = 0x0400,
+    VPAD_BUTTON_UP = 0x0200,
+    VPAD_BUTTON_DOWN = 0x0100,
+    VPAD_BUTTON_PLUS = 0x0008,
+    VPAD_BUTTON_MINUS = 0x0004,
+    VPAD_BUTTON_HOME = 0x0002,
+} VPADButtons;
+
+// No gamepad on the host, only what NUSspli reads
+typedef struct
+{
+    uint32_t hold;
+    uint32_t trigger;
+    uint32_t release;
+} VPADStatus;
@@ -0,0 +1,35 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define WUT_PP_CAT(a, b)            WUT_PP_CAT_(a, b)
+#define WUT_PP_CAT_(a, b)           a##b
+#define WUT_UNKNOWN_BYTES(size)     uint8_t WUT_PP_CAT(__unk, __COUNTER__)[size]
+#define WUT_CHECK_OFFSET(type, offset, field) \
+    _Static_assert(offsetof(type, field) == (offset), "Wrong offset of " #type "." #field)
+#define WUT_CHECK_SIZE(type, size) \
+    _Static_assert(sizeof(type) == (size), "Wrong size of " #type)
+
+#ifndef WUT_PACKED
+#define WUT_PACKED __attribute__((__packed__))
+#endif
@@ -0,0 +1,344 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nusServer.h"
+#include "test.h"
+
+/*
+ * Serves the files added with addNusFile() by path. Requests may use the
+ * absolute form a client sends to its proxy, so the downloader reaches this
+ * through the proxy setting without changing DOWNLOAD_URL. HEAD and
+ * "Range: bytes=<start>-" are supported, everything else gets a 404.
+ * setNusServerTiming() adds the round trips of a far away server: A delay
+ * after accepting a connection, one before each answer and a transfer rate
+ * per connection.
+ */
+
+#define REQUEST_LENGTH 2048
+#define MAX_FILES      64
+#define CHUNK_SIZE     (16 * 1024)
+
+typedef struct
+{
+    char path[128];
+    void *data;
+    size_t size;
+    uint32_t requests;
+} NUS_FILE;
+
+static NUS_FILE files[MAX_FILES];
+static size_t fileCount = 0;
+static int listenSocket = -1;
+static pthread_t acceptThread;
+static volatile uint32_t running = 0;
+static NUS_SERVER_STATS stats;
+static uint32_t inFlight = 0;
+static uint32_t connectDelay = 0;
+static uint32_t requestDelay = 0;
+static uint64_t rate = 0;
+
+static void count(uint32_t *counter)
+{
+    __atomic_add_fetch(counter, 1, __ATOMIC_SEQ_CST);
+}
+
+static void sleepMs(uint32_t ms)
+{
+    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static bool sendAll(int sock, const char *buf, size_t size)
+{
+    while(size != 0)
+    {
+        ssize_t ret = send(sock, buf, size, MSG_NOSIGNAL);
+        if(ret <= 0)
+            return false;
+
+        buf += ret;
+        size -= ret;
+    }
+
+    return true;
+}
+
+// Sends size bytes of the file starting at offset, throttled to the rate
+static bool sendBody(int sock, const NUS_FILE *file, size_t offset, size_t size)
+{
+    static const char filler[CHUNK_SIZE];
+    uint64_t start = testNow();
+    size_t sent = 0;
+    while(sent != size)
+    {
+        size_t chunk = size - sent < CHUNK_SIZE ? size - sent : CHUNK_SIZE;
+        if(!sendAll(sock, file->data == NULL ? filler : (const char *)file->data + offset + sent, chunk))
+            return false;
+
+        sent += chunk;
+        if(rate != 0)
+        {
+            uint64_t due = start + (sent * 1000000000ull) / rate;
+            uint64_t now = testNow();
+            if(due > now)
+                sleepMs((due - now) / 1000000);
+        }
+    }
+
+    return true;
+}
+
+static NUS_FILE *findFile(const char *path, size_t len)
+{
+    for(size_t i = 0; i < fileCount; ++i)
+        if(strlen(files[i].path) == len && memcmp(files[i].path, path, len) == 0)
+            return files + i;
+
+    return NULL;
+}
+
+static bool answer(int sock, const char *request)
+{
+    bool head = strncmp(request, "HEAD ", 5) == 0;
+    const char *path = strchr(request, ' ');
+    if(path == NULL)
+        return false;
+
+    // Absolute form: http://host/path
+    ++path;
+    if(strncmp(path, "http://", 7) == 0)
+    {
+        path = strchr(path + 7, '/');
+        if(path == NULL)
+            return false;
+    }
+
+    const char *end = strchr(path, ' ');
+    if(end == NULL)
+        return false;
+
+    __atomic_store_n(&stats.lastRequest, testNow(), __ATOMIC_SEQ_CST);
+    count(&stats.requests);
+    uint32_t parallel = __atomic_add_fetch(&inFlight, 1, __ATOMIC_SEQ_CST);
+    uint32_t max = __atomic_load_n(&stats.maxParallel, __ATOMIC_SEQ_CST);
+    while(parallel > max && !__atomic_compare_exchange_n(&stats.maxParallel, &max, parallel, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+        ;
+
+    if(requestDelay != 0)
+        sleepMs(requestDelay);
+
+    char header[256];
+    bool ret;
+    NUS_FILE *file = findFile(path, end - path);
+    if(file == NULL)
+    {
+        count(&stats.notFound);
+        strcpy(header, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+        ret = sendAll(sock, header, strlen(header));
+    }
+    else
+    {
+        count(&file->requests);
+        size_t offset = 0;
+        const char *range = strcasestr(request, "\r\nRange: bytes=");
+        if(range != NULL)
+            sscanf(range + 15, "%zu", &offset);
+
+        if(offset > file->size)
+        {
+            strcpy(header, "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Length: 0\r\n\r\n");
+            ret = sendAll(sock, header, strlen(header));
+        }
+        else
+        {
+            size_t size = file->size - offset;
+            if(range != NULL)
+                sprintf(header, "HTTP/1.1 206 Partial Content\r\nContent-Length: %zu\r\nContent-Range: bytes %zu-%zu/%zu\r\nContent-Type: application/octet-stream\r\n\r\n", size, offset, file->size - 1, file->size);
+            else
+                sprintf(header, "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\nContent-Type: application/octet-stream\r\n\r\n", size);
+
+            ret = sendAll(sock, header, strlen(header)) && (head || sendBody(sock, file, offset, size));
+        }
+    }
+
+    __atomic_sub_fetch(&inFlight, 1, __ATOMIC_SEQ_CST);
+    return ret;
+}
+
+static void *connectionThreadMain(void *arg)
+{
+    int sock = (int)(intptr_t)arg;
+    if(connectDelay != 0)
+        sleepMs(connectDelay);
+
+    char request[REQUEST_LENGTH];
+    size_t got = 0;
+    ssize_t ret;
+    while((ret = recv(sock, request + got, sizeof(request) - 1 - got, 0)) > 0)
+    {
+        got += ret;
+        request[got] = '\0';
+        char *end;
+        while((end = strstr(request, "\r\n\r\n")) != NULL)
+        {
+            if(!answer(sock, request))
+                goto closeConnection;
+
+            // Keep what the client pipelined behind this request
+            end += 4;
+            got -= end - request;
+            memmove(request, end, got + 1);
+        }
+
+        if(got == sizeof(request) - 1)
+            break;
+    }
+
+closeConnection:
+    close(sock);
+    return NULL;
+}
+
+static void *acceptThreadMain(void *arg)
+{
+    (void)arg;
+
+    while(running)
+    {
+        int sock = accept(listenSocket, NULL, NULL);
+        if(sock < 0)
+            continue;
+
+        count(&stats.connections);
+        int one = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        pthread_t thread;
+        if(pthread_create(&thread, NULL, connectionThreadMain, (void *)(intptr_t)sock) == 0)
+            pthread_detach(thread);
+        else
+            close(sock);
+    }
+
+    return NULL;
+}
+
+int startNusServer()
+{
+    listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if(listenSocket < 0)
+        return 0;
+
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if(bind(listenSocket, (struct sockaddr *)&addr, sizeof(addr)) == 0 &&
+       listen(listenSocket, 16) == 0 &&
+       getsockname(listenSocket, (struct sockaddr *)&addr, &len) == 0)
+    {
+        running = 1;
+        if(pthread_create(&acceptThread, NULL, acceptThreadMain, NULL) == 0)
+            return ntohs(addr.sin_port);
+
+        running = 0;
+    }
+
+    close(listenSocket);
+    listenSocket = -1;
+    return 0;
+}
+
+// Connections still open by then keep their thread, these end when the client closes them
+void stopNusServer()
+{
+    if(!running)
+        return;
+
+    running = 0;
+    shutdown(listenSocket, SHUT_RDWR);
+    pthread_join(acceptThread, NULL);
+    close(listenSocket);
+    listenSocket = -1;
+    clearNusFiles();
+}
+
+void addNusFile(const char *path, const void *data, size_t size)
+{
+    if(fileCount == MAX_FILES)
+        return;
+
+    NUS_FILE *file = files + fileCount++;
+    strcpy(file->path, path);
+    file->size = size;
+    file->requests = 0;
+    file->data = NULL;
+    if(data != NULL)
+    {
+        file->data = malloc(size);
+        memcpy(file->data, data, size);
+    }
+}
+
+void clearNusFiles()
+{
+    for(size_t i = 0; i < fileCount; ++i)
+        free(files[i].data);
+
+    fileCount = 0;
+}
+
+uint32_t getNusFileRequests(const char *path)
+{
+    NUS_FILE *file = findFile(path, strlen(path));
+    return file == NULL ? 0 : __atomic_load_n(&file->requests, __ATOMIC_SEQ_CST);
+}
+
+void setNusServerTiming(uint32_t connectMs, uint32_t requestMs, uint64_t bytesPerSecond)
+{
+    connectDelay = connectMs;
+    requestDelay = requestMs;
+    rate = bytesPerSecond;
+}
+
+void getNusServerStats(NUS_SERVER_STATS *out)
+{
+    out->connections = __atomic_load_n(&stats.connections, __ATOMIC_SEQ_CST);
+    out->requests = __atomic_load_n(&stats.requests, __ATOMIC_SEQ_CST);
+    out->notFound = __atomic_load_n(&stats.notFound, __ATOMIC_SEQ_CST);
+    out->maxParallel = __atomic_load_n(&stats.maxParallel, __ATOMIC_SEQ_CST);
+    out->lastRequest = __atomic_load_n(&stats.lastRequest, __ATOMIC_SEQ_CST);
+}
+
+void resetNusServerStats()
+{
+    memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,42 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Plain HTTP/1.1 stand-in for the NUS on 127.0.0.1, see tests/nusServer.c
+
+typedef struct
+{
+    uint32_t connections;
+    uint32_t requests;
+    uint32_t notFound;
+    uint32_t maxParallel; // Most requests answered at the same time
+    uint64_t lastRequest; // testNow() when the last request came in
+} NUS_SERVER_STATS;
+
+int startNusServer(); // Returns the port or 0 on error
+void stopNusServer();
+void addNusFile(const char *path, const void *data, size_t size); // Without data size filler bytes get served
+void clearNusFiles();
+uint32_t getNusFileRequests(const char *path);
+void setNusServerTiming(uint32_t connectMs, uint32_t requestMs, uint64_t bytesPerSecond); // 0 for no delay / no limit
+void getNusServerStats(NUS_SERVER_STATS *out);
+void resetNusServerStats();
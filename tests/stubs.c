@@ -0,0 +1,544 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+/*
+ * Weak stand-ins for NUSspli functions the units under test call but which
+ * live in files that need the real console (renderer, menus, network...).
+ * Tests override them with strong definitions when they need to look at the
+ * calls.
+ */
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <config.h>
+#include <crypto.h>
+#include <downloader.h>
+#include <file.h>
+#include <filesystem.h>
+#include <input.h>
+#include <installer.h>
+#include <keygen.h>
+#include <menu/filebrowser.h>
+#include <menu/utils.h>
+#include <metaCache.h>
+#include <otp.h>
+#include <renderer.h>
+#include <state.h>
+#include <staticMem.h>
+#include <swkbd_wrapper.h>
+#include <tmd.h>
+#include <utils.h>
+
+#include <mbedtls/aes.h>
+
+#include <coreinit/filesystem_fsa.h>
+#include <coreinit/mcp.h>
+#include <coreinit/memdefaultheap.h>
+
+#define WEAK __attribute__((weak))
+
+__attribute__((constructor)) static void initHost()
+{
+    initStaticMem();
+}
+
+WEAK FSAClientHandle getFSAClient()
+{
+    return 1;
+}
+
+WEAK NUSDEV getUSB()
+{
+    return NUSDEV_NONE;
+}
+
+WEAK bool AppRunning(bool mainthread)
+{
+    (void)mainthread;
+    return true;
+}
+
+WEAK const char *localise(const char *msg)
+{
+    return msg;
+}
+
+WEAK void addEntropy(void *e, size_t len)
+{
+    (void)e;
+    (void)len;
+}
+
+WEAK void addToScreenLog(const char *str, ...)
+{
+    (void)str;
+}
+
+#ifdef NUSSPLI_DEBUG
+WEAK void debugPrintf(const char *str, ...)
+{
+    (void)str;
+}
+#endif
+
+WEAK void hex(uint64_t i, int digits, char *out)
+{
+    sprintf(out, "%0*llx", digits, (unsigned long long)i);
+}
+
+WEAK void hexToByte(const char *hex, uint8_t *out)
+{
+    for(int i = 0; hex[0] != '\0' && hex[1] != '\0' && i < 64; hex += 2)
+        sscanf(hex, "%2hhx", out + i++);
+}
+
+WEAK bool isNumber(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+WEAK bool isHexa(char c)
+{
+    return isNumber(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+WEAK bool isAllowedInFilename(char c)
+{
+    return c >= ' ' && c <= '~' && strchr("\\/:*?\"<>|", c) == NULL;
+}
+
+/*
+ * The settings are the defaults, apart from auto resume: With no input the
+ * retry prompts would spin forever
+ */
+WEAK bool autoResumeEnabled()
+{
+    return false;
+}
+
+WEAK bool lowPowerEnabled()
+{
+    return false;
+}
+
+WEAK bool dlToUSBenabled()
+{
+    return true;
+}
+
+WEAK uint32_t getContentCacheSize()
+{
+    return 0;
+}
+
+/*
+ * There's no screen and no pad, the UI loops just spin
+ */
+WEAK volatile APP_STATE app = APP_STATE_RUNNING;
+WEAK VPADStatus vpad;
+
+WEAK void colorStartNewFrame(SCREEN_COLOR color)
+{
+    (void)color;
+}
+
+WEAK void showFrame()
+{
+}
+
+WEAK void drawFrame()
+{
+}
+
+WEAK void textToFrameCut(int line, int column, const char *str, int maxWidth)
+{
+    (void)line;
+    (void)column;
+    (void)str;
+    (void)maxWidth;
+}
+
+WEAK void textToFrameColoredCut(int line, int column, const char *str, SCREEN_COLOR color, int maxWidth)
+{
+    (void)line;
+    (void)column;
+    (void)str;
+    (void)color;
+    (void)maxWidth;
+}
+
+WEAK int textToFrameMultiline(int x, int y, const char *text, size_t len)
+{
+    (void)y;
+    (void)text;
+    (void)len;
+    return x + 1;
+}
+
+WEAK void lineToFrame(int column, SCREEN_COLOR color)
+{
+    (void)column;
+    (void)color;
+}
+
+WEAK void barToFrame(int line, int column, uint32_t width, float progress)
+{
+    (void)line;
+    (void)column;
+    (void)width;
+    (void)progress;
+}
+
+WEAK void readInput()
+{
+}
+
+WEAK bool showExitOverlay(bool really)
+{
+    (void)really;
+    return false;
+}
+
+WEAK bool Swkbd_IsReady()
+{
+    return false;
+}
+
+WEAK bool Swkbd_IsHidden()
+{
+    return true;
+}
+
+WEAK void Swkbd_DrawTV()
+{
+}
+
+WEAK void Swkbd_DrawDRC()
+{
+}
+
+WEAK void writeScreenLog(int line)
+{
+    (void)line;
+}
+
+WEAK void showErrorFrame(const char *text)
+{
+    (void)text;
+}
+
+WEAK void *addErrorOverlay(const char *err)
+{
+    (void)err;
+    return NULL;
+}
+
+WEAK void removeErrorOverlay(void *overlay)
+{
+    (void)overlay;
+}
+
+WEAK void drawErrorFrame(const char *text, ErrorOptions option)
+{
+    (void)text;
+    (void)option;
+}
+
+WEAK uint32_t homeButtonCallback(void *dummy)
+{
+    (void)dummy;
+    return 0;
+}
+
+WEAK void showFinishedScreen(const char *titleName, FINISHING_OPERATION op)
+{
+    (void)titleName;
+    (void)op;
+}
+
+WEAK const char *prettyDir(const char *dir)
+{
+    return dir;
+}
+
+WEAK void humanize(uint64_t size, char *out)
+{
+    sprintf(out, "%llu B", (unsigned long long)size);
+}
+
+WEAK void secsToTime(uint32_t seconds, char *out)
+{
+    sprintf(out, "%u s", seconds);
+}
+
+WEAK void getSpeedString(float bytePerSecond, char *out)
+{
+    sprintf(out, "%.0f B/s", bytePerSecond);
+}
+
+/*
+ * A made up common key instead of the one from the OTP
+ */
+static uint8_t commonKey[16] = { 0xC0, 0xFF, 0xEE, 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC };
+
+WEAK uint8_t *getCommonKey()
+{
+    return commonKey;
+}
+
+WEAK bool decryptAES(void *data, int data_len, const unsigned char *key, unsigned char *iv, void *decrypted)
+{
+    mbedtls_aes_context aes;
+    mbedtls_aes_init(&aes);
+    mbedtls_aes_setkey_dec(&aes, key, 128);
+    return mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_DECRYPT, data_len, iv, data, decrypted) == 0;
+}
+
+// Tests without keygen.c provide a ticket
+WEAK bool generateKey(uint64_t tid, uint8_t *out)
+{
+    (void)tid;
+    (void)out;
+    return false;
+}
+
+WEAK bool encryptAES(void *data, int data_len, const unsigned char *key, unsigned char *iv, void *encrypted)
+{
+    mbedtls_aes_context aes;
+    mbedtls_aes_init(&aes);
+    mbedtls_aes_setkey_enc(&aes, key, 128);
+    return mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_ENCRYPT, data_len, iv, data, encrypted) == 0;
+}
+
+/*
+ * Every device has room for everything
+ */
+WEAK uint64_t getFreeSpace(NUSDEV dev)
+{
+    (void)dev;
+    return UINT64_MAX;
+}
+
+WEAK bool checkFreeSpace(NUSDEV dev, uint64_t size)
+{
+    (void)dev;
+    (void)size;
+    return true;
+}
+
+/*
+ * The I/O queue writes synchronously on the host
+ */
+WEAK bool checkForQueueErrors()
+{
+    return false;
+}
+
+WEAK FSAFileHandle openFile(const char *path, const char *mode, size_t filesize)
+{
+    (void)filesize;
+    FSAFileHandle ret;
+    return FSAOpenFileEx(getFSAClient(), path, mode, 0x660, FS_OPEN_FLAG_NONE, 0, &ret) == FS_ERROR_OK ? ret : 0;
+}
+
+WEAK size_t addToIOQueue(const void *buf, size_t size, size_t n, FSAFileHandle file)
+{
+    if(buf == NULL)
+    {
+        FSACloseFile(getFSAClient(), file);
+        return 0;
+    }
+
+    return FSAWriteFile(getFSAClient(), buf, size, n, file, 0);
+}
+
+WEAK void flushIOQueue()
+{
+}
+
+/*
+ * There's no network on the host, tests wanting downloads override downloadFile()
+ */
+WEAK int downloadFile(const char *url, char *file, downloadData *data, FileType type, bool resume, QUEUE_DATA *queueData, RAMBUF *rambuf)
+{
+    (void)url;
+    (void)file;
+    (void)data;
+    (void)type;
+    (void)resume;
+    (void)queueData;
+    (void)rambuf;
+    return 1;
+}
+
+WEAK int downloadMetadata(uint64_t tid, const char *file, const char *titleVer, FileType type, downloadData *data, QUEUE_DATA *queueData, RAMBUF *rambuf)
+{
+    (void)tid;
+    (void)file;
+    (void)titleVer;
+    (void)type;
+    (void)data;
+    (void)queueData;
+    (void)rambuf;
+    return 1;
+}
+
+WEAK char *fileBrowserMenu(bool installMenu, bool allowNoIntro)
+{
+    (void)installMenu;
+    (void)allowNoIntro;
+    return NULL;
+}
+
+WEAK RAMBUF *allocRamBuf()
+{
+    RAMBUF *ret = MEMAllocFromDefaultHeap(sizeof(RAMBUF));
+    if(ret != NULL)
+    {
+        ret->buf = NULL;
+        ret->size = 0;
+        ret->capacity = 0;
+    }
+
+    return ret;
+}
+
+WEAK void clearRamBuf(RAMBUF *rambuf)
+{
+    if(rambuf->buf != NULL)
+        MEMFreeToDefaultHeap(rambuf->buf);
+
+    rambuf->buf = NULL;
+    rambuf->size = 0;
+    rambuf->capacity = 0;
+}
+
+WEAK bool setRamBuf(RAMBUF *rambuf, const void *data, size_t size)
+{
+    clearRamBuf(rambuf);
+    rambuf->buf = MEMAllocFromDefaultHeap(size);
+    if(rambuf->buf == NULL)
+        return false;
+
+    memcpy(rambuf->buf, data, size);
+    rambuf->size = rambuf->capacity = size;
+    return true;
+}
+
+WEAK void freeRamBuf(RAMBUF *rambuf)
+{
+    clearRamBuf(rambuf);
+    MEMFreeToDefaultHeap(rambuf);
+}
+
+/*
+ * The content cache is empty and only the NUS layout is known, tests
+ * linking contentCache.c or no-intro.c get the real ones.
+ */
+WEAK bool isCached(const TMD *tmd, uint16_t content)
+{
+    (void)tmd;
+    (void)content;
+    return false;
+}
+
+WEAK bool getTitleFilePath(const char *dir, const char *file, char *out)
+{
+    strcpy(out, dir);
+    strcat(out, file);
+    FSAStat stat;
+    return FSAGetStat(getFSAClient(), out, &stat) == FS_ERROR_OK;
+}
+
+/*
+ * MCP, nothing gets installed on the host
+ */
+WEAK bool install(const char *game, bool hasDeps, NUSDEV dev, const char *path, bool toUsb, bool keepFiles, const TMD *tmd)
+{
+    (void)game;
+    (void)hasDeps;
+    (void)dev;
+    (void)path;
+    (void)toUsb;
+    (void)keepFiles;
+    (void)tmd;
+    return true;
+}
+
+WEAK int installToFrame(int line)
+{
+    (void)line;
+    return 0;
+}
+
+WEAK int startInstall(INSTALL_JOB *job, const char *game, bool hasDeps, NUSDEV dev, const char *path, bool toUsb, bool keepFiles, const TMD *tmd)
+{
+    (void)job;
+    (void)game;
+    (void)hasDeps;
+    (void)dev;
+    (void)path;
+    (void)toUsb;
+    (void)keepFiles;
+    (void)tmd;
+    return 0;
+}
+
+WEAK bool finishInstall(INSTALL_JOB *job)
+{
+    (void)job;
+    return false;
+}
+
+WEAK int mcpHandle = 1;
+
+WEAK MCPError MCP_InstallGetProgress(int32_t handle, MCPInstallProgress *installProgressOut)
+{
+    (void)handle;
+    memset(installProgressOut, 0, sizeof(MCPInstallProgress));
+    return 0;
+}
+
+WEAK MCPError MCP_InstallTitleAbort(int32_t handle)
+{
+    (void)handle;
+    return 0;
+}
+
+/*
+ * There's no auto power down or HOME menu on the host
+ */
+WEAK void enableApd()
+{
+}
+
+WEAK void disableApd()
+{
+}
+
+WEAK void enableShutdown()
+{
+}
+
+WEAK void disableShutdown()
+{
+}
@@ -0,0 +1,77 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// Tiny helpers shared by the host tests, see tests/Makefile
+
+static int testFailures __attribute__((unused)) = 0;
+
+#define CHECK(cond)                                                                  \
+    do                                                                               \
+    {                                                                                \
+        if(!(cond))                                                                  \
+        {                                                                            \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++testFailures;                                                          \
+        }                                                                            \
+    } while(0)
+
+#define CHECK_EQ(a, b)                                                                                      \
+    do                                                                                                      \
+    {                                                                                                       \
+        long long _a = (long long)(a);                                                                      \
+        long long _b = (long long)(b);                                                                      \
+        if(_a != _b)                                                                                        \
+        {                                                                                                   \
+            fprintf(stderr, "%s:%d: %s == %s failed (%lld != %lld)\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+            ++testFailures;                                                                                 \
+        }                                                                                                   \
+    } while(0)
+
+#define RUN_TEST(fn)                                                          \
+    do                                                                        \
+    {                                                                         \
+        int _before = testFailures;                                           \
+        fn();                                                                 \
+        printf("%-40s %s\n", #fn, _before == testFailures ? "ok" : "FAILED"); \
+    } while(0)
+
+#define TEST_RESULT() (testFailures == 0 ? 0 : 1)
+
+// Temp folder the console paths get moved to, see tests/host.c
+const char *hostMakeRoot();
+const char *hostGetRoot();
+void hostRemoveRoot();
+uint64_t hostHeapAllocations(); // Calls to MEMAllocFromDefaultHeap(Ex)()
+void hostCrashAfterRenames(int renames); // FSARename() ends the process after that many renames, for forked children
+void hostSetProxy(const char *host, uint16_t port); // The proxy from the network settings, port 0 for none
+uint32_t hostUnjoinedThreads(); // Threads started by OSResumeThread() and not joined yet
+
+// Wall clock in nanoseconds for the benchmarks
+static inline uint64_t testNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
@@ -0,0 +1,268 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <bulkConvert.h>
+#include <crypto.h>
+#include <file.h>
+#include <keygen.h>
+#include <no-intro.h>
+#include <preflight.h>
+#include <ticket.h>
+#include <tmd.h>
+
+#include <coreinit/memdefaultheap.h>
+
+#include "fixtures.h"
+#include "test.h"
+
+#define TID_READY     0x0005000010201000ull
+#define TID_NO_TICKET 0x0005000010202000ull // First of MISSING_TICKETS
+#define TID_NO_CERT   0x0005000010203000ull
+#define TID_NO_INTRO  0x0005000010204000ull
+#define TID_BARE      0x0005000010205000ull
+#define TID_BROKEN    0x0005000010206000ull
+
+#define MISSING_TICKETS (KEY_CACHE_SIZE + 8) // More than one key batch
+
+#define READY_DIR    INSTALL_DIR_SD "Ready [0005000010201000]/"
+#define NO_CERT_DIR  INSTALL_DIR_SD "No cert [0005000010203000]/"
+#define NO_INTRO_DIR INSTALL_DIR_SD "No-Intro [0005000010204000]/"
+#define BARE_DIR     INSTALL_DIR_USB1 "Bare [0005000010205000]/"
+#define BROKEN_DIR   INSTALL_DIR_SD "Broken [0005000010206000]/"
+
+static const CONTENT_DESC contents[] = {
+    { .size = 3000, .hash = 0x11 },
+};
+
+/*
+ * Fake no-intro code: It just renames tmd and cetk, which is enough for
+ * the folder to look converted on the next scan.
+ */
+static int transformed;
+static int kept;
+static bool transformFails;
+static char transformedPath[FS_MAX_PATH];
+
+static void renameInDir(const char *dir, const char *from, const char *to)
+{
+    char a[FS_MAX_PATH * 2];
+    char b[FS_MAX_PATH * 2];
+    sprintf(a, "%s%s%s", hostGetRoot(), dir, from);
+    sprintf(b, "%s%s%s", hostGetRoot(), dir, to);
+    rename(a, b);
+}
+
+NO_INTRO_DATA *transformNoIntro(const char *path)
+{
+    ++transformed;
+    strcpy(transformedPath, path);
+    if(transformFails)
+        return NULL;
+
+    renameInDir(path, "tmd", "title.tmd");
+    renameInDir(path, "cetk", "title.tik");
+    NO_INTRO_DATA *data = calloc(1, sizeof(NO_INTRO_DATA));
+    data->path = strdup(path);
+    return data;
+}
+
+void keepNoIntro(NO_INTRO_DATA *data)
+{
+    ++kept;
+    free(data->path);
+    free(data);
+}
+
+bool recoverNoIntro(const char *path)
+{
+    (void)path;
+    return false;
+}
+
+static void writeIn(const char *dir, const char *file, const void *data, size_t size)
+{
+    char path[FS_MAX_PATH];
+    sprintf(path, "%s%s", dir, file);
+    writeHostFile(path, data, size);
+}
+
+static void writeTitle(const char *dir, uint64_t tid, const char *tmdName, const char *tikName, bool cert)
+{
+    size_t size;
+    makeHostDirs(dir);
+    TMD *tmd = buildTmd(tid, 0, contents, 1, &size);
+    writeIn(dir, tmdName, tmd, size);
+    free(tmd);
+
+    if(tikName != NULL)
+    {
+        void *ticket = buildTicket(tid, &size);
+        writeIn(dir, tikName, ticket, size);
+        free(ticket);
+    }
+
+    if(cert)
+        writeIn(dir, "title.cert", "cert", 4);
+}
+
+static void missingTicketDir(int i, char *out)
+{
+    sprintf(out, INSTALL_DIR_SD "Missing ticket %02d [%016llx]/", i, (unsigned long long)(TID_NO_TICKET + i));
+}
+
+static void buildTree()
+{
+    char dir[FS_MAX_PATH];
+    writeTitle(READY_DIR, TID_READY, "title.tmd", "title.tik", true);
+    for(int i = 0; i < MISSING_TICKETS; ++i)
+    {
+        missingTicketDir(i, dir);
+        writeTitle(dir, TID_NO_TICKET + i, "title.tmd", NULL, true);
+    }
+    writeTitle(NO_CERT_DIR, TID_NO_CERT, "title.tmd", "title.tik", true);
+    writeTitle(NO_INTRO_DIR, TID_NO_INTRO, "tmd", "cetk", false);
+    writeTitle(BARE_DIR, TID_BARE, "title.tmd", NULL, false);
+
+    // Neither of these is a title to convert
+    makeHostDirs(INSTALL_DIR_SD "Not a title/");
+    writeIn(INSTALL_DIR_SD "Not a title/", "readme.txt", "hello", 5);
+    makeHostDirs(BROKEN_DIR);
+    writeIn(BROKEN_DIR, "title.tmd", "broken", 6);
+
+    // The cert of the "No cert" folder goes missing
+    char path[FS_MAX_PATH * 2];
+    sprintf(path, "%s%stitle.cert", hostGetRoot(), NO_CERT_DIR);
+    remove(path);
+}
+
+static size_t readIn(const char *dir, const char *file, void **out)
+{
+    char path[FS_MAX_PATH * 2];
+    sprintf(path, "%s%s", dir, file);
+    *out = NULL;
+    return readFile(path, out);
+}
+
+static bool hasValidTicket(const char *dir, uint64_t tid)
+{
+    TICKET *ticket;
+    size_t size = readIn(dir, "title.tik", (void **)&ticket);
+    if(ticket == NULL)
+        return false;
+
+    uint8_t key[16];
+    bool ret = checkTicketStructure(ticket, size, tid) && generateKey(tid, key) && memcmp(ticket->key, key, 16) == 0;
+    MEMFreeToDefaultHeap(ticket);
+    return ret;
+}
+
+static bool hasValidCert(const char *dir)
+{
+    CETK *cert;
+    size_t size = readIn(dir, "title.cert", (void **)&cert);
+    if(cert == NULL)
+        return false;
+
+    bool ret = checkCertStructure(cert, size);
+    MEMFreeToDefaultHeap(cert);
+    return ret;
+}
+
+static bool sameContent(const char *dir, const char *file, const void *data, size_t size)
+{
+    void *buf;
+    bool ret = readIn(dir, file, &buf) == size && memcmp(buf, data, size) == 0;
+    if(buf != NULL)
+        MEMFreeToDefaultHeap(buf);
+
+    return ret;
+}
+
+static void testConvertsTree()
+{
+    CHECK(bulkConvert());
+
+    CHECK_EQ(transformed, 1);
+    CHECK_EQ(kept, 1);
+    CHECK(strcmp(transformedPath, NO_INTRO_DIR) == 0);
+
+    char dir[FS_MAX_PATH];
+    for(int i = 0; i < MISSING_TICKETS; ++i)
+    {
+        missingTicketDir(i, dir);
+        CHECK(hasValidTicket(dir, TID_NO_TICKET + i));
+        CHECK(sameContent(dir, "title.cert", "cert", 4));
+    }
+
+    CHECK(hasValidCert(NO_CERT_DIR));
+    CHECK(hasValidTicket(BARE_DIR, TID_BARE));
+    CHECK(hasValidCert(BARE_DIR));
+
+    // Complete folders stay as they are
+    size_t size;
+    void *ticket = buildTicket(TID_READY, &size);
+    CHECK(sameContent(READY_DIR, "title.tik", ticket, size));
+    CHECK(sameContent(READY_DIR, "title.cert", "cert", 4));
+    free(ticket);
+
+    CHECK(!fileExists(INSTALL_DIR_SD "Not a title/title.tik"));
+    CHECK(!fileExists(BROKEN_DIR "title.tik"));
+    CHECK(!fileExists(INSTALL_DIR_SD "NUSspli_manifest.json"));
+}
+
+static void testSecondRunKeepsFiles()
+{
+    // Generated tickets have a random ID, so rewriting them would show
+    void *before;
+    size_t size = readIn(BARE_DIR, "title.tik", &before);
+    transformed = 0;
+
+    CHECK(bulkConvert());
+    CHECK_EQ(transformed, 0);
+    CHECK(sameContent(BARE_DIR, "title.tik", before, size));
+    MEMFreeToDefaultHeap(before);
+}
+
+static void testFailedConversion()
+{
+    writeTitle(INSTALL_DIR_USB2 "No-Intro 2 [0005000010207000]/", 0x0005000010207000ull, "tmd", "cetk", false);
+    transformed = 0;
+    transformFails = true;
+
+    CHECK(!bulkConvert());
+    CHECK_EQ(transformed, 1);
+    transformFails = false;
+}
+
+int main()
+{
+    hostMakeRoot();
+    initCrypto();
+    buildTree();
+
+    RUN_TEST(testConvertsTree);
+    RUN_TEST(testSecondRunKeepsFiles);
+    RUN_TEST(testFailedConversion);
+
+    hostRemoveRoot();
+    return TEST_RESULT();
+}
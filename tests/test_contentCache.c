@@ -0,0 +1,290 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <contentCache.h>
+#include <file.h>
+#include <thread.h>
+#include <titles.h>
+#include <tmd.h>
+
+#include "fixtures.h"
+#include "test.h"
+
+#define TID      0x0005000010101000ull
+#define GAME_DIR INSTALL_DIR_SD "Game [0005000010101000]/"
+#define COPY_DIR INSTALL_DIR_SD "Copy [0005000010101000]/"
+
+static const CONTENT_DESC contents[] = {
+    { .size = 3000, .hash = 0x11 },
+    { .size = 70000, .hash = 0x22, .hashed = true },
+    { .size = 5000, .hash = 0x33 },
+};
+
+static TMD *tmd;
+static size_t tmdSize;
+static uint32_t cacheGB = 1;
+static pthread_t mainThread;
+static int logs;
+static int logsOffMain;
+
+uint32_t getContentCacheSize()
+{
+    return cacheGB;
+}
+
+// The screen log belongs to the main thread
+void addToScreenLog(const char *str, ...)
+{
+    (void)str;
+    ++logs;
+    if(!pthread_equal(pthread_self(), mainThread))
+        ++logsOffMain;
+}
+
+static void writeContent(const char *dir, const TMD_CONTENT *c, const char *ext, size_t size)
+{
+    uint8_t *data = malloc(size);
+    for(size_t i = 0; i < size; ++i)
+        data[i] = (uint8_t)(c->hash[0] + i * 7);
+
+    char path[FS_MAX_PATH];
+    sprintf(path, "%s%08x%s", dir, c->cid, ext);
+    writeHostFile(path, data, size);
+    free(data);
+}
+
+// A finished temporary download, the way installer.c hands it to storeInCache()
+static void writeDownload()
+{
+    char path[FS_MAX_PATH];
+    makeHostDirs(GAME_DIR);
+    sprintf(path, "%stitle.tmd", GAME_DIR);
+    writeHostFile(path, tmd, tmdSize);
+    for(uint16_t i = 0; i < tmd->num_contents; ++i)
+    {
+        writeContent(GAME_DIR, tmd->contents + i, ".app", tmd->contents[i].size);
+        if(tmd->contents[i].type & TMD_CONTENT_TYPE_HASHED)
+            writeContent(GAME_DIR, tmd->contents + i, ".h3", getH3size(tmd->contents[i].size));
+    }
+}
+
+static bool contentExists(const char *dir, uint16_t i, const char *ext)
+{
+    char path[FS_MAX_PATH];
+    sprintf(path, "%s%08x%s", dir, tmd->contents[i].cid, ext);
+    return fileExists(path);
+}
+
+// The index is kept in LRU order, returns the content index of the LRU entry pos
+static int indexEntry(size_t pos)
+{
+    flushContentCache();
+    uint8_t *buf;
+    size_t size = readFile(CONTENT_CACHE_DIR "index.bin", (void **)&buf);
+    if(buf == NULL)
+        return -1;
+
+    int ret = -1;
+    pos = sizeof(uint32_t) + pos * sizeof(CACHE_ENTRY);
+    if(pos + sizeof(CACHE_ENTRY) <= size)
+        ret = ((CACHE_ENTRY *)(buf + pos))->index;
+
+    MEMFreeToDefaultHeap(buf);
+    return ret;
+}
+
+static void testStore()
+{
+    writeDownload();
+    storeInCache(GAME_DIR);
+
+    CACHE_ENTRY entry;
+    for(uint16_t i = 0; i < tmd->num_contents; ++i)
+    {
+        CHECK(findInCache(tmd, i, &entry));
+        CHECK(!contentExists(GAME_DIR, i, ".app")); // Moved, not copied
+    }
+
+    CHECK_EQ(entry.size, 5000);
+    CHECK(findInCache(tmd, 1, &entry));
+    CHECK_EQ(entry.size, 70000 + getH3size(70000));
+    CHECK_EQ(indexEntry(0), 0);
+    CHECK_EQ(indexEntry(2), 2);
+}
+
+static void testRestoreCopy()
+{
+    CACHE_ENTRY entry;
+    makeHostDirs(COPY_DIR);
+    CHECK(findInCache(tmd, 1, &entry));
+    logs = 0;
+    CHECK_EQ(restoreFromCache(&entry, tmd, 1, COPY_DIR, false, NULL), CACHE_RESTORE_COPIED);
+    CHECK(contentExists(COPY_DIR, 1, ".app"));
+    CHECK(contentExists(COPY_DIR, 1, ".h3"));
+
+    // Nothing but files until the main thread finishes the restore
+    CHECK_EQ(logs, 0);
+    CHECK_EQ(indexEntry(0), 0);
+
+    uint64_t saved = getCacheSavedBytes();
+    CHECK_EQ(finishCacheRestore(&entry, tmd->contents[1].cid, CACHE_RESTORE_COPIED), entry.size);
+    CHECK_EQ(getCacheSavedBytes(), saved + entry.size);
+    CHECK_EQ(logs, 1);
+    CHECK_EQ(indexEntry(2), 1); // Most recently used
+    CHECK(findInCache(tmd, 1, &entry));
+
+    // A second time there's nothing to do
+    CHECK_EQ(restoreFromCache(&entry, tmd, 1, COPY_DIR, false, NULL), CACHE_RESTORE_NONE);
+    CHECK_EQ(finishCacheRestore(&entry, tmd->contents[1].cid, CACHE_RESTORE_NONE), 0);
+    CHECK_EQ(logs, 1);
+}
+
+typedef struct
+{
+    CACHE_ENTRY entry;
+    COPY_PROGRESS progress;
+    uint16_t content;
+    bool move;
+    CACHE_RESTORE result;
+} RESTORE_JOB;
+
+static int restoreThreadMain(int argc, const char **argv)
+{
+    (void)argc;
+
+    RESTORE_JOB *job = (RESTORE_JOB *)argv;
+    job->result = restoreFromCache(&job->entry, tmd, job->content, GAME_DIR, job->move, &job->progress);
+    return 0;
+}
+
+// Like reuseContent(): Restore on a copy thread, bookkeeping after the join
+static uint64_t restoreThreaded(uint16_t content, bool move, bool cancel, CACHE_RESTORE *result)
+{
+    RESTORE_JOB job = { .content = content, .move = move };
+    job.progress.cancel = cancel;
+    if(!findInCache(tmd, content, &job.entry))
+        return 0;
+
+    OSThread *thread = startThread("NUSspli cache test", THREAD_PRIORITY_HIGH, STACKSIZE_MEDIUM, restoreThreadMain, 0, (char *)&job, OS_THREAD_ATTRIB_AFFINITY_CPU0);
+    CHECK(thread != NULL);
+    if(thread == NULL)
+        return 0;
+
+    stopThread(thread, NULL);
+    *result = job.result;
+    return finishCacheRestore(&job.entry, tmd->contents[content].cid, job.result);
+}
+
+static void testRestoreMove()
+{
+    CACHE_RESTORE result;
+    CACHE_ENTRY entry;
+    logs = logsOffMain = 0;
+    CHECK_EQ(restoreThreaded(0, true, false, &result), 3000);
+    CHECK_EQ(result, CACHE_RESTORE_MOVED);
+    CHECK(contentExists(GAME_DIR, 0, ".app"));
+    CHECK(!findInCache(tmd, 0, &entry)); // Left the cache with the files
+    CHECK_EQ(logs, 1);
+    CHECK_EQ(logsOffMain, 0);
+}
+
+static void testRestoreCancelled()
+{
+    CACHE_RESTORE result;
+    CACHE_ENTRY entry;
+    CHECK_EQ(restoreThreaded(2, false, true, &result), 0);
+    CHECK_EQ(result, CACHE_RESTORE_CANCELLED);
+    CHECK(!contentExists(GAME_DIR, 2, ".app"));
+    CHECK(findInCache(tmd, 2, &entry)); // Still good
+}
+
+static void testRestoreBroken()
+{
+    char path[FS_MAX_PATH];
+    sprintf(path, "%s%s%016llx_%04x_", hostGetRoot(), CONTENT_CACHE_DIR, TID, tmd->contents[2].index);
+    for(int i = 0; i < 5; ++i)
+        sprintf(path + strlen(path), "%08x", tmd->contents[2].hash[i]);
+
+    strcat(path, ".app");
+    CHECK_EQ(truncate(path, 100), 0);
+
+    CACHE_RESTORE result;
+    CACHE_ENTRY entry;
+    logs = 0;
+    CHECK_EQ(restoreThreaded(2, false, false, &result), 0);
+    CHECK_EQ(result, CACHE_RESTORE_BROKEN);
+    CHECK(!findInCache(tmd, 2, &entry));
+    CHECK(access(path, F_OK) != 0);
+    CHECK_EQ(logs, 0);
+}
+
+static void testEvictedWhileCopying()
+{
+    // The copy thread holds no pointer into the index, so evicting in between is fine
+    CACHE_ENTRY entry;
+    CHECK(findInCache(tmd, 1, &entry));
+    cacheGB = 0;
+    trimContentCache();
+    cacheGB = 1;
+    CHECK(!findInCache(tmd, 1, &entry));
+
+    uint64_t saved = getCacheSavedBytes();
+    CHECK_EQ(finishCacheRestore(&entry, tmd->contents[1].cid, CACHE_RESTORE_COPIED), entry.size);
+    CHECK_EQ(getCacheSavedBytes(), saved + entry.size);
+    CHECK_EQ(indexEntry(0), -1);
+}
+
+static void testReload()
+{
+    writeDownload();
+    storeInCache(GAME_DIR);
+    shutdownContentCache();
+    initContentCache();
+
+    CACHE_ENTRY entry;
+    for(uint16_t i = 0; i < tmd->num_contents; ++i)
+        CHECK(findInCache(tmd, i, &entry));
+}
+
+int main()
+{
+    mainThread = pthread_self();
+    hostMakeRoot();
+    tmd = buildTmd(TID, 1, contents, 3, &tmdSize);
+    initContentCache();
+
+    RUN_TEST(testStore);
+    RUN_TEST(testRestoreCopy);
+    RUN_TEST(testRestoreMove);
+    RUN_TEST(testRestoreCancelled);
+    RUN_TEST(testRestoreBroken);
+    RUN_TEST(testEvictedWhileCopying);
+    RUN_TEST(testReload);
+
+    shutdownContentCache();
+    free(tmd);
+    hostRemoveRoot();
+    return TEST_RESULT();
+}
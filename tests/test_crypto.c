@@ -0,0 +1,128 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <string.h>
+
+#include <crypto.h>
+#include <thread.h>
+
+#include <coreinit/thread.h>
+
+#include "test.h"
+
+#define CORE_BYTES 64
+
+static const OSThreadAttributes coreAffinity[3] = {
+    OS_THREAD_ATTRIB_AFFINITY_CPU0,
+    OS_THREAD_ATTRIB_AFFINITY_CPU1,
+    OS_THREAD_ATTRIB_AFFINITY_CPU2,
+};
+
+static uint8_t coreOutput[3][CORE_BYTES];
+
+static void testFillsExactly()
+{
+    uint8_t buf[16];
+    for(size_t len = 0; len < 10; ++len)
+    {
+        memset(buf, 0xAA, sizeof(buf));
+        NUSrng(NULL, buf, len);
+        for(size_t i = len; i < sizeof(buf); ++i)
+            CHECK_EQ(buf[i], 0xAA);
+    }
+}
+
+static void testDistribution()
+{
+    static uint8_t buf[256 * 256];
+    uint32_t counts[256] = { 0 };
+    NUSrng(NULL, buf, sizeof(buf));
+    for(size_t i = 0; i < sizeof(buf); ++i)
+        ++counts[buf[i]];
+
+    // 256 expected per value, all four bytes of a word are used
+    for(int i = 0; i < 256; ++i)
+    {
+        CHECK(counts[i] > 160);
+        CHECK(counts[i] < 352);
+    }
+
+    uint32_t a;
+    uint32_t b;
+    for(size_t i = 4; i < sizeof(buf); i += 4)
+    {
+        memcpy(&a, buf + i - 4, 4);
+        memcpy(&b, buf + i, 4);
+        CHECK(a != b);
+    }
+}
+
+static void testEntropy()
+{
+    // Odd sizes and unaligned buffers are fine, the output keeps working
+    uint8_t data[67];
+    for(size_t i = 0; i < sizeof(data); ++i)
+        data[i] = i * 3;
+
+    for(size_t len = 0; len < 8; ++len)
+        addEntropy(data + 1, len);
+    addEntropy(data, sizeof(data));
+
+    uint8_t buf[16] = { 0 };
+    uint8_t zero[16] = { 0 };
+    NUSrng(NULL, buf, sizeof(buf));
+    CHECK(memcmp(buf, zero, sizeof(buf)) != 0);
+}
+
+static int coreThreadMain(int argc, const char **argv)
+{
+    (void)argv;
+
+    addEntropy(&argc, sizeof(argc));
+    NUSrng(NULL, coreOutput[argc], CORE_BYTES);
+    return 0;
+}
+
+static void testPerCore()
+{
+    // Every core has its own generator, so the cores don't repeat each others numbers
+    OSThread *threads[3];
+    for(int i = 0; i < 3; ++i)
+        threads[i] = startThread("NUSspli RNG test", THREAD_PRIORITY_MEDIUM, STACKSIZE_SMALL, coreThreadMain, i, NULL, coreAffinity[i]);
+
+    for(int i = 0; i < 3; ++i)
+    {
+        CHECK(threads[i] != NULL);
+        if(threads[i] != NULL)
+            stopThread(threads[i], NULL);
+    }
+
+    CHECK(memcmp(coreOutput[0], coreOutput[1], CORE_BYTES) != 0);
+    CHECK(memcmp(coreOutput[0], coreOutput[2], CORE_BYTES) != 0);
+    CHECK(memcmp(coreOutput[1], coreOutput[2], CORE_BYTES) != 0);
+}
+
+int main()
+{
+    CHECK(initCrypto());
+    RUN_TEST(testFillsExactly);
+    RUN_TEST(testDistribution);
+    RUN_TEST(testEntropy);
+    RUN_TEST(testPerCore);
+    return TEST_RESULT();
+}
@@ -0,0 +1,262 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <utils.h>
+
+#include <coreinit/thread.h>
+#include <coreinit/time.h>
+
+#include "test.h"
+
+#define MAX_LINES 1024
+
+/*
+ * Fake log backends: Lines get collected, printing blocks while the gate
+ * is closed so the test can fill the ring.
+ */
+static pthread_mutex_t lineLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gateCond = PTHREAD_COND_INITIALIZER;
+static char *lines[MAX_LINES];
+static volatile int lineCount = 0;
+static volatile bool gateClosed = false;
+static volatile bool printerWaiting = false;
+static volatile int udpDeinits = 0;
+
+BOOL WHBLogPrint(const char *str)
+{
+    pthread_mutex_lock(&lineLock);
+    while(gateClosed)
+    {
+        printerWaiting = true;
+        pthread_cond_wait(&gateCond, &lineLock);
+    }
+    printerWaiting = false;
+
+    if(lineCount < MAX_LINES)
+        lines[lineCount++] = strdup(str);
+
+    pthread_mutex_unlock(&lineLock);
+    return TRUE;
+}
+
+BOOL WHBLogUdpInit()
+{
+    return TRUE;
+}
+
+BOOL WHBLogUdpDeinit()
+{
+    ++udpDeinits;
+    return TRUE;
+}
+
+BOOL WHBLogCafeInit()
+{
+    return TRUE;
+}
+
+BOOL WHBLogCafeDeinit()
+{
+    return TRUE;
+}
+
+static void setGate(bool closed)
+{
+    pthread_mutex_lock(&lineLock);
+    gateClosed = closed;
+    pthread_cond_broadcast(&gateCond);
+    pthread_mutex_unlock(&lineLock);
+}
+
+static void clearLines()
+{
+    pthread_mutex_lock(&lineLock);
+    for(int i = 0; i < lineCount; ++i)
+        free(lines[i]);
+
+    lineCount = 0;
+    pthread_mutex_unlock(&lineLock);
+}
+
+static bool waitFor(volatile int *count, int n)
+{
+    for(int i = 0; i < 2000 && *count < n; ++i)
+        OSSleepTicks(OSMillisecondsToTicks(1));
+
+    return *count >= n;
+}
+
+// The message of line i, without the timestamp
+static const char *message(int i)
+{
+    if(!waitFor(&lineCount, i + 1))
+        return "";
+
+    const char *tab = strchr(lines[i], '\t');
+    return tab == NULL ? lines[i] : tab + 1;
+}
+
+// Everything debugPrintf() has to understand, checked against snprintf()
+#define CHECK_FORMAT(...)                                              \
+    do                                                                 \
+    {                                                                  \
+        char ref[512];                                                 \
+        snprintf(ref, sizeof(ref), __VA_ARGS__);                       \
+        int line = lineCount;                                          \
+        debugPrintf(__VA_ARGS__);                                      \
+        if(strcmp(message(line), ref) != 0)                            \
+        {                                                              \
+            fprintf(stderr, "\"%s\" != \"%s\"\n", message(line), ref); \
+            ++testFailures;                                            \
+        }                                                              \
+    } while(0)
+
+static void checkFormats()
+{
+    int n = 0;
+    CHECK_FORMAT("Plain text");
+    CHECK_FORMAT("100%% done");
+    CHECK_FORMAT("%s: %d / %u", "Downloading", -42, 0xFFFFFFFFu);
+    CHECK_FORMAT("%#010x %X %o", 0xDEAD, 0xBEEFu, 8);
+    CHECK_FORMAT("[%5d] [%-5d] [%+d] [% d] [%05d]", 1, 2, 3, 4, 5);
+    CHECK_FORMAT("[%*d] [%-*s] [%.*s]", 6, 7, 8, "left", 3, "truncated");
+    CHECK_FORMAT("%lld %llu %llx", -1234567890123ll, 18446744073709551615ull, 0x0005000010101000ull);
+    CHECK_FORMAT("%ld %lu %zu %td %jd", -7l, 7ul, (size_t)123456789, (ptrdiff_t)-5, (intmax_t)-99);
+    CHECK_FORMAT("%hhu %hd %c", 300, 70000, 'N');
+    CHECK_FORMAT("%f %.2f %e %g %10.3E", 3.5, 2.0 / 3.0, 12345.678, 0.0001, -1.5);
+    CHECK_FORMAT("%Lf", (long double)1.25);
+    CHECK_FORMAT("%p %s", (void *)0x1234, (const char *)NULL);
+    CHECK_FORMAT("%s%n%s", "a", &n, "b");
+}
+
+static void testSynchronous()
+{
+    // No ring yet, debugPrintf() formats on the calling thread
+    clearLines();
+    checkFormats();
+    CHECK(strchr(lines[0], '\t') != NULL);
+}
+
+static void testDeferred()
+{
+    clearLines();
+    checkFormats();
+
+    // Strings get copied at call time
+    char buf[16];
+    strcpy(buf, "before");
+    int line = lineCount;
+    debugPrintf("%s", buf);
+    strcpy(buf, "after");
+    CHECK(strcmp(message(line), "before") == 0);
+}
+
+static void testTruncated()
+{
+    clearLines();
+
+    // Arguments which don't fit get cut and marked
+    char big[300];
+    memset(big, 'A', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    debugPrintf("%s %d", big, 1);
+    const char *msg = message(0);
+    size_t l = strlen(msg);
+    CHECK(l > 64 && l < sizeof(big));
+    CHECK(strspn(msg, "A") == l - strlen("  [...]"));
+    CHECK(strcmp(msg + l - strlen(" [...]"), " [...]") == 0);
+
+    char fmt[128] = "";
+    char ref[256] = "";
+    int i;
+    for(i = 0; i < 40; ++i)
+        strcat(fmt, "%d ");
+
+    debugPrintf(fmt, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39);
+    for(i = 0; i < 40; ++i)
+        sprintf(ref + strlen(ref), "%d ", i);
+
+    msg = message(1);
+    l = strlen(msg);
+    CHECK(l < strlen(ref));
+    CHECK(strcmp(msg + l - strlen(" [...]"), " [...]") == 0);
+    CHECK(strncmp(msg, ref, l - strlen(" [...]")) == 0);
+
+    // An unknown conversion ends the parsing, the rest is printed as is
+    debugPrintf("%d %y %d", 1, 2);
+    CHECK(strcmp(message(2), "1 %y %d") == 0);
+}
+
+static void testOverflow()
+{
+    clearLines();
+
+    // Stall the log thread on the first message, then overfill the ring (512 entries)
+    setGate(true);
+    debugPrintf("First");
+    for(int i = 0; i < 2000 && !printerWaiting; ++i)
+        OSSleepTicks(OSMillisecondsToTicks(1));
+
+    CHECK(printerWaiting);
+
+    for(int i = 0; i < 600; ++i)
+        debugPrintf("Message %d", i);
+
+    setGate(false);
+    CHECK(waitFor(&lineCount, 513));
+    CHECK(strcmp(message(0), "First") == 0);
+    CHECK(strcmp(message(1), "Message 0") == 0);
+    CHECK(strcmp(message(511), "Message 510") == 0);
+    CHECK(strcmp(message(512), "Debug log overflow: 89 messages dropped") == 0);
+
+    // Once there is room again messages get accepted again
+    debugPrintf("After");
+    CHECK(strcmp(message(513), "After") == 0);
+}
+
+static void testShutdown()
+{
+    clearLines();
+
+    // Entries still in the ring get printed before the backends close
+    for(int i = 0; i < 100; ++i)
+        debugPrintf("Late %d", i);
+
+    shutdownDebug();
+    CHECK_EQ(lineCount, 100);
+    CHECK(strcmp(message(99), "Late 99") == 0);
+    CHECK_EQ(udpDeinits, 1);
+}
+
+int main()
+{
+    RUN_TEST(testSynchronous);
+
+    debugInit();
+    RUN_TEST(testDeferred);
+    RUN_TEST(testTruncated);
+    RUN_TEST(testOverflow);
+    RUN_TEST(testShutdown);
+
+    clearLines();
+    return TEST_RESULT();
+}
@@ -0,0 +1,206 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <delta.h>
+#include <file.h>
+#include <titles.h>
+#include <tmd.h>
+
+#include "fixtures.h"
+#include "test.h"
+
+#define TID         0x0005000010101000ull
+#define GAME_DIR(v) INSTALL_DIR_SD "Game [0005000010101000] " v "/"
+
+// Version 2 keeps contents 0 and 1, changes 2 and 3 and adds 4
+static const CONTENT_DESC v1[] = {
+    { .size = 3000, .hash = 0x11 },
+    { .size = 70000, .hash = 0x22, .hashed = true },
+    { .size = 5000, .hash = 0x33 },
+    { .size = 6000, .hash = 0x44 },
+};
+
+static const CONTENT_DESC v2[] = {
+    { .size = 3000, .hash = 0x11 },
+    { .size = 70000, .hash = 0x22, .hashed = true },
+    { .size = 5000, .hash = 0x35 },
+    { .size = 6001, .hash = 0x44 },
+    { .size = 100, .hash = 0x55 },
+};
+
+// Only content 0 is the same as in version 2
+static const CONTENT_DESC v3[] = {
+    { .size = 3000, .hash = 0x11 },
+    { .size = 70000, .hash = 0x23, .hashed = true },
+};
+
+// Content data depends on the hash, so unchanged contents are the same in all versions
+static void writeContent(const char *dir, const TMD_CONTENT *c, const char *ext, size_t size)
+{
+    uint8_t *data = malloc(size);
+    for(size_t i = 0; i < size; ++i)
+        data[i] = (uint8_t)(c->hash[0] + i * 7);
+
+    char path[FS_MAX_PATH];
+    sprintf(path, "%s%08x%s", dir, c->cid, ext);
+    writeHostFile(path, data, size);
+    free(data);
+}
+
+static void writeTitle(const char *dir, const TMD *tmd, size_t size, bool contents)
+{
+    char path[FS_MAX_PATH];
+    makeHostDirs(dir);
+    sprintf(path, "%stitle.tmd", dir);
+    writeHostFile(path, tmd, size);
+
+    if(!contents)
+        return;
+
+    for(uint16_t i = 0; i < tmd->num_contents; ++i)
+    {
+        writeContent(dir, tmd->contents + i, ".app", tmd->contents[i].size);
+        if(tmd->contents[i].type & TMD_CONTENT_TYPE_HASHED)
+            writeContent(dir, tmd->contents + i, ".h3", getH3size(tmd->contents[i].size));
+    }
+}
+
+static TMD *tmd1;
+static TMD *tmd2;
+static TMD *tmd3;
+static size_t tmd1Size;
+static size_t tmd2Size;
+static size_t tmd3Size;
+
+static void setupTree()
+{
+    hostMakeRoot();
+    tmd1 = buildTmd(TID, 1, v1, 4, &tmd1Size);
+    tmd2 = buildTmd(TID, 2, v2, 5, &tmd2Size);
+    tmd3 = buildTmd(TID, 3, v3, 2, &tmd3Size);
+
+    writeTitle(GAME_DIR("v1"), tmd1, tmd1Size, true);
+    writeTitle(GAME_DIR("v3"), tmd3, tmd3Size, true);
+    // The download folder of the new version and an old copy of it, both must be ignored
+    writeTitle(GAME_DIR("v2"), tmd2, tmd2Size, false);
+    writeTitle(GAME_DIR("v2 (old)"), tmd2, tmd2Size, true);
+
+    // Another title sharing everything
+    size_t size;
+    TMD *other = buildTmd(TID + 0x1000, 1, v2, 5, &size);
+    writeTitle(INSTALL_DIR_SD "Other [0005000010102000] v1/", other, size, true);
+    free(other);
+}
+
+static void teardownTree()
+{
+    hostRemoveRoot();
+    free(tmd1);
+    free(tmd2);
+    free(tmd3);
+}
+
+static void testFindUnchangedContent()
+{
+    CHECK_EQ(findUnchangedContent(tmd2, 0, tmd1), 0);
+    CHECK_EQ(findUnchangedContent(tmd2, 1, tmd1), 1);
+    CHECK_EQ(findUnchangedContent(tmd2, 2, tmd1), -1); // Other hash
+    CHECK_EQ(findUnchangedContent(tmd2, 3, tmd1), -1); // Other size
+    CHECK_EQ(findUnchangedContent(tmd2, 4, tmd1), -1); // New content
+    CHECK_EQ(findUnchangedContent(tmd2, 0, tmd3), 0);
+    CHECK_EQ(findUnchangedContent(tmd2, 1, tmd3), -1);
+}
+
+static void testDeltaSize()
+{
+    CHECK_EQ(getDeltaSize(tmd2, tmd1), 3000 + 70000 + getH3size(70000));
+    CHECK_EQ(getDeltaSize(tmd2, tmd3), 3000);
+    CHECK_EQ(getDeltaSize(tmd1, tmd1), 3000 + 70000 + getH3size(70000) + 5000 + 6000);
+
+    size_t size;
+    TMD *other = buildTmd(TID + 0x1000, 1, v2, 5, &size);
+    CHECK_EQ(getDeltaSize(tmd2, other), 0);
+    free(other);
+}
+
+static void testFindPreviousVersion()
+{
+    DELTA_SOURCE source;
+    CHECK(findPreviousVersion(tmd2, GAME_DIR("v2"), &source));
+    CHECK(source.tmd != NULL);
+    CHECK_EQ(strcmp(source.dir, GAME_DIR("v1")), 0);
+    if(source.tmd != NULL)
+        CHECK_EQ(source.tmd->title_version, 1);
+
+    freeDeltaSource(&source);
+    CHECK(source.tmd == NULL);
+
+    // Nothing to share
+    size_t size;
+    TMD *lonely = buildTmd(0x0005000010103000ull, 1, v1, 4, &size);
+    CHECK(!findPreviousVersion(lonely, NULL, &source));
+    CHECK(source.tmd == NULL);
+    free(lonely);
+}
+
+static void testFetchFromPreviousVersion()
+{
+    DELTA_SOURCE source;
+    findPreviousVersion(tmd2, GAME_DIR("v2"), &source);
+
+    COPY_PROGRESS progress = { .copied = 0, .cancel = false };
+    CHECK_EQ(fetchFromPreviousVersion(tmd2, 0, &source, GAME_DIR("v2"), &progress), 3000);
+    CHECK_EQ(fetchFromPreviousVersion(tmd2, 1, &source, GAME_DIR("v2"), &progress), 70000 + getH3size(70000));
+    CHECK_EQ(progress.copied, 3000 + 70000 + getH3size(70000));
+    for(uint16_t i = 2; i < 5; ++i)
+        CHECK_EQ(fetchFromPreviousVersion(tmd2, i, &source, GAME_DIR("v2"), &progress), 0);
+
+    // Copied under the new content IDs
+    CHECK(sameHostFile(GAME_DIR("v1") "00000100.app", GAME_DIR("v2") "00000200.app"));
+    CHECK(sameHostFile(GAME_DIR("v1") "00000101.app", GAME_DIR("v2") "00000201.app"));
+    CHECK(sameHostFile(GAME_DIR("v1") "00000101.h3", GAME_DIR("v2") "00000201.h3"));
+    CHECK(!fileExists(GAME_DIR("v2") "00000202.app"));
+
+    // Already there, downloadFile() skips it
+    CHECK_EQ(fetchFromPreviousVersion(tmd2, 0, &source, GAME_DIR("v2"), NULL), 0);
+
+    // A cancelled copy leaves nothing behind
+    FSARemove(1, GAME_DIR("v2") "00000201.app");
+    FSARemove(1, GAME_DIR("v2") "00000201.h3");
+    progress.cancel = true;
+    CHECK_EQ(fetchFromPreviousVersion(tmd2, 1, &source, GAME_DIR("v2"), &progress), 0);
+    CHECK(!fileExists(GAME_DIR("v2") "00000201.app"));
+
+    freeDeltaSource(&source);
+    source.tmd = NULL;
+    CHECK_EQ(fetchFromPreviousVersion(tmd2, 0, &source, GAME_DIR("v2"), NULL), 0);
+}
+
+int main()
+{
+    setupTree();
+    RUN_TEST(testFindUnchangedContent);
+    RUN_TEST(testDeltaSize);
+    RUN_TEST(testFindPreviousVersion);
+    RUN_TEST(testFetchFromPreviousVersion);
+    teardownTree();
+    return TEST_RESULT();
+}
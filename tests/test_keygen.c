@@ -0,0 +1,170 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <string.h>
+
+#include <keygen.h>
+#include <otp.h>
+#include <titles.h>
+
+#include <openssl/evp.h>
+
+#include "test.h"
+
+static const uint8_t secret[10] = { 0xfd, 0x04, 0x01, 0x05, 0x06, 0x0b, 0x11, 0x1c, 0x2d, 0x49 };
+static const char *passwords[] = { "mypass", "nintendo", "test", "1234567890", "Lucy131211", "fbf10", "5678", "1234", "", "mypass" };
+
+// The key derivation written down once more, straight on top of OpenSSL
+static void referenceKey(uint64_t tid, uint8_t *out)
+{
+    const uint8_t *ti = (const uint8_t *)&tid;
+    size_t len = 7;
+    if(getTidHighFromTid(tid) == TID_HIGH_VWII_IOS)
+    {
+        ti += 2;
+        len = 5;
+    }
+
+    uint8_t salt[17];
+    memcpy(salt, secret, 10);
+    memcpy(salt + 10, ti + 1, len);
+    EVP_Digest(salt, 10 + len, salt, NULL, EVP_md5(), NULL);
+
+    const TitleEntry *entry = getTitleEntryByTid(tid);
+    const char *pw = passwords[entry == NULL ? TITLE_KEY_mypass : entry->key];
+    uint8_t key[16];
+    PKCS5_PBKDF2_HMAC(pw, strlen(pw), salt, 16, 20, EVP_sha1(), 16, key);
+
+    uint8_t iv[16] = { 0 };
+    memcpy(iv, &tid, 8);
+    EVP_CIPHER_CTX *aes = EVP_CIPHER_CTX_new();
+    EVP_EncryptInit_ex(aes, EVP_aes_128_cbc(), NULL, getCommonKey(), iv);
+    EVP_CIPHER_CTX_set_padding(aes, 0);
+    int outLen;
+    EVP_EncryptUpdate(aes, out, &outLen, key, 16);
+    EVP_CIPHER_CTX_free(aes);
+}
+
+// What getTitleEntryByTid() did before the index: The first match in database order
+static const TitleEntry *linearLookup(uint64_t tid)
+{
+    TITLE_CATEGORY cat;
+    switch(getTidHighFromTid(tid))
+    {
+        case TID_HIGH_GAME:
+            cat = TITLE_CATEGORY_GAME;
+            break;
+        case TID_HIGH_UPDATE:
+            cat = TITLE_CATEGORY_UPDATE;
+            break;
+        case TID_HIGH_DLC:
+            cat = TITLE_CATEGORY_DLC;
+            break;
+        case TID_HIGH_DEMO:
+            cat = TITLE_CATEGORY_DEMO;
+            break;
+        default:
+            cat = TITLE_CATEGORY_ALL;
+    }
+
+    for(int pass = 0; pass < 2; ++pass)
+    {
+        const TitleEntry *e = getTitleEntries(cat);
+        for(size_t i = getTitleEntriesSize(cat); i != 0; --i, ++e)
+            if(e->tid == tid)
+                return e;
+
+        if(cat != TITLE_CATEGORY_GAME)
+            break;
+
+        cat = TITLE_CATEGORY_DISC;
+    }
+
+    return NULL;
+}
+
+static void testTitleLookup()
+{
+    for(int cat = 0; cat <= TITLE_CATEGORY_DISC; ++cat)
+    {
+        const TitleEntry *e = getTitleEntries(cat);
+        for(size_t i = getTitleEntriesSize(cat); i != 0; --i, ++e)
+        {
+            CHECK(getTitleEntryByTid(e->tid) == linearLookup(e->tid));
+            CHECK(getTitleEntryByTid(e->tid) != NULL);
+        }
+    }
+
+    // Unknown IDs, including ones between and around the known ones
+    const uint64_t unknown[] = { 0, 0x0005000010000000ull, 0x000500001FFFFFFFull, 0x0005000E00000000ull, 0x0005001010040000ull, UINT64_MAX };
+    for(size_t i = 0; i < sizeof(unknown) / sizeof(unknown[0]); ++i)
+        CHECK(getTitleEntryByTid(unknown[i]) == linearLookup(unknown[i]));
+}
+
+static void testMatchesReference()
+{
+    uint64_t tids[] = {
+        getTitleEntries(TITLE_CATEGORY_GAME)[0].tid,
+        getTitleEntries(TITLE_CATEGORY_GAME)[1].tid,
+        getTitleEntries(TITLE_CATEGORY_UPDATE)[2].tid,
+        getTitleEntries(TITLE_CATEGORY_DLC)[3].tid,
+        getTitleEntries(TITLE_CATEGORY_DISC)[8].tid,
+        0x0005000012345678ull, // Unknown, so "mypass"
+        0x0000000700000050ull, // vWii IOS, other part of the ID
+    };
+
+    uint8_t key[16];
+    uint8_t expected[16];
+    for(size_t i = 0; i < sizeof(tids) / sizeof(tids[0]); ++i)
+    {
+        referenceKey(tids[i], expected);
+        CHECK(generateKey(tids[i], key));
+        CHECK(memcmp(key, expected, 16) == 0);
+        // Now from the cache
+        CHECK(generateKey(tids[i], key));
+        CHECK(memcmp(key, expected, 16) == 0);
+    }
+}
+
+static void testBatch()
+{
+    // More titles than the cache holds, with repeats
+    uint64_t tids[KEY_CACHE_SIZE * 2];
+    const TitleEntry *e = getTitleEntries(TITLE_CATEGORY_ALL);
+    for(int i = 0; i < KEY_CACHE_SIZE * 2; ++i)
+        tids[i] = e[(i % (KEY_CACHE_SIZE + 5)) * 31].tid;
+
+    uint8_t keys[KEY_CACHE_SIZE * 2][16];
+    uint8_t expected[16];
+    CHECK(generateKeys(tids, KEY_CACHE_SIZE * 2, keys[0]));
+    for(int i = 0; i < KEY_CACHE_SIZE * 2; ++i)
+    {
+        referenceKey(tids[i], expected);
+        CHECK(memcmp(keys[i], expected, 16) == 0);
+    }
+
+    CHECK(generateKeys(tids, 0, keys[0]));
+}
+
+int main()
+{
+    RUN_TEST(testTitleLookup);
+    RUN_TEST(testMatchesReference);
+    RUN_TEST(testBatch);
+    return TEST_RESULT();
+}
@@ -0,0 +1,267 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <downloader.h>
+#include <file.h>
+#include <metaCache.h>
+#include <tmd.h>
+
+#include <coreinit/time.h>
+
+#include "fixtures.h"
+#include "test.h"
+
+#define TID      0x0005000010101000ull
+#define META_TMD METADATA_CACHE_DIR "0005000010101000_tmd"
+
+static const CONTENT_DESC contents[] = {
+    { .size = 3000, .hash = 0x11 },
+    { .size = 70000, .hash = 0x22, .hashed = true },
+};
+
+// Mirrors the header in src/metaCache.c
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    int32_t result;
+    OSTime fetched;
+} HEADER;
+
+/*
+ * Fake NUS: Every downloadFile() call returns nusResult and, on success, a
+ * copy of nusData.
+ */
+static int nusResult;
+static const void *nusData;
+static size_t nusSize;
+static int nusCalls;
+
+int downloadFile(const char *url, char *file, downloadData *data, FileType type, bool resume, QUEUE_DATA *queueData, RAMBUF *rambuf)
+{
+    ++nusCalls;
+    if(nusResult == 0)
+    {
+        free(rambuf->buf);
+        rambuf->buf = malloc(nusSize);
+        memcpy(rambuf->buf, nusData, nusSize);
+        rambuf->size = nusSize;
+    }
+
+    return nusResult;
+}
+
+static void setNus(int result, const void *data, size_t size)
+{
+    nusResult = result;
+    nusData = data;
+    nusSize = size;
+    nusCalls = 0;
+}
+
+static int fetch(const char *file, const char *titleVer, RAMBUF **out)
+{
+    RAMBUF *rambuf = allocRamBuf();
+    int ret = downloadMetadata(TID, file, titleVer, FILE_TYPE_TMD, NULL, NULL, rambuf);
+    if(out == NULL)
+        freeRamBuf(rambuf);
+    else
+        *out = rambuf;
+
+    return ret;
+}
+
+static void ageEntry(const char *path, OSTime age)
+{
+    char p[FS_MAX_PATH * 2];
+    sprintf(p, "%s%s", hostGetRoot(), path);
+    FILE *f = fopen(p, "r+b");
+    HEADER header;
+    fread(&header, sizeof(HEADER), 1, f);
+    header.fetched -= age;
+    fseek(f, 0, SEEK_SET);
+    fwrite(&header, sizeof(HEADER), 1, f);
+    fclose(f);
+}
+
+static void testStoresValidTmd()
+{
+    size_t size;
+    TMD *tmd = buildTmd(TID, 32, contents, 2, &size);
+    setNus(0, tmd, size);
+
+    RAMBUF *rambuf;
+    CHECK_EQ(fetch("tmd", "32", &rambuf), 0);
+    CHECK_EQ(nusCalls, 1);
+    freeRamBuf(rambuf);
+
+    CHECK_EQ(fetch("tmd", "32", &rambuf), 0);
+    CHECK_EQ(nusCalls, 1);
+    CHECK_EQ(rambuf->size, size);
+    CHECK(rambuf->buf != NULL && memcmp(rambuf->buf, tmd, size) == 0);
+    freeRamBuf(rambuf);
+
+    // Versioned TMDs don't expire
+    ageEntry(META_TMD ".32", OSSecondsToTicks(7 * 24 * 60 * 60));
+    CHECK_EQ(fetch("tmd", "32", NULL), 0);
+    CHECK_EQ(nusCalls, 1);
+    free(tmd);
+}
+
+static void testRejectsInvalidTmd()
+{
+    size_t size;
+    TMD *tmd = buildTmd(TID, 48, contents, 2, &size);
+
+    // Broken content hash
+    tmd->contents[0].size++;
+    setNus(0, tmd, size);
+    CHECK_EQ(fetch("tmd", "48", NULL), 0); // The caller checks it, too
+    CHECK(!fileExists(META_TMD ".48"));
+
+    // Wrong version
+    sealTmd(tmd);
+    setNus(0, tmd, size);
+    CHECK_EQ(fetch("tmd", "49", NULL), 0);
+    CHECK(!fileExists(META_TMD ".49"));
+
+    // Wrong title
+    TMD *other = buildTmd(TID + 1, 48, contents, 2, &size);
+    setNus(0, other, size);
+    CHECK_EQ(fetch("tmd", "48", NULL), 0);
+    CHECK(!fileExists(META_TMD ".48"));
+
+    // Truncated
+    setNus(0, tmd, size - 0x800);
+    CHECK_EQ(fetch("tmd", "48", NULL), 0);
+    CHECK(!fileExists(META_TMD ".48"));
+    CHECK_EQ(nusCalls, 1);
+
+    free(tmd);
+    free(other);
+}
+
+static void testDropsBrokenEntries()
+{
+    size_t size;
+    TMD *tmd = buildTmd(TID, 64, contents, 2, &size);
+    setNus(0, tmd, size);
+    CHECK_EQ(fetch("tmd", "64", NULL), 0);
+    CHECK(fileExists(META_TMD ".64"));
+
+    // Flip a byte of the cached TMD
+    char p[FS_MAX_PATH * 2];
+    sprintf(p, "%s%s", hostGetRoot(), META_TMD ".64");
+    FILE *f = fopen(p, "r+b");
+    fseek(f, sizeof(HEADER) + sizeof(TMD) + 4, SEEK_SET);
+    fputc(0xFF, f);
+    fclose(f);
+
+    int result = -1;
+    RAMBUF *rambuf = allocRamBuf();
+    CHECK(!loadCachedMetadata(TID, "tmd", "64", true, rambuf, &result));
+    CHECK(!fileExists(META_TMD ".64"));
+    freeRamBuf(rambuf);
+
+    // Downloaded again
+    CHECK_EQ(fetch("tmd", "64", NULL), 0);
+    CHECK_EQ(nusCalls, 2);
+    CHECK(fileExists(META_TMD ".64"));
+    free(tmd);
+}
+
+static void testLatestTmdExpires()
+{
+    size_t size;
+    TMD *tmd = buildTmd(TID, 80, contents, 2, &size);
+    setNus(0, tmd, size);
+    CHECK_EQ(fetch("tmd", "", NULL), 0);
+    CHECK_EQ(fetch("tmd", "", NULL), 0);
+    CHECK_EQ(nusCalls, 1);
+
+    ageEntry(META_TMD, OSSecondsToTicks(25 * 60 * 60));
+    CHECK_EQ(fetch("tmd", "", NULL), 0);
+    CHECK_EQ(nusCalls, 2);
+
+    // Offline: The outdated one is better than nothing
+    ageEntry(META_TMD, OSSecondsToTicks(25 * 60 * 60));
+    setNus(1, NULL, 0);
+    RAMBUF *rambuf;
+    CHECK_EQ(fetch("tmd", "", &rambuf), 0);
+    CHECK_EQ(nusCalls, 1);
+    CHECK_EQ(rambuf->size, size);
+    freeRamBuf(rambuf);
+    free(tmd);
+}
+
+static void testTickets()
+{
+    size_t size;
+    void *ticket = buildTicket(TID + 1, &size);
+    setNus(0, ticket, size);
+    CHECK_EQ(fetch("cetk", "", NULL), 0);
+    CHECK(!fileExists(METADATA_CACHE_DIR "0005000010101000_cetk"));
+    free(ticket);
+
+    ticket = buildTicket(TID, &size);
+    setNus(0, ticket, size);
+    CHECK_EQ(fetch("cetk", "", NULL), 0);
+    CHECK(fileExists(METADATA_CACHE_DIR "0005000010101000_cetk"));
+
+    // Tickets don't expire
+    ageEntry(METADATA_CACHE_DIR "0005000010101000_cetk", OSSecondsToTicks(7 * 24 * 60 * 60));
+    CHECK_EQ(fetch("cetk", "", NULL), 0);
+    CHECK_EQ(nusCalls, 1);
+    free(ticket);
+}
+
+static void testMissingTicketExpires()
+{
+    FSARemove(1, METADATA_CACHE_DIR "0005000010101000_cetk");
+
+    // The NUS has no ticket, the fake one is needed for a day
+    setNus(2, NULL, 0);
+    CHECK_EQ(fetch("cetk", "", NULL), 2);
+    CHECK_EQ(fetch("cetk", "", NULL), 2);
+    CHECK_EQ(nusCalls, 1);
+
+    // But it might show up later
+    ageEntry(METADATA_CACHE_DIR "0005000010101000_cetk", OSSecondsToTicks(25 * 60 * 60));
+    size_t size;
+    void *ticket = buildTicket(TID, &size);
+    setNus(0, ticket, size);
+    CHECK_EQ(fetch("cetk", "", NULL), 0);
+    CHECK_EQ(nusCalls, 1);
+    free(ticket);
+}
+
+int main()
+{
+    hostMakeRoot();
+    makeHostDirs(NUSDIR_SD);
+    RUN_TEST(testStoresValidTmd);
+    RUN_TEST(testRejectsInvalidTmd);
+    RUN_TEST(testDropsBrokenEntries);
+    RUN_TEST(testLatestTmdExpires);
+    RUN_TEST(testTickets);
+    RUN_TEST(testMissingTicketExpires);
+    hostRemoveRoot();
+    return TEST_RESULT();
+}
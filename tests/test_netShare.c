@@ -0,0 +1,157 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdio.h>
+
+#include <netShare.h>
+
+#include "test.h"
+#include "tlsServer.h"
+
+#define TRANSFERS 8
+#define FILE_SIZE 4096
+
+static int port;
+
+static size_t discardData(void *buf, size_t size, size_t nmemb, void *userp)
+{
+    (void)buf;
+    (void)userp;
+
+    return size * nmemb;
+}
+
+// Set up like the main handle in initDownloader(), minus the console specific parts
+static CURL *newHandle(CURLSH *share)
+{
+    char url[64];
+    sprintf(url, "https://127.0.0.1:%d/%d", port, FILE_SIZE);
+
+    CURL *handle = curl_easy_init();
+    if(handle == NULL)
+        return NULL;
+
+    if(curl_easy_setopt(handle, CURLOPT_URL, url) == CURLE_OK &&
+       curl_easy_setopt(handle, CURLOPT_SSL_VERIFYPEER, 0L) == CURLE_OK &&
+       curl_easy_setopt(handle, CURLOPT_SSL_VERIFYHOST, 0L) == CURLE_OK &&
+       curl_easy_setopt(handle, CURLOPT_FAILONERROR, 1L) == CURLE_OK &&
+       curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, discardData) == CURLE_OK &&
+       curl_easy_setopt(handle, CURLOPT_SHARE, share) == CURLE_OK)
+        return handle;
+
+    curl_easy_cleanup(handle);
+    return NULL;
+}
+
+// Like the handles of the parallel TMD fetch, see downloadTmds()
+static CURL *dupHandle(CURL *handle, CURLSH *share)
+{
+    CURL *ret = curl_easy_duphandle(handle);
+    if(ret != NULL && curl_easy_setopt(ret, CURLOPT_SHARE, share) != CURLE_OK)
+    {
+        curl_easy_cleanup(ret);
+        ret = NULL;
+    }
+
+    return ret;
+}
+
+// Alternates between two handles the way downloadFile() and downloadTmds() do
+static void runTransfers(CURLSH *share, bool fresh, TLS_SERVER_STATS *out)
+{
+    resetTlsServerStats();
+    CURL *handles[2];
+    handles[0] = newHandle(share);
+    handles[1] = handles[0] == NULL ? NULL : dupHandle(handles[0], share);
+    CHECK(handles[1] != NULL);
+    if(handles[1] != NULL)
+    {
+        for(int i = 0; i < TRANSFERS; ++i)
+        {
+            CURL *handle = handles[i & 1];
+            // What downloadFile() does after a network reset
+            curl_easy_setopt(handle, CURLOPT_FRESH_CONNECT, fresh ? 1L : 0L);
+            CHECK_EQ(curl_easy_perform(handle), CURLE_OK);
+        }
+    }
+
+    getTlsServerStats(out);
+    for(int i = 0; i < 2; ++i)
+        if(handles[i] != NULL)
+            curl_easy_cleanup(handles[i]);
+}
+
+static void testSharedConnection()
+{
+    CURLSH *share = initNetShare();
+    CHECK(share != NULL);
+
+    TLS_SERVER_STATS stats;
+    runTransfers(share, false, &stats);
+    CHECK_EQ(stats.requests, TRANSFERS);
+    CHECK_EQ(stats.connections, 1);
+    CHECK_EQ(stats.handshakes, 1);
+    CHECK_EQ(stats.resumed, 0);
+
+    curl_share_cleanup(share);
+}
+
+static void testUnshared()
+{
+    // Without the share each handle has its own pool and session cache
+    TLS_SERVER_STATS stats;
+    runTransfers(NULL, false, &stats);
+    CHECK_EQ(stats.requests, TRANSFERS);
+    CHECK_EQ(stats.connections, 2);
+    CHECK_EQ(stats.handshakes, 2);
+}
+
+static void testSessionResumption()
+{
+    // New connections still skip the full handshake thanks to the shared session cache
+    CURLSH *share = initNetShare();
+    CHECK(share != NULL);
+
+    TLS_SERVER_STATS stats;
+    runTransfers(share, true, &stats);
+    CHECK_EQ(stats.requests, TRANSFERS);
+    CHECK_EQ(stats.connections, TRANSFERS);
+    CHECK_EQ(stats.handshakes, 1);
+    CHECK_EQ(stats.resumed, TRANSFERS - 1);
+
+    curl_share_cleanup(share);
+}
+
+int main()
+{
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    port = startTlsServer();
+    if(port == 0)
+    {
+        fprintf(stderr, "Can't start the TLS server\n");
+        return 1;
+    }
+
+    RUN_TEST(testSharedConnection);
+    RUN_TEST(testUnshared);
+    RUN_TEST(testSessionResumption);
+
+    stopTlsServer();
+    curl_global_cleanup();
+    return TEST_RESULT();
+}
@@ -0,0 +1,263 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <netStats.h>
+
+#include "fixtures.h"
+#include "test.h"
+#include "tlsServer.h"
+
+#define TID       0x0005000010101000ull
+#define FILE_SIZE 4096
+
+static int port;
+
+static size_t discardData(void *buf, size_t size, size_t nmemb, void *userp)
+{
+    (void)buf;
+    (void)userp;
+
+    return size * nmemb;
+}
+
+// Returns field n (counting from 0) of a CSV row, quoted fields must not contain commas
+static uint64_t field(const char *row, int n)
+{
+    while(n--)
+        row = strchr(row, ',') + 1;
+
+    return strtoull(row, NULL, 10);
+}
+
+static void testAddTransfer()
+{
+    NET_STATS stats;
+    memset(&stats, 0x00, sizeof(stats));
+
+    NET_TRANSFER fresh = {
+        .lookup = 1000,
+        .connect = 2000,
+        .tls = 3000,
+        .ttfb = 10000,
+        .total = 50000,
+        .bytes = 4096,
+        .speed = 80000,
+        .newConnections = 1,
+        .http = NET_HTTP_2,
+    };
+    addTransferToNetStats(&stats, &fresh);
+
+    // Reused connections don't count into the connection phases
+    NET_TRANSFER reused = {
+        .lookup = 999,
+        .connect = 999,
+        .tls = 999,
+        .ttfb = 5000,
+        .total = 20000,
+        .bytes = 1024,
+        .speed = 50000,
+        .resumeOffset = 512,
+        .http = NET_HTTP_1,
+        .failed = true,
+    };
+    addTransferToNetStats(&stats, &reused);
+
+    CHECK_EQ(stats.transfers, 2);
+    CHECK_EQ(stats.failed, 1);
+    CHECK_EQ(stats.resumed, 1);
+    CHECK_EQ(stats.resumedBytes, 512);
+    CHECK_EQ(stats.newConnections, 1);
+    CHECK_EQ(stats.lookup, 1000);
+    CHECK_EQ(stats.connect, 2000);
+    CHECK_EQ(stats.tls, 3000);
+    CHECK_EQ(stats.ttfb, 15000);
+    CHECK_EQ(stats.total, 70000);
+    CHECK_EQ(stats.bytes, 5120);
+    CHECK_EQ(stats.maxSpeed, 80000);
+    CHECK_EQ(stats.http[NET_HTTP_1], 1);
+    CHECK_EQ(stats.http[NET_HTTP_2], 1);
+    CHECK_EQ(stats.http[NET_HTTP_UNKNOWN], 0);
+}
+
+static void testFormatRow()
+{
+    NET_STATS stats = {
+        .transfers = 4,
+        .failed = 1,
+        .retries = 2,
+        .resumed = 1,
+        .newConnections = 2,
+        .http = { [NET_HTTP_1] = 3, [NET_HTTP_2] = 1 },
+        .resumedBytes = 1000,
+        .bytes = 2 * 1024 * 1024,
+        .lookup = 4000,
+        .connect = 10000,
+        .tls = 30000,
+        .ttfb = 400000,
+        .total = 2000000,
+        .maxSpeed = 3 * 1024 * 1024,
+    };
+    char line[NET_REPORT_LINE_LENGTH];
+
+    // Names get quoted, inner quotes doubled
+    size_t len = formatNetStatsRow(line, "title", TID, "Name, with \"quotes\"", &stats);
+    const char *expected = "title,0005000010101000,\"Name, with \"\"quotes\"\"\",4,1,2,1,1000,2097152,2000,1024,3072,2,2,5,15,100,3,1,0,0\n";
+    CHECK(strcmp(line, expected) == 0);
+    CHECK_EQ(len, strlen(expected));
+
+    memset(&stats, 0x00, sizeof(stats));
+    len = formatNetStatsRow(line, "session", 0, NULL, &stats);
+    CHECK(strcmp(line, "session,,,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0\n") == 0);
+    CHECK_EQ(len, strlen(line));
+
+    // Long names get cut
+    char name[NET_REPORT_NAME_LENGTH * 2];
+    memset(name, 'N', sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    formatNetStatsRow(line, "title", TID, name, &stats);
+    CHECK_EQ(strspn(line + strlen("title,0005000010101000,\""), "N"), NET_REPORT_NAME_LENGTH);
+}
+
+static void testSummary()
+{
+    NET_STATS stats;
+    memset(&stats, 0x00, sizeof(stats));
+    char out[NET_SUMMARY_LENGTH];
+    CHECK(!formatNetStatsSummary(&stats, out));
+
+    stats.transfers = 2;
+    stats.bytes = 4096;
+    stats.total = 1000000;
+    stats.ttfb = 60000;
+    CHECK(formatNetStatsSummary(&stats, out));
+    CHECK(strcmp(out, "Network: 4096 B @ 4096 B/s | TTFB 30 ms") == 0);
+
+    stats.retries = 3;
+    stats.resumed = 1;
+    stats.failed = 2;
+    CHECK(formatNetStatsSummary(&stats, out));
+    CHECK(strcmp(out, "Network: 4096 B @ 4096 B/s | TTFB 30 ms | 3 retries | 1 resumed | 2 failed") == 0);
+}
+
+static int readReport(char rows[][NET_REPORT_LINE_LENGTH], int max)
+{
+    char path[512];
+    sprintf(path, "%s" NET_REPORT_PATH, hostGetRoot());
+    FILE *f = fopen(path, "r");
+    if(f == NULL)
+        return 0;
+
+    int n = 0;
+    while(n < max && fgets(rows[n], NET_REPORT_LINE_LENGTH, f) != NULL)
+        ++n;
+
+    fclose(f);
+    return n;
+}
+
+static void testReport()
+{
+    char url[64];
+    sprintf(url, "https://127.0.0.1:%d/%d", port, FILE_SIZE);
+    CURL *handle = curl_easy_init();
+    CHECK(handle != NULL);
+    if(handle == NULL)
+        return;
+
+    curl_easy_setopt(handle, CURLOPT_URL, url);
+    curl_easy_setopt(handle, CURLOPT_SSL_VERIFYPEER, 0L);
+    curl_easy_setopt(handle, CURLOPT_SSL_VERIFYHOST, 0L);
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, discardData);
+
+    // Two transfers over one connection, the second one resumed after a retry
+    startTitleNetStats(TID, "Test \"title\"");
+    CHECK_EQ(curl_easy_perform(handle), CURLE_OK);
+    recordTransfer(handle, 0, false);
+    recordRetry();
+    CHECK_EQ(curl_easy_perform(handle), CURLE_OK);
+    recordTransfer(handle, 1024, false);
+    finishTitleNetStats();
+    curl_easy_cleanup(handle);
+
+    char rows[4][NET_REPORT_LINE_LENGTH];
+    CHECK_EQ(readReport(rows, 4), 3);
+    CHECK(strncmp(rows[0], "scope,tid,name,", strlen("scope,tid,name,")) == 0);
+    CHECK(strncmp(rows[1], "session,,,", strlen("session,,,")) == 0);
+    CHECK(strncmp(rows[2], "title,0005000010101000,\"Test \"\"title\"\"\",", strlen("title,0005000010101000,\"Test \"\"title\"\"\",")) == 0);
+    for(int i = 1; i < 3; ++i)
+    {
+        CHECK_EQ(field(rows[i], 3), 2); // transfers
+        CHECK_EQ(field(rows[i], 4), 0); // failed
+        CHECK_EQ(field(rows[i], 5), 1); // retries
+        CHECK_EQ(field(rows[i], 6), 1); // resumed
+        CHECK_EQ(field(rows[i], 7), 1024); // resumed_bytes
+        CHECK_EQ(field(rows[i], 8), 2 * FILE_SIZE); // bytes
+        CHECK_EQ(field(rows[i], 12), 1); // new_connections
+        CHECK_EQ(field(rows[i], 17), 2); // http1
+    }
+
+    // The summary covers everything since the last finished screen
+    char out[NET_SUMMARY_LENGTH];
+    CHECK(getNetStatsSummary(out));
+    CHECK(strncmp(out, "Network: 8192 B @ ", strlen("Network: 8192 B @ ")) == 0);
+    CHECK(!getNetStatsSummary(out));
+
+    // Transfers outside of a title only count into the session, one without a response failed
+    handle = curl_easy_init();
+    recordTransfer(handle, 0, false);
+    curl_easy_cleanup(handle);
+    writeNetStatsReport();
+    CHECK_EQ(readReport(rows, 4), 3);
+    CHECK_EQ(field(rows[1], 3), 3);
+    CHECK_EQ(field(rows[1], 4), 1);
+    CHECK_EQ(field(rows[2], 3), 2);
+    CHECK(!getNetStatsSummary(out));
+
+    clearNetStats();
+    writeNetStatsReport();
+    CHECK_EQ(readReport(rows, 4), 2);
+    CHECK(strcmp(rows[1], "session,,,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0\n") == 0);
+}
+
+int main()
+{
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    port = startTlsServer();
+    if(port == 0)
+    {
+        fprintf(stderr, "Can't start the TLS server\n");
+        return 1;
+    }
+
+    hostMakeRoot();
+    makeHostDirs("/vol/app_sd/");
+
+    RUN_TEST(testAddTransfer);
+    RUN_TEST(testFormatRow);
+    RUN_TEST(testSummary);
+    RUN_TEST(testReport);
+
+    hostRemoveRoot();
+    stopTlsServer();
+    curl_global_cleanup();
+    return TEST_RESULT();
+}
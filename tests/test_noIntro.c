@@ -0,0 +1,306 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <file.h>
+#include <no-intro.h>
+#include <ticket.h>
+#include <tmd.h>
+
+#include "fixtures.h"
+#include "test.h"
+
+#define TID     0x0005000010204000ull
+#define SET_DIR INSTALL_DIR_SD "No-Intro [0005000010204000]/"
+#define NUS_DIR INSTALL_DIR_SD "NUS [0005000010204000]/"
+
+static const CONTENT_DESC contents[] = {
+    { .size = 3000, .hash = 0x11 },
+    { .size = 70000, .hash = 0x22, .hashed = true },
+    { .size = 5000, .hash = 0x33 },
+    { .size = 100, .hash = 0x44 },
+};
+
+static void writeIn(const char *dir, const char *file, const void *data, size_t size)
+{
+    char path[FS_MAX_PATH];
+    sprintf(path, "%s%s", dir, file);
+    writeHostFile(path, data, size);
+}
+
+// A no-intro dump: tmd, cetk (optional) and contents without extension
+static void writeSet(const char *dir, bool ticket)
+{
+    char path[FS_MAX_PATH * 2];
+    sprintf(path, "rm -rf '%s%s'", hostGetRoot(), dir);
+    CHECK_EQ(system(path), 0);
+    makeHostDirs(dir);
+
+    size_t size;
+    TMD *tmd = buildTmd(TID, 0, contents, 4, &size);
+    writeIn(dir, "tmd", tmd, size);
+    if(ticket)
+    {
+        void *tik = buildTicket(TID, &size);
+        writeIn(dir, "cetk", tik, size);
+        free(tik);
+    }
+
+    char name[13];
+    for(uint16_t i = 0; i < tmd->num_contents; ++i)
+    {
+        uint8_t *data = malloc(tmd->contents[i].size);
+        for(size_t j = 0; j < tmd->contents[i].size; ++j)
+            data[j] = (uint8_t)(i * 31 + j);
+
+        sprintf(name, "%08x", tmd->contents[i].cid);
+        writeIn(dir, name, data, tmd->contents[i].size);
+        if(tmd->contents[i].type & TMD_CONTENT_TYPE_HASHED)
+        {
+            strcat(name, ".h3");
+            writeIn(dir, name, data, getH3size(tmd->contents[i].size));
+        }
+
+        free(data);
+    }
+
+    free(tmd);
+}
+
+static int compareNames(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Sorted "name size checksum" lines of all files in dir
+static void snapshot(const char *dir, char *out)
+{
+    char path[FS_MAX_PATH * 2];
+    char *names[32];
+    int n = 0;
+    sprintf(path, "%s%s", hostGetRoot(), dir);
+    DIR *d = opendir(path);
+    struct dirent *e;
+    while(d != NULL && (e = readdir(d)) != NULL && n < 32)
+        if(e->d_name[0] != '.')
+            names[n++] = strdup(e->d_name);
+
+    if(d != NULL)
+        closedir(d);
+
+    qsort(names, n, sizeof(char *), compareNames);
+    *out = '\0';
+    for(int i = 0; i < n; ++i)
+    {
+        sprintf(path, "%s%s%s", hostGetRoot(), dir, names[i]);
+        FILE *f = fopen(path, "rb");
+        uint32_t sum = 2166136261u;
+        long size = 0;
+        int c;
+        while(f != NULL && (c = fgetc(f)) != EOF)
+        {
+            sum = (sum ^ (uint32_t)c) * 16777619u;
+            ++size;
+        }
+
+        if(f != NULL)
+            fclose(f);
+
+        out += sprintf(out, "%s %ld %08x\n", names[i], size, sum);
+        free(names[i]);
+    }
+}
+
+static bool inDir(const char *dir, const char *file)
+{
+    char path[FS_MAX_PATH];
+    sprintf(path, "%s%s", dir, file);
+    return fileExists(path);
+}
+
+static void testTitleFilePath()
+{
+    char out[FS_MAX_PATH];
+    writeSet(SET_DIR, true);
+    CHECK(getTitleFilePath(SET_DIR, "title.tmd", out));
+    CHECK(strcmp(out, SET_DIR "tmd") == 0);
+    CHECK(getTitleFilePath(SET_DIR, "title.tik", out));
+    CHECK(strcmp(out, SET_DIR "cetk") == 0);
+    CHECK(getTitleFilePath(SET_DIR, "00000001.app", out));
+    CHECK(strcmp(out, SET_DIR "00000001") == 0);
+
+    // Names without a no-intro counterpart
+    CHECK(getTitleFilePath(SET_DIR, "00000001.h3", out)); // Same name in both layouts
+    CHECK(strcmp(out, SET_DIR "00000001.h3") == 0);
+    CHECK(!getTitleFilePath(SET_DIR, "title.cert", out));
+    CHECK(strcmp(out, SET_DIR "title.cert") == 0);
+    CHECK(!getTitleFilePath(SET_DIR, "00000009.app", out));
+    CHECK(strcmp(out, SET_DIR "00000009.app") == 0); // Left at the NUS name
+    CHECK(!getTitleFilePath(SET_DIR, "0000001.app", out)); // 7 characters
+
+    // NUS names win
+    writeIn(SET_DIR, "00000002.app", "x", 1);
+    CHECK(getTitleFilePath(SET_DIR, "00000002.app", out));
+    CHECK(strcmp(out, SET_DIR "00000002.app") == 0);
+}
+
+static void testTransformAndRevert()
+{
+    char before[4096];
+    char after[4096];
+    for(int ticket = 1; ticket >= 0; --ticket)
+    {
+        writeSet(SET_DIR, ticket);
+        snapshot(SET_DIR, before);
+
+        NO_INTRO_DATA *data = transformNoIntro(SET_DIR);
+        CHECK(data != NULL);
+        if(data == NULL)
+            continue;
+
+        CHECK_EQ(data->hadTicket, ticket);
+        CHECK_EQ(data->ac, 4);
+        CHECK(inDir(SET_DIR, "title.tmd"));
+        CHECK(inDir(SET_DIR, "title.tik"));
+        CHECK(inDir(SET_DIR, "title.cert"));
+        CHECK(inDir(SET_DIR, "00000003.app"));
+        CHECK(!inDir(SET_DIR, "tmd"));
+        CHECK(!inDir(SET_DIR, "cetk"));
+        CHECK(!recoverNoIntro(SET_DIR)); // Fully converted
+
+        revertNoIntro(data);
+        snapshot(SET_DIR, after);
+        CHECK(strcmp(before, after) == 0);
+    }
+}
+
+static void testNotASet()
+{
+    // A NUS download has no tmd, so its title.tik is no marker
+    char before[4096];
+    char after[4096];
+    writeSet(NUS_DIR, true);
+    NO_INTRO_DATA *data = transformNoIntro(NUS_DIR);
+    CHECK(data != NULL);
+    if(data != NULL)
+        keepNoIntro(data);
+
+    snapshot(NUS_DIR, before);
+    CHECK(!recoverNoIntro(NUS_DIR));
+    snapshot(NUS_DIR, after);
+    CHECK(strcmp(before, after) == 0);
+
+    // Neither is a folder without a valid tmd, which stays untouched
+    writeSet(SET_DIR, false);
+    writeIn(SET_DIR, "tmd", "broken", 6);
+    snapshot(SET_DIR, before);
+    CHECK(transformNoIntro(SET_DIR) == NULL);
+    snapshot(SET_DIR, after);
+    CHECK(strcmp(before, after) == 0);
+}
+
+// Runs a transform (and a revert) in a child which dies after the given number of renames
+static bool crashAfter(int renames, bool revert)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if(pid == 0)
+    {
+        hostCrashAfterRenames(renames);
+        NO_INTRO_DATA *data = transformNoIntro(SET_DIR);
+        if(data != NULL && revert)
+            revertNoIntro(data);
+
+        _exit(0);
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 3;
+}
+
+static void crashAndRecover(bool ticket, bool revert)
+{
+    char before[4096];
+    char after[4096];
+    int crashes = 0;
+    for(int renames = 0;; ++renames)
+    {
+        writeSet(SET_DIR, ticket);
+        snapshot(SET_DIR, before);
+        if(!crashAfter(renames, revert))
+            break; // Got through
+
+        ++crashes;
+        // Died before the first or after the last rename of the transform
+        bool untouched = !inDir(SET_DIR, "title.tik");
+        bool converted = inDir(SET_DIR, "title.tmd") && !inDir(SET_DIR, "tmd");
+        CHECK_EQ(recoverNoIntro(SET_DIR), !untouched && !converted);
+        if(converted)
+            continue; // Stays in the NUS layout
+
+        // A generated ticket can't be told apart from a dumped one, so it's kept as cetk
+        if(!ticket)
+        {
+            sprintf(after, "%s%scetk", hostGetRoot(), SET_DIR);
+            remove(after);
+        }
+
+        snapshot(SET_DIR, after);
+        if(strcmp(before, after) != 0)
+        {
+            fprintf(stderr, "Crash after %d renames (revert: %d, ticket: %d)\n%s---\n%s", renames, revert, ticket, before, after);
+            CHECK(false);
+        }
+    }
+
+    // Ticket, 4 contents and tmd, the revert renames the same back
+    CHECK_EQ(crashes, (ticket ? 6 : 5) * (revert ? 2 : 1));
+}
+
+static void testCrashWhileTransforming()
+{
+    crashAndRecover(true, false);
+    crashAndRecover(false, false);
+}
+
+static void testCrashWhileReverting()
+{
+    crashAndRecover(true, true);
+    crashAndRecover(false, true);
+}
+
+int main()
+{
+    hostMakeRoot();
+
+    RUN_TEST(testTitleFilePath);
+    RUN_TEST(testTransformAndRevert);
+    RUN_TEST(testNotASet);
+    RUN_TEST(testCrashWhileTransforming);
+    RUN_TEST(testCrashWhileReverting);
+
+    hostRemoveRoot();
+    return TEST_RESULT();
+}
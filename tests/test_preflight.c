@@ -0,0 +1,304 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <file.h>
+#include <preflight.h>
+#include <ticket.h>
+#include <titles.h>
+#include <tmd.h>
+
+#include "fixtures.h"
+#include "test.h"
+
+#define TID       0x0005000010301000ull
+#define TITLE_DIR INSTALL_DIR_SD "Preflight [0005000010301000]/"
+
+static const CONTENT_DESC contents[] = {
+    { .size = 3000, .hash = 0x11 }, // Padded to 3008 on disk
+    { .size = 4 * 0x10000, .hash = 0x22, .hashed = true },
+    { .size = 4096, .hash = 0x33 },
+};
+
+#define CONTENTS (sizeof(contents) / sizeof(contents[0]))
+
+static TMD *tmd;
+
+static void setFile(PREFLIGHT_FILE *file, const char *name, uint64_t size)
+{
+    strcpy(file->name, name);
+    file->size = size;
+}
+
+// The listing of a complete folder for the TMD above, unsorted
+static size_t goodListing(PREFLIGHT_FILE *files)
+{
+    size_t n = 0;
+    setFile(files + n++, "title.tik", 0x350);
+    setFile(files + n++, "00000002.app", 4096);
+    setFile(files + n++, "00000000.app", 3008);
+    setFile(files + n++, "00000001.h3", 20);
+    setFile(files + n++, "00000001.app", 4 * 0x10000);
+    setFile(files + n++, "title.cert", 0xA00);
+    return n;
+}
+
+static PREFLIGHT_FILE *findInListing(PREFLIGHT_FILE *files, size_t count, const char *name)
+{
+    for(size_t i = 0; i < count; ++i)
+        if(strcmp(files[i].name, name) == 0)
+            return files + i;
+
+    return NULL;
+}
+
+static void removeFromListing(PREFLIGHT_FILE *files, size_t *count, const char *name)
+{
+    PREFLIGHT_FILE *file = findInListing(files, *count, name);
+    *file = files[--*count];
+}
+
+static void testSortListing()
+{
+    PREFLIGHT_FILE files[5];
+    setFile(files + 0, "title.tik", 0);
+    setFile(files + 1, "0000000A.app", 0);
+    setFile(files + 2, "00000001.h3", 0);
+    setFile(files + 3, "TITLE.CERT", 0);
+    setFile(files + 4, "00000001.APP", 0);
+    sortListing(files, 5);
+
+    const char *expected[] = { "00000001.APP", "00000001.h3", "0000000A.app", "TITLE.CERT", "title.tik" };
+    for(int i = 0; i < 5; ++i)
+        CHECK(strcmp(files[i].name, expected[i]) == 0);
+}
+
+static void testCheckListing()
+{
+    PREFLIGHT_FILE files[8];
+    PREFLIGHT_RESULT result;
+    size_t count = goodListing(files);
+    sortListing(files, count);
+    CHECK(checkListing(tmd, files, count, &result));
+    CHECK_EQ(result.state, PREFLIGHT_STATE_OK);
+
+    // Unpadded sizes are fine, too, names are case insensitive
+    findInListing(files, count, "00000000.app")->size = 3000;
+    strcpy(findInListing(files, count, "00000002.app")->name, "00000002.APP");
+    sortListing(files, count);
+    CHECK(checkListing(tmd, files, count, &result));
+
+    count = goodListing(files);
+    findInListing(files, count, "00000000.app")->size = 2999;
+    sortListing(files, count);
+    CHECK(!checkListing(tmd, files, count, &result));
+    CHECK_EQ(result.state, PREFLIGHT_STATE_BAD_APP_SIZE);
+    CHECK_EQ(result.cid, 0);
+    CHECK_EQ(result.expected, 3000);
+    CHECK_EQ(result.found, 2999);
+
+    count = goodListing(files);
+    removeFromListing(files, &count, "00000002.app");
+    sortListing(files, count);
+    CHECK(!checkListing(tmd, files, count, &result));
+    CHECK_EQ(result.state, PREFLIGHT_STATE_MISSING_APP);
+    CHECK_EQ(result.cid, 2);
+
+    count = goodListing(files);
+    removeFromListing(files, &count, "00000001.h3");
+    sortListing(files, count);
+    CHECK(!checkListing(tmd, files, count, &result));
+    CHECK_EQ(result.state, PREFLIGHT_STATE_MISSING_H3);
+    CHECK_EQ(result.cid, 1);
+
+    count = goodListing(files);
+    findInListing(files, count, "00000001.h3")->size = 40;
+    sortListing(files, count);
+    CHECK(!checkListing(tmd, files, count, &result));
+    CHECK_EQ(result.state, PREFLIGHT_STATE_BAD_H3_SIZE);
+    CHECK_EQ(result.expected, 20);
+    CHECK_EQ(result.found, 40);
+
+    count = goodListing(files);
+    removeFromListing(files, &count, "title.tik");
+    sortListing(files, count);
+    CHECK(!checkListing(tmd, files, count, &result));
+    CHECK_EQ(result.state, PREFLIGHT_STATE_MISSING_TIK);
+
+    count = goodListing(files);
+    removeFromListing(files, &count, "title.cert");
+    sortListing(files, count);
+    CHECK(!checkListing(tmd, files, count, &result));
+    CHECK_EQ(result.state, PREFLIGHT_STATE_MISSING_CERT);
+}
+
+static void testTicketStructure()
+{
+    size_t size;
+    TICKET *ticket = buildTicket(TID, &size);
+    CHECK(checkTicketStructure(ticket, size, TID));
+    CHECK(!checkTicketStructure(ticket, size, TID + 1));
+    CHECK(!checkTicketStructure(ticket, sizeof(TICKET) - 1, TID));
+    CHECK(!checkTicketStructure(ticket, PREFLIGHT_MAX_META + 1, TID));
+
+    // The header sections have to fit into the file
+    ticket->total_hdr_size = size;
+    CHECK(!checkTicketStructure(ticket, size, TID));
+    ticket->total_hdr_size = 0x14;
+
+    ticket->header_version = 0;
+    CHECK(!checkTicketStructure(ticket, size, TID));
+    ticket->header_version = 1;
+
+    ticket->header.sig_type = 0x00010003;
+    CHECK(!checkTicketStructure(ticket, size, TID));
+    free(ticket);
+}
+
+static void testCertStructure()
+{
+    size_t size;
+    CETK *cert = buildCert(&size);
+    CHECK(checkCertStructure(cert, size));
+    CHECK(!checkCertStructure(cert, size - 1));
+
+    cert->cert3.issuer[0] = 'X';
+    CHECK(!checkCertStructure(cert, size));
+    cert->cert3.issuer[0] = 'R';
+
+    cert->cert1.sig_type = 0x00010004;
+    CHECK(!checkCertStructure(cert, size));
+    free(cert);
+}
+
+static void writeIn(const char *file, const void *data, size_t size)
+{
+    char path[FS_MAX_PATH];
+    sprintf(path, TITLE_DIR "%s", file);
+    writeHostFile(path, data, size);
+}
+
+static void hostPath(const char *file, char *out)
+{
+    sprintf(out, "%s" TITLE_DIR "%s", hostGetRoot(), file);
+}
+
+static void buildFolder()
+{
+    makeHostDirs(TITLE_DIR);
+    size_t size;
+    void *buf = buildTicket(TID, &size);
+    writeIn("title.tik", buf, size);
+    free(buf);
+    buf = buildCert(&size);
+    writeIn("title.cert", buf, size);
+    free(buf);
+
+    char name[16];
+    buf = calloc(1, 4 * 0x10000);
+    for(uint16_t i = 0; i < CONTENTS; ++i)
+    {
+        sprintf(name, "%08x.app", tmd->contents[i].cid);
+        writeIn(name, buf, (tmd->contents[i].size + 15) & ~15);
+        if(tmd->contents[i].type & TMD_CONTENT_TYPE_HASHED)
+        {
+            sprintf(name, "%08x.h3", tmd->contents[i].cid);
+            writeIn(name, buf, getH3size(tmd->contents[i].size));
+        }
+    }
+
+    // Leftovers of older versions and other files don't matter
+    for(int i = 0; i < 12; ++i)
+    {
+        sprintf(name, "%08x.app", 0x100 + i);
+        writeIn(name, buf, 16);
+    }
+    writeIn("title.tmd", tmd, 16);
+    writeIn("readme.txt", buf, 16);
+    makeHostDirs(TITLE_DIR "subfolder/");
+    free(buf);
+}
+
+static void testPreflightInstall()
+{
+    PREFLIGHT_RESULT result;
+    char out[256];
+    CHECK(preflightInstall(TITLE_DIR, tmd, &result));
+    CHECK_EQ(result.state, PREFLIGHT_STATE_OK);
+    preflightToString(&result, out);
+    CHECK(out[0] == '\0');
+
+    // A ticket for another title
+    size_t size;
+    void *ticket = buildTicket(TID + 1, &size);
+    writeIn("title.tik", ticket, size);
+    free(ticket);
+    CHECK(!preflightInstall(TITLE_DIR, tmd, &result));
+    CHECK_EQ(result.state, PREFLIGHT_STATE_BAD_TIK);
+
+    // A missing file wins over the bad ticket
+    char path[FS_MAX_PATH * 2];
+    char moved[FS_MAX_PATH * 2];
+    hostPath("00000001.h3", path);
+    hostPath("00000001.h3.bak", moved);
+    rename(path, moved);
+    CHECK(!preflightInstall(TITLE_DIR, tmd, &result));
+    CHECK_EQ(result.state, PREFLIGHT_STATE_MISSING_H3);
+    preflightToString(&result, out);
+    CHECK(strcmp(out, "00000001.h3: File missing") == 0);
+    rename(moved, path);
+
+    ticket = buildTicket(TID, &size);
+    writeIn("title.tik", ticket, size);
+    free(ticket);
+
+    // Truncated download
+    hostPath("00000002.app", path);
+    truncate(path, 1000);
+    CHECK(!preflightInstall(TITLE_DIR, tmd, &result));
+    CHECK_EQ(result.state, PREFLIGHT_STATE_BAD_APP_SIZE);
+    preflightToString(&result, out);
+    CHECK(strcmp(out, "00000002.app: Wrong size (1000 / 4096)") == 0);
+    truncate(path, 4096);
+
+    CHECK(!preflightInstall(INSTALL_DIR_SD "Nothing here/", tmd, &result));
+    CHECK_EQ(result.state, PREFLIGHT_STATE_NO_LISTING);
+    CHECK(preflightInstall(TITLE_DIR, tmd, &result));
+}
+
+int main()
+{
+    size_t size;
+    tmd = buildTmd(TID, 0, contents, CONTENTS, &size);
+    hostMakeRoot();
+    buildFolder();
+
+    RUN_TEST(testSortListing);
+    RUN_TEST(testCheckListing);
+    RUN_TEST(testTicketStructure);
+    RUN_TEST(testCertStructure);
+    RUN_TEST(testPreflightInstall);
+
+    hostRemoveRoot();
+    free(tmd);
+    return TEST_RESULT();
+}
@@ -0,0 +1,313 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <downloader.h>
+#include <file.h>
+#include <list.h>
+#include <metaCache.h>
+#include <queue.h>
+#include <queueImport.h>
+#include <romfs.h>
+#include <titles.h>
+#include <tmd.h>
+
+#include "fixtures.h"
+#include "nusServer.h"
+#include "test.h"
+
+/*
+ * Runs downloadTmds() and importQueue() against the NUS stand-in from
+ * tests/nusServer.c. The titles are the first games of the test title
+ * database. All but the last one have their TMD on the server, the first
+ * two also as version 16.
+ */
+
+#define TITLES     (MAX_PARALLEL_TMDS + 2)
+#define REQUEST_MS 100
+
+static const CONTENT_DESC contents[] = {
+    { .size = 0x8000, .hash = 0x22 },
+};
+
+static const TitleEntry *entries[TITLES];
+
+static void tmdPath(uint64_t tid, const char *titleVer, char *out)
+{
+    sprintf(out, "/ccs/download/%016llx/tmd%s%s", (unsigned long long)tid, titleVer[0] == '\0' ? "" : ".", titleVer);
+}
+
+static void serveTmd(uint64_t tid, uint16_t version, const char *titleVer)
+{
+    char path[128];
+    size_t size;
+    TMD *tmd = buildTmd(tid, version, contents, 1, &size);
+    tmdPath(tid, titleVer, path);
+    addNusFile(path, tmd, size);
+    free(tmd);
+}
+
+static uint32_t tmdRequests(int title, const char *titleVer)
+{
+    char path[128];
+    tmdPath(entries[title]->tid, titleVer, path);
+    return getNusFileRequests(path);
+}
+
+// Empty queue and metadata cache, fresh server statistics
+static void reset()
+{
+    char cmd[FS_MAX_PATH * 3];
+    clearQueue();
+    sprintf(cmd, "rm -rf '%s" METADATA_CACHE_DIR "' '%s" QUEUE_IMPORT_TEXT "' '%s" QUEUE_IMPORT_JSON "'", hostGetRoot(), hostGetRoot(), hostGetRoot());
+    CHECK_EQ(system(cmd), 0);
+    makeHostDirs(METADATA_CACHE_DIR);
+    clearNusFiles();
+    for(int i = 0; i < TITLES - 1; ++i)
+        serveTmd(entries[i]->tid, 0, "");
+    for(int i = 0; i < 2; ++i)
+        serveTmd(entries[i]->tid, 16, "16");
+
+    resetNusServerStats();
+    setNusServerTiming(0, 0, 0);
+}
+
+static TitleData *findQueued(int title, const char *titleVer, OPERATION operation)
+{
+    TitleData *data;
+    forEachListEntry(getTitleQueue(), data)
+        if(data->tid == entries[title]->tid && strcmp(data->titleVer, titleVer) == 0 && data->operation == operation)
+            return data;
+
+    return NULL;
+}
+
+static void initRequests(TMD_REQUEST *requests, const int *titles, size_t count)
+{
+    for(size_t i = 0; i < count; ++i)
+    {
+        requests[i].tid = entries[titles[i]]->tid;
+        requests[i].titleVer[0] = '\0';
+    }
+}
+
+static void freeRequests(TMD_REQUEST *requests, size_t count)
+{
+    for(size_t i = 0; i < count; ++i)
+        if(requests[i].rambuf != NULL)
+            freeRamBuf(requests[i].rambuf);
+}
+
+static void testParallelFetch()
+{
+    static const int titles[TITLES - 1] = { 0, 1, 2, 3, 4 };
+    TMD_REQUEST requests[TITLES - 1];
+    NUS_SERVER_STATS stats;
+    reset();
+    setNusServerTiming(0, REQUEST_MS, 0);
+    initRequests(requests, titles, TITLES - 1);
+
+    uint64_t t = testNow();
+    downloadTmds(requests, TITLES - 1);
+    t = (testNow() - t) / 1000000;
+
+    getNusServerStats(&stats);
+    CHECK_EQ(stats.requests, TITLES - 1);
+    CHECK_EQ(stats.maxParallel, MAX_PARALLEL_TMDS);
+    CHECK(t < REQUEST_MS * (TITLES - 1)); // Two rounds instead of one request after the other
+    for(int i = 0; i < TITLES - 1; ++i)
+    {
+        CHECK(requests[i].rambuf != NULL);
+        if(requests[i].rambuf == NULL)
+            continue;
+
+        CHECK_EQ(verifyTmd((TMD *)requests[i].rambuf->buf, requests[i].rambuf->size), TMD_STATE_GOOD);
+        CHECK(((TMD *)requests[i].rambuf->buf)->tid == requests[i].tid);
+    }
+
+    freeRequests(requests, TITLES - 1);
+}
+
+// The missing TMD fails its own slot only
+static void testMissingTmd()
+{
+    static const int titles[3] = { 0, TITLES - 1, 1 };
+    TMD_REQUEST requests[3];
+    NUS_SERVER_STATS stats;
+    reset();
+    initRequests(requests, titles, 3);
+    downloadTmds(requests, 3);
+
+    getNusServerStats(&stats);
+    CHECK_EQ(stats.notFound, 1);
+    CHECK(requests[0].rambuf != NULL);
+    CHECK(requests[1].rambuf == NULL);
+    CHECK(requests[2].rambuf != NULL);
+    freeRequests(requests, 3);
+}
+
+// Versioned TMDs never change, cache hits don't take a slot
+static void testCachedTmds()
+{
+    static const int titles[2] = { 0, 1 };
+    TMD_REQUEST requests[2];
+    reset();
+    initRequests(requests, titles, 2);
+    strcpy(requests[0].titleVer, "16");
+    strcpy(requests[1].titleVer, "16");
+    downloadTmds(requests, 2);
+    freeRequests(requests, 2);
+
+    downloadTmds(requests, 2);
+    CHECK_EQ(tmdRequests(0, "16"), 1);
+    CHECK_EQ(tmdRequests(1, "16"), 1);
+    CHECK(requests[0].rambuf != NULL);
+    CHECK(requests[1].rambuf != NULL);
+    freeRequests(requests, 2);
+}
+
+static void writeImport(const char *path, const char *text)
+{
+    writeHostFile(path, text, strlen(text));
+}
+
+static void testImportText()
+{
+    char text[512];
+    reset();
+    sprintf(text,
+            "# Queue\n"
+            "%016llx\n"
+            "%016llx 16\n"
+            "%016llX, sd\r\n"
+            "  # Indented comment\n"
+            "%016llx floppy\n"
+            "nothex\n"
+            "\n"
+            "%016llx dl-mlc",
+            (unsigned long long)entries[0]->tid, (unsigned long long)entries[1]->tid, (unsigned long long)entries[2]->tid,
+            (unsigned long long)entries[3]->tid, (unsigned long long)entries[4]->tid);
+    writeImport(QUEUE_IMPORT_TEXT, text);
+
+    CHECK(importQueue());
+    CHECK_EQ(getListSize(getTitleQueue()), 4);
+
+    TitleData *data = findQueued(0, "", OPERATION_DOWNLOAD_INSTALL);
+    CHECK(data != NULL && !data->toUSB);
+    CHECK(findQueued(1, "16", OPERATION_DOWNLOAD_INSTALL) != NULL);
+    data = findQueued(2, "", OPERATION_DOWNLOAD);
+    CHECK(data != NULL && data->dlDev == NUSDEV_SD);
+    data = findQueued(4, "", OPERATION_DOWNLOAD); // No trailing newline
+    CHECK(data != NULL && data->dlDev == NUSDEV_MLC);
+    CHECK_EQ(tmdRequests(3, ""), 0); // Bad device
+}
+
+static void testImportJson()
+{
+    char text[512];
+    reset();
+    sprintf(text,
+            "[\n"
+            "    { \"tid\": \"%016llx\", \"version\": 16 },\n"
+            "    { \"tid\": \"%016llx\", \"version\": \"16\", \"device\": \"sd\" },\n"
+            "    { \"tid\": \"%016llx\", \"device\": \"floppy\" },\n"
+            "    { \"tid\": \"%016llx\", \"version\": \"v1\" },\n"
+            "    42,\n"
+            "    { \"version\": 16 },\n"
+            "    { \"tid\": \"%016llx\", \"version\": \"\" }\n"
+            "]\n",
+            (unsigned long long)entries[0]->tid, (unsigned long long)entries[1]->tid, (unsigned long long)entries[2]->tid,
+            (unsigned long long)entries[3]->tid, (unsigned long long)entries[4]->tid);
+    writeImport(QUEUE_IMPORT_JSON, text);
+
+    CHECK(importQueue());
+    CHECK_EQ(getListSize(getTitleQueue()), 3);
+    CHECK(findQueued(0, "16", OPERATION_DOWNLOAD_INSTALL) != NULL); // Integer version
+    CHECK(findQueued(1, "16", OPERATION_DOWNLOAD) != NULL);
+    CHECK(findQueued(4, "", OPERATION_DOWNLOAD_INSTALL) != NULL);
+    CHECK_EQ(tmdRequests(2, ""), 0);
+    CHECK_EQ(tmdRequests(3, ""), 0);
+}
+
+// Titles only differing in the device fetch their TMD once
+static void testDuplicatesShareSlot()
+{
+    char text[256];
+    NUS_SERVER_STATS stats;
+    reset();
+    sprintf(text, "%016llx dl-mlc\n%016llx mlc\n%016llx dl-mlc\n",
+            (unsigned long long)entries[0]->tid, (unsigned long long)entries[0]->tid, (unsigned long long)entries[0]->tid);
+    writeImport(QUEUE_IMPORT_TEXT, text);
+
+    CHECK(importQueue());
+    getNusServerStats(&stats);
+    CHECK_EQ(stats.requests, 1);
+    CHECK_EQ(getListSize(getTitleQueue()), 2);
+    CHECK(findQueued(0, "", OPERATION_DOWNLOAD) != NULL);
+    CHECK(findQueued(0, "", OPERATION_DOWNLOAD_INSTALL) != NULL);
+}
+
+static void testImportMissingTmd()
+{
+    char text[256];
+    NUS_SERVER_STATS stats;
+    reset();
+    sprintf(text, "%016llx\n%016llx\n", (unsigned long long)entries[TITLES - 1]->tid, (unsigned long long)entries[1]->tid);
+    writeImport(QUEUE_IMPORT_TEXT, text);
+
+    CHECK(importQueue());
+    getNusServerStats(&stats);
+    CHECK_EQ(stats.notFound, 1);
+    CHECK_EQ(getListSize(getTitleQueue()), 1);
+    CHECK(findQueued(1, "", OPERATION_DOWNLOAD_INSTALL) != NULL);
+}
+
+int main()
+{
+    static const char certs[] = "# Plain HTTP only on the host\n";
+
+    hostMakeRoot();
+    makeHostDirs(ROMFS_PATH);
+    writeHostFile(ROMFS_PATH "ca-certs.pem", certs, sizeof(certs) - 1);
+    for(int i = 0; i < TITLES; ++i)
+        entries[i] = getTitleEntries(TITLE_CATEGORY_GAME) + i + 1;
+
+    int port = startNusServer();
+    CHECK(port != 0);
+    hostSetProxy("127.0.0.1", port);
+    CHECK(initDownloader());
+    CHECK(initQueue());
+
+    RUN_TEST(testParallelFetch);
+    RUN_TEST(testMissingTmd);
+    RUN_TEST(testCachedTmds);
+    RUN_TEST(testImportText);
+    RUN_TEST(testImportJson);
+    RUN_TEST(testDuplicatesShareSlot);
+    RUN_TEST(testImportMissingTmd);
+
+    clearQueue();
+    shutdownQueue();
+    deinitDownloader();
+    stopNusServer();
+    hostRemoveRoot();
+    return TEST_RESULT();
+}
@@ -0,0 +1,434 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <deinstaller.h>
+#include <downloader.h>
+#include <file.h>
+#include <filesystem.h>
+#include <installer.h>
+#include <list.h>
+#include <preflight.h>
+#include <queue.h>
+#include <titles.h>
+#include <tmd.h>
+#include <utils.h>
+
+#include <coreinit/mcp.h>
+#include <coreinit/memdefaultheap.h>
+
+#include "fixtures.h"
+#include "test.h"
+
+/*
+ * Runs proccessQueue() with downloadTitle() and MCP stubbed out: Downloads
+ * take DOWNLOAD_MS, MCP installs in a thread taking INSTALL_MS. Free space
+ * is a number per device the test controls.
+ */
+
+#define TITLES      3
+#define DOWNLOAD_MS 40
+#define INSTALL_MS  80
+#define TITLE_SIZE  (64 * 1024)
+
+typedef struct
+{
+    uint64_t downloadStart;
+    uint64_t downloadEnd;
+    uint64_t installStart;
+    uint64_t installEnd;
+} TIMES;
+
+static const CONTENT_DESC contents[] = {
+    { .size = TITLE_SIZE, .hash = 0x11 },
+};
+
+static const TitleEntry *entries[TITLES];
+static TIMES times[TITLES];
+static uint64_t start;
+static int downloads;
+static int installsStarted;
+static int installsFinished;
+static int warmups;
+static int spaceErrors;
+static int cancelDownload;
+static int cancelInstall;
+static int shrinkAfterDownload;
+static uint64_t freeBytes[3]; // USB, SD, NAND
+static uint64_t claimed[3]; // Installations keep their claim for the session, like in filesystem.c
+
+static McpData *mcpData;
+static pthread_t mcpThread;
+static int mcpTitle;
+static volatile bool mcpAbort;
+
+static uint64_t nowMs()
+{
+    return (testNow() - start) / 1000000;
+}
+
+static int titleIndex(uint64_t tid)
+{
+    for(int i = 0; i < TITLES; ++i)
+        if(entries[i]->tid == tid)
+            return i;
+
+    return -1;
+}
+
+/*
+ * Free space
+ */
+static inline int spaceIndex(NUSDEV dev)
+{
+    return dev & NUSDEV_USB ? 0 : (dev == NUSDEV_SD ? 1 : 2);
+}
+
+void claimSpace(NUSDEV dev, uint64_t size)
+{
+    claimed[spaceIndex(dev)] += size;
+}
+
+void freeSpace(NUSDEV dev, uint64_t size)
+{
+    claimed[spaceIndex(dev)] -= size;
+}
+
+uint64_t getFreeSpace(NUSDEV dev)
+{
+    int i = spaceIndex(dev);
+    return freeBytes[i] > claimed[i] ? freeBytes[i] - claimed[i] : 0;
+}
+
+bool checkFreeSpace(NUSDEV dev, uint64_t size)
+{
+    if(size <= getFreeSpace(dev))
+        return true;
+
+    ++spaceErrors;
+    return false;
+}
+
+/*
+ * Downloads
+ */
+bool downloadTitle(const TMD *tmd, size_t tmdSize, const TitleEntry *titleEntry, const char *titleVer, char *folderName, bool inst, NUSDEV dlDev, bool toUSB, bool keepFiles, QUEUE_DATA *queueData)
+{
+    (void)titleEntry;
+    (void)titleVer;
+    (void)inst;
+    (void)dlDev;
+    (void)toUSB;
+    (void)keepFiles;
+    (void)queueData;
+
+    int i = titleIndex(tmd->tid);
+    times[i].downloadStart = nowMs();
+    ++downloads;
+    if(i == cancelDownload)
+        return false;
+
+    usleep(DOWNLOAD_MS * 1000);
+    sprintf(folderName + strlen(folderName), " [%016llx]", (unsigned long long)tmd->tid);
+
+    char path[FS_MAX_PATH];
+    sprintf(path, INSTALL_DIR_SD "%s/", folderName);
+    makeHostDirs(path);
+    strcat(path, "title.tmd");
+    writeHostFile(path, tmd, tmdSize);
+
+    times[i].downloadEnd = nowMs();
+    if(i == shrinkAfterDownload)
+        freeBytes[2] = TITLE_SIZE + TITLE_SIZE / 2; // Something else took the space in the meantime
+    return true;
+}
+
+void warmupConnection()
+{
+    ++warmups;
+}
+
+/*
+ * MCP
+ */
+MCPError MCP_GetTitleInfo(int32_t handle, uint64_t titleId, MCPTitleListType *titleInfo)
+{
+    (void)handle;
+    (void)titleId;
+    (void)titleInfo;
+    return -1; // Not installed yet
+}
+
+MCPError MCP_InstallGetInfo(int32_t handle, const char *path, MCPInstallInfo *out)
+{
+    (void)handle;
+    (void)path;
+    (void)out;
+    return 0;
+}
+
+MCPError MCP_InstallSetTargetDevice(int32_t handle, MCPInstallTarget device)
+{
+    (void)handle;
+    (void)device;
+    return 0;
+}
+
+MCPError MCP_InstallSetTargetUsb(int32_t handle, int32_t usb)
+{
+    (void)handle;
+    (void)usb;
+    return 0;
+}
+
+static void *mcpThreadMain(void *arg)
+{
+    (void)arg;
+    for(int ms = 0; ms < INSTALL_MS && !mcpAbort; ms += 5)
+        usleep(5000);
+
+    times[mcpTitle].installEnd = nowMs();
+    ++installsFinished;
+    mcpData->err = mcpAbort ? CUSTOM_MCP_ERROR_CANCELLED : 0;
+    mcpData->processing = false;
+    return NULL;
+}
+
+void glueMcpData(MCPInstallTitleInfo *info, McpData *data)
+{
+    (void)info;
+    data->processing = true;
+    data->err = 0;
+    mcpData = data;
+}
+
+MCPError MCP_InstallTitleAsync(int32_t handle, const char *path, MCPInstallTitleInfo *out)
+{
+    (void)handle;
+    (void)out;
+
+    // Only one installation at a time
+    CHECK(installsStarted == installsFinished);
+    unsigned long long tid = 0;
+    const char *id = strrchr(path, '[');
+    if(id != NULL)
+        sscanf(id + 1, "%016llx", &tid);
+
+    mcpTitle = titleIndex(tid);
+    CHECK(mcpTitle >= 0);
+    if(mcpTitle < 0)
+        return -1;
+
+    times[mcpTitle].installStart = nowMs();
+    ++installsStarted;
+    mcpAbort = false;
+    return pthread_create(&mcpThread, NULL, mcpThreadMain, NULL) == 0 ? 0 : -1;
+}
+
+MCPError MCP_InstallTitleAbort(int32_t handle)
+{
+    (void)handle;
+    mcpAbort = true;
+    return 0;
+}
+
+// The progress screen, the test plays the user pressing B
+void showMcpProgress(McpData *data, const char *game, bool inst)
+{
+    (void)game;
+    (void)inst;
+    if(mcpTitle == cancelInstall)
+        MCP_InstallTitleAbort(mcpHandle);
+
+    while(data->processing)
+        usleep(1000);
+
+    pthread_join(mcpThread, NULL);
+}
+
+/*
+ * Everything else startInstall() and finishInstall() call
+ */
+bool deinstall(MCPTitleListType *title, const char *name, bool channelHaxx, bool skipEnd)
+{
+    (void)title;
+    (void)name;
+    (void)channelHaxx;
+    (void)skipEnd;
+    return true;
+}
+
+bool preflightInstall(const char *path, const TMD *tmd, PREFLIGHT_RESULT *result)
+{
+    (void)path;
+    (void)tmd;
+    (void)result;
+    return true;
+}
+
+void preflightToString(const PREFLIGHT_RESULT *result, char *out)
+{
+    (void)result;
+    *out = '\0';
+}
+
+void storeInCache(const char *dir)
+{
+    (void)dir;
+}
+
+/*
+ * Tests
+ */
+static void queueTitles()
+{
+    for(int i = 0; i < TITLES; ++i)
+    {
+        size_t size;
+        TMD *tmd = buildTmd(entries[i]->tid, 0, contents, 1, &size);
+        RAMBUF *rambuf = allocRamBuf();
+        rambuf->buf = MEMAllocFromDefaultHeap(size);
+        memcpy(rambuf->buf, tmd, size);
+        rambuf->size = size;
+        free(tmd);
+
+        TitleData *title = MEMAllocFromDefaultHeap(sizeof(TitleData));
+        memset(title, 0, sizeof(TitleData));
+        title->tmd = (TMD *)rambuf->buf;
+        title->tmdSize = rambuf->size;
+        title->rambuf = rambuf;
+        title->entry = entries[i];
+        title->folderName = entries[i]->name;
+        title->operation = OPERATION_DOWNLOAD_INSTALL;
+        title->dlDev = NUSDEV_SD;
+        CHECK_EQ(addToQueue(title), 1);
+    }
+
+    memset(times, 0, sizeof(times));
+    memset(claimed, 0, sizeof(claimed));
+    downloads = installsStarted = installsFinished = warmups = spaceErrors = 0;
+    cancelDownload = cancelInstall = shrinkAfterDownload = -1;
+    for(int i = 0; i < 3; ++i)
+        freeBytes[i] = 1ull << 40;
+
+    start = testNow();
+}
+
+// The journal has to restore exactly what's still queued
+static void checkJournal(int first, int count)
+{
+    CHECK_EQ(getListSize(getTitleQueue()), count);
+    shutdownQueue();
+    CHECK(initQueue());
+    CHECK_EQ(getListSize(getTitleQueue()), count);
+
+    int i = first;
+    TitleData *title;
+    forEachListEntry(getTitleQueue(), title)
+        CHECK_EQ(title->tid, entries[i++]->tid);
+
+    CHECK_EQ(fileExists(NUSDIR_SD "NUSspli_queue.bin"), count != 0);
+    clearQueue();
+}
+
+static void testInstallOverlapsDownload()
+{
+    queueTitles();
+    CHECK(proccessQueue());
+    uint64_t total = nowMs();
+
+    CHECK_EQ(downloads, TITLES);
+    CHECK_EQ(installsFinished, TITLES);
+    for(int i = 0; i + 1 < TITLES; ++i)
+    {
+        // The next download runs while MCP installs, the next install waits for MCP
+        CHECK(times[i + 1].downloadStart < times[i].installEnd);
+        CHECK(times[i + 1].installStart >= times[i].installEnd);
+    }
+
+    // Sequential would be TITLES * (DOWNLOAD_MS + INSTALL_MS)
+    CHECK(total < TITLES * (DOWNLOAD_MS + INSTALL_MS) - INSTALL_MS / 2);
+    CHECK_EQ(warmups, TITLES - 2); // Only while a download is left
+    CHECK_EQ(claimed[2], TITLES * TITLE_SIZE);
+    checkJournal(0, 0);
+}
+
+static void testCancelDownloadWhileInstalling()
+{
+    queueTitles();
+    cancelDownload = 1;
+    CHECK(!proccessQueue());
+
+    // The running installation still finishes and leaves the queue
+    CHECK_EQ(installsFinished, 1);
+    CHECK_EQ(claimed[2], TITLE_SIZE);
+    checkJournal(1, 2);
+}
+
+static void testCancelInstall()
+{
+    queueTitles();
+    cancelInstall = 0;
+    CHECK(proccessQueue());
+
+    // The cancelled title is gone with its files, the rest got installed
+    char path[FS_MAX_PATH];
+    sprintf(path, INSTALL_DIR_SD "%s [%016llx]/", entries[0]->name, (unsigned long long)entries[0]->tid);
+    CHECK(!dirExists(path));
+    CHECK_EQ(installsStarted, TITLES);
+    CHECK_EQ(claimed[2], (TITLES - 1) * TITLE_SIZE); // The cancelled one gave its claim back
+    checkJournal(0, 0);
+}
+
+static void testTitleOverBudget()
+{
+    queueTitles();
+    freeBytes[2] = TITLES * TITLE_SIZE; // Fits when the queue starts
+    shrinkAfterDownload = 0;
+    CHECK(!proccessQueue());
+
+    // The installation of title 0 claimed its size, title 1 doesn't fit next to it
+    CHECK_EQ(spaceErrors, 1);
+    CHECK_EQ(downloads, 1);
+    CHECK_EQ(installsFinished, 1);
+    CHECK_EQ(claimed[2], TITLE_SIZE);
+    checkJournal(1, 2);
+}
+
+int main()
+{
+    hostMakeRoot();
+    makeHostDirs(INSTALL_DIR_SD);
+    for(int i = 0; i < TITLES; ++i)
+        entries[i] = getTitleEntries(TITLE_CATEGORY_GAME) + i + 1;
+
+    CHECK(initQueue());
+    RUN_TEST(testInstallOverlapsDownload);
+    RUN_TEST(testCancelDownloadWhileInstalling);
+    RUN_TEST(testCancelInstall);
+    RUN_TEST(testTitleOverBudget);
+    shutdownQueue();
+
+    hostRemoveRoot();
+    return TEST_RESULT();
+}
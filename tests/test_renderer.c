@@ -0,0 +1,293 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <file.h>
+#include <renderer.h>
+#include <romfs.h>
+
+#include "fixtures.h"
+#include "headlessSdl.h"
+#include "test.h"
+
+static HEADLESS_STATS stats;
+
+static void frameStats()
+{
+    drawFrame();
+    getHeadlessStats(&stats);
+    resetHeadlessStats();
+}
+
+static void testRectBatching()
+{
+    // The four gray lines share one fill, the translucent background gets a second one
+    startNewFrame();
+    resetHeadlessStats();
+    boxToFrame(1, 10);
+    frameStats();
+    CHECK_EQ(stats.fills, 2);
+    CHECK_EQ(stats.rects, 5);
+
+    // A texture copy in between has to flush the pending rects first
+    startNewFrame();
+    resetHeadlessStats();
+    lineToFrame(1, SCREEN_COLOR_GRAY);
+    arrowToFrame(2, 1);
+    lineToFrame(3, SCREEN_COLOR_GRAY);
+    frameStats();
+    CHECK_EQ(stats.fills, 2);
+    CHECK_EQ(stats.copies, 2); // The arrow and the frame buffer
+}
+
+static void testArenaWrap()
+{
+    // 512 rects fit into the arena, the rest goes into a second fill
+    startNewFrame();
+    resetHeadlessStats();
+    for(int i = 0; i < 600; ++i)
+        lineToFrame(i % MAX_LINES, SCREEN_COLOR_GRAY);
+
+    frameStats();
+    CHECK_EQ(stats.fills, 2);
+    CHECK_EQ(stats.rects, 600);
+}
+
+static void drawBusyFrame(const char *name)
+{
+    startNewFrame();
+    for(int i = 0; i < 5; ++i)
+        tabToFrame(0, i, "Tab", i == 0);
+
+    boxToFrame(1, MAX_LINES - 3);
+    for(int i = 2; i < 21; ++i)
+    {
+        checkmarkToFrame(i, 4);
+        flagToFrame(i, 7, MCP_REGION_EUROPE | MCP_REGION_USA);
+        textToFrameCut(i, 10, name, 600);
+    }
+
+    barToFrame(MAX_LINES - 2, 0, 40, 0.5f);
+    drawFrame();
+}
+
+static void testNoAllocationsPerFrame()
+{
+    drawBusyFrame("Warm up");
+    uint64_t allocs = hostHeapAllocations();
+    int textures = getLiveTextures();
+    resetHeadlessStats();
+    for(int i = 0; i < 100; ++i)
+        drawBusyFrame("A title name long enough to get cut at the end of the row, which happens a lot");
+
+    getHeadlessStats(&stats);
+    CHECK_EQ(hostHeapAllocations(), allocs);
+    CHECK_EQ(stats.texturesCreated, 0);
+    CHECK_EQ(getLiveTextures(), textures);
+    CHECK_EQ(stats.presents, 100);
+}
+
+static void testGlyphCache()
+{
+    // ASCII gets rasterised when the font loads
+    resetHeadlessStats();
+    startNewFrame();
+    textToFrame(1, 0, "Downloading 00050000101C9500 (12.5 MB/s)");
+    frameStats();
+    CHECK(stats.glyphs != 0);
+    CHECK_EQ(stats.glyphMisses, 0);
+
+    // Everything else on first use only
+    startNewFrame();
+    textToFrame(1, 0, "\xE3\x82\xBC\xE3\x83\xAB\xE3\x83\x80"); // Three katakana
+    frameStats();
+    CHECK_EQ(stats.glyphMisses, 3);
+
+    startNewFrame();
+    textToFrame(1, 0, "\xE3\x82\xBC\xE3\x83\xAB\xE3\x83\x80");
+    frameStats();
+    CHECK_EQ(stats.glyphMisses, 0);
+}
+
+#define ICON_CELL 21
+#define ICONS     14
+
+// Draws icon i of the atlas, in the order loadIconAtlas() lays them out
+static void iconByIndex(int i)
+{
+    static const MCPRegion flags[8] = {
+        0,
+        MCP_REGION_EUROPE,
+        MCP_REGION_USA,
+        MCP_REGION_JAPAN,
+        MCP_REGION_EUROPE | MCP_REGION_USA,
+        MCP_REGION_EUROPE | MCP_REGION_JAPAN,
+        MCP_REGION_USA | MCP_REGION_JAPAN,
+        MCP_REGION_EUROPE | MCP_REGION_USA | MCP_REGION_JAPAN,
+    };
+
+    if(i == 0)
+        arrowToFrame(1, 1);
+    else if(i == 1)
+        checkmarkToFrame(1, 1);
+    else if(i < 10)
+        flagToFrame(1, 1, flags[i - 2]);
+    else
+        deviceToFrame(1, 1, (DEVICE_TYPE)(i - 10));
+}
+
+static void checkAtlas(int *arrowW, int *arrowH)
+{
+    SDL_Texture *atlas = NULL;
+    SDL_Texture *tex;
+    SDL_Rect src;
+    SDL_Rect dst;
+
+    startNewFrame();
+    for(int i = 0; i < ICONS; ++i)
+    {
+        iconByIndex(i);
+        getLastCopy(&tex, &src, &dst);
+        if(i == 0)
+        {
+            atlas = tex;
+            *arrowW = src.w;
+            *arrowH = src.h;
+        }
+
+        // All icons come from one texture, each from its own cell
+        CHECK(tex == atlas);
+        CHECK_EQ(src.x, ICON_CELL * i);
+        CHECK_EQ(src.y, 0);
+        CHECK(src.w > 0 && src.w <= ICON_CELL);
+        CHECK(src.h > 0 && src.h <= ICON_CELL);
+        CHECK_EQ(dst.w, src.w);
+        CHECK_EQ(dst.h, src.h);
+    }
+
+    drawFrame();
+
+    int w;
+    int h;
+    SDL_QueryTexture(atlas, NULL, NULL, &w, &h);
+    CHECK_EQ(w, ICON_CELL * ICONS);
+    CHECK_EQ(h, ICON_CELL);
+}
+
+static void testIconAtlas()
+{
+    int w;
+    int h;
+    checkAtlas(&w, &h);
+    CHECK_EQ(w, 19); // arrow.png is smaller than its cell
+    CHECK_EQ(h, 18);
+
+    // A title browser row switches between the atlas and the font twice
+    startNewFrame();
+    resetHeadlessStats();
+    checkmarkToFrame(2, 4);
+    flagToFrame(2, 7, MCP_REGION_EUROPE);
+    deviceToFrame(2, 10, DEVICE_TYPE_USB);
+    frameStats();
+    CHECK_EQ(stats.copies, 4); // Three icons and the frame buffer
+    CHECK_EQ(stats.textureSwitches, 2); // Atlas, frame buffer
+}
+
+// Replaces the romfs links with a copy whose arrow is too big for its cell
+static void oversizeArrow()
+{
+    static const uint8_t png[24] = {
+        0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n',
+        0, 0, 0, 13, 'I', 'H', 'D', 'R',
+        0, 0, 0, 40, 0, 0, 0, 32, // 40x32
+    };
+    char path[FS_MAX_PATH * 2];
+    char cmd[FS_MAX_PATH * 5];
+
+    sprintf(path, "%s" ROMFS_PATH, hostGetRoot());
+    path[strlen(path) - 1] = '\0';
+    sprintf(cmd, "rm -rf '%s' && cp -r ../data '%s'", path, path);
+    CHECK_EQ(system(cmd), 0);
+
+    strcat(path, "/textures/arrow.png");
+    FILE *f = fopen(path, "wb");
+    CHECK(f != NULL);
+    if(f != NULL)
+    {
+        fwrite(png, 1, sizeof(png), f);
+        fclose(f);
+    }
+}
+
+static void testOversizedIcon()
+{
+    shutdownRenderer();
+    oversizeArrow();
+    CHECK(initRenderer());
+
+    // Cut to its cell, without spilling into the checkmark
+    int w;
+    int h;
+    checkAtlas(&w, &h);
+    CHECK_EQ(w, ICON_CELL);
+    CHECK_EQ(h, ICON_CELL);
+}
+
+static void testErrorOverlay()
+{
+    int textures = getLiveTextures();
+    void *overlay = addErrorOverlay("Something went wrong!\nPress A");
+    CHECK(overlay != NULL);
+    CHECK_EQ(getLiveTextures(), textures + 1);
+
+    // Overlays get drawn on top of every frame
+    resetHeadlessStats();
+    startNewFrame();
+    frameStats();
+    CHECK_EQ(stats.copies, 3); // Background, frame buffer, overlay
+
+    removeErrorOverlay(overlay);
+    CHECK_EQ(getLiveTextures(), textures);
+}
+
+int main()
+{
+    hostMakeRoot();
+    mountHostRomfs();
+    if(!initRenderer())
+    {
+        fprintf(stderr, "Can't start the renderer\n");
+        return 1;
+    }
+
+    RUN_TEST(testRectBatching);
+    RUN_TEST(testArenaWrap);
+    RUN_TEST(testNoAllocationsPerFrame);
+    RUN_TEST(testGlyphCache);
+    RUN_TEST(testErrorOverlay);
+    RUN_TEST(testIconAtlas);
+    RUN_TEST(testOversizedIcon);
+
+    shutdownRenderer();
+    CHECK_EQ(getLiveTextures(), 0);
+    hostRemoveRoot();
+    return TEST_RESULT();
+}
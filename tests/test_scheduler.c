@@ -0,0 +1,175 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <queue.h>
+#include <scheduler.h>
+#include <titles.h>
+
+#include "test.h"
+
+#define GAME(id)   ((uint64_t)TID_HIGH_GAME << 32 | (id))
+#define UPDATE(id) ((uint64_t)TID_HIGH_UPDATE << 32 | (id))
+#define DLC(id)    ((uint64_t)TID_HIGH_DLC << 32 | (id))
+
+static TitleData *newTitle(TitleData *title, uint64_t tid, uint64_t size, OPERATION op, bool toUSB)
+{
+    memset(title, 0, sizeof(TitleData));
+    title->tid = tid;
+    title->dlSize = size;
+    title->installSize = size;
+    title->operation = op;
+    title->toUSB = toUSB;
+    title->dlDev = NUSDEV_SD;
+    return title;
+}
+
+static void testSmallFirst()
+{
+    TitleData t[3];
+    TitleData *q[3] = {
+        newTitle(t + 0, GAME(1), 3000, OPERATION_DOWNLOAD_INSTALL, true),
+        newTitle(t + 1, GAME(2), 1000, OPERATION_DOWNLOAD_INSTALL, true),
+        newTitle(t + 2, GAME(3), 2000, OPERATION_DOWNLOAD_INSTALL, true),
+    };
+
+    CHECK(scheduleTitles(q, 3));
+    CHECK(q[0] == t + 1);
+    CHECK(q[1] == t + 2);
+    CHECK(q[2] == t + 0);
+
+    // Already sorted
+    CHECK(!scheduleTitles(q, 3));
+    CHECK(!scheduleTitles(q, 1));
+}
+
+static void testStableOnTies()
+{
+    TitleData t[4];
+    TitleData *q[4];
+    for(int i = 0; i < 4; ++i)
+        q[i] = newTitle(t + i, GAME(i + 1), 500, OPERATION_DOWNLOAD_INSTALL, false);
+
+    CHECK(!scheduleTitles(q, 4));
+    for(int i = 0; i < 4; ++i)
+        CHECK(q[i] == t + i);
+}
+
+static void testDependenciesFollowBase()
+{
+    // The update and DLC are tiny but must come right behind their big base game
+    TitleData t[5];
+    TitleData *q[5] = {
+        newTitle(t + 0, DLC(7), 10, OPERATION_DOWNLOAD_INSTALL, true),
+        newTitle(t + 1, GAME(7), 9000, OPERATION_DOWNLOAD_INSTALL, true),
+        newTitle(t + 2, GAME(8), 4000, OPERATION_DOWNLOAD_INSTALL, true),
+        newTitle(t + 3, UPDATE(7), 20, OPERATION_DOWNLOAD_INSTALL, true),
+        newTitle(t + 4, UPDATE(9), 5, OPERATION_DOWNLOAD_INSTALL, true), // No base queued
+    };
+
+    CHECK(scheduleTitles(q, 5));
+    CHECK(q[0] == t + 4);
+    CHECK(q[1] == t + 2);
+    CHECK(q[2] == t + 1);
+    CHECK(q[3] == t + 3);
+    CHECK(q[4] == t + 0);
+}
+
+static void testDependencyNeedsSameTarget()
+{
+    // The update goes to another device than the game, so it's sorted on its own
+    TitleData t[3];
+    TitleData *q[3] = {
+        newTitle(t + 0, GAME(1), 9000, OPERATION_DOWNLOAD_INSTALL, true),
+        newTitle(t + 1, UPDATE(1), 100, OPERATION_DOWNLOAD_INSTALL, false),
+        newTitle(t + 2, GAME(2), 1000, OPERATION_DOWNLOAD, false),
+    };
+
+    CHECK(scheduleTitles(q, 3));
+    CHECK(q[0] == t + 1);
+    CHECK(q[1] == t + 2);
+    CHECK(q[2] == t + 0);
+
+    // Download only titles use the download device
+    newTitle(t + 0, GAME(1), 9000, OPERATION_DOWNLOAD, false);
+    newTitle(t + 1, UPDATE(1), 100, OPERATION_DOWNLOAD, false);
+    t[1].dlDev = NUSDEV_USB01;
+    q[0] = t + 0;
+    q[1] = t + 1;
+    q[2] = t + 2;
+    scheduleTitles(q, 3);
+    CHECK(q[0] == t + 1);
+
+    t[1].dlDev = NUSDEV_SD;
+    q[0] = t + 0;
+    q[1] = t + 1;
+    q[2] = t + 2;
+    scheduleTitles(q, 3);
+    CHECK(q[0] == t + 2);
+    CHECK(q[1] == t + 0);
+    CHECK(q[2] == t + 1);
+}
+
+static void testDownloadSizeForDownloads()
+{
+    TitleData t[2];
+    TitleData *q[2] = {
+        newTitle(t + 0, GAME(1), 100, OPERATION_INSTALL, true),
+        newTitle(t + 1, GAME(2), 100, OPERATION_DOWNLOAD_INSTALL, true),
+    };
+
+    t[0].installSize = 5000;
+    t[1].dlSize = 4000;
+    t[1].installSize = 1;
+    CHECK(scheduleTitles(q, 2));
+    CHECK(q[0] == t + 1);
+}
+
+static void testBalancedDevice()
+{
+    TitleData t;
+    newTitle(&t, GAME(1), 100, OPERATION_DOWNLOAD_INSTALL, true);
+
+    CHECK_EQ(getBalancedDownloadDevice(&t, NUSDEV_SD, NUSDEV_USB01), NUSDEV_USB01);
+    CHECK_EQ(getBalancedDownloadDevice(&t, NUSDEV_USB01, NUSDEV_USB01), NUSDEV_SD);
+    CHECK_EQ(getBalancedDownloadDevice(&t, NUSDEV_SD, NUSDEV_NONE), NUSDEV_SD);
+
+    t.dlDev = NUSDEV_USB01;
+    CHECK_EQ(getBalancedDownloadDevice(&t, NUSDEV_USB01, NUSDEV_USB01), NUSDEV_SD);
+    CHECK_EQ(getBalancedDownloadDevice(&t, NUSDEV_SD, NUSDEV_USB01), NUSDEV_USB01);
+
+    t.keepFiles = true;
+    CHECK_EQ(getBalancedDownloadDevice(&t, NUSDEV_USB01, NUSDEV_USB01), NUSDEV_USB01);
+
+    t.keepFiles = false;
+    t.operation = OPERATION_DOWNLOAD;
+    CHECK_EQ(getBalancedDownloadDevice(&t, NUSDEV_USB01, NUSDEV_USB01), NUSDEV_USB01);
+}
+
+int main()
+{
+    RUN_TEST(testSmallFirst);
+    RUN_TEST(testStableOnTies);
+    RUN_TEST(testDependenciesFollowBase);
+    RUN_TEST(testDependencyNeedsSameTarget);
+    RUN_TEST(testDownloadSizeForDownloads);
+    RUN_TEST(testBalancedDevice);
+    return TEST_RESULT();
+}
@@ -0,0 +1,250 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <file.h>
+#include <jansson.h>
+#include <thread.h>
+#include <trace.h>
+
+#include "fixtures.h"
+#include "test.h"
+
+#include <coreinit/thread.h>
+
+/*
+ * exportTrace() output parsed back as JSON: Events of all cores in time
+ * order, the ring keeping the newest events once it wraps, and no end
+ * event whose begin event got overwritten.
+ */
+
+#define MAX_TIDS 8
+
+// The exported trace or NULL
+static json_t *loadTrace()
+{
+    char path[FS_MAX_PATH];
+    sprintf(path, "%s" TRACE_PATH, hostGetRoot());
+    FILE *f = fopen(path, "rb");
+    if(f == NULL)
+        return NULL;
+
+    fseek(f, 0, SEEK_END);
+    size_t size = ftell(f);
+    rewind(f);
+    char *buf = malloc(size);
+    json_t *ret = NULL;
+    if(fread(buf, 1, size, f) == size)
+    {
+        json_error_t err;
+        ret = json_loadb(buf, size, 0, &err);
+        if(ret == NULL)
+            printf("Invalid JSON at %d: %s\n", err.line, err.text);
+    }
+
+    free(buf);
+    fclose(f);
+    return ret;
+}
+
+static const char *eventString(const json_t *event, const char *key)
+{
+    const char *ret = json_string_value(json_object_get(event, key));
+    return ret == NULL ? "" : ret;
+}
+
+// Checks the time order and that every end event closes a begin event of its thread
+static void checkBalanced(const json_t *events)
+{
+    json_int_t tids[MAX_TIDS];
+    int depth[MAX_TIDS];
+    size_t tidCount = 0;
+    json_int_t last = 0;
+    for(size_t i = 0; i < json_array_size(events); ++i)
+    {
+        const json_t *event = json_array_get(events, i);
+        const char *ph = eventString(event, "ph");
+        if(strcmp(ph, "M") == 0)
+            continue;
+
+        json_int_t ts = json_integer_value(json_object_get(event, "ts"));
+        CHECK(ts >= last);
+        last = ts;
+
+        json_int_t tid = json_integer_value(json_object_get(event, "tid"));
+        size_t t;
+        for(t = 0; t < tidCount && tids[t] != tid; ++t)
+            ;
+        if(t == tidCount)
+        {
+            CHECK(tidCount < MAX_TIDS);
+            if(tidCount == MAX_TIDS)
+                return;
+
+            tids[tidCount] = tid;
+            depth[tidCount++] = 0;
+        }
+
+        if(strcmp(ph, "B") == 0)
+            ++depth[t];
+        else if(strcmp(ph, "E") == 0)
+        {
+            CHECK(depth[t] > 0);
+            --depth[t];
+        }
+    }
+}
+
+// Names of the begin and end events, like "B:a E:a "
+static void phases(const json_t *events, char *out)
+{
+    out[0] = '\0';
+    for(size_t i = 0; i < json_array_size(events); ++i)
+    {
+        const json_t *event = json_array_get(events, i);
+        const char *ph = eventString(event, "ph");
+        if(strcmp(ph, "B") == 0 || strcmp(ph, "E") == 0)
+            out += sprintf(out, "%s:%s ", ph, eventString(event, "name"));
+    }
+}
+
+static void testExport()
+{
+    initTrace();
+    traceBegin("a");
+    traceCounter("c", 42);
+    traceEnd("a");
+    CHECK(exportTrace());
+    shutdownTrace();
+
+    json_t *trace = loadTrace();
+    CHECK(trace != NULL);
+    if(trace == NULL)
+        return;
+
+    const json_t *events = json_object_get(trace, "traceEvents");
+    CHECK_EQ(json_array_size(events), 4);
+    const json_t *event = json_array_get(events, 0);
+    CHECK_EQ(strcmp(eventString(event, "ph"), "M"), 0);
+    CHECK_EQ(strcmp(eventString(json_object_get(event, "args"), "name"), "main"), 0);
+    event = json_array_get(events, 2);
+    CHECK_EQ(strcmp(eventString(event, "ph"), "C"), 0);
+    CHECK_EQ(json_integer_value(json_object_get(json_object_get(event, "args"), "value")), 42);
+
+    char names[64];
+    phases(events, names);
+    CHECK_EQ(strcmp(names, "B:a E:a "), 0);
+    checkBalanced(events);
+    json_decref(trace);
+}
+
+static void testRingWrap()
+{
+    initTrace();
+    traceBegin("outer");
+    for(int i = 0; i < TRACE_RING_EVENTS; ++i)
+        traceCounter("n", i);
+    traceEnd("outer");
+    traceBegin("inner");
+    traceEnd("inner");
+    CHECK(exportTrace());
+    shutdownTrace();
+
+    json_t *trace = loadTrace();
+    CHECK(trace != NULL);
+    if(trace == NULL)
+        return;
+
+    // The ring holds the last counters and the three events after them, "E:outer" gets dropped
+    const json_t *events = json_object_get(trace, "traceEvents");
+    size_t counters = 0;
+    json_int_t first = -1;
+    for(size_t i = 0; i < json_array_size(events); ++i)
+    {
+        const json_t *event = json_array_get(events, i);
+        if(strcmp(eventString(event, "ph"), "C") == 0)
+        {
+            if(first == -1)
+                first = json_integer_value(json_object_get(json_object_get(event, "args"), "value"));
+            ++counters;
+        }
+    }
+    CHECK_EQ(counters, TRACE_RING_EVENTS - 3);
+    CHECK_EQ(first, 3);
+
+    char names[64];
+    phases(events, names);
+    CHECK_EQ(strcmp(names, "B:inner E:inner "), 0);
+    checkBalanced(events);
+    json_decref(trace);
+}
+
+static int workerMain(int argc, const char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    traceBegin("worker");
+    traceEnd("worker");
+    return 0;
+}
+
+static void testCoresMerged()
+{
+    static OSThread thread;
+    static uint8_t stack[STACKSIZE_SMALL];
+
+    // The main thread runs on core 1, so both go to different rings
+    initTrace();
+    traceBegin("main");
+    CHECK(OSCreateThread(&thread, workerMain, 0, NULL, stack + sizeof(stack), sizeof(stack), THREAD_PRIORITY_MEDIUM, OS_THREAD_ATTRIB_AFFINITY_CPU0));
+    OSSetThreadName(&thread, "Trace worker");
+    CHECK(OSResumeThread(&thread));
+    CHECK(OSJoinThread(&thread, NULL));
+    traceEnd("main");
+    CHECK(exportTrace());
+    shutdownTrace();
+
+    json_t *trace = loadTrace();
+    CHECK(trace != NULL);
+    if(trace == NULL)
+        return;
+
+    const json_t *events = json_object_get(trace, "traceEvents");
+    char names[64];
+    phases(events, names);
+    CHECK_EQ(strcmp(names, "B:main B:worker E:worker E:main "), 0);
+    checkBalanced(events);
+    json_decref(trace);
+}
+
+int main()
+{
+    hostMakeRoot();
+    makeHostDirs(NUSDIR_SD);
+
+    RUN_TEST(testExport);
+    RUN_TEST(testRingWrap);
+    RUN_TEST(testCoresMerged);
+
+    hostRemoveRoot();
+    return TEST_RESULT();
+}
@@ -0,0 +1,174 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <file.h>
+#include <tmd.h>
+#include <verifier.h>
+
+#include "fixtures.h"
+#include "test.h"
+
+#define TID       0x0005000010102000ull
+#define TITLE_DIR INSTALL_DIR_SD "Verify [0005000010102000]/"
+
+// A flat content not ending on an AES block, a hashed one spanning two H0 groups and a small flat one
+static const CONTENT_DESC desc[] = {
+    { .size = 100003 },
+    { .size = 20 * HASHED_BLOCK_SIZE, .hashed = true },
+    { .size = 16 },
+};
+
+#define CONTENTS (sizeof(desc) / sizeof(desc[0]))
+
+static TMD *tmd;
+
+static void writeFolder()
+{
+    size_t size;
+    char path[FS_MAX_PATH];
+    makeHostDirs(TITLE_DIR);
+    tmd = buildTmd(TID, 0, desc, CONTENTS, &size);
+    for(uint16_t i = 0; i < CONTENTS; ++i)
+        writeEncryptedContent(TITLE_DIR, tmd, i);
+
+    sealTmd(tmd);
+    strcpy(path, TITLE_DIR "title.tmd");
+    writeHostFile(path, tmd, size);
+
+    void *ticket = buildTicket(TID, &size);
+    strcpy(path, TITLE_DIR "title.tik");
+    writeHostFile(path, ticket, size);
+    free(ticket);
+}
+
+static void contentPath(uint16_t i, const char *ext, char *out)
+{
+    sprintf(out, "%s%s%08x%s", hostGetRoot(), TITLE_DIR, tmd->contents[i].cid, ext);
+}
+
+static void flipByte(uint16_t i, const char *ext, long offset)
+{
+    char path[FS_MAX_PATH * 2];
+    contentPath(i, ext, path);
+    FILE *f = fopen(path, "r+b");
+    fseek(f, offset, SEEK_SET);
+    int c = fgetc(f);
+    fseek(f, offset, SEEK_SET);
+    fputc(c ^ 0x01, f);
+    fclose(f);
+}
+
+static bool verify(VERIFY_RESULT *results)
+{
+    char dir[] = TITLE_DIR;
+    return verifyContents(dir, tmd, results);
+}
+
+static void testIntact()
+{
+    VERIFY_RESULT results[CONTENTS];
+    CHECK(verify(results));
+    for(uint16_t i = 0; i < CONTENTS; ++i)
+    {
+        CHECK_EQ(results[i].state, VERIFY_STATE_OK);
+        CHECK_EQ(results[i].block, VERIFY_NO_BLOCK);
+    }
+}
+
+static void testCorruptFlat()
+{
+    flipByte(0, ".app", 54321);
+
+    VERIFY_RESULT results[CONTENTS];
+    CHECK(verify(results));
+    CHECK_EQ(results[0].state, VERIFY_STATE_BAD_HASH);
+    CHECK_EQ(results[1].state, VERIFY_STATE_OK);
+    CHECK_EQ(results[2].state, VERIFY_STATE_OK);
+
+    flipByte(0, ".app", 54321);
+}
+
+static void testCorruptBlock()
+{
+    // Block 17 is the second one in the second H0 group
+    flipByte(1, ".app", 17 * HASHED_BLOCK_SIZE + HASHED_HEADER_SIZE + 0x1234);
+
+    VERIFY_RESULT results[CONTENTS];
+    CHECK(verify(results));
+    CHECK_EQ(results[0].state, VERIFY_STATE_OK);
+    CHECK_EQ(results[1].state, VERIFY_STATE_BAD_BLOCK);
+    CHECK_EQ(results[1].block, 17);
+    CHECK_EQ(results[2].state, VERIFY_STATE_OK);
+
+    flipByte(1, ".app", 17 * HASHED_BLOCK_SIZE + HASHED_HEADER_SIZE + 0x1234);
+
+    // A damaged hash table gets caught as well
+    flipByte(1, ".app", 3 * HASHED_BLOCK_SIZE + 0x150);
+    CHECK(verify(results));
+    CHECK_EQ(results[1].state, VERIFY_STATE_BAD_BLOCK);
+    CHECK_EQ(results[1].block, 3);
+    flipByte(1, ".app", 3 * HASHED_BLOCK_SIZE + 0x150);
+}
+
+static void testBadH3()
+{
+    flipByte(1, ".h3", 5);
+
+    VERIFY_RESULT results[CONTENTS];
+    CHECK(verify(results));
+    CHECK_EQ(results[1].state, VERIFY_STATE_BAD_H3);
+
+    flipByte(1, ".h3", 5);
+}
+
+static void testMissing()
+{
+    char path[FS_MAX_PATH * 2];
+    char moved[sizeof(path) + 4];
+    contentPath(2, ".app", path);
+    sprintf(moved, "%s.bak", path);
+    rename(path, moved);
+
+    VERIFY_RESULT results[CONTENTS];
+    CHECK(verify(results));
+    CHECK_EQ(results[0].state, VERIFY_STATE_OK);
+    CHECK_EQ(results[1].state, VERIFY_STATE_OK);
+    CHECK_EQ(results[2].state, VERIFY_STATE_MISSING);
+
+    rename(moved, path);
+}
+
+int main()
+{
+    hostMakeRoot();
+    writeFolder();
+
+    RUN_TEST(testIntact);
+    RUN_TEST(testCorruptFlat);
+    RUN_TEST(testCorruptBlock);
+    RUN_TEST(testBadH3);
+    RUN_TEST(testMissing);
+
+    hostRemoveRoot();
+    free(tmd);
+    return TEST_RESULT();
+}
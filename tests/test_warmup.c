@@ -0,0 +1,156 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <downloader.h>
+#include <file.h>
+#include <romfs.h>
+
+#include "fixtures.h"
+#include "nusServer.h"
+#include "test.h"
+
+/*
+ * warmupConnection() against the NUS stand-in from tests/nusServer.c: The
+ * download after it has to reuse the warmed up connection, there's no
+ * warm-up right after a transfer and deinitDownloader() has to join a
+ * warm-up that's still waiting for the server.
+ */
+
+#define TMD_PATH   "/ccs/download/0005000010101a00/tmd"
+#define REQUEST_MS 3000
+
+static bool fetch()
+{
+    RAMBUF *rambuf = allocRamBuf();
+    if(rambuf == NULL)
+        return false;
+
+    bool ret = downloadFile(DOWNLOAD_URL "0005000010101a00/tmd", "tmd", NULL, FILE_TYPE_TMD | FILE_TYPE_TORAM, false, NULL, rambuf) == 0 && rambuf->size == 0x1000;
+    freeRamBuf(rambuf);
+    return ret;
+}
+
+// Waits for the server to see count requests, then gives curl the time to pool the connection
+static bool waitForRequests(uint32_t count)
+{
+    NUS_SERVER_STATS stats;
+    for(int i = 0; i < 1000; ++i)
+    {
+        getNusServerStats(&stats);
+        if(stats.requests >= count)
+        {
+            usleep(50000);
+            return true;
+        }
+
+        usleep(1000);
+    }
+
+    return false;
+}
+
+// Fresh downloader without connections and without a recent transfer
+static void reinit()
+{
+    deinitDownloader();
+    CHECK(initDownloader());
+    setNusServerTiming(0, 0, 0);
+    resetNusServerStats();
+}
+
+static void testWarmupReused()
+{
+    NUS_SERVER_STATS stats;
+    reinit();
+    warmupConnection();
+    CHECK(waitForRequests(1));
+    CHECK(fetch());
+
+    getNusServerStats(&stats);
+    CHECK_EQ(stats.connections, 1);
+    CHECK_EQ(stats.requests, 2);
+    CHECK_EQ(getNusFileRequests(TMD_PATH), 1);
+}
+
+static void testNoWarmupAfterTransfer()
+{
+    NUS_SERVER_STATS stats;
+    reinit();
+    CHECK(fetch());
+    resetNusServerStats();
+    warmupConnection();
+    usleep(100000);
+
+    getNusServerStats(&stats);
+    CHECK_EQ(stats.connections, 0);
+    CHECK_EQ(stats.requests, 0);
+}
+
+static void testDeinitJoinsWarmup()
+{
+    reinit();
+    uint32_t threads = hostUnjoinedThreads();
+    setNusServerTiming(0, REQUEST_MS, 0);
+    warmupConnection();
+    CHECK_EQ(hostUnjoinedThreads(), threads + 1);
+
+    // The server holds the answer back, so the warm-up is in flight now
+    NUS_SERVER_STATS stats = { .requests = 0 };
+    for(int i = 0; i < 1000 && stats.requests == 0; ++i)
+    {
+        usleep(1000);
+        getNusServerStats(&stats);
+    }
+    CHECK_EQ(stats.requests, 1);
+
+    uint64_t t = testNow();
+    deinitDownloader();
+    t = testNow() - t;
+    CHECK_EQ(hostUnjoinedThreads(), threads);
+    CHECK(t < REQUEST_MS * 1000000ull / 2); // Cancelled instead of waited for
+
+    CHECK(initDownloader());
+    setNusServerTiming(0, 0, 0);
+}
+
+int main()
+{
+    static const char certs[] = "# Plain HTTP only on the host\n";
+
+    hostMakeRoot();
+    makeHostDirs(ROMFS_PATH);
+    writeHostFile(ROMFS_PATH "ca-certs.pem", certs, sizeof(certs) - 1);
+
+    int port = startNusServer();
+    CHECK(port != 0);
+    addNusFile(TMD_PATH, NULL, 0x1000);
+    hostSetProxy("127.0.0.1", port);
+    CHECK(initDownloader());
+
+    RUN_TEST(testWarmupReused);
+    RUN_TEST(testNoWarmupAfterTransfer);
+    RUN_TEST(testDeinitJoinsWarmup);
+
+    deinitDownloader();
+    stopNusServer();
+    hostRemoveRoot();
+    return TEST_RESULT();
+}
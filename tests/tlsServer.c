@@ -0,0 +1,259 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#include "tlsServer.h"
+
+/*
+ * Answers "GET /<bytes>" with that many bytes and keeps the connection
+ * open until the client closes it. Each connection gets its own thread, so
+ * clients holding several connections at once work, too. The certificate
+ * is self signed and made up on start, clients have to skip verification.
+ */
+
+#define REQUEST_LENGTH 2048
+
+static SSL_CTX *ctx = NULL;
+static int listenSocket = -1;
+static pthread_t acceptThread;
+static volatile uint32_t running = 0;
+static TLS_SERVER_STATS stats;
+
+static void count(uint32_t *counter)
+{
+    __atomic_add_fetch(counter, 1, __ATOMIC_SEQ_CST);
+}
+
+static bool sendAll(SSL *ssl, const char *buf, size_t size)
+{
+    while(size != 0)
+    {
+        int ret = SSL_write(ssl, buf, size);
+        if(ret <= 0)
+            return false;
+
+        buf += ret;
+        size -= ret;
+    }
+
+    return true;
+}
+
+static bool answer(SSL *ssl, const char *request)
+{
+    size_t size = 0;
+    sscanf(request, "GET /%zu", &size);
+    count(&stats.requests);
+
+    char header[128];
+    sprintf(header, "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\nContent-Type: application/octet-stream\r\n\r\n", size);
+    if(!sendAll(ssl, header, strlen(header)))
+        return false;
+
+    char body[4096];
+    memset(body, 'N', sizeof(body));
+    while(size != 0)
+    {
+        size_t chunk = size < sizeof(body) ? size : sizeof(body);
+        if(!sendAll(ssl, body, chunk))
+            return false;
+
+        size -= chunk;
+    }
+
+    return true;
+}
+
+static void *connectionThreadMain(void *arg)
+{
+    int sock = (int)(intptr_t)arg;
+    SSL *ssl = SSL_new(ctx);
+    if(ssl != NULL)
+    {
+        SSL_set_fd(ssl, sock);
+        if(SSL_accept(ssl) == 1)
+        {
+            count(SSL_session_reused(ssl) ? &stats.resumed : &stats.handshakes);
+
+            char request[REQUEST_LENGTH];
+            size_t got = 0;
+            int ret;
+            while((ret = SSL_read(ssl, request + got, sizeof(request) - 1 - got)) > 0)
+            {
+                got += ret;
+                request[got] = '\0';
+                char *end = strstr(request, "\r\n\r\n");
+                if(end == NULL)
+                {
+                    if(got == sizeof(request) - 1)
+                        break;
+
+                    continue;
+                }
+
+                if(!answer(ssl, request))
+                    break;
+
+                // Keep what the client pipelined behind this request
+                end += 4;
+                got -= end - request;
+                memmove(request, end, got + 1);
+            }
+
+            SSL_shutdown(ssl);
+        }
+
+        SSL_free(ssl);
+    }
+
+    close(sock);
+    return NULL;
+}
+
+static void *acceptThreadMain(void *arg)
+{
+    (void)arg;
+
+    while(running)
+    {
+        int sock = accept(listenSocket, NULL, NULL);
+        if(sock < 0)
+            continue;
+
+        count(&stats.connections);
+        int one = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        pthread_t thread;
+        if(pthread_create(&thread, NULL, connectionThreadMain, (void *)(intptr_t)sock) == 0)
+            pthread_detach(thread);
+        else
+            close(sock);
+    }
+
+    return NULL;
+}
+
+static bool addCertificate()
+{
+    EVP_PKEY *key = EVP_EC_gen("P-256");
+    if(key == NULL)
+        return false;
+
+    bool ret = false;
+    X509 *cert = X509_new();
+    if(cert != NULL)
+    {
+        X509_set_version(cert, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert), -60);
+        X509_gmtime_adj(X509_getm_notAfter(cert), 60 * 60);
+        X509_set_pubkey(cert, key);
+
+        X509_NAME *name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char *)"localhost", -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+
+        ret = X509_sign(cert, key, EVP_sha256()) != 0 &&
+            SSL_CTX_use_certificate(ctx, cert) == 1 &&
+            SSL_CTX_use_PrivateKey(ctx, key) == 1;
+
+        X509_free(cert);
+    }
+
+    EVP_PKEY_free(key);
+    return ret;
+}
+
+int startTlsServer()
+{
+    ctx = SSL_CTX_new(TLS_server_method());
+    if(ctx == NULL)
+        return 0;
+
+    SSL_CTX_set_session_id_context(ctx, (const unsigned char *)"NUSspli", 7);
+    if(addCertificate())
+    {
+        listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+        if(listenSocket >= 0)
+        {
+            struct sockaddr_in addr;
+            socklen_t len = sizeof(addr);
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            if(bind(listenSocket, (struct sockaddr *)&addr, sizeof(addr)) == 0 &&
+               listen(listenSocket, 16) == 0 &&
+               getsockname(listenSocket, (struct sockaddr *)&addr, &len) == 0)
+            {
+                running = 1;
+                if(pthread_create(&acceptThread, NULL, acceptThreadMain, NULL) == 0)
+                    return ntohs(addr.sin_port);
+
+                running = 0;
+            }
+
+            close(listenSocket);
+            listenSocket = -1;
+        }
+    }
+
+    SSL_CTX_free(ctx);
+    ctx = NULL;
+    return 0;
+}
+
+// Connections still open by then keep their thread, these end when the client closes them
+void stopTlsServer()
+{
+    if(!running)
+        return;
+
+    running = 0;
+    shutdown(listenSocket, SHUT_RDWR);
+    pthread_join(acceptThread, NULL);
+    close(listenSocket);
+    listenSocket = -1;
+}
+
+void getTlsServerStats(TLS_SERVER_STATS *out)
+{
+    out->connections = __atomic_load_n(&stats.connections, __ATOMIC_SEQ_CST);
+    out->handshakes = __atomic_load_n(&stats.handshakes, __ATOMIC_SEQ_CST);
+    out->resumed = __atomic_load_n(&stats.resumed, __ATOMIC_SEQ_CST);
+    out->requests = __atomic_load_n(&stats.requests, __ATOMIC_SEQ_CST);
+}
+
+void resetTlsServerStats()
+{
+    memset(&stats, 0, sizeof(stats));
+}
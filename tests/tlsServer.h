@@ -0,0 +1,36 @@
+/***************************************************************************
+ * This file is part of NUSspli.                                           *
+ * Copyright (c) 2025 V10lator <v10lator@myway.de>                         *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify    *
+ * it under the terms of the GNU General Public License as published by    *
+ * the Free Software Foundation; either version 3 of the License, or       *
+ * (at your option) any later version.                                     *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful,         *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+// Minimal HTTPS/1.1 server on 127.0.0.1 for the network tests, see tests/tlsServer.c
+
+typedef struct
+{
+    uint32_t connections;
+    uint32_t handshakes; // Full TLS handshakes
+    uint32_t resumed; // Abbreviated handshakes using a cached session
+    uint32_t requests;
+} TLS_SERVER_STATS;
+
+int startTlsServer(); // Returns the port or 0 on error
+void stopTlsServer();
+void getTlsServerStats(TLS_SERVER_STATS *out);
+void resetTlsServerStats();